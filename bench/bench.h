@@ -0,0 +1,143 @@
+/*
+USAGE:
+Include bench.h
+Include relevant header files
+Define each benchmark as 'uint64_t bench(uint32_t size, BenchParams *params, uint64_t *ops)',
+returning the nanoseconds taken by the timed part and storing the operations it performed
+Call bench_run(name, bench, size, params) for each size to time and report it
+Parse arguments with bench_args(argc, argv, &params, &max_size) and call bench_start(&params)
+before the first bench_run and bench_finish(&params) after the last
+
+Results go to stdout, one per benchmark and size: CSV by default, or a JSON array with -j.
+Every result records the commit built from and the DArray parameters used, so runs can be
+compared across commits.
+*/
+
+#ifndef _bench_h
+#define _bench_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef BENCH_COMMIT
+#define BENCH_COMMIT "unknown"
+#endif
+
+typedef struct BenchParams {
+    double expand_rate;     // expand_rate of every DArray created
+    double max_pool_size;   // max_pool_size of every DArray created
+    int repeats;            // Runs of each benchmark; the minimum and median are reported
+    int json;               // Report JSON rather than CSV
+    const char *filter;     // Run only benchmarks whose name contains this; NULL for all
+    int reported;           // Results reported so far
+} BenchParams;
+
+typedef uint64_t (*Bench)(uint32_t size, BenchParams *params, uint64_t *ops);
+
+// Defeats dead-code elimination of results
+static volatile uintptr_t bench_sink;
+
+static inline uint64_t bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int bench_compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void bench_usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-j] [-e expand_rate] [-p max_pool_size] [-m max_size] [-r repeats] [-f filter]\n", name);
+    exit(2);
+}
+
+static void bench_args(int argc, char *argv[], BenchParams *params, uint32_t *max_size)
+{
+    params->expand_rate = 1.5;
+    params->max_pool_size = 0.3;
+    params->repeats = 3;
+    params->json = 0;
+    params->filter = NULL;
+    params->reported = 0;
+    *max_size = 10000000;
+
+    int opt;
+    while((opt = getopt(argc, argv, "je:p:m:r:f:")) != -1) {
+        switch(opt) {
+            case 'j': params->json = 1; break;
+            case 'e': params->expand_rate = strtod(optarg, NULL); break;
+            case 'p': params->max_pool_size = strtod(optarg, NULL); break;
+            case 'm': *max_size = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'r': params->repeats = atoi(optarg); break;
+            case 'f': params->filter = optarg; break;
+            default: bench_usage(argv[0]);
+        }
+    }
+
+    if(params->expand_rate <= 1 || params->max_pool_size < 0 || params->max_pool_size > 1 ||
+            params->repeats < 1 || *max_size < 1000) {
+        bench_usage(argv[0]);
+    }
+}
+
+static void bench_start(BenchParams *params)
+{
+    if(params->json) {
+        printf("[\n");
+    } else {
+        printf("commit,bench,size,expand_rate,max_pool_size,repeats,ops,min_ns_per_op,median_ns_per_op,min_ops_per_sec\n");
+    }
+}
+
+static void bench_finish(BenchParams *params)
+{
+    if(params->json) {
+        printf("\n]\n");
+    }
+}
+
+static void bench_run(const char *name, Bench bench, uint32_t size, BenchParams *params)
+{
+    if(params->filter != NULL && strstr(name, params->filter) == NULL) {
+        return;
+    }
+
+    uint64_t times[64];
+    int repeats = params->repeats < 64 ? params->repeats : 64;
+    uint64_t ops = 0;
+
+    for(int i = 0; i < repeats; i++) {
+        times[i] = bench(size, params, &ops);
+    }
+    qsort(times, (size_t)repeats, sizeof(uint64_t), bench_compare_u64);
+
+    double min_ns = ops > 0 ? (double)times[0] / (double)ops : 0.0;
+    double median_ns = ops > 0 ? (double)times[repeats / 2] / (double)ops : 0.0;
+    double ops_per_sec = times[0] > 0 ? (double)ops * 1e9 / (double)times[0] : 0.0;
+
+    if(params->json) {
+        printf("%s  {\"commit\": \"%s\", \"bench\": \"%s\", \"size\": %u, \"expand_rate\": %g, \"max_pool_size\": %g, "
+                "\"repeats\": %d, \"ops\": %llu, \"min_ns_per_op\": %.3f, \"median_ns_per_op\": %.3f, \"min_ops_per_sec\": %.0f}",
+                params->reported > 0 ? ",\n" : "", BENCH_COMMIT, name, size, params->expand_rate, params->max_pool_size,
+                repeats, (unsigned long long)ops, min_ns, median_ns, ops_per_sec);
+    } else {
+        printf("%s,%s,%u,%g,%g,%d,%llu,%.3f,%.3f,%.0f\n", BENCH_COMMIT, name, size, params->expand_rate,
+                params->max_pool_size, repeats, (unsigned long long)ops, min_ns, median_ns, ops_per_sec);
+    }
+    fflush(stdout);
+    params->reported++;
+}
+
+#endif
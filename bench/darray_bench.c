@@ -0,0 +1,384 @@
+#include "darray.h"
+#include "bench.h"
+
+// Values are never dereferenced, so any non-NULL pointer will do
+#define VALUE(i) ((void *)(uintptr_t)((i) + 1))
+
+static DArray *bench_array(BenchParams *params)
+{
+    int rc = 0;
+    DArray *darray = DArray_init_with_pool(16, params->max_pool_size, params->expand_rate, 0, &rc);
+
+    if(darray == NULL) {
+        fprintf(stderr, "Failed to create DArray (%#04x)\n", rc);
+        exit(1);
+    }
+
+    return darray;
+}
+
+static DArray *bench_filled(uint32_t size, BenchParams *params)
+{
+    DArray *darray = bench_array(params);
+
+    for(uint32_t i = 0; i < size; i++) {
+        if(DArray_push(darray, VALUE(i)) != 0) {
+            fprintf(stderr, "Failed to fill DArray of %u values\n", size);
+            exit(1);
+        }
+    }
+
+    return darray;
+}
+
+// Small, fast generator for the mixed workload and sort keys
+static inline uint64_t bench_rand(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+static uint64_t bench_push(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_array(params);
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        DArray_push(darray, VALUE(i));
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+static uint64_t bench_pop(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_filled(size, params);
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        bench_sink += (uintptr_t)DArray_pop(darray);
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+static uint64_t bench_unshift(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_array(params);
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        DArray_unshift(darray, VALUE(i));
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+static uint64_t bench_shift(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_filled(size, params);
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        bench_sink += (uintptr_t)DArray_shift(darray, NULL);
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+// FIFO queue held at size values: push one, shift one
+static uint64_t bench_queue_darray(DArray *darray, uint32_t size, uint64_t *ops)
+{
+    for(uint32_t i = 0; i < size; i++) {
+        DArray_push(darray, VALUE(i));
+    }
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        DArray_push(darray, VALUE(i));
+        bench_sink += (uintptr_t)DArray_shift(darray, NULL);
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    DArray_destroy(darray);
+    *ops = 2 * (uint64_t)size;
+    return elapsed;
+}
+
+static uint64_t bench_queue(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    return bench_queue_darray(bench_array(params), size, ops);
+}
+
+static uint64_t bench_queue_ring(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    int rc = 0;
+    DArray *darray = DArray_init_ring(16, params->expand_rate, &rc);
+
+    if(darray == NULL) {
+        fprintf(stderr, "Failed to create ring DArray (%#04x)\n", rc);
+        exit(1);
+    }
+
+    return bench_queue_darray(darray, size, ops);
+}
+
+// Random pushes, pops, shifts and unshifts, holding the length near size
+static uint64_t bench_deque_mixed(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_filled(size, params);
+    uint64_t state = 88172645463325252u;
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        uint64_t r = bench_rand(&state);
+        int grow = darray->length < size ? (r & 3) != 0 : (r & 3) == 0;
+
+        if(grow) {
+            if(r & 4) {
+                DArray_push(darray, VALUE(i));
+            } else {
+                DArray_unshift(darray, VALUE(i));
+            }
+        } else {
+            bench_sink += (uintptr_t)((r & 4) ? DArray_pop(darray) : DArray_shift(darray, NULL));
+        }
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+// Read every value through DArray_index; ns per op here is per 8-byte value
+static uint64_t bench_scan_index(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_filled(size, params);
+    uintptr_t sum = 0;
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        sum += (uintptr_t)DArray_index(darray, i);
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    bench_sink += sum;
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+// Read every value straight from the backing store, for comparison with bench_scan_index
+static uint64_t bench_scan_raw(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_filled(size, params);
+    void **items = darray->items + darray->start_index;
+    uintptr_t sum = 0;
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < size; i++) {
+        sum += (uintptr_t)items[i];
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    bench_sink += sum;
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+// Read every value through a DArrayIter
+static uint64_t bench_scan_iter(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_filled(size, params);
+    uintptr_t sum = 0;
+    void *value = NULL;
+
+    uint64_t start = bench_now();
+    DArray_foreach(darray, value) {
+        sum += (uintptr_t)value;
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    bench_sink += sum;
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+static int bench_visit_sum(void **values, DArraySize count, DArraySize index, void *ctx)
+{
+    uintptr_t sum = 0;
+    (void)index;
+
+    for(DArraySize i = 0; i < count; i++) {
+        sum += (uintptr_t)values[i];
+    }
+    *(uintptr_t *)ctx += sum;
+
+    return 0;
+}
+
+// Read every value in runs of 4096 handed out by DArray_visit_chunks
+static uint64_t bench_scan_visit(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    DArray *darray = bench_filled(size, params);
+    uintptr_t sum = 0;
+
+    uint64_t start = bench_now();
+    DArray_visit_chunks(darray, 4096, bench_visit_sum, &sum);
+    uint64_t elapsed = bench_now() - start;
+
+    bench_sink += sum;
+    DArray_destroy(darray);
+    *ops = size;
+    return elapsed;
+}
+
+// Create size / 8 arrays of 8 values each, then read and destroy them all
+static uint64_t bench_tiny_arrays(uint32_t size, BenchParams *params, int small)
+{
+    uint32_t count = size / 8;
+    DArray **arrays = malloc((size_t)count * sizeof(DArray *));
+    if(arrays == NULL) {
+        fprintf(stderr, "Failed to allocate %u arrays\n", count);
+        exit(1);
+    }
+
+    uint64_t start = bench_now();
+    for(uint32_t i = 0; i < count; i++) {
+        arrays[i] = small ? DArray_init_small(params->max_pool_size, params->expand_rate, 0, NULL, NULL)
+                : DArray_init_with_pool(8, params->max_pool_size, params->expand_rate, 0, NULL);
+        for(uint32_t j = 0; j < 8; j++) {
+            DArray_push(arrays[i], VALUE(j));
+        }
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        bench_sink += (uintptr_t)DArray_index(arrays[i], 7);
+        DArray_destroy(arrays[i]);
+    }
+    uint64_t elapsed = bench_now() - start;
+
+    free(arrays);
+    return elapsed;
+}
+
+static uint64_t bench_tiny(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    *ops = size / 8 * 8;
+    return bench_tiny_arrays(size, params, 0);
+}
+
+static uint64_t bench_tiny_small(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    *ops = size / 8 * 8;
+    return bench_tiny_arrays(size, params, 1);
+}
+
+static int bench_compare(void *a, void *b)
+{
+    uint64_t x = *(uint64_t *)a;
+    uint64_t y = *(uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t bench_sort(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    uint64_t *keys = malloc((size_t)size * sizeof(uint64_t));
+    if(keys == NULL) {
+        fprintf(stderr, "Failed to allocate %u sort keys\n", size);
+        exit(1);
+    }
+
+    uint64_t state = 88172645463325252u;
+    DArray *darray = bench_array(params);
+    for(uint32_t i = 0; i < size; i++) {
+        keys[i] = bench_rand(&state);
+        DArray_push(darray, &keys[i]);
+    }
+
+    uint64_t start = bench_now();
+    DArray_qsort(darray, bench_compare);
+    uint64_t elapsed = bench_now() - start;
+
+    DArray_destroy(darray);
+    free(keys);
+    *ops = size;
+    return elapsed;
+}
+
+// Latency of a single DArray_expand of a full store of size slots
+static uint64_t bench_expand(uint32_t size, BenchParams *params, uint64_t *ops)
+{
+    int rc = 0;
+    DArray *darray = DArray_init_with_pool(size, params->max_pool_size, params->expand_rate, 0, &rc);
+    if(darray == NULL) {
+        fprintf(stderr, "Failed to create DArray of %u slots (%#04x)\n", size, rc);
+        exit(1);
+    }
+    for(uint32_t i = 0; i < size; i++) {
+        darray->items[i] = VALUE(i);
+    }
+    darray->length = size;
+
+    uint64_t start = bench_now();
+    rc = DArray_expand(darray);
+    uint64_t elapsed = bench_now() - start;
+
+    if(rc != 0) {
+        fprintf(stderr, "Failed to expand DArray of %u slots (%#04x)\n", size, rc);
+        exit(1);
+    }
+
+    DArray_destroy(darray);
+    *ops = 1;
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchParams params;
+    uint32_t max_size;
+
+    bench_args(argc, argv, &params, &max_size);
+    bench_start(&params);
+
+    for(uint64_t size = 1000; size <= max_size; size *= 10) {
+        bench_run("push", bench_push, (uint32_t)size, &params);
+        bench_run("pop", bench_pop, (uint32_t)size, &params);
+        bench_run("unshift", bench_unshift, (uint32_t)size, &params);
+        bench_run("shift", bench_shift, (uint32_t)size, &params);
+        bench_run("queue", bench_queue, (uint32_t)size, &params);
+        bench_run("queue_ring", bench_queue_ring, (uint32_t)size, &params);
+        bench_run("deque_mixed", bench_deque_mixed, (uint32_t)size, &params);
+        bench_run("scan_index", bench_scan_index, (uint32_t)size, &params);
+        bench_run("scan_raw", bench_scan_raw, (uint32_t)size, &params);
+        bench_run("scan_iter", bench_scan_iter, (uint32_t)size, &params);
+        bench_run("scan_visit", bench_scan_visit, (uint32_t)size, &params);
+        bench_run("tiny", bench_tiny, (uint32_t)size, &params);
+        bench_run("tiny_small", bench_tiny_small, (uint32_t)size, &params);
+        bench_run("sort", bench_sort, (uint32_t)size, &params);
+        bench_run("expand", bench_expand, (uint32_t)size, &params);
+    }
+
+    bench_finish(&params);
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "darray.h"
+#include "darray_harness.h"
+
+// libFuzzer entry point. The first three bytes choose the mode, max_pool_size and expand_rate;
+// each step after that is an operation byte followed by its arguments. Every value is compared
+// after every step, and a failure aborts so the fuzzer keeps the input
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    Harness harness;
+    HarnessInput in = { data, size, 0, 0 };
+
+    uint64_t mode = harness_draw(&in, 1) % H_MODE_COUNT;
+    uint64_t pool = harness_draw(&in, 1);
+    uint64_t rate = harness_draw(&in, 1);
+    double max_pool_size = (double)pool / 255.0;
+    double expand_rate = 1.0 + (double)(rate + 1) / 64.0;
+
+    if(harness_init(&harness, (int)mode, max_pool_size, expand_rate, 64) != 0) {
+        harness_destroy(&harness);
+        return 0;
+    }
+    harness.check_every_step = 1;
+
+    while(!harness_exhausted(&in)) {
+        int op = (int)(harness_draw(&in, 1) % H_OP_COUNT);
+        char *failure = harness_step(&harness, op, &in);
+
+        if(failure != NULL) {
+            fprintf(stderr, "%s\n", failure);
+            abort();
+        }
+    }
+
+    harness_destroy(&harness);
+    return 0;
+}
+
+#ifdef FUZZ_REPLAY
+// Without libFuzzer, run each file named on the command line as one input
+int main(int argc, char *argv[])
+{
+    static uint8_t data[1 << 20];
+
+    for(int i = 1; i < argc; i++) {
+        FILE *file = fopen(argv[i], "rb");
+        if(file == NULL) {
+            fprintf(stderr, "Failed to open %s\n", argv[i]);
+            return 1;
+        }
+
+        size_t size = fread(data, 1, sizeof(data), file);
+        fclose(file);
+        LLVMFuzzerTestOneInput(data, size);
+    }
+
+    return 0;
+}
+#endif
@@ -0,0 +1,541 @@
+/*
+USAGE:
+Include darray_harness.h
+Create a Harness with harness_init(&harness, mode, max_pool_size, expand_rate, max_count)
+Run operations with harness_step(&harness, op, &input), where input is a HarnessInput of fuzzer
+bytes or, with data set to NULL, a seeded generator which draws each operation's arguments
+Each step checks the DArray against a reference model and returns NULL, or a message describing
+the first difference or broken invariant; harness_check_all compares every value
+Free everything with harness_destroy(&harness)
+
+The model is a plain deque of the values the DArray should hold, in order. After every step the
+harness checks that length matches the model, that start_index and length fit the store, that a
+shift left the pool within max_pool_size, and that the values at both ends and where the step
+worked match. Every value is compared once at least as many steps have run as the array holds,
+so checking costs O(1) per step on average.
+*/
+
+#ifndef _darray_harness_h
+#define _darray_harness_h
+
+#include "darray.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Values are never dereferenced; each value added is unique and non-NULL
+#define HARNESS_VALUE(i) ((void *)(uintptr_t)(i))
+
+enum harness_mode {
+    H_MODE_POOL,            // DArray_init_with_pool
+    H_MODE_RING,            // DArray_init_ring
+    H_MODE_SMALL,           // DArray_init_small
+    H_MODE_TUNED,           // DArray_init_with_pool with DArray_enable_tuning
+    H_MODE_ALLOCATOR,       // DArray_init_with_allocator on Allocator_pool
+    H_MODE_COUNT
+};
+
+enum harness_op {
+    H_PUSH,
+    H_POP,
+    H_UNSHIFT,
+    H_SHIFT,
+    H_PUSH_N,
+    H_POP_N,
+    H_UNSHIFT_N,
+    H_SHIFT_N,
+    H_INSERT,
+    H_SPLICE,
+    H_RESERVE,
+    H_RESERVE_FRONT,
+    H_SHRINK,
+    H_LINEARISE,
+    H_INDEX,
+    H_OP_COUNT
+};
+
+static const char *harness_op_names[H_OP_COUNT] = {
+    "push", "pop", "unshift", "shift", "push_n", "pop_n", "unshift_n", "shift_n",
+    "insert", "splice", "reserve", "reserve_front", "shrink_to_fit", "linearise", "index"
+};
+
+static const char *harness_mode_names[H_MODE_COUNT] = {
+    "pool", "ring", "small", "tuned", "allocator"
+};
+
+typedef struct HarnessInput {
+    const uint8_t *data;    // Bytes to decode arguments from, or NULL to generate them
+    size_t size;            // Bytes in data
+    size_t pos;             // Bytes of data used
+    uint64_t state;         // Generator state when data is NULL; must not be 0
+} HarnessInput;
+
+typedef struct HarnessModel {
+    uintptr_t *values;      // Values, from head
+    size_t head;            // Index of the first value in values
+    size_t length;          // Number of values
+    size_t capacity;        // Slots in values
+} HarnessModel;
+
+typedef struct Harness {
+    DArray *darray;         // Array under test
+    Allocator *allocator;   // Allocator of the array in H_MODE_ALLOCATOR, otherwise NULL
+    HarnessModel model;     // Values the array should hold
+    int mode;               // A harness_mode
+    DArraySize max_count;   // Most values added or removed by one bulk step
+    void **scratch;         // Room for 2 * max_count values passed to and from bulk steps
+    uintptr_t next_value;   // Value given to the next value added
+    uint64_t steps;         // Steps run
+    uint64_t values;        // Values added and removed
+    uint64_t unchecked;     // Steps since every value was compared
+    int check_every_step;   // Compare every value after every step
+    char message[256];      // Failure message returned by the last step
+} Harness;
+
+// 64-bit xorshift; the same generator as the benchmarks
+static inline uint64_t harness_rand(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+// Draw an argument of up to 8 bytes; past the end of the data every argument is 0
+static inline uint64_t harness_draw(HarnessInput *in, int bytes)
+{
+    if(in->data == NULL) {
+        return harness_rand(&in->state);
+    }
+
+    uint64_t value = 0;
+    for(int i = 0; i < bytes && in->pos < in->size; i++) {
+        value |= (uint64_t)in->data[in->pos++] << (8 * i);
+    }
+
+    return value;
+}
+
+// Draw an argument from 0 to bound inclusive
+static inline uint64_t harness_below(HarnessInput *in, uint64_t bound)
+{
+    int bytes = bound < 0x100 ? 1 : bound < 0x10000 ? 2 : bound < 0x100000000u ? 4 : 8;
+
+    return bound == UINT64_MAX ? harness_draw(in, 8) : harness_draw(in, bytes) % (bound + 1);
+}
+
+static inline int harness_exhausted(const HarnessInput *in)
+{
+    return in->data != NULL && in->pos >= in->size;
+}
+
+// Ensure the model has room for front values before its head and back values after its tail
+static int harness_model_reserve(HarnessModel *model, size_t front, size_t back)
+{
+    if(model->head >= front && model->capacity - model->head - model->length >= back) {
+        return 0;
+    }
+
+    size_t capacity = 2 * (model->length + front + back) + 16;
+    uintptr_t *values = malloc(capacity * sizeof(uintptr_t));
+    if(values == NULL) {
+        return -1;
+    }
+
+    // Centre the values so growth at either end is amortised
+    size_t head = front + (capacity - model->length - front - back) / 2;
+    if(model->length > 0) {
+        memcpy(values + head, model->values + model->head, model->length * sizeof(uintptr_t));
+    }
+    free(model->values);
+
+    model->values = values;
+    model->head = head;
+    model->capacity = capacity;
+
+    return 0;
+}
+
+static inline uintptr_t harness_model_at(const HarnessModel *model, size_t index)
+{
+    return model->values[model->head + index];
+}
+
+// Replace remove values at index with count values, moving the shorter side as DArray_splice does
+static int harness_model_splice(HarnessModel *model, size_t index, size_t remove, void **values, size_t count)
+{
+    size_t tail = model->length - index - remove;
+
+    if(index < tail) {
+        if(count > remove && harness_model_reserve(model, count - remove, 0) != 0) {
+            return -1;
+        }
+
+        uintptr_t *head = model->values + model->head;
+        model->head = model->head + remove - count;
+        memmove(model->values + model->head, head, index * sizeof(uintptr_t));
+    } else {
+        if(count > remove && harness_model_reserve(model, 0, count - remove) != 0) {
+            return -1;
+        }
+
+        uintptr_t *at = model->values + model->head + index;
+        memmove(at + count, at + remove, tail * sizeof(uintptr_t));
+    }
+
+    uintptr_t *at = model->values + model->head + index;
+    for(size_t i = 0; i < count; i++) {
+        at[i] = (uintptr_t)values[i];
+    }
+    model->length = model->length - remove + count;
+
+    return 0;
+}
+
+// Scale n by a fixed-point ratio as DArray does, rounding down
+static inline uint64_t harness_scale(uint64_t n, uint32_t fixed)
+{
+    uint64_t whole = (n >> DA_FIXED_SHIFT) * fixed;
+    uint64_t part = ((n & (DA_FIXED_ONE - 1)) * fixed) >> DA_FIXED_SHIFT;
+
+    return whole + part;
+}
+
+static char *harness_fail(Harness *harness, int op, const char *what, uint64_t detail)
+{
+    DArray *darray = harness->darray;
+
+    snprintf(harness->message, sizeof(harness->message),
+            "step %llu (%s, %s mode): %s (%llu); length %" PRIuDA ", start_index %" PRIuDA ", store_size %" PRIuDA
+            ", model length %zu", (unsigned long long)harness->steps, op >= 0 ? harness_op_names[op] : "check",
+            harness_mode_names[harness->mode], what, (unsigned long long)detail, darray->length, darray->start_index,
+            darray->store_size, harness->model.length);
+
+    return harness->message;
+}
+
+// Compare every value with the model, through DArray_index and the backing store
+static char *harness_check_all(Harness *harness)
+{
+    DArray *darray = harness->darray;
+    int ring = (darray->flags & DA_FLAG_RING) != 0;
+
+    harness->unchecked = 0;
+    if(darray->length != harness->model.length) {
+        return harness_fail(harness, -1, "Length differs from model", harness->model.length);
+    }
+
+    for(size_t i = 0; i < harness->model.length; i++) {
+        uint64_t slot = (uint64_t)darray->start_index + i;
+        if(ring && slot >= darray->store_size) {
+            slot -= darray->store_size;
+        }
+
+        void *value = DArray_index(darray, (DArraySize)i);
+        if((uintptr_t)value != harness_model_at(&harness->model, i) || darray->items[slot] != value) {
+            return harness_fail(harness, -1, "Value differs from model at index", i);
+        }
+    }
+
+    return NULL;
+}
+
+// Check the layout invariants, and the values at the ends of the array and at index
+static char *harness_check(Harness *harness, int op, size_t index)
+{
+    DArray *darray = harness->darray;
+    HarnessModel *model = &harness->model;
+    int ring = (darray->flags & DA_FLAG_RING) != 0;
+
+    if(darray->length != model->length) {
+        return harness_fail(harness, op, "Length differs from model", model->length);
+    }
+    if(darray->store_size == 0 || darray->items == NULL) {
+        return harness_fail(harness, op, "No backing store", 0);
+    }
+    if(ring) {
+        if(darray->start_index >= darray->store_size || darray->length > darray->store_size) {
+            return harness_fail(harness, op, "Ring values outside store", darray->store_size);
+        }
+    } else if((uint64_t)darray->start_index + darray->length > darray->store_size) {
+        return harness_fail(harness, op, "Values outside store", darray->store_size);
+    }
+
+    if((darray->flags & DA_FLAG_SMALL) && DArray_is_inline(darray) && darray->store_size != DARRAY_SMALL_SLOTS) {
+        return harness_fail(harness, op, "Inline store has the wrong size", DARRAY_SMALL_SLOTS);
+    }
+
+    if(model->length > 0) {
+        size_t spots[3] = { 0, model->length - 1, index < model->length ? index : 0 };
+        for(int i = 0; i < 3; i++) {
+            void *value = DArray_index(darray, (DArraySize)spots[i]);
+            if((uintptr_t)value != harness_model_at(model, spots[i])) {
+                return harness_fail(harness, op, "Value differs from model at index", spots[i]);
+            }
+        }
+    }
+
+    harness->unchecked++;
+    if(harness->check_every_step || harness->unchecked >= model->length) {
+        return harness_check_all(harness);
+    }
+
+    return NULL;
+}
+
+// Create the array; max_count bounds bulk steps, and must be at least 1
+static int harness_init(Harness *harness, int mode, double max_pool_size, double expand_rate, DArraySize max_count)
+{
+    int rc = 0;
+
+    memset(harness, 0, sizeof(*harness));
+    harness->mode = mode;
+    harness->max_count = max_count;
+    harness->next_value = 1;
+
+    harness->scratch = malloc(2 * (size_t)max_count * sizeof(void *));
+    if(harness->scratch == NULL) {
+        return DA_ERR_MEMORY;
+    }
+
+    switch(mode) {
+        case H_MODE_RING:
+            harness->darray = DArray_init_ring(4, expand_rate, &rc);
+            break;
+        case H_MODE_SMALL:
+            harness->darray = DArray_init_small(max_pool_size, expand_rate, 0, NULL, &rc);
+            break;
+        case H_MODE_ALLOCATOR:
+            harness->allocator = Allocator_pool(&rc);
+            if(harness->allocator != NULL) {
+                harness->darray = DArray_init_with_allocator(4, max_pool_size, expand_rate, 0, 0, harness->allocator, &rc);
+            }
+            break;
+        default:
+            harness->darray = DArray_init_with_pool(4, max_pool_size, expand_rate, 0, &rc);
+            if(harness->darray != NULL && mode == H_MODE_TUNED) {
+                rc = DArray_enable_tuning(harness->darray, 1.25, 4.0, 0.05, 0.75);
+            }
+            break;
+    }
+
+    if(harness->darray == NULL && rc == 0) {
+        rc = DA_ERR_ARGS;
+    }
+
+    return rc;
+}
+
+static void harness_destroy(Harness *harness)
+{
+    DArray_destroy(harness->darray);
+    Allocator_destroy(harness->allocator);
+    free(harness->model.values);
+    free(harness->scratch);
+    memset(harness, 0, sizeof(*harness));
+}
+
+// Fill the first count scratch slots with new values
+static void **harness_new_values(Harness *harness, size_t count)
+{
+    for(size_t i = 0; i < count; i++) {
+        harness->scratch[i] = HARNESS_VALUE(harness->next_value++);
+    }
+    harness->values += count;
+
+    return harness->scratch;
+}
+
+// Check count values removed by a step against the model, starting at model index index
+static char *harness_check_removed(Harness *harness, int op, void **removed, size_t index, size_t count)
+{
+    for(size_t i = 0; i < count; i++) {
+        if((uintptr_t)removed[i] != harness_model_at(&harness->model, index + i)) {
+            return harness_fail(harness, op, "Removed value differs from model at index", index + i);
+        }
+    }
+    harness->values += count;
+
+    return NULL;
+}
+
+// Run one operation, drawing its arguments from in, then check the array
+static char *harness_step(Harness *harness, int op, HarnessInput *in)
+{
+    DArray *darray = harness->darray;
+    HarnessModel *model = &harness->model;
+    char *failure = NULL;
+    size_t index = 0;
+    int shifted = 0;
+    int rc = 0;
+
+    harness->steps++;
+
+    switch(op) {
+        case H_PUSH:
+        case H_UNSHIFT: {
+            void *value = harness_new_values(harness, 1)[0];
+            rc = op == H_PUSH ? DArray_push(darray, value) : DArray_unshift(darray, value);
+            if(rc == 0) {
+                index = op == H_PUSH ? model->length : 0;
+                rc = harness_model_splice(model, index, 0, &value, 1);
+            }
+            break;
+        }
+
+        case H_POP:
+        case H_SHIFT: {
+            void *value = op == H_POP ? DArray_pop(darray) : DArray_shift(darray, &rc);
+            if(rc != 0) {
+                break;
+            }
+            if(model->length == 0) {
+                if(value != NULL) {
+                    return harness_fail(harness, op, "Value removed from empty array", (uintptr_t)value);
+                }
+                break;
+            }
+            index = op == H_POP ? model->length - 1 : 0;
+            if((failure = harness_check_removed(harness, op, &value, index, 1)) != NULL) {
+                return failure;
+            }
+            if(op == H_SHIFT) {
+                model->head++;
+                shifted = 1;
+            }
+            model->length--;
+            index = 0;
+            break;
+        }
+
+        case H_PUSH_N:
+        case H_UNSHIFT_N:
+        case H_INSERT: {
+            size_t count = op == H_INSERT ? 1 : (size_t)harness_below(in, harness->max_count);
+            index = op == H_PUSH_N ? model->length : op == H_UNSHIFT_N ? 0 : (size_t)harness_below(in, model->length);
+            void **values = harness_new_values(harness, count);
+
+            if(op == H_PUSH_N) {
+                rc = DArray_push_n(darray, values, (DArraySize)count);
+            } else if(op == H_UNSHIFT_N) {
+                rc = DArray_unshift_n(darray, values, (DArraySize)count);
+            } else {
+                rc = DArray_insert(darray, (DArraySize)index, values[0]);
+            }
+            if(rc == 0) {
+                rc = harness_model_splice(model, index, 0, values, count);
+            }
+            break;
+        }
+
+        case H_POP_N:
+        case H_SHIFT_N: {
+            size_t count = (size_t)harness_below(in, harness->max_count);
+            size_t removed = count < model->length ? count : model->length;
+            DArraySize got = op == H_POP_N ? DArray_pop_n(darray, harness->scratch, (DArraySize)count)
+                    : DArray_shift_n(darray, harness->scratch, (DArraySize)count, &rc);
+
+            if(rc != 0) {
+                break;
+            }
+            if(got != removed) {
+                return harness_fail(harness, op, "Wrong number of values removed", got);
+            }
+            index = op == H_POP_N ? model->length - removed : 0;
+            if((failure = harness_check_removed(harness, op, harness->scratch, index, removed)) != NULL) {
+                return failure;
+            }
+            if(op == H_SHIFT_N) {
+                model->head += removed;
+                shifted = removed > 0;
+            }
+            model->length -= removed;
+            index = 0;
+            break;
+        }
+
+        case H_SPLICE: {
+            index = (size_t)harness_below(in, model->length);
+            size_t room = model->length - index;
+            size_t remove = (size_t)harness_below(in, room < harness->max_count ? room : harness->max_count);
+            size_t count = (size_t)harness_below(in, harness->max_count);
+            void **values = harness_new_values(harness, count);
+            void **removed = harness->scratch + harness->max_count;
+
+            rc = DArray_splice(darray, (DArraySize)index, (DArraySize)remove, removed, values, (DArraySize)count);
+            if(rc == 0) {
+                if((failure = harness_check_removed(harness, op, removed, index, remove)) != NULL) {
+                    return failure;
+                }
+                rc = harness_model_splice(model, index, remove, values, count);
+            }
+            break;
+        }
+
+        case H_RESERVE: {
+            uint64_t capacity = model->length + harness_below(in, harness->max_count);
+            rc = DArray_reserve(darray, (DArraySize)capacity);
+            uint64_t room = darray->flags & DA_FLAG_RING ? darray->store_size : darray->store_size - darray->start_index;
+            if(rc == 0 && room < capacity) {
+                return harness_fail(harness, op, "Capacity not reserved", capacity);
+            }
+            break;
+        }
+
+        case H_RESERVE_FRONT: {
+            uint64_t pool = harness_below(in, harness->max_count);
+            rc = DArray_reserve_front(darray, (DArraySize)pool);
+            uint64_t room = darray->flags & DA_FLAG_RING ? darray->store_size - darray->length : darray->start_index;
+            if(rc == 0 && room < pool) {
+                return harness_fail(harness, op, "Pool not reserved", pool);
+            }
+            break;
+        }
+
+        case H_SHRINK:
+            rc = DArray_shrink_to_fit(darray);
+            if(rc == 0 && (darray->flags & DA_FLAG_RING) && darray->store_size > (darray->length > 0 ? darray->length : 1)) {
+                return harness_fail(harness, op, "Ring keeps free slots", darray->store_size);
+            }
+            if(rc == 0 && (darray->flags & DA_FLAG_SMALL) && !DArray_is_inline(darray) && darray->store_size <= DARRAY_SMALL_SLOTS) {
+                return harness_fail(harness, op, "Small array not moved inline", DARRAY_SMALL_SLOTS);
+            }
+            // Only the part of the pool max_pool_size allows for the length is kept
+            if(rc == 0 && !DArray_is_inline(darray) && darray->store_size >
+                    (darray->length > 0 ? darray->length : 1) + harness_scale(darray->length, darray->max_pool_size)) {
+                return harness_fail(harness, op, "Store not shrunk", darray->store_size);
+            }
+            break;
+
+        case H_LINEARISE:
+            rc = DArray_linearise(darray);
+            if(rc == 0 && (uint64_t)darray->start_index + darray->length > darray->store_size) {
+                return harness_fail(harness, op, "Not linear", darray->store_size);
+            }
+            break;
+
+        case H_INDEX:
+            index = (size_t)harness_below(in, model->length);
+            break;
+
+        default:
+            return harness_fail(harness, op, "Unknown operation", (uint64_t)op);
+    }
+
+    if(rc != 0) {
+        return harness_fail(harness, op, "Operation failed with error", (uint64_t)rc);
+    }
+
+    // A shift trims a pool which has outgrown max_pool_size
+    uint64_t limit = harness_scale(darray->store_size, darray->max_pool_size);
+    if(shifted && !(darray->flags & DA_FLAG_RING) && darray->start_index > limit) {
+        return harness_fail(harness, op, "Pool not trimmed by shift; limit", limit);
+    }
+
+    return harness_check(harness, op, index);
+}
+
+#endif
@@ -0,0 +1,189 @@
+#include "darray.h"
+#include "darray_stats.h"
+#include "darray_harness.h"
+
+#include <time.h>
+#include <unistd.h>
+
+typedef struct StressParams {
+    uint64_t steps;         // Steps to run in each mode
+    DArraySize max_size;    // Most values the workload aims to hold
+    DArraySize max_count;   // Most values added or removed by one bulk step
+    uint64_t seed;          // Seed of the generator
+    int mode;               // harness_mode to run, or -1 for all of them
+    double expand_rate;     // expand_rate of every DArray created
+    double max_pool_size;   // max_pool_size of every DArray created
+} StressParams;
+
+static uint64_t stress_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static void stress_usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n steps] [-m max_size] [-b max_count] [-s seed] [-M mode] [-e expand_rate] [-p max_pool_size]\n", name);
+    fprintf(stderr, "modes: pool, ring, small, tuned, allocator; all by default\n");
+    exit(2);
+}
+
+static void stress_args(int argc, char *argv[], StressParams *params)
+{
+    params->steps = 2000000;
+    params->max_size = 1u << 22;
+    params->max_count = 1024;
+    params->seed = 88172645463325252u;
+    params->mode = -1;
+    params->expand_rate = 1.5;
+    params->max_pool_size = 0.3;
+
+    int opt;
+    while((opt = getopt(argc, argv, "n:m:b:s:M:e:p:")) != -1) {
+        switch(opt) {
+            case 'n': params->steps = strtoull(optarg, NULL, 10); break;
+            case 'm': params->max_size = (DArraySize)strtoull(optarg, NULL, 10); break;
+            case 'b': params->max_count = (DArraySize)strtoull(optarg, NULL, 10); break;
+            case 's': params->seed = strtoull(optarg, NULL, 10); break;
+            case 'M':
+                params->mode = H_MODE_COUNT;
+                for(int mode = 0; mode < H_MODE_COUNT; mode++) {
+                    if(strcmp(optarg, harness_mode_names[mode]) == 0) {
+                        params->mode = mode;
+                    }
+                }
+                break;
+            case 'e': params->expand_rate = strtod(optarg, NULL); break;
+            case 'p': params->max_pool_size = strtod(optarg, NULL); break;
+            default: stress_usage(argv[0]);
+        }
+    }
+
+    if(params->mode == H_MODE_COUNT || params->expand_rate <= 1 || params->max_pool_size < 0 ||
+            params->max_pool_size > 1 || params->max_size < 1 || params->max_count < 1) {
+        stress_usage(argv[0]);
+    }
+}
+
+// Pick a step which moves the length towards target; operations which are O(n) are rare
+static int stress_pick(uint64_t r, size_t length, size_t target)
+{
+    uint64_t kind = r % 1024;
+    r /= 1024;
+
+    if(kind < 2) {
+        return H_SHRINK;
+    } else if(kind < 4) {
+        return H_LINEARISE;
+    } else if(kind < 8) {
+        return H_SPLICE;
+    } else if(kind < 12) {
+        return H_INSERT;
+    } else if(kind < 20) {
+        return H_RESERVE;
+    } else if(kind < 28) {
+        return H_RESERVE_FRONT;
+    } else if(kind < 48) {
+        return H_INDEX;
+    }
+
+    // Drift towards the target three times in four
+    int grow = length < target ? (r & 3) != 0 : (r & 3) == 0;
+    int bulk = (r & 12) == 0;
+    int front = (r & 16) != 0;
+
+    if(grow) {
+        return bulk ? (front ? H_UNSHIFT_N : H_PUSH_N) : (front ? H_UNSHIFT : H_PUSH);
+    }
+
+    return bulk ? (front ? H_SHIFT_N : H_POP_N) : (front ? H_SHIFT : H_POP);
+}
+
+// Run the workload in one mode and report it; returns 0 if every check passed
+static int stress_run(int mode, StressParams *params)
+{
+    Harness harness;
+    HarnessInput in = { NULL, 0, 0, params->seed ^ (0x9E3779B97F4A7C15u * (uint64_t)(mode + 1)) };
+    DArrayStats stats;
+
+    if(in.state == 0) {
+        in.state = 1;
+    }
+
+    int rc = harness_init(&harness, mode, params->max_pool_size, params->expand_rate, params->max_count);
+    if(rc != 0) {
+        fprintf(stderr, "Failed to create %s DArray (%#04x)\n", harness_mode_names[mode], rc);
+        harness_destroy(&harness);
+        return -1;
+    }
+
+    DArray_stats_reset();
+    size_t target = 0;
+    size_t peak = 0;
+    char *failure = NULL;
+
+    uint64_t start = stress_now();
+    for(uint64_t step = 0; step < params->steps && failure == NULL; step++) {
+        // Every 64K steps, aim for a new length, spread evenly over the powers of two below max_size
+        if(step % 65536 == 0) {
+            target = (size_t)(params->max_size >> (harness_rand(&in.state) % 24));
+        }
+
+        int op = stress_pick(harness_rand(&in.state), harness.model.length, target);
+        failure = harness_step(&harness, op, &in);
+
+        if(harness.model.length > peak) {
+            peak = harness.model.length;
+        }
+    }
+    if(failure == NULL) {
+        failure = harness_check_all(&harness);
+    }
+    uint64_t elapsed = stress_now() - start;
+
+    DArray_stats(&stats);
+
+    if(failure != NULL) {
+        fprintf(stderr, "FAILED with seed %llu: %s\n", (unsigned long long)params->seed, failure);
+        harness_destroy(&harness);
+        return -1;
+    }
+
+    double seconds = (double)elapsed / 1e9;
+    printf("%s,%llu,%llu,%zu,%.3f,%.0f,%.0f", harness_mode_names[mode], (unsigned long long)harness.steps,
+            (unsigned long long)harness.values, peak, seconds, seconds > 0 ? (double)harness.steps / seconds : 0.0,
+            seconds > 0 ? (double)harness.values / seconds : 0.0);
+    if(DArray_stats_enabled()) {
+        printf(",%llu,%llu,%llu,%llu,%llu\n", (unsigned long long)stats.counters[DA_STAT_BYTES_COPIED],
+                (unsigned long long)stats.counters[DA_STAT_BYTES_MOVED], (unsigned long long)stats.counters[DA_STAT_EXPAND],
+                (unsigned long long)stats.counters[DA_STAT_POOL_REBUILD], (unsigned long long)stats.counters[DA_STAT_POOL_SHRINK]);
+    } else {
+        printf(",,,,,\n");
+    }
+    fflush(stdout);
+
+    harness_destroy(&harness);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    StressParams params;
+    int failed = 0;
+
+    stress_args(argc, argv, &params);
+    if(!DArray_stats_enabled()) {
+        fprintf(stderr, "Built without DARRAY_STATS; copy volume is not reported\n");
+    }
+
+    printf("mode,steps,values,peak_length,seconds,steps_per_sec,values_per_sec,bytes_copied,bytes_moved,expands,pool_rebuilds,pool_shrinks\n");
+    for(int mode = 0; mode < H_MODE_COUNT; mode++) {
+        if(params.mode < 0 || params.mode == mode) {
+            failed |= stress_run(mode, &params) != 0;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,487 @@
+#define _GNU_SOURCE
+
+#include "allocator.h"
+#include "darray.h"
+#include "dbg.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define ALIGNMENT 16
+#define ALIGN_UP(n, a) (((n) + ((a) - 1)) & ~((size_t)(a) - 1))
+
+void Allocator_destroy(Allocator *allocator)
+{
+    if(allocator != NULL && allocator->destroy != NULL) {
+        allocator->destroy(allocator);
+    }
+}
+
+/*
+ * Arena
+ */
+
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;            // Usable bytes after the header
+    size_t used;
+} ArenaBlock;
+
+#define ARENA_HEADER ALIGN_UP(sizeof(ArenaBlock), ALIGNMENT)
+
+typedef struct Arena {
+    Allocator allocator;
+    ArenaBlock *head;       // Block currently being carved up
+    size_t block_size;
+    void *last;             // Most recent allocation, which can still be resized or freed
+} Arena;
+
+static inline unsigned char *arena_data(ArenaBlock *block)
+{
+    return (unsigned char *)block + ARENA_HEADER;
+}
+
+static void *arena_alloc(void *ctx, size_t size)
+{
+    Arena *arena = ctx;
+    size_t needed = ALIGN_UP(size > 0 ? size : 1, ALIGNMENT);
+    ArenaBlock *block = arena->head;
+
+    if(block == NULL || block->used + needed > block->size) {
+        size_t usable = needed > arena->block_size ? needed : arena->block_size;
+        ArenaBlock *fresh = malloc(ARENA_HEADER + usable);
+        if(fresh == NULL) {
+            return NULL;
+        }
+
+        fresh->size = usable;
+        fresh->used = 0;
+
+        // An oversized block is used up by this request; keep carving the current block after it
+        if(block != NULL && usable > arena->block_size) {
+            fresh->next = block->next;
+            block->next = fresh;
+            fresh->used = needed;
+            arena->last = NULL;
+            return arena_data(fresh);
+        }
+
+        fresh->next = block;
+        arena->head = fresh;
+        block = fresh;
+    }
+
+    void *ptr = arena_data(block) + block->used;
+    block->used += needed;
+    arena->last = ptr;
+
+    return ptr;
+}
+
+static void *arena_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    Arena *arena = ctx;
+
+    // The latest allocation can grow or shrink in place while its block has room
+    if(ptr != NULL && ptr == arena->last) {
+        ArenaBlock *block = arena->head;
+        size_t offset = (size_t)((unsigned char *)ptr - arena_data(block));
+        size_t needed = ALIGN_UP(new_size > 0 ? new_size : 1, ALIGNMENT);
+
+        if(offset + needed <= block->size) {
+            block->used = offset + needed;
+            return ptr;
+        }
+    }
+
+    void *fresh = arena_alloc(ctx, new_size);
+    if(fresh != NULL && ptr != NULL) {
+        memcpy(fresh, ptr, old_size < new_size ? old_size : new_size);
+    }
+
+    return fresh;
+}
+
+static void arena_free(void *ctx, void *ptr, size_t size)
+{
+    Arena *arena = ctx;
+    (void)size;
+
+    if(ptr != NULL && ptr == arena->last) {
+        arena->head->used = (size_t)((unsigned char *)ptr - arena_data(arena->head));
+        arena->last = NULL;
+    }
+}
+
+static void arena_destroy(Allocator *allocator)
+{
+    Arena *arena = allocator->ctx;
+    ArenaBlock *block = arena->head;
+
+    while(block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
+Allocator *Allocator_arena(size_t block_size, int *res)
+{
+    Arena *arena = malloc(sizeof(Arena));
+    check_mem(arena);
+
+    arena->head = NULL;
+    arena->block_size = block_size > 0 ? ALIGN_UP(block_size, ALIGNMENT) : ARENA_DEFAULT_BLOCK;
+    arena->last = NULL;
+    arena->allocator.alloc = arena_alloc;
+    arena->allocator.realloc = arena_realloc;
+    arena->allocator.free = arena_free;
+    arena->allocator.destroy = arena_destroy;
+    arena->allocator.ctx = arena;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return &arena->allocator;
+
+error:
+    if(res != NULL) {
+        *res = DA_ERR_MEMORY;
+    }
+
+    return NULL;
+}
+
+void Allocator_arena_reset(Allocator *allocator)
+{
+    if(allocator == NULL || allocator->destroy != arena_destroy) {
+        return;
+    }
+
+    Arena *arena = allocator->ctx;
+    if(arena->head == NULL) {
+        return;
+    }
+
+    ArenaBlock *block = arena->head->next;
+    while(block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->head->next = NULL;
+    arena->head->used = 0;
+    arena->last = NULL;
+}
+
+/*
+ * Size-class pool
+ */
+
+#define POOL_MIN_SHIFT 4    // 16 bytes
+#define POOL_MAX_SHIFT 20   // 1MiB
+#define POOL_CLASSES (POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+
+// Header before every block the pool hands out, linking it into Pool.blocks so destroy can
+// release blocks which were never freed; 16 bytes, so blocks keep malloc's alignment
+typedef struct PoolBlock {
+    struct PoolBlock *prev;
+    struct PoolBlock *next;
+} PoolBlock;
+
+#define POOL_HEADER ALIGN_UP(sizeof(PoolBlock), ALIGNMENT)
+
+typedef struct PoolFree {
+    struct PoolFree *next;
+} PoolFree;
+
+typedef struct Pool {
+    Allocator allocator;
+    PoolFree *free_lists[POOL_CLASSES];
+    PoolBlock *blocks;      // Every block from malloc not yet given back to it, live or free
+} Pool;
+
+// Size class for a request, or -1 if it is too large to pool
+static inline int pool_class(size_t size)
+{
+    if(size > ((size_t)1 << POOL_MAX_SHIFT)) {
+        return -1;
+    }
+
+    int class = 0;
+    while(((size_t)1 << (class + POOL_MIN_SHIFT)) < size) {
+        class++;
+    }
+
+    return class;
+}
+
+static inline void pool_link(Pool *pool, PoolBlock *block)
+{
+    block->prev = NULL;
+    block->next = pool->blocks;
+    if(pool->blocks != NULL) {
+        pool->blocks->prev = block;
+    }
+    pool->blocks = block;
+}
+
+static inline void pool_unlink(Pool *pool, PoolBlock *block)
+{
+    if(block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        pool->blocks = block->next;
+    }
+    if(block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+}
+
+// Allocate a block of size bytes from malloc and track it
+static void *pool_malloc(Pool *pool, size_t size)
+{
+    if(size > SIZE_MAX - POOL_HEADER) {
+        return NULL;
+    }
+
+    PoolBlock *block = malloc(POOL_HEADER + size);
+    if(block == NULL) {
+        return NULL;
+    }
+    pool_link(pool, block);
+
+    return (char *)block + POOL_HEADER;
+}
+
+static inline PoolBlock *pool_block(void *ptr)
+{
+    return (PoolBlock *)(void *)((char *)ptr - POOL_HEADER);
+}
+
+static void *pool_alloc(void *ctx, size_t size)
+{
+    Pool *pool = ctx;
+    int class = pool_class(size);
+
+    if(class < 0) {
+        return pool_malloc(pool, size);
+    }
+
+    PoolFree *block = pool->free_lists[class];
+    if(block != NULL) {
+        pool->free_lists[class] = block->next;
+        return block;
+    }
+
+    return pool_malloc(pool, (size_t)1 << (class + POOL_MIN_SHIFT));
+}
+
+static void pool_free(void *ctx, void *ptr, size_t size)
+{
+    Pool *pool = ctx;
+    int class = pool_class(size);
+
+    if(class < 0) {
+        PoolBlock *header = pool_block(ptr);
+        pool_unlink(pool, header);
+        free(header);
+        return;
+    }
+
+    PoolFree *block = ptr;
+    block->next = pool->free_lists[class];
+    pool->free_lists[class] = block;
+}
+
+static void *pool_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    int old_class = pool_class(old_size);
+    int new_class = pool_class(new_size);
+
+    if(ptr == NULL) {
+        return pool_alloc(ctx, new_size);
+    }
+    if(old_class >= 0 && old_class == new_class) {
+        return ptr;
+    }
+    if(old_class < 0 && new_class < 0) {
+        Pool *pool = ctx;
+        PoolBlock *header = pool_block(ptr);
+
+        // realloc may move the header, so relink whichever block survives
+        pool_unlink(pool, header);
+        PoolBlock *fresh = new_size <= SIZE_MAX - POOL_HEADER ? realloc(header, POOL_HEADER + new_size) : NULL;
+        pool_link(pool, fresh != NULL ? fresh : header);
+
+        return fresh != NULL ? (char *)fresh + POOL_HEADER : NULL;
+    }
+
+    void *fresh = pool_alloc(ctx, new_size);
+    if(fresh != NULL) {
+        memcpy(fresh, ptr, old_size < new_size ? old_size : new_size);
+        pool_free(ctx, ptr, old_size);
+    }
+
+    return fresh;
+}
+
+static void pool_destroy(Allocator *allocator)
+{
+    Pool *pool = allocator->ctx;
+
+    // Free-listed blocks are still on the block list, so this releases them too
+    PoolBlock *block = pool->blocks;
+    while(block != NULL) {
+        PoolBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(pool);
+}
+
+Allocator *Allocator_pool(int *res)
+{
+    Pool *pool = calloc(1, sizeof(Pool));
+    check_mem(pool);
+
+    pool->allocator.alloc = pool_alloc;
+    pool->allocator.realloc = pool_realloc;
+    pool->allocator.free = pool_free;
+    pool->allocator.destroy = pool_destroy;
+    pool->allocator.ctx = pool;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return &pool->allocator;
+
+error:
+    if(res != NULL) {
+        *res = DA_ERR_MEMORY;
+    }
+
+    return NULL;
+}
+
+/*
+ * Huge pages
+ */
+
+#define HUGE_DEFAULT_PAGE (2 * 1024 * 1024)
+
+typedef struct Huge {
+    Allocator allocator;
+    size_t page_size;
+} Huge;
+
+static void *huge_map(size_t length)
+{
+    void *ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    // No reserved huge pages; ask for transparent ones instead
+    if(ptr == MAP_FAILED) {
+        ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(ptr == MAP_FAILED) {
+            return NULL;
+        }
+
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+    }
+
+    return ptr;
+}
+
+static void *huge_alloc(void *ctx, size_t size)
+{
+    Huge *huge = ctx;
+
+    return huge_map(ALIGN_UP(size > 0 ? size : 1, huge->page_size));
+}
+
+static void huge_free(void *ctx, void *ptr, size_t size)
+{
+    Huge *huge = ctx;
+
+    munmap(ptr, ALIGN_UP(size > 0 ? size : 1, huge->page_size));
+}
+
+static void *huge_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    Huge *huge = ctx;
+    size_t old_length = ALIGN_UP(old_size > 0 ? old_size : 1, huge->page_size);
+    size_t new_length = ALIGN_UP(new_size > 0 ? new_size : 1, huge->page_size);
+
+    if(ptr == NULL) {
+        return huge_map(new_length);
+    }
+    if(old_length == new_length) {
+        return ptr;
+    }
+
+#ifdef MREMAP_MAYMOVE
+    void *moved = mremap(ptr, old_length, new_length, MREMAP_MAYMOVE);
+    if(moved != MAP_FAILED) {
+        return moved;
+    }
+#endif
+
+    void *fresh = huge_map(new_length);
+    if(fresh != NULL) {
+        memcpy(fresh, ptr, old_size < new_size ? old_size : new_size);
+        munmap(ptr, old_length);
+    }
+
+    return fresh;
+}
+
+static void huge_destroy(Allocator *allocator)
+{
+    free(allocator->ctx);
+}
+
+Allocator *Allocator_huge(size_t page_size, int *res)
+{
+    Huge *huge = NULL;
+    int err = 0;
+
+    check_err(page_size == 0 || (page_size & (page_size - 1)) == 0, err, DA_ERR_ARGS, "Page size %zu not a power of 2", page_size);
+
+    huge = malloc(sizeof(Huge));
+    check_err(huge != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    huge->page_size = page_size > 0 ? page_size : HUGE_DEFAULT_PAGE;
+    huge->allocator.alloc = huge_alloc;
+    huge->allocator.realloc = huge_realloc;
+    huge->allocator.free = huge_free;
+    huge->allocator.destroy = huge_destroy;
+    huge->allocator.ctx = huge;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return &huge->allocator;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file allocator.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for pluggable allocators
+ *
+ * An `Allocator` is a table of allocation functions and a context pointer. Containers which
+ * accept one make all allocations for their headers and backing stores through it; a `NULL`
+ * allocator means `malloc`, `realloc` and `free`.
+ */
+
+#ifndef Allocator_h
+#define Allocator_h
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * @brief Allocator function table
+ *
+ * Sizes are passed back to `realloc` and `free`, so allocators do not need to track them;
+ * callers must pass the size the block was last allocated with.
+ */
+typedef struct Allocator {
+    void *(*alloc)(void *ctx, size_t size);                                     ///< Allocate `size` bytes, or return `NULL`
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);   ///< Resize a block, or return `NULL` and leave it intact
+    void (*free)(void *ctx, void *ptr, size_t size);                            ///< Release a block
+    void (*destroy)(struct Allocator *allocator);                               ///< Release the allocator itself; may be `NULL`
+    void *ctx;                                                                  ///< Backend state passed to each function
+} Allocator;
+
+/**
+ * @brief Allocate memory through an allocator
+ *
+ * @param allocator Allocator to use; `NULL` for `malloc`
+ * @param size Number of bytes
+ *
+ * @return New block, or `NULL` on failure
+ */
+static inline void *Allocator_alloc(Allocator *allocator, size_t size)
+{
+    return allocator == NULL ? malloc(size) : allocator->alloc(allocator->ctx, size);
+}
+
+/**
+ * @brief Resize memory through an allocator
+ *
+ * @param allocator Allocator the block came from; `NULL` for `realloc`
+ * @param ptr Block to resize
+ * @param old_size Current size of the block
+ * @param new_size Size required
+ *
+ * @return Resized block, or `NULL` on failure, in which case `ptr` is untouched
+ */
+static inline void *Allocator_realloc(Allocator *allocator, void *ptr, size_t old_size, size_t new_size)
+{
+    return allocator == NULL ? realloc(ptr, new_size) : allocator->realloc(allocator->ctx, ptr, old_size, new_size);
+}
+
+/**
+ * @brief Free memory through an allocator
+ *
+ * @param allocator Allocator the block came from; `NULL` for `free`
+ * @param ptr Block to free; may be `NULL`
+ * @param size Size of the block
+ */
+static inline void Allocator_free(Allocator *allocator, void *ptr, size_t size)
+{
+    if(ptr == NULL) {
+        return;
+    }
+
+    if(allocator == NULL) {
+        free(ptr);
+    } else {
+        allocator->free(allocator->ctx, ptr, size);
+    }
+}
+
+/**
+ * @brief Destroy an allocator created by one of the functions below
+ *
+ * Any memory still allocated from an arena or pool allocator is released with it.
+ *
+ * @param allocator Allocator to destroy
+ */
+void Allocator_destroy(Allocator *allocator);
+
+/**
+ * @brief Create a bump-pointer arena allocator
+ *
+ * Allocations are carved sequentially out of blocks of `block_size` bytes (larger requests get
+ * a block of their own), aligned to 16 bytes. `free` only reclaims the most recent allocation,
+ * and `realloc` extends the most recent allocation in place where it can; everything else is
+ * released at once by `Allocator_arena_reset` or `Allocator_destroy`. Not thread-safe.
+ *
+ * @param block_size Size of each arena block; 0 for a default of 64KiB
+ * @param [out] res Result; 0 on success, otherwise `DA_ERR_MEMORY`
+ *
+ * @return New allocator on success, otherwise `NULL`
+ */
+Allocator *Allocator_arena(size_t block_size, int *res);
+
+/**
+ * @brief Release every allocation made from an arena, keeping its first block for reuse
+ *
+ * @param allocator Arena allocator from `Allocator_arena`
+ */
+void Allocator_arena_reset(Allocator *allocator);
+
+/**
+ * @brief Create a size-class pool allocator
+ *
+ * Requests up to 1MiB are rounded up to a power of two and freed blocks are kept on a free
+ * list for their size class, so containers of similar sizes recycle each other's memory
+ * without returning to `malloc`. Larger requests go straight to `malloc`. Every block carries
+ * a 16 byte header tracking it, so `Allocator_destroy` releases blocks never freed. Not
+ * thread-safe.
+ *
+ * @param [out] res Result; 0 on success, otherwise `DA_ERR_MEMORY`
+ *
+ * @return New allocator on success, otherwise `NULL`
+ */
+Allocator *Allocator_pool(int *res);
+
+/**
+ * @brief Create an `mmap`-backed allocator using huge pages
+ *
+ * Every allocation is its own mapping, rounded up to `page_size`. Mappings use `MAP_HUGETLB`
+ * where the system has huge pages reserved, and otherwise fall back to regular pages with
+ * transparent huge pages requested through `madvise`. On Linux `realloc` uses `mremap`, so
+ * growing a block does not copy it. Suitable for very large backing stores only.
+ *
+ * @param page_size Huge page size; must be a power of 2, or 0 for a default of 2MiB
+ * @param [out] res Result; 0 on success, otherwise `DA_ERR_ARGS` or `DA_ERR_MEMORY`
+ *
+ * @return New allocator on success, otherwise `NULL`
+ */
+Allocator *Allocator_huge(size_t page_size, int *res);
+
+#endif
@@ -0,0 +1,272 @@
+#include "cdarray.h"
+#include "dbg.h"
+
+#include <sched.h>
+#include <stdlib.h>
+
+// Allocate an empty store; all slots start NULL
+static CDStore *cd_store_alloc(uint32_t size)
+{
+    CDStore *store = calloc(1, sizeof(CDStore) + (size_t)size * sizeof(_Atomic(void *)));
+    if(store != NULL) {
+        store->size = size;
+    }
+
+    return store;
+}
+
+CDArray *CDArray_init(uint32_t length, double expand_rate, int *res)
+{
+    CDArray *cdarray = NULL;
+    CDStore *store = NULL;
+    int err = 0;
+
+    check_err(length > 0, err, DA_ERR_ARGS | DA_INIT_LENGTH, "Invalid length: %u", length);
+    check_err(expand_rate > 1, err, DA_ERR_ARGS | DA_INIT_EXPAND_RATE, "Invalid expand_rate: %f", expand_rate);
+
+    cdarray = aligned_alloc(CDARRAY_CACHE_LINE, sizeof(CDArray));
+    check_err(cdarray != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    store = cd_store_alloc(length);
+    check_err(store != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    check_err(pthread_mutex_init(&cdarray->grow_lock, NULL) == 0, err, DA_ERR_MEMORY, "Failed to create CDArray lock");
+    if(pthread_cond_init(&cdarray->grown, NULL) != 0) {
+        pthread_mutex_destroy(&cdarray->grow_lock);
+        err = DA_ERR_MEMORY;
+        sentinel("Failed to create CDArray condition");
+    }
+
+    atomic_init(&cdarray->store, store);
+    atomic_init(&cdarray->size, length);
+    atomic_init(&cdarray->reserved, 0);
+    atomic_init(&cdarray->epoch, 1);
+    cdarray->expand_rate = expand_rate;
+    atomic_init(&cdarray->full, 0);
+    cdarray->growing = 0;
+    cdarray->retired = NULL;
+
+    for(int i = 0; i < CDARRAY_MAX_READERS; i++) {
+        atomic_init(&cdarray->readers[i].epoch, 0);
+        atomic_init(&cdarray->readers[i].registered, 0);
+        cdarray->readers[i].cdarray = cdarray;
+    }
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return cdarray;
+
+error:
+    free(store);
+    free(cdarray);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void CDArray_destroy(CDArray *cdarray)
+{
+    if(cdarray == NULL) {
+        return;
+    }
+
+    CDStore *store = cdarray->retired;
+    while(store != NULL) {
+        CDStore *next = store->next_retired;
+        free(store);
+        store = next;
+    }
+
+    free(atomic_load_explicit(&cdarray->store, memory_order_relaxed));
+    pthread_cond_destroy(&cdarray->grown);
+    pthread_mutex_destroy(&cdarray->grow_lock);
+    free(cdarray);
+}
+
+CDReader *CDArray_reader_register(CDArray *cdarray, int *res)
+{
+    for(int i = 0; i < CDARRAY_MAX_READERS; i++) {
+        int expected = 0;
+        if(atomic_compare_exchange_strong(&cdarray->readers[i].registered, &expected, 1)) {
+            if(res != NULL) {
+                *res = 0;
+            }
+            return &cdarray->readers[i];
+        }
+    }
+
+    if(res != NULL) {
+        *res = DA_ERR_MEMORY | CD_READER_LIMIT;
+    }
+
+    return NULL;
+}
+
+void CDArray_reader_unregister(CDReader *reader)
+{
+    if(reader != NULL) {
+        atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+        atomic_store_explicit(&reader->registered, 0, memory_order_release);
+    }
+}
+
+void CDArray_read_begin(CDReader *reader)
+{
+    // Sequentially consistent, so the pin is ordered before any load of the store: a grower
+    // which misses the pin has already published its new store
+    uint64_t epoch = atomic_load(&reader->cdarray->epoch);
+    atomic_store(&reader->epoch, epoch);
+}
+
+void CDArray_read_end(CDReader *reader)
+{
+    atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
+
+void *CDArray_index(CDArray *cdarray, uint32_t index)
+{
+    CDStore *store = atomic_load(&cdarray->store);
+
+    if(index >= store->size) {
+        return NULL;
+    }
+
+    return atomic_load_explicit(&store->items[index], memory_order_acquire);
+}
+
+uint32_t CDArray_length(CDArray *cdarray)
+{
+    uint64_t reserved = atomic_load_explicit(&cdarray->reserved, memory_order_acquire);
+
+    // Reservations past the end of a store which can no longer grow never land
+    if(atomic_load_explicit(&cdarray->full, memory_order_acquire)) {
+        uint32_t size = atomic_load_explicit(&cdarray->size, memory_order_acquire);
+        reserved = reserved < size ? reserved : size;
+    }
+
+    return reserved < UINT32_MAX ? (uint32_t)reserved : UINT32_MAX;
+}
+
+// Free retired stores older than every pinned epoch; caller holds grow_lock
+static void cd_reclaim_locked(CDArray *cdarray)
+{
+    uint64_t oldest = UINT64_MAX;
+    for(int i = 0; i < CDARRAY_MAX_READERS; i++) {
+        uint64_t epoch = atomic_load(&cdarray->readers[i].epoch);
+        if(epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    CDStore **link = &cdarray->retired;
+    while(*link != NULL) {
+        CDStore *store = *link;
+        if(store->retire_epoch < oldest) {
+            *link = store->next_retired;
+            free(store);
+        } else {
+            link = &store->next_retired;
+        }
+    }
+}
+
+void CDArray_reclaim(CDArray *cdarray)
+{
+    pthread_mutex_lock(&cdarray->grow_lock);
+    cd_reclaim_locked(cdarray);
+    pthread_mutex_unlock(&cdarray->grow_lock);
+}
+
+// Grow the store until it holds index; caller holds grow_lock
+static int cd_grow_locked(CDArray *cdarray, uint64_t index)
+{
+    int err = 0;
+    CDStore *old = atomic_load_explicit(&cdarray->store, memory_order_relaxed);
+
+    while(index >= old->size) {
+        if(cdarray->growing) {
+            pthread_cond_wait(&cdarray->grown, &cdarray->grow_lock);
+            old = atomic_load_explicit(&cdarray->store, memory_order_relaxed);
+            continue;
+        }
+
+        check_err(!atomic_load_explicit(&cdarray->full, memory_order_relaxed), err, DA_ERR_MEMORY | CD_PUSH_EXPAND, "CDArray can no longer grow");
+
+        double scaled = old->size * cdarray->expand_rate;
+        uint64_t new_size = scaled >= (double)UINT32_MAX ? UINT32_MAX : (uint64_t)scaled;
+        new_size = new_size > index ? new_size : index + 1;
+        new_size = new_size > old->size ? new_size : old->size + 1U;
+
+        CDStore *store = cd_store_alloc((uint32_t)new_size);
+        if(store == NULL) {
+            atomic_store_explicit(&cdarray->full, 1, memory_order_release);
+            pthread_cond_broadcast(&cdarray->grown);
+        }
+        check_err(store != NULL, err, DA_ERR_MEMORY | CD_PUSH_EXPAND, "Out of memory.");
+
+        // Every slot in the old store has been reserved; wait for the pushes writing them. Some of
+        // those may be queued on grow_lock after missing an earlier store, so let them through
+        cdarray->growing = 1;
+        for(uint32_t i = 0; i < old->size; i++) {
+            void *value;
+            while((value = atomic_load_explicit(&old->items[i], memory_order_acquire)) == NULL) {
+                pthread_mutex_unlock(&cdarray->grow_lock);
+                sched_yield();
+                pthread_mutex_lock(&cdarray->grow_lock);
+            }
+            atomic_init(&store->items[i], value);
+        }
+
+        atomic_store(&cdarray->store, store);
+        atomic_store(&cdarray->size, store->size);
+        old->retire_epoch = atomic_fetch_add(&cdarray->epoch, 1);
+        old->next_retired = cdarray->retired;
+        cdarray->retired = old;
+        cdarray->growing = 0;
+        pthread_cond_broadcast(&cdarray->grown);
+        old = store;
+    }
+
+    cd_reclaim_locked(cdarray);
+
+    return 0;
+
+error:
+    return err;
+}
+
+int CDArray_push(CDArray *cdarray, void *value)
+{
+    int err = 0;
+
+    check_err(cdarray != NULL && value != NULL, err, DA_ERR_ARGS, "NULL cdarray or value");
+
+    uint64_t index = atomic_fetch_add_explicit(&cdarray->reserved, 1, memory_order_relaxed);
+    check_err(index < UINT32_MAX, err, DA_ERR_MEMORY | CD_PUSH_LIMIT, "CDArray at maximum size");
+
+    // A store too small for this slot may be replaced and freed at any moment, as growth only
+    // waits for the slots it holds, so its size is read from the array rather than the store.
+    // The size is published after its store, so the store loaded next holds the slot, and
+    // can't be replaced before the slot is written
+    CDStore *store = NULL;
+    if(index < atomic_load(&cdarray->size)) {
+        store = atomic_load(&cdarray->store);
+    } else {
+        pthread_mutex_lock(&cdarray->grow_lock);
+        int rc = cd_grow_locked(cdarray, index);
+        store = atomic_load(&cdarray->store);
+        pthread_mutex_unlock(&cdarray->grow_lock);
+        check_err(rc == 0, err, rc, "Failed to expand CDArray for push");
+    }
+
+    atomic_store_explicit(&store->items[index], value, memory_order_release);
+
+    return 0;
+
+error:
+    return err;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file cdarray.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for CDArray implementation
+ *
+ */
+
+#ifndef CDArray_h
+#define CDArray_h
+
+#include "darray.h"
+#include "stdint.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * @brief Maximum number of readers which can be registered with a CDArray at once
+ */
+#ifndef CDARRAY_MAX_READERS
+#define CDARRAY_MAX_READERS 64
+#endif
+
+/**
+ * @brief Size of a cache line, used to keep reader epochs apart
+ */
+#ifndef CDARRAY_CACHE_LINE
+#define CDARRAY_CACHE_LINE 64
+#endif
+
+/**
+ * @brief Backing store of a CDArray
+ *
+ * Stores are never resized in place; growth copies the values into a larger store and retires
+ * the old one, which is freed once no reader can still be using it.
+ */
+typedef struct CDStore {
+    uint32_t size;                  ///< Number of slots
+    uint64_t retire_epoch;          ///< Epoch in which the store was replaced
+    struct CDStore *next_retired;   ///< Next store on the retired list
+    _Atomic(void *) items[];        ///< Slots; `NULL` until a push has written the slot
+} CDStore;
+
+/**
+ * @brief Registration of a reader thread with a CDArray
+ * @see CDArray_reader_register
+ */
+typedef struct CDReader {
+    _Alignas(CDARRAY_CACHE_LINE) _Atomic uint64_t epoch;   ///< Epoch pinned by the reader; 0 when not reading
+    _Atomic int registered;                                 ///< Non-0 while the slot belongs to a reader
+    struct CDArray *cdarray;                                ///< Array the reader is registered with
+} CDReader;
+
+/**
+ * @brief Concurrent append-only dynamic array
+ *
+ * A DArray variant for many threads pushing while many others read by index. Pushes reserve a
+ * slot with an atomic fetch-add and write it with a release store, so pushes only take a lock
+ * when the store must grow. Reads take no locks at all and never block.
+ *
+ * Growth allocates a larger store, waits for every push into the old store to land, copies the
+ * values across and publishes the new store with one atomic store; a reader therefore sees
+ * either the old store or the new one, never a partial copy. The old store is retired rather
+ * than freed, and is reclaimed once every registered reader has left the epoch it was retired in.
+ *
+ * Slots are `NULL` until the push that reserved them has written its value, so `NULL` values
+ * cannot be pushed, and a read of an index below `CDArray_length` may still return `NULL` while
+ * its push is in progress.
+ */
+typedef struct CDArray {
+    _Atomic(CDStore *) store;                   ///< Current backing store
+    _Atomic uint32_t size;                      ///< Number of slots in `store`; published after it
+    _Atomic uint64_t reserved;                  ///< Number of slots handed out to pushes
+    _Atomic uint64_t epoch;                     ///< Global epoch; advanced each time a store is retired
+    double expand_rate;                         ///< Expansion rate of the array
+    _Atomic int full;                           ///< Non-0 once growth has failed; no further growth is attempted
+    int growing;                                ///< Non-0 while a store is being grown; guarded by `grow_lock`
+    pthread_mutex_t grow_lock;                  ///< Serialises growth and reclamation
+    pthread_cond_t grown;                       ///< Signalled when growth finishes
+    CDStore *retired;                           ///< Retired stores not yet freed; guarded by `grow_lock`
+    CDReader readers[CDARRAY_MAX_READERS];      ///< Reader registrations
+} CDArray;
+
+/**
+ * @brief Initialise a CDArray
+ *
+ * @see darray_err_init for errors
+ *
+ * @param length Length of array to create
+ * @param expand_rate Expansion rate of array; suitable value 1.5; must be greater than 1
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New CDArray on success, otherwise `NULL`
+ */
+CDArray *CDArray_init(uint32_t length, double expand_rate, int *res);
+
+/**
+ * @brief Destroy a CDArray and free its memory
+ *
+ * No other thread may be using the array.
+ *
+ * @param cdarray CDArray to free
+ */
+void CDArray_destroy(CDArray *cdarray);
+
+/**
+ * @brief Register the calling thread as a reader of a CDArray
+ *
+ * @param cdarray CDArray to read from
+ * @param [out] res Result; 0 on success, otherwise `DA_ERR_MEMORY | CD_READER_LIMIT`
+ *
+ * @return Reader handle on success, otherwise `NULL`
+ */
+CDReader *CDArray_reader_register(CDArray *cdarray, int *res);
+
+/**
+ * @brief CDArray_reader_register errors
+ * @see CDArray_reader_register
+ */
+enum cdarray_err_reader {
+    CD_READER_LIMIT = 0x10  ///< `CDARRAY_MAX_READERS` readers already registered
+};
+
+/**
+ * @brief Release a reader registration
+ *
+ * @param reader Reader handle, which must not be in a read section
+ */
+void CDArray_reader_unregister(CDReader *reader);
+
+/**
+ * @brief Begin a read section
+ *
+ * Pins the current epoch, so no store the reader can load is freed until `CDArray_read_end`.
+ * Sections should be kept short, as they hold back reclamation of retired stores.
+ *
+ * @param reader Reader handle
+ */
+void CDArray_read_begin(CDReader *reader);
+
+/**
+ * @brief End a read section
+ *
+ * @param reader Reader handle
+ */
+void CDArray_read_end(CDReader *reader);
+
+/**
+ * @brief Get the value of a cdarray at an index
+ *
+ * Must be called inside a read section. Never blocks.
+ * Performance: `O(1)`
+ *
+ * @param cdarray CDArray to index into
+ * @param index Index of value to get
+ *
+ * @return Value at given index, or `NULL` if it does not exist or has not been written yet
+ */
+void *CDArray_index(CDArray *cdarray, uint32_t index);
+
+/**
+ * @brief Get the number of slots reserved in a cdarray
+ *
+ * @param cdarray CDArray
+ *
+ * @return Number of values pushed or being pushed
+ */
+uint32_t CDArray_length(CDArray *cdarray);
+
+/**
+ * @brief Push a value onto the end of a cdarray
+ *
+ * Safe to call from any number of threads at once.
+ * Best-case performance: `O(1)`<br>
+ * Worst-case performance: `O(1) + expansion` if array is full, which waits for pushes into the
+ * old store to complete
+ * @see cdarray_err_push for errors
+ *
+ * @param cdarray Array to push value onto
+ * @param value Value to push; must not be `NULL`
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int CDArray_push(CDArray *cdarray, void *value);
+
+/**
+ * @brief CDArray_push errors
+ * @see CDArray_push
+ */
+enum cdarray_err_push {
+    CD_PUSH_EXPAND  = 0x10, ///< Backing store could not be grown; the array no longer grows
+    CD_PUSH_LIMIT   = 0x20  ///< Array at maximum size
+};
+
+/**
+ * @brief Free retired stores which no reader can still be using
+ *
+ * Called automatically on growth; call explicitly to release memory sooner.
+ *
+ * @param cdarray CDArray
+ */
+void CDArray_reclaim(CDArray *cdarray);
+
+#endif
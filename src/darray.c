@@ -0,0 +1,1328 @@
+#define _GNU_SOURCE
+
+#include "darray.h"
+#include "darray_stats_internal.h"
+#include "darray_sort.h"
+#include "dbg.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define DA_COMPARE_LESS(a, b, compare) ((compare)((a), (b)) < 0)
+
+DARRAY_SORT_DEFINE(darray_sort_generic, void *, DArray_compare, DA_COMPARE_LESS)
+
+// Inline slots of a small array start on the line after the header
+_Static_assert(sizeof(DArray) <= 64, "DArray header must fit in a cache line");
+
+// Convert a ratio to fixed point, saturating
+static inline uint32_t da_fixed(double ratio)
+{
+    return ratio * DA_FIXED_ONE >= (double)UINT32_MAX ? UINT32_MAX : DA_FIXED(ratio);
+}
+
+// n scaled by a fixed-point ratio, rounded down and saturating at DARRAY_SIZE_MAX; split so the
+// products fit in 64 bits for either size of DArraySize
+static inline DArraySize da_scale(DArraySize n, uint32_t fixed)
+{
+    uint64_t whole = (uint64_t)(n >> DA_FIXED_SHIFT);
+    uint64_t part = ((uint64_t)(n & (DA_FIXED_ONE - 1)) * fixed) >> DA_FIXED_SHIFT;
+
+    if(fixed > 0 && whole > (DARRAY_SIZE_MAX - part) / fixed) {
+        return DARRAY_SIZE_MAX;
+    }
+
+    return (DArraySize)(whole * fixed + part);
+}
+
+// Whether a size computed in 64 bits fits in a DArraySize; with DARRAY_64 memory runs out long
+// before the sizes used here could overflow
+static inline int da_fits(uint64_t size)
+{
+#ifdef DARRAY_64
+    (void)size;
+    return 1;
+#else
+    return size <= UINT32_MAX;
+#endif
+}
+
+// Position in the backing store of the value at index; index may be up to length
+static inline DArraySize da_slot(const DArray *darray, DArraySize index)
+{
+    uint64_t slot = (uint64_t)darray->start_index + index;
+
+    if((darray->flags & DA_FLAG_RING) && slot >= darray->store_size) {
+        slot -= darray->store_size;
+    }
+
+    return (DArraySize)slot;
+}
+
+// Bytes allocated for the header of darray, including any inline slots
+static inline size_t da_header_size(const DArray *darray)
+{
+    return sizeof(DArray) + ((darray->flags & DA_FLAG_SMALL) ? DARRAY_SMALL_SLOTS * sizeof(void *) : 0);
+}
+
+// Slots the pool may reach before shift shrinks it
+static inline DArraySize da_pool_limit(const DArray *darray)
+{
+    return da_scale(darray->store_size, darray->max_pool_size);
+}
+
+#ifdef __linux__
+// Bytes mapped for a mapped backing store of size slots
+static inline size_t da_map_length(DArraySize size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    return ((size_t)size * sizeof(void *) + page - 1) & ~(page - 1);
+}
+#endif
+
+// Reallocate the backing store to new_size slots without initialising anything; once the store
+// reaches map_threshold it is moved into an anonymous mapping, which mremap can then resize by
+// remapping pages instead of copying them
+static void **da_store_realloc(DArray *darray, DArraySize new_size)
+{
+    size_t old_bytes = (size_t)darray->store_size * sizeof(void *);
+    size_t new_bytes = (size_t)new_size * sizeof(void *);
+
+    // A borrowed store can't be reallocated, so move to one of the array's own
+    if(darray->flags & DA_FLAG_BORROWED) {
+        void **items = Allocator_alloc(darray->allocator, new_bytes);
+        if(items != NULL) {
+            memcpy(items, darray->items, old_bytes < new_bytes ? old_bytes : new_bytes);
+            darray->flags &= ~(uint32_t)DA_FLAG_BORROWED;
+            DA_STAT_ADD(DA_STAT_REALLOC, 1);
+            DA_STAT_ADD(DA_STAT_REALLOC_MOVED, 1);
+            DA_STAT_ADD(DA_STAT_BYTES_COPIED, old_bytes < new_bytes ? old_bytes : new_bytes);
+        }
+        return items;
+    }
+
+#ifdef __linux__
+    if(darray->flags & DA_FLAG_MAPPED) {
+        void *items = mremap(darray->items, da_map_length(darray->store_size), da_map_length(new_size), MREMAP_MAYMOVE);
+        DA_STAT_ADD(DA_STAT_MREMAP, 1);
+        return items == MAP_FAILED ? NULL : items;
+    }
+
+    if(darray->allocator == NULL && darray->map_threshold > 0 && new_size >= darray->map_threshold && new_size > darray->store_size) {
+        void *items = mmap(NULL, da_map_length(new_size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        // On failure carry on with realloc, and try again at the next expansion
+        if(items != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(items, da_map_length(new_size), MADV_HUGEPAGE);
+#endif
+            memcpy(items, darray->items, old_bytes);
+            free(darray->items);
+            DA_STAT_ADD(DA_STAT_REALLOC, 1);
+            DA_STAT_ADD(DA_STAT_REALLOC_MOVED, 1);
+            DA_STAT_ADD(DA_STAT_BYTES_COPIED, old_bytes);
+            darray->flags |= DA_FLAG_MAPPED;
+            return items;
+        }
+    }
+#endif
+
+    void **items = Allocator_realloc(darray->allocator, darray->items, old_bytes, new_bytes);
+
+#ifdef DARRAY_STATS
+    DA_STAT_ADD(DA_STAT_REALLOC, 1);
+    if(items != NULL && items != darray->items) {
+        DA_STAT_ADD(DA_STAT_REALLOC_MOVED, 1);
+        DA_STAT_ADD(DA_STAT_BYTES_COPIED, old_bytes < new_bytes ? old_bytes : new_bytes);
+    }
+#endif
+
+    return items;
+}
+
+// Free the backing store, if the array owns it
+static void da_store_free(DArray *darray)
+{
+#ifdef __linux__
+    if(darray->flags & DA_FLAG_MAPPED) {
+        munmap(darray->items, da_map_length(darray->store_size));
+        darray->flags &= ~(uint32_t)DA_FLAG_MAPPED;
+        darray->items = NULL;
+    }
+#endif
+
+    if(!(darray->flags & DA_FLAG_BORROWED)) {
+        Allocator_free(darray->allocator, darray->items, (size_t)darray->store_size * sizeof(void *));
+    }
+}
+
+DArray *DArray_init_with_allocator(DArraySize length, double max_pool_size, double expand_rate, DArraySize pool_size, uint32_t flags, Allocator *allocator, int *res)
+{
+    DArray *darray = NULL;
+    int err = 0;
+
+    check_err(length > 0, err, DA_ERR_ARGS | DA_INIT_LENGTH, "Invalid length: %" PRIuDA, length);
+    check_err(max_pool_size >= 0 && max_pool_size <= 1, err, DA_ERR_ARGS | DA_INIT_M_POOL_SIZE, "Invalid max_pool_size: %f", max_pool_size);
+    check_err(expand_rate > 1, err, DA_ERR_ARGS | DA_INIT_EXPAND_RATE, "Invalid expand_rate: %f", expand_rate);
+    check_err(pool_size < length, err, DA_ERR_ARGS | DA_INIT_POOL_SIZE, "Invalid pool_size: %" PRIuDA, pool_size);
+    check_err((flags & ~(uint32_t)DA_FLAG_RING) == 0, err, DA_ERR_ARGS | DA_INIT_FLAGS, "Invalid flags: %#x", flags);
+
+    darray = Allocator_alloc(allocator, sizeof(DArray));
+    check_err(darray != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    darray->items = Allocator_alloc(allocator, (size_t)length * sizeof(void *));
+    check_err(darray->items != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+    memset(darray->items, 0, (size_t)length * sizeof(void *));
+
+    darray->length = 0;
+    darray->store_size = length;
+    darray->start_index = pool_size;
+    darray->flags = flags;
+    darray->map_threshold = DARRAY_MAP_THRESHOLD;
+    darray->expand_rate = da_fixed(expand_rate);
+    darray->max_pool_size = da_fixed(max_pool_size);
+    darray->allocator = allocator;
+    darray->tuning = NULL;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return darray;
+
+error:
+    Allocator_free(allocator, darray, sizeof(DArray));
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+DArray *DArray_init_with_pool(DArraySize length, double max_pool_size, double expand_rate, DArraySize pool_size, int *res)
+{
+    return DArray_init_with_allocator(length, max_pool_size, expand_rate, pool_size, 0, NULL, res);
+}
+
+DArray *DArray_init_ring(DArraySize length, double expand_rate, int *res)
+{
+    return DArray_init_with_allocator(length, 0.0, expand_rate, 0, DA_FLAG_RING, NULL, res);
+}
+
+DArray *DArray_from_buffer(void **items, DArraySize length, DArraySize store_size, double max_pool_size, double expand_rate, uint32_t flags, Allocator *allocator, int *res)
+{
+    DArray *darray = NULL;
+    int err = 0;
+
+    check_err(items != NULL, err, DA_ERR_ARGS | DA_INIT_ITEMS, "NULL items");
+    check_err(store_size > 0 && store_size >= length, err, DA_ERR_ARGS | DA_INIT_STORE_SIZE, "Invalid store_size: %" PRIuDA, store_size);
+    check_err(max_pool_size >= 0 && max_pool_size <= 1, err, DA_ERR_ARGS | DA_INIT_M_POOL_SIZE, "Invalid max_pool_size: %f", max_pool_size);
+    check_err(expand_rate > 1, err, DA_ERR_ARGS | DA_INIT_EXPAND_RATE, "Invalid expand_rate: %f", expand_rate);
+    check_err((flags & ~(uint32_t)(DA_FLAG_RING | DA_FLAG_BORROWED)) == 0, err, DA_ERR_ARGS | DA_INIT_FLAGS, "Invalid flags: %#x", flags);
+
+    darray = Allocator_alloc(allocator, sizeof(DArray));
+    check_err(darray != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    memset(items + length, 0, (size_t)(store_size - length) * sizeof(void *));
+
+    darray->length = length;
+    darray->store_size = store_size;
+    darray->start_index = 0;
+    darray->flags = flags;
+    darray->map_threshold = DARRAY_MAP_THRESHOLD;
+    darray->expand_rate = da_fixed(expand_rate);
+    darray->max_pool_size = da_fixed(max_pool_size);
+    darray->items = items;
+    darray->allocator = allocator;
+    darray->tuning = NULL;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return darray;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+DArray *DArray_init_small(double max_pool_size, double expand_rate, uint32_t flags, Allocator *allocator, int *res)
+{
+    DArray *darray = NULL;
+    int err = 0;
+
+    check_err(max_pool_size >= 0 && max_pool_size <= 1, err, DA_ERR_ARGS | DA_INIT_M_POOL_SIZE, "Invalid max_pool_size: %f", max_pool_size);
+    check_err(expand_rate > 1, err, DA_ERR_ARGS | DA_INIT_EXPAND_RATE, "Invalid expand_rate: %f", expand_rate);
+    check_err((flags & ~(uint32_t)DA_FLAG_RING) == 0, err, DA_ERR_ARGS | DA_INIT_FLAGS, "Invalid flags: %#x", flags);
+
+    // The inline slots are treated as a borrowed store, so the first resize moves the values out
+    darray = Allocator_alloc(allocator, sizeof(DArray) + DARRAY_SMALL_SLOTS * sizeof(void *));
+    check_err(darray != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    darray->items = (void **)(darray + 1);
+    memset(darray->items, 0, DARRAY_SMALL_SLOTS * sizeof(void *));
+
+    darray->length = 0;
+    darray->store_size = DARRAY_SMALL_SLOTS;
+    darray->start_index = 0;
+    darray->flags = flags | DA_FLAG_SMALL | DA_FLAG_BORROWED;
+    darray->map_threshold = DARRAY_MAP_THRESHOLD;
+    darray->expand_rate = da_fixed(expand_rate);
+    darray->max_pool_size = da_fixed(max_pool_size);
+    darray->allocator = allocator;
+    darray->tuning = NULL;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return darray;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void DArray_destroy(DArray *darray)
+{
+    if(darray == NULL) {
+        return;
+    }
+
+    da_store_free(darray);
+    Allocator_free(darray->allocator, darray->tuning, sizeof(DArrayTuning));
+    Allocator_free(darray->allocator, darray, da_header_size(darray));
+}
+
+void *DArray_index(DArray *darray, DArraySize index)
+{
+    if(darray == NULL || index >= darray->length) {
+        return NULL;
+    }
+
+    return darray->items[da_slot(darray, index)];
+}
+
+// Slots at the start of the next run prefetched while a run is visited: four cache lines
+#define DA_VISIT_PREFETCH 32
+
+int DArray_visit_chunks(DArray *darray, DArraySize chunk_size, DArray_visit visit, void *ctx)
+{
+    if(darray == NULL || visit == NULL) {
+        return DA_ERR_ARGS;
+    }
+
+    DArraySpan spans[2];
+    DArraySize runs = DArray_spans(darray, spans);
+    DArraySize index = 0;
+
+    for(DArraySize s = 0; s < runs; s++) {
+        DArraySize length = spans[s].length;
+        DArraySize step = chunk_size > 0 && chunk_size < length ? chunk_size : length;
+
+        for(DArraySize done = 0; done < length; done += step) {
+            DArraySize count = length - done < step ? length - done : step;
+            void **values = spans[s].values + done;
+
+            // Start fetching the next run while this one is visited, including across the wrap
+            // of a ring, which the hardware prefetcher can't predict
+            void **ahead = values + count;
+            DArraySize ahead_length = length - done - count;
+            if(ahead_length == 0 && s + 1 < runs) {
+                ahead = spans[s + 1].values;
+                ahead_length = spans[s + 1].length;
+            }
+            for(DArraySize i = 0; i < DA_VISIT_PREFETCH && i < ahead_length; i += 8) {
+                __builtin_prefetch(ahead + i);
+            }
+
+            int rc = visit(values, count, index, ctx);
+            if(rc != 0) {
+                return rc;
+            }
+            index += count;
+        }
+    }
+
+    return 0;
+}
+
+// Grow the backing store to new_size slots
+static int da_resize(DArray *darray, DArraySize new_size)
+{
+    int err = 0;
+    DArraySize old_size = darray->store_size;
+    DA_TIMER_START(started);
+
+    void **items = da_store_realloc(darray, new_size);
+    check_err(items != NULL, err, DA_ERR_MEMORY | DA_EXPAND_REALLOC, "Out of memory.");
+
+    // Pages added by mremap are already zeroed; only the rest of the old last page needs clearing
+    DArraySize clear_end = new_size;
+#ifdef __linux__
+    if(darray->flags & DA_FLAG_MAPPED) {
+        size_t mapped = da_map_length(old_size) / sizeof(void *);
+        clear_end = mapped < new_size ? (DArraySize)mapped : new_size;
+    }
+#endif
+    memset(items + old_size, 0, (size_t)(clear_end - old_size) * sizeof(void *));
+    darray->items = items;
+    darray->store_size = new_size;
+
+    // A wrapped ring is split by the new slots; rejoin it by moving the wrapped run after the
+    // old end, or the first run up to the new end if the wrapped run doesn't fit
+    uint64_t end = (uint64_t)darray->start_index + darray->length;
+    if((darray->flags & DA_FLAG_RING) && end > old_size) {
+        DArraySize tail = (DArraySize)(end - old_size);
+        DArraySize extra = new_size - old_size;
+
+        if(tail <= extra) {
+            memcpy(items + old_size, items, (size_t)tail * sizeof(void *));
+            memset(items, 0, (size_t)tail * sizeof(void *));
+            DA_STAT_ADD(DA_STAT_BYTES_MOVED, (size_t)tail * sizeof(void *));
+        } else {
+            DArraySize head = old_size - darray->start_index;
+            memmove(items + darray->start_index + extra, items + darray->start_index, (size_t)head * sizeof(void *));
+            memset(items + darray->start_index, 0, (size_t)(extra < head ? extra : head) * sizeof(void *));
+            darray->start_index += extra;
+            DA_STAT_ADD(DA_STAT_BYTES_MOVED, (size_t)head * sizeof(void *));
+        }
+    }
+
+    DA_STAT_ADD(DA_STAT_EXPAND, 1);
+    DA_TIMER_STOP(DA_TIMER_RESIZE, started);
+
+    return 0;
+
+error:
+    return err;
+}
+
+// Count values added or removed, and values unshifted, for tuning
+static inline void da_tune_ops(DArray *darray, uint64_t count, uint64_t unshifts)
+{
+    if(darray->tuning != NULL) {
+        darray->tuning->ops += count;
+        darray->tuning->unshifts += unshifts;
+    }
+}
+
+// About to expand: sustained growth wants a faster rate, churn a slower one
+static void da_tune_expand(DArray *darray)
+{
+    DArrayTuning *tuning = darray->tuning;
+    if(tuning == NULL) {
+        return;
+    }
+
+    uint64_t ops = tuning->ops - tuning->expand_ops;
+    uint64_t grown = darray->length > tuning->expand_length ? darray->length - tuning->expand_length : 0;
+
+    if(2 * grown >= ops) {
+        darray->expand_rate += (tuning->max_expand_rate - darray->expand_rate + 1) / 2;
+    } else {
+        darray->expand_rate -= (darray->expand_rate - tuning->min_expand_rate + 1) / 2;
+    }
+
+    tuning->expand_ops = tuning->ops;
+    tuning->expand_length = darray->length;
+}
+
+// About to move every value to rebuild or shrink the pool: widen it if such moves copy more
+// than the operations they serve, or narrow it if a shift finds it idle
+static void da_tune_pool(DArray *darray, int shifting)
+{
+    DArrayTuning *tuning = darray->tuning;
+    if(tuning == NULL) {
+        return;
+    }
+
+    uint64_t ops = tuning->ops - tuning->pool_ops;
+    uint64_t unshifts = tuning->unshifts - tuning->pool_unshifts;
+
+    if(darray->length > ops) {
+        darray->max_pool_size += (tuning->max_pool_size - darray->max_pool_size + 1) / 2;
+    } else if(shifting && unshifts == 0 && 4 * (uint64_t)darray->length <= ops) {
+        darray->max_pool_size -= (darray->max_pool_size - tuning->min_pool_size + 1) / 2;
+    }
+
+    tuning->pool_ops = tuning->ops;
+    tuning->pool_unshifts = tuning->unshifts;
+}
+
+// Slots the pool may reach before shift shrinks it, retuning first once it has been reached
+static inline DArraySize da_shift_limit(DArray *darray)
+{
+    DArraySize limit = da_pool_limit(darray);
+
+    if(darray->start_index > limit && darray->tuning != NULL) {
+        da_tune_pool(darray, 1);
+        limit = da_pool_limit(darray);
+    }
+
+    return limit;
+}
+
+// Size the backing store would be expanded to by DArray_expand
+static inline DArraySize da_next_size(const DArray *darray)
+{
+    DArraySize new_size = da_scale(darray->store_size, darray->expand_rate);
+
+    return new_size > darray->store_size ? new_size : darray->store_size + 1;
+}
+
+// Expand the backing store to hold at least needed slots, growing at least geometrically
+static int da_grow(DArray *darray, uint64_t needed)
+{
+    if(needed <= darray->store_size) {
+        return 0;
+    }
+    if(!da_fits(needed)) {
+        return DA_ERR_MEMORY | DA_EXPAND_LIMIT;
+    }
+
+    da_tune_expand(darray);
+    DArraySize new_size = da_next_size(darray);
+
+    return da_resize(darray, new_size > needed ? new_size : (DArraySize)needed);
+}
+
+// Copy count values in to the positions starting at index, which may be past the end
+static void da_write(DArray *darray, DArraySize index, void **values, DArraySize count)
+{
+    DArraySize slot = da_slot(darray, index);
+    DArraySize first = count;
+
+    if((uint64_t)slot + count > darray->store_size) {
+        first = darray->store_size - slot;
+    }
+
+    memcpy(darray->items + slot, values, (size_t)first * sizeof(void *));
+    memcpy(darray->items, values + first, (size_t)(count - first) * sizeof(void *));
+}
+
+// Copy count values starting at index out, clearing the slots they leave
+static void da_read(DArray *darray, DArraySize index, void **values, DArraySize count)
+{
+    DArraySize slot = da_slot(darray, index);
+    DArraySize first = count;
+
+    if((uint64_t)slot + count > darray->store_size) {
+        first = darray->store_size - slot;
+    }
+
+    if(values != NULL) {
+        memcpy(values, darray->items + slot, (size_t)first * sizeof(void *));
+        memcpy(values + first, darray->items, (size_t)(count - first) * sizeof(void *));
+    }
+    memset(darray->items + slot, 0, (size_t)first * sizeof(void *));
+    memset(darray->items, 0, (size_t)(count - first) * sizeof(void *));
+}
+
+// Position in the backing store of a position relative to start_index, which may be negative
+static inline DArraySize da_rel_slot(const DArray *darray, int64_t pos)
+{
+    int64_t slot = (int64_t)darray->start_index + pos;
+    int64_t size = (int64_t)darray->store_size;
+
+    if(darray->flags & DA_FLAG_RING) {
+        if(slot < 0) {
+            slot += size;
+        } else if(slot >= size) {
+            slot -= size;
+        }
+    }
+
+    return (DArraySize)slot;
+}
+
+// Move count values from position from to position to, relative to start_index, and clear
+// the slots left behind; the caller adjusts start_index and length
+static void da_slide(DArray *darray, int64_t from, int64_t to, DArraySize length)
+{
+    int64_t count = (int64_t)length;
+
+    if(count == 0 || from == to) {
+        return;
+    }
+
+    DA_STAT_ADD(DA_STAT_BYTES_MOVED, (size_t)count * sizeof(void *));
+
+    // Ring ranges which don't cross the end of the store can be moved in one piece too
+    int64_t low = (int64_t)darray->start_index + (from < to ? from : to);
+    int64_t high = (int64_t)darray->start_index + (from < to ? to : from) + count;
+    if(!(darray->flags & DA_FLAG_RING) || (low >= 0 && high <= (int64_t)darray->store_size)) {
+        void **items = darray->items + darray->start_index;
+        memmove(items + to, items + from, (size_t)count * sizeof(void *));
+
+        if(to > from) {
+            int64_t gap = to - from;
+            memset(items + from, 0, (size_t)(gap < count ? gap : count) * sizeof(void *));
+        } else {
+            int64_t clear = to + count > from ? to + count : from;
+            memset(items + clear, 0, (size_t)(from + count - clear) * sizeof(void *));
+        }
+
+        return;
+    }
+
+    // Ring slots wrap, so copy one at a time in whichever direction doesn't overwrite the source
+    if(to < from) {
+        for(int64_t i = 0; i < count; i++) {
+            darray->items[da_rel_slot(darray, to + i)] = darray->items[da_rel_slot(darray, from + i)];
+        }
+    } else {
+        for(int64_t i = count; i > 0; i--) {
+            darray->items[da_rel_slot(darray, to + i - 1)] = darray->items[da_rel_slot(darray, from + i - 1)];
+        }
+    }
+
+    int64_t clear_from = to > from ? from : (to + count > from ? to + count : from);
+    int64_t clear_to = to > from ? (from + count < to ? from + count : to) : from + count;
+    for(int64_t pos = clear_from; pos < clear_to; pos++) {
+        darray->items[da_rel_slot(darray, pos)] = NULL;
+    }
+}
+
+int DArray_expand(DArray *darray)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+    check_err(darray->store_size < DARRAY_SIZE_MAX, err, DA_ERR_MEMORY | DA_EXPAND_LIMIT, "DArray at maximum size");
+
+    da_tune_expand(darray);
+
+    return da_resize(darray, da_next_size(darray));
+
+error:
+    return err;
+}
+
+int DArray_reserve(DArray *darray, DArraySize capacity)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    uint64_t needed = darray->flags & DA_FLAG_RING ? capacity : (uint64_t)darray->start_index + capacity;
+    check_err(da_fits(needed), err, DA_ERR_MEMORY | DA_RESERVE_EXPAND | (DA_EXPAND_LIMIT << 4), "Reserve of %" PRIuDA " too large", capacity);
+
+    if(needed > darray->store_size) {
+        int rc = da_resize(darray, (DArraySize)needed);
+        check_err(rc == 0, err, da_chain(DA_RESERVE_EXPAND, rc), "Failed to expand DArray for reserve");
+    }
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DArray_reserve_front(DArray *darray, DArraySize pool_size)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    if(darray->flags & DA_FLAG_RING) {
+        // Every free slot in a ring is available to unshift
+        uint64_t capacity = (uint64_t)darray->length + pool_size;
+        check_err(da_fits(capacity), err, DA_ERR_MEMORY | DA_RESERVE_EXPAND | (DA_EXPAND_LIMIT << 4), "Reserve of %" PRIuDA " too large", pool_size);
+
+        int rc = DArray_reserve(darray, (DArraySize)capacity);
+        check_err(rc == 0, err, rc, "Failed to expand DArray for reserve");
+    } else if(darray->start_index < pool_size) {
+        int rc = DArray_move(darray, (int64_t)(pool_size - darray->start_index));
+        check_err(rc == 0, err, da_chain(DA_RESERVE_MOVE, rc), "Failed to move DArray for reserve");
+    }
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DArray_shrink_to_fit(DArray *darray)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    int rc = DArray_linearise(darray);
+    check_err(rc == 0, err, DA_ERR_MEMORY | DA_SHRINK_REALLOC, "Failed to linearise DArray for shrink");
+
+    // Keep as much of the pool as max_pool_size allows for the values that remain
+    DArraySize pool = 0;
+    if(!(darray->flags & DA_FLAG_RING)) {
+        pool = da_scale(darray->length, darray->max_pool_size);
+        pool = pool < darray->start_index ? pool : darray->start_index;
+    }
+
+    DArraySize new_size = pool + darray->length > 0 ? pool + darray->length : 1;
+
+    // A small array's values go back to its inline slots once they fit, whatever the store size
+    if((darray->flags & DA_FLAG_SMALL) && new_size <= DARRAY_SMALL_SLOTS) {
+        if(DArray_is_inline(darray)) {
+            return 0;
+        }
+
+        void **slots = (void **)(darray + 1);
+        memset(slots, 0, DARRAY_SMALL_SLOTS * sizeof(void *));
+        memcpy(slots + pool, darray->items + darray->start_index, (size_t)darray->length * sizeof(void *));
+        DA_STAT_ADD(DA_STAT_BYTES_COPIED, (size_t)darray->length * sizeof(void *));
+
+        da_store_free(darray);
+        darray->items = slots;
+        darray->store_size = DARRAY_SMALL_SLOTS;
+        darray->start_index = pool;
+        darray->flags |= DA_FLAG_BORROWED;
+        DA_STAT_ADD(DA_STAT_SHRINK, 1);
+
+        return 0;
+    }
+
+    if(new_size == darray->store_size) {
+        return 0;
+    }
+
+    da_slide(darray, 0, (int64_t)pool - (int64_t)darray->start_index, darray->length);
+    darray->start_index = pool;
+
+    void **items = da_store_realloc(darray, new_size);
+    check_err(items != NULL, err, DA_ERR_MEMORY | DA_SHRINK_REALLOC, "Out of memory.");
+
+    darray->items = items;
+    darray->store_size = new_size;
+    DA_STAT_ADD(DA_STAT_SHRINK, 1);
+
+    return 0;
+
+error:
+    return err;
+}
+
+void **DArray_detach(DArray *darray, DArraySize *length, DArraySize *store_size, int *res)
+{
+    void **items = NULL;
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    err = DArray_linearise(darray);
+    check_err(err == 0, err, DA_ERR_MEMORY, "Failed to linearise DArray for detach");
+
+    items = darray->items;
+    DArraySize size = darray->store_size;
+
+#ifdef __linux__
+    // A mapping can't be freed through the allocator, so copy the values out of it
+    if(darray->flags & DA_FLAG_MAPPED) {
+        size = darray->length > 0 ? darray->length : 1;
+        items = malloc((size_t)size * sizeof(void *));
+        check_err(items != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+        memcpy(items, darray->items + darray->start_index, (size_t)darray->length * sizeof(void *));
+        munmap(darray->items, da_map_length(darray->store_size));
+        DA_STAT_ADD(DA_STAT_BYTES_COPIED, (size_t)darray->length * sizeof(void *));
+    } else
+#endif
+    {
+        da_slide(darray, 0, -(int64_t)darray->start_index, darray->length);
+    }
+
+    // Inline slots are freed with the header, so copy the values out of them
+    if(DArray_is_inline(darray)) {
+        items = Allocator_alloc(darray->allocator, (size_t)size * sizeof(void *));
+        check_err(items != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+        memcpy(items, darray->items, (size_t)size * sizeof(void *));
+        DA_STAT_ADD(DA_STAT_BYTES_COPIED, (size_t)size * sizeof(void *));
+    }
+
+    if(length != NULL) {
+        *length = darray->length;
+    }
+    if(store_size != NULL) {
+        *store_size = size;
+    }
+
+    Allocator_free(darray->allocator, darray->tuning, sizeof(DArrayTuning));
+    Allocator_free(darray->allocator, darray, da_header_size(darray));
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return items;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+int DArray_swap(DArray *darray, DArray *other)
+{
+    int err = 0;
+
+    check_err(darray != NULL && other != NULL, err, DA_ERR_ARGS, "NULL darray");
+    check_err(darray->allocator == other->allocator, err, DA_ERR_ARGS | DA_SWAP_ALLOCATOR, "DArrays use different allocators");
+
+    // Inline slots stay with their header, so their values move to the heap first
+    DArray *arrays[2] = { darray, other };
+    for(int i = 0; i < 2; i++) {
+        if(DArray_is_inline(arrays[i])) {
+            void **items = da_store_realloc(arrays[i], arrays[i]->store_size);
+            check_err(items != NULL, err, DA_ERR_MEMORY | DA_SWAP_SPILL, "Out of memory.");
+            arrays[i]->items = items;
+        }
+    }
+
+    // The size of each header's allocation stays with it
+    uint32_t small = darray->flags & DA_FLAG_SMALL;
+    uint32_t other_small = other->flags & DA_FLAG_SMALL;
+
+    DArray swapped = *darray;
+    *darray = *other;
+    *other = swapped;
+
+    darray->flags = (darray->flags & ~(uint32_t)DA_FLAG_SMALL) | small;
+    other->flags = (other->flags & ~(uint32_t)DA_FLAG_SMALL) | other_small;
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DArray_enable_tuning(DArray *darray, double min_expand_rate, double max_expand_rate, double min_pool_size, double max_pool_size)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+    check_err(min_expand_rate > 1 && max_expand_rate >= min_expand_rate, err, DA_ERR_ARGS | DA_TUNING_BOUNDS,
+            "Invalid expand_rate bounds: %f to %f", min_expand_rate, max_expand_rate);
+    check_err(min_pool_size >= 0 && max_pool_size >= min_pool_size && max_pool_size <= 1, err, DA_ERR_ARGS | DA_TUNING_BOUNDS,
+            "Invalid max_pool_size bounds: %f to %f", min_pool_size, max_pool_size);
+
+    if(darray->tuning == NULL) {
+        darray->tuning = Allocator_alloc(darray->allocator, sizeof(DArrayTuning));
+        check_err(darray->tuning != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+    }
+
+    DArrayTuning *tuning = darray->tuning;
+    memset(tuning, 0, sizeof(DArrayTuning));
+    tuning->min_expand_rate = da_fixed(min_expand_rate);
+    tuning->max_expand_rate = da_fixed(max_expand_rate);
+    tuning->min_pool_size = da_fixed(min_pool_size);
+    tuning->max_pool_size = da_fixed(max_pool_size);
+    tuning->expand_length = darray->length;
+
+    darray->expand_rate = darray->expand_rate < tuning->min_expand_rate ? tuning->min_expand_rate :
+        darray->expand_rate > tuning->max_expand_rate ? tuning->max_expand_rate : darray->expand_rate;
+    darray->max_pool_size = darray->max_pool_size < tuning->min_pool_size ? tuning->min_pool_size :
+        darray->max_pool_size > tuning->max_pool_size ? tuning->max_pool_size : darray->max_pool_size;
+
+    return 0;
+
+error:
+    return err;
+}
+
+void DArray_disable_tuning(DArray *darray)
+{
+    if(darray == NULL) {
+        return;
+    }
+
+    Allocator_free(darray->allocator, darray->tuning, sizeof(DArrayTuning));
+    darray->tuning = NULL;
+}
+
+int DArray_move(DArray *darray, int64_t dist)
+{
+    int err = 0;
+    DA_TIMER_START(started);
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+    check_err(!(darray->flags & DA_FLAG_RING), err, DA_ERR_ARGS | DA_MOVE_RING, "Cannot move a ring-mode DArray");
+
+    int64_t start = (int64_t)darray->start_index + dist;
+    check_err(start >= 0, err, DA_ERR_ARGS | DA_MOVE_RANGE, "Move of %" PRId64 " from %" PRIuDA " out of range", dist, darray->start_index);
+
+    int rc = da_grow(darray, (uint64_t)start + darray->length);
+    check_err(rc == 0, err, da_chain(DA_MOVE_EXPAND, rc), "Failed to expand DArray for move");
+
+    da_slide(darray, 0, dist, darray->length);
+    darray->start_index = (DArraySize)start;
+
+    DA_STAT_ADD(DA_STAT_MOVE, 1);
+    DA_TIMER_STOP(DA_TIMER_MOVE, started);
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DArray_linearise(DArray *darray)
+{
+    if(darray == NULL || !(darray->flags & DA_FLAG_RING)) {
+        return 0;
+    }
+
+    uint64_t end = (uint64_t)darray->start_index + darray->length;
+    if(end <= darray->store_size) {
+        return 0;
+    }
+
+    void **items = darray->items;
+    DArraySize head = darray->store_size - darray->start_index;
+    DArraySize tail = darray->length - head;
+    DA_STAT_ADD(DA_STAT_BYTES_MOVED, (size_t)darray->length * sizeof(void *));
+
+    // Stash the shorter run, slide the longer one into place, then drop the stash in
+    if(tail <= head) {
+        void **tmp = malloc((size_t)tail * sizeof(void *));
+        if(tmp == NULL) {
+            return DA_ERR_MEMORY;
+        }
+
+        memcpy(tmp, items, (size_t)tail * sizeof(void *));
+        memmove(items + darray->start_index - tail, items + darray->start_index, (size_t)head * sizeof(void *));
+        memcpy(items + darray->store_size - tail, tmp, (size_t)tail * sizeof(void *));
+        free(tmp);
+
+        DArraySize start = darray->start_index - tail;
+        memset(items, 0, (size_t)(tail < start ? tail : start) * sizeof(void *));
+        darray->start_index = start;
+    } else {
+        void **tmp = malloc((size_t)head * sizeof(void *));
+        if(tmp == NULL) {
+            return DA_ERR_MEMORY;
+        }
+
+        memcpy(tmp, items + darray->start_index, (size_t)head * sizeof(void *));
+        memmove(items + head, items, (size_t)tail * sizeof(void *));
+        memcpy(items, tmp, (size_t)head * sizeof(void *));
+        free(tmp);
+
+        DArraySize from = darray->length > darray->start_index ? darray->length : darray->start_index;
+        memset(items + from, 0, (size_t)(darray->store_size - from) * sizeof(void *));
+        darray->start_index = 0;
+    }
+
+    return 0;
+}
+
+int DArray_push(DArray *darray, void *value)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    DArraySize used = darray->flags & DA_FLAG_RING ? darray->length : darray->start_index + darray->length;
+    if(used == darray->store_size) {
+        int rc = DArray_expand(darray);
+        check_err(rc == 0, err, da_chain(DA_PUSH_EXPAND, rc), "Failed to expand DArray for push");
+    }
+
+    darray->items[da_slot(darray, darray->length)] = value;
+    darray->length++;
+    da_tune_ops(darray, 1, 0);
+    DA_STAT_ADD(DA_STAT_PUSH, 1);
+
+    return 0;
+
+error:
+    return err;
+}
+
+void *DArray_pop(DArray *darray)
+{
+    if(darray == NULL || darray->length == 0) {
+        return NULL;
+    }
+
+    DArraySize slot = da_slot(darray, darray->length - 1);
+    void *value = darray->items[slot];
+
+    darray->items[slot] = NULL;
+    darray->length--;
+    da_tune_ops(darray, 1, 0);
+    DA_STAT_ADD(DA_STAT_POP, 1);
+
+    return value;
+}
+
+int DArray_unshift(DArray *darray, void *value)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    if(darray->flags & DA_FLAG_RING) {
+        if(darray->length == darray->store_size) {
+            int rc = DArray_expand(darray);
+            check_err(rc == 0, err, da_chain(DA_UNSHIFT_MOVE, da_chain(DA_MOVE_EXPAND, rc)), "Failed to expand DArray for unshift");
+        }
+
+        darray->start_index = darray->start_index == 0 ? darray->store_size - 1 : darray->start_index - 1;
+    } else {
+        if(darray->start_index == 0) {
+            // Pool exhausted; rebuild it at its maximum size
+            da_tune_pool(darray, 0);
+            DArraySize pool = da_pool_limit(darray);
+            int rc = DArray_move(darray, pool > 0 ? (int64_t)pool : 1);
+            check_err(rc == 0, err, da_chain(DA_UNSHIFT_MOVE, rc), "Failed to move DArray for unshift");
+            DA_STAT_ADD(DA_STAT_POOL_REBUILD, 1);
+        }
+
+        darray->start_index--;
+    }
+
+    darray->items[darray->start_index] = value;
+    darray->length++;
+    da_tune_ops(darray, 1, 1);
+    DA_STAT_ADD(DA_STAT_UNSHIFT, 1);
+
+    return 0;
+
+error:
+    return err;
+}
+
+void *DArray_shift(DArray *darray, int *res)
+{
+    void *value = NULL;
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    if(darray->length == 0) {
+        if(res != NULL) {
+            *res = 0;
+        }
+        return NULL;
+    }
+
+    value = darray->items[darray->start_index];
+    darray->items[darray->start_index] = NULL;
+    darray->length--;
+    da_tune_ops(darray, 1, 0);
+    DA_STAT_ADD(DA_STAT_SHIFT, 1);
+
+    if(darray->flags & DA_FLAG_RING) {
+        darray->start_index = da_slot(darray, 1);
+    } else {
+        darray->start_index++;
+
+        // Pool has outgrown its maximum; shrink it to half that
+        DArraySize limit = da_shift_limit(darray);
+        if(darray->start_index > limit) {
+            DA_STAT_ADD(DA_STAT_POOL_SHRINK, 1);
+            if(darray->length == 0) {
+                darray->start_index = limit / 2;
+            } else {
+                int rc = DArray_move(darray, -(int64_t)(darray->start_index - limit / 2));
+                check_err(rc == 0, err, da_chain(DA_SHIFT_MOVE, rc), "Failed to move DArray for shift");
+            }
+        }
+    }
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return value;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return value;
+}
+
+int DArray_push_n(DArray *darray, void **values, DArraySize count)
+{
+    int err = 0;
+
+    check_err(darray != NULL && (values != NULL || count == 0), err, DA_ERR_ARGS, "NULL darray or values");
+
+    uint64_t used = darray->flags & DA_FLAG_RING ? darray->length : (uint64_t)darray->start_index + darray->length;
+    int rc = da_grow(darray, used + count);
+    check_err(rc == 0, err, da_chain(DA_PUSH_EXPAND, rc), "Failed to expand DArray for push");
+
+    da_write(darray, darray->length, values, count);
+    darray->length += count;
+    da_tune_ops(darray, count, 0);
+    DA_STAT_ADD(DA_STAT_PUSH, count);
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DArray_unshift_n(DArray *darray, void **values, DArraySize count)
+{
+    int err = 0;
+
+    check_err(darray != NULL && (values != NULL || count == 0), err, DA_ERR_ARGS, "NULL darray or values");
+
+    if(darray->flags & DA_FLAG_RING) {
+        int rc = da_grow(darray, (uint64_t)darray->length + count);
+        check_err(rc == 0, err, da_chain(DA_UNSHIFT_MOVE, da_chain(DA_MOVE_EXPAND, rc)), "Failed to expand DArray for unshift");
+
+        darray->start_index = da_rel_slot(darray, -(int64_t)count);
+    } else {
+        if(darray->start_index < count) {
+            // Make room for the whole batch plus a rebuilt pool in a single move
+            da_tune_pool(darray, 0);
+            int rc = DArray_move(darray, (int64_t)(count - darray->start_index + da_pool_limit(darray)));
+            check_err(rc == 0, err, da_chain(DA_UNSHIFT_MOVE, rc), "Failed to move DArray for unshift");
+            DA_STAT_ADD(DA_STAT_POOL_REBUILD, 1);
+        }
+
+        darray->start_index -= count;
+    }
+
+    da_write(darray, 0, values, count);
+    darray->length += count;
+    da_tune_ops(darray, count, count);
+    DA_STAT_ADD(DA_STAT_UNSHIFT, count);
+
+    return 0;
+
+error:
+    return err;
+}
+
+DArraySize DArray_pop_n(DArray *darray, void **values, DArraySize count)
+{
+    if(darray == NULL) {
+        return 0;
+    }
+
+    if(count > darray->length) {
+        count = darray->length;
+    }
+
+    da_read(darray, darray->length - count, values, count);
+    darray->length -= count;
+    da_tune_ops(darray, count, 0);
+    DA_STAT_ADD(DA_STAT_POP, count);
+
+    return count;
+}
+
+DArraySize DArray_shift_n(DArray *darray, void **values, DArraySize count, int *res)
+{
+    int err = 0;
+    DArraySize shifted = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    if(count > darray->length) {
+        count = darray->length;
+    }
+
+    da_read(darray, 0, values, count);
+    darray->length -= count;
+    darray->start_index = da_slot(darray, count);
+    da_tune_ops(darray, count, 0);
+    DA_STAT_ADD(DA_STAT_SHIFT, count);
+    // The values are shifted even if shrinking the pool below fails
+    shifted = count;
+
+    if(!(darray->flags & DA_FLAG_RING)) {
+        // As for DArray_shift, but the pool is only resized once for the whole batch
+        DArraySize limit = da_shift_limit(darray);
+        if(darray->start_index > limit) {
+            DA_STAT_ADD(DA_STAT_POOL_SHRINK, 1);
+            if(darray->length == 0) {
+                darray->start_index = limit / 2;
+            } else {
+                int rc = DArray_move(darray, -(int64_t)(darray->start_index - limit / 2));
+                check_err(rc == 0, err, da_chain(DA_SHIFT_MOVE, rc), "Failed to move DArray for shift");
+            }
+        }
+    }
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return shifted;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return shifted;
+}
+
+int DArray_splice(DArray *darray, DArraySize index, DArraySize remove, void **removed, void **values, DArraySize count)
+{
+    int err = 0;
+
+    check_err(darray != NULL && (values != NULL || count == 0), err, DA_ERR_ARGS, "NULL darray or values");
+    check_err(index <= darray->length && remove <= darray->length - index, err, DA_ERR_ARGS | DA_SPLICE_RANGE, "Splice of %" PRIuDA " at %" PRIuDA " out of range", remove, index);
+
+    DArraySize head = index;
+    DArraySize tail = darray->length - index - remove;
+    int ring = darray->flags & DA_FLAG_RING;
+
+    if(count > remove) {
+        DArraySize grow = count - remove;
+
+        // Slide the head into the pool if it is the smaller side and fits, otherwise the tail
+        int front = head <= tail && (ring || darray->start_index >= grow);
+
+        // Grow before touching any value, so a failed splice leaves the darray as it was
+        if(ring || !front) {
+            uint64_t used = ring ? darray->length : (uint64_t)darray->start_index + darray->length;
+            int rc = da_grow(darray, used + grow);
+            check_err(rc == 0, err, da_chain(DA_SPLICE_EXPAND, rc), "Failed to expand DArray for splice");
+        }
+
+        da_read(darray, index, removed, remove);
+        if(front) {
+            da_slide(darray, 0, -(int64_t)grow, head);
+            darray->start_index = da_rel_slot(darray, -(int64_t)grow);
+        } else {
+            da_slide(darray, (int64_t)index + (int64_t)remove, (int64_t)index + (int64_t)count, tail);
+        }
+    } else {
+        da_read(darray, index, removed, remove);
+
+        if(count < remove) {
+            DArraySize shrink = remove - count;
+
+            if(head < tail) {
+                da_slide(darray, 0, (int64_t)shrink, head);
+                darray->start_index = da_slot(darray, shrink);
+            } else {
+                da_slide(darray, (int64_t)index + (int64_t)remove, (int64_t)index + (int64_t)count, tail);
+            }
+        }
+    }
+
+    da_write(darray, index, values, count);
+    darray->length = darray->length - remove + count;
+    da_tune_ops(darray, (uint64_t)remove + count, 0);
+    DA_STAT_ADD(DA_STAT_SPLICE, 1);
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DArray_insert(DArray *darray, DArraySize index, void *value)
+{
+    return DArray_splice(darray, index, 0, NULL, &value, 1);
+}
+
+void DArray_qsort(DArray *darray, int (compare)(void *val1, void *val2))
+{
+    if(darray == NULL || compare == NULL || darray->length < 2) {
+        return;
+    }
+
+    if(DArray_linearise(darray) != 0) {
+        return;
+    }
+
+    darray_sort_generic(darray->items + darray->start_index, darray->length, compare);
+}
+
+// Index of the first value which sorts after value, or which does not sort before it
+static DArraySize da_bound(DArray *darray, void *value, DArray_compare compare, int upper)
+{
+    DArraySize base = 0;
+    DArraySize n = darray->length;
+
+    // Both selects compile to conditional moves, so only the comparison itself can mispredict
+    while(n > 0) {
+        DArraySize half = n / 2;
+        int c = compare(darray->items[da_slot(darray, base + half)], value);
+        int before = upper ? c <= 0 : c < 0;
+        base = before ? base + half + 1 : base;
+        n = before ? n - half - 1 : half;
+    }
+
+    return base;
+}
+
+DArraySize DArray_lower_bound(DArray *darray, void *value, DArray_compare compare)
+{
+    if(darray == NULL || compare == NULL) {
+        return 0;
+    }
+
+    return da_bound(darray, value, compare, 0);
+}
+
+DArraySize DArray_upper_bound(DArray *darray, void *value, DArray_compare compare)
+{
+    if(darray == NULL || compare == NULL) {
+        return 0;
+    }
+
+    return da_bound(darray, value, compare, 1);
+}
+
+DArraySize DArray_bsearch(DArray *darray, void *value, DArray_compare compare)
+{
+    if(darray == NULL || compare == NULL) {
+        return DA_NOT_FOUND;
+    }
+
+    DArraySize index = da_bound(darray, value, compare, 0);
+    if(index == darray->length || compare(darray->items[da_slot(darray, index)], value) != 0) {
+        return DA_NOT_FOUND;
+    }
+
+    return index;
+}
+
+int DArray_insert_sorted(DArray *darray, void *value, DArray_compare compare)
+{
+    int err = 0;
+
+    check_err(darray != NULL && compare != NULL, err, DA_ERR_ARGS, "NULL darray or compare");
+
+    DArraySize index = da_bound(darray, value, compare, 1);
+
+    if(!(darray->flags & DA_FLAG_RING) && darray->start_index == 0 && index <= darray->length - index) {
+        // Pool exhausted; rebuild it at its maximum size so the head can move into it
+        DArraySize pool = da_pool_limit(darray);
+        int rc = DArray_move(darray, pool > 0 ? (int64_t)pool : 1);
+        check_err(rc == 0, err, da_chain(DA_INSERT_SORTED_MOVE, rc), "Failed to move DArray for insert");
+    }
+
+    return DArray_insert(darray, index, value);
+
+error:
+    return err;
+}
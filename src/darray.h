@@ -7,8 +7,11 @@
  */
 
 #ifndef DArray_h
+#define DArray_h
 
+#include "allocator.h"
 #include "stdint.h"
+#include <inttypes.h>
 
 /**
  * @brief DArray error types
@@ -26,6 +29,73 @@ enum darray_err_general {
     DA_DETAIL3_MASK = 0xF000 ///< AND an error with this mask to retrieve tertiary error details
 };
 
+/**
+ * @brief Wrap an error from an inner call as the secondary detail of an outer error
+ *
+ * The general error is kept, `detail` becomes the detail, and the inner details each move
+ * down one level. Used throughout the library, and by code generated from `darray_define.h`.
+ *
+ * @param detail Detail of the outer error
+ * @param inner Error returned by the inner call
+ *
+ * @return Combined error
+ */
+static inline int da_chain(int detail, int inner)
+{
+    return (inner & DA_ERR_MASK) | detail | ((inner & (DA_DETAIL_MASK | DA_DETAIL2_MASK)) << 4);
+}
+
+/**
+ * @brief Type of DArray lengths, indices and store sizes
+ *
+ * 32 bits by default, which caps an array at `UINT32_MAX` values and keeps the header small;
+ * build everything with `DARRAY_64` defined (`make big`) for 64-bit sizes. `PRIuDA` is the
+ * matching `printf` conversion, as for the `PRIu32` family.
+ */
+#ifdef DARRAY_64
+typedef uint64_t DArraySize;
+#define DARRAY_SIZE_MAX UINT64_MAX
+#define PRIuDA PRIu64
+#else
+typedef uint32_t DArraySize;
+#define DARRAY_SIZE_MAX UINT32_MAX
+#define PRIuDA PRIu32
+#endif
+
+/**
+ * @brief Scale of the fixed-point `expand_rate` and `max_pool_size` of a DArray
+ *
+ * Both are held as multiples of `1 / DA_FIXED_ONE`, so that growth and pool checks are integer
+ * multiplies and shifts. The init functions take them as `double`s and convert them with
+ * `DA_FIXED`; `DArray_expand_rate` and `DArray_max_pool_size` convert back.
+ */
+#define DA_FIXED_SHIFT 16
+#define DA_FIXED_ONE (1u << DA_FIXED_SHIFT)
+
+/**
+ * @brief Convert a non-negative ratio to fixed point, rounding to nearest
+ */
+#define DA_FIXED(ratio) ((uint32_t)((ratio) * DA_FIXED_ONE + 0.5))
+
+/**
+ * @brief Adaptive tuning state of a DArray
+ *
+ * Bounds are set by `DArray_enable_tuning`; the counters are kept by the array.
+ * @see DArray_enable_tuning
+ */
+typedef struct DArrayTuning {
+    uint32_t min_expand_rate;   ///< Lowest `expand_rate` the policy may choose, in fixed point
+    uint32_t max_expand_rate;   ///< Highest `expand_rate` the policy may choose, in fixed point
+    uint32_t min_pool_size;     ///< Lowest `max_pool_size` the policy may choose, in fixed point
+    uint32_t max_pool_size;     ///< Highest `max_pool_size` the policy may choose, in fixed point
+    uint64_t ops;               ///< Values added or removed since tuning was enabled
+    uint64_t unshifts;          ///< Values unshifted since tuning was enabled
+    uint64_t expand_ops;        ///< `ops` at the last expansion
+    uint64_t pool_ops;          ///< `ops` at the last pool rebuild or shrink
+    uint64_t pool_unshifts;     ///< `unshifts` at the last pool rebuild or shrink
+    DArraySize expand_length;   ///< Length of the array at the last expansion
+} DArrayTuning;
+
 /**
  * @brief Dynamic array representation
  *
@@ -36,16 +106,75 @@ enum darray_err_general {
  * exceeds the value of `max_pool_size`. All DArray methods are aware of the pool; when
  * the provided access/manipulation methods are used, users should not need to manipulate
  * the pool.
+ *
+ * A DArray created with `DArray_init_ring` has no pool; instead `start_index` wraps around
+ * the end of the backing store, so the values may occupy two runs of `items`.
+ *
+ * The fields used by every push, pop, shift and unshift come first; the whole header fits in
+ * one 64-byte cache line with either size of `DArraySize`.
+ * @see darray_flags
  */
 typedef struct DArray {
-    uint32_t length;        ///< Number of values in the dynamic array
-    uint32_t store_size;    ///< Maximum number of values in backing store
-    uint32_t start_index;   ///< Index of the first item in the array within the backing store
-    double expand_rate;     ///< Expansion rate of the dynamic array
-    double max_pool_size;   ///< Maximum size of the array's pool
-    void **items;           ///< Backing store of the array
+    void **items;               ///< Backing store of the array
+    DArraySize length;          ///< Number of values in the dynamic array
+    DArraySize start_index;     ///< Index of the first item in the array within the backing store
+    DArraySize store_size;      ///< Maximum number of values in backing store
+    uint32_t flags;             ///< Layout flags; see `darray_flags`
+    uint32_t max_pool_size;     ///< Maximum size of the array's pool relative to the store, in fixed point; see `DA_FIXED_ONE`
+    uint32_t expand_rate;       ///< Expansion rate of the dynamic array, in fixed point; see `DA_FIXED_ONE`
+    uint32_t map_threshold;     ///< Store size in slots from which the store is grown with `mremap`; 0 to disable
+    Allocator *allocator;       ///< Allocator for the array and its backing store; `NULL` for `malloc`
+    DArrayTuning *tuning;       ///< Adaptive tuning state; `NULL` unless enabled with `DArray_enable_tuning`
 } DArray;
 
+/**
+ * @brief Get the expansion rate of a darray as a ratio
+ *
+ * @param darray DArray to get the rate of
+ *
+ * @return `expand_rate` converted from fixed point
+ */
+static inline double DArray_expand_rate(const DArray *darray)
+{
+    return (double)darray->expand_rate / DA_FIXED_ONE;
+}
+
+/**
+ * @brief Get the maximum pool size of a darray as a ratio
+ *
+ * @param darray DArray to get the maximum pool size of
+ *
+ * @return `max_pool_size` converted from fixed point
+ */
+static inline double DArray_max_pool_size(const DArray *darray)
+{
+    return (double)darray->max_pool_size / DA_FIXED_ONE;
+}
+
+/**
+ * @brief DArray layout flags
+ * @see DArray
+ */
+enum darray_flags {
+    DA_FLAG_RING        = 0x1,      ///< Values wrap around the end of the backing store
+    DA_FLAG_MAPPED      = 0x100,    ///< Backing store is an anonymous mapping; set by the DArray, not by callers
+    DA_FLAG_BORROWED    = 0x200,    ///< Backing store belongs to the caller; copied on the first resize and never freed
+    DA_FLAG_SMALL       = 0x400     ///< Header is followed by `DARRAY_SMALL_SLOTS` inline slots; set by `DArray_init_small`
+};
+
+/**
+ * @brief Default `map_threshold` for new DArrays
+ *
+ * Once the backing store of a DArray with no allocator reaches this many slots (8MiB of
+ * pointers by default) it is moved into an anonymous `mmap` mapping, and from there on is grown
+ * and shrunk with `mremap`, so very large arrays expand without copying their values. Only
+ * available on Linux; elsewhere, and for arrays with an allocator, `realloc` is always used.
+ * Define before building to change it, or set `map_threshold` on an individual array.
+ */
+#ifndef DARRAY_MAP_THRESHOLD
+#define DARRAY_MAP_THRESHOLD (1u << 20)
+#endif
+
 /**
  * @brief Initialise a DArray with a pool
  *
@@ -59,7 +188,7 @@ typedef struct DArray {
  *
  * @return New DArray on success, otherwise `NULL`
  */
-DArray *DArray_init_with_pool(uint32_t length, double max_pool_size, double expand_rate, uint32_t pool_size, int *res);
+DArray *DArray_init_with_pool(DArraySize length, double max_pool_size, double expand_rate, DArraySize pool_size, int *res);
 
 /**
  * @brief DArray_init errors
@@ -70,8 +199,117 @@ enum darray_err_init {
     DA_INIT_M_POOL_SIZE = 0x20, ///< Invalid max_pool_size: Not between 0 and 1
     DA_INIT_EXPAND_RATE = 0x30, ///< Invalid expand_rate: Less than 1
     DA_INIT_POOL_SIZE   = 0x40, ///< Invalid pool_size: Greater than (length)/(max_pool_size)
+    DA_INIT_FLAGS       = 0x60, ///< Invalid flags: Unknown flag set
+    DA_INIT_ITEMS       = 0x70, ///< Invalid items: `NULL`
+    DA_INIT_STORE_SIZE  = 0x80  ///< Invalid store_size: 0 or less than the length
 };
 
+/**
+ * @brief Initialise a DArray in ring-buffer mode
+ *
+ * In ring mode the first value may sit anywhere in the backing store, and the values wrap
+ * around its end. Pushing, popping, shifting and unshifting are then all `O(1)`, with no
+ * moves; the only copying happens when a full array is expanded. `max_pool_size` is unused.
+ * All DArray methods work on ring-mode arrays, though `DArray_move` is rejected.
+ * @see darray_err_init for errors
+ *
+ * @param length Length of array to create
+ * @param expand_rate Expansion rate of array; suitable value 1.5; must be greater than 1
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DArray on success, otherwise `NULL`
+ */
+DArray *DArray_init_ring(DArraySize length, double expand_rate, int *res);
+
+/**
+ * @brief Initialise a DArray which allocates through an allocator
+ *
+ * The DArray itself and its backing store are allocated from `allocator`, which must outlive
+ * the array. `DArray_init_with_pool` and `DArray_init_ring` are equivalent to this with a
+ * `NULL` allocator.
+ * @see darray_err_init for errors
+ * @see allocator.h
+ *
+ * @param length Length of array to create
+ * @param max_pool_size Maximum size of initial pool; must be between 0 and 1
+ * @param expand_rate Expansion rate of array; suitable value 1.5; must be greater than 1
+ * @param pool_size Initial size of pool; must be less than the length
+ * @param flags Layout flags; see `darray_flags`
+ * @param allocator Allocator to use; `NULL` for `malloc`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DArray on success, otherwise `NULL`
+ */
+DArray *DArray_init_with_allocator(DArraySize length, double max_pool_size, double expand_rate, DArraySize pool_size, uint32_t flags, Allocator *allocator, int *res);
+
+/**
+ * @brief Initialise a DArray around an existing backing store, without copying it
+ *
+ * The first `length` slots of `items` become the values of the array, with no pool, and the
+ * slots after them are cleared. Unless `DA_FLAG_BORROWED` is set, the array takes ownership of
+ * `items`, which must have been allocated from `allocator` (with `malloc` if `NULL`) with room
+ * for `store_size` pointers, and frees it when destroyed. With `DA_FLAG_BORROWED`, `items` may
+ * be any memory which outlives the array, such as a static or stack buffer: it is never freed,
+ * and is copied to a new store the first time the array is resized.
+ * @see darray_err_init for errors
+ * @see DArray_detach
+ *
+ * @param items Backing store to adopt
+ * @param length Number of values at the start of `items`
+ * @param store_size Number of slots in `items`; must be at least 1 and at least `length`
+ * @param max_pool_size Maximum size of pool; must be between 0 and 1
+ * @param expand_rate Expansion rate of array; suitable value 1.5; must be greater than 1
+ * @param flags `DA_FLAG_RING` and/or `DA_FLAG_BORROWED`
+ * @param allocator Allocator for the array, which `items` came from; `NULL` for `malloc`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DArray on success, otherwise `NULL`, with `items` left to the caller
+ */
+DArray *DArray_from_buffer(void **items, DArraySize length, DArraySize store_size, double max_pool_size, double expand_rate, uint32_t flags, Allocator *allocator, int *res);
+
+/**
+ * @brief Number of inline slots in a DArray from `DArray_init_small`
+ *
+ * The default of 8 fills the cache line after the 64-byte header. Define before building to
+ * change it.
+ */
+#ifndef DARRAY_SMALL_SLOTS
+#define DARRAY_SMALL_SLOTS 8u
+#endif
+
+/**
+ * @brief Initialise a DArray which keeps its first values inside its own allocation
+ *
+ * The header and a store of `DARRAY_SMALL_SLOTS` slots come from a single allocation, with the
+ * slots straight after the header, so a small array costs one allocation instead of two and its
+ * values share the header's memory. The first expansion moves the values to a store of their own
+ * on the heap, as for a borrowed store (see `DA_FLAG_BORROWED`), and `DArray_shrink_to_fit`
+ * moves them back once they fit again. The array starts with no pool. Otherwise the array
+ * behaves as any other.
+ * @see darray_err_init for errors
+ *
+ * @param max_pool_size Maximum size of pool; must be between 0 and 1
+ * @param expand_rate Expansion rate of array; suitable value 1.5; must be greater than 1
+ * @param flags `DA_FLAG_RING` or 0
+ * @param allocator Allocator to use; `NULL` for `malloc`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DArray on success, otherwise `NULL`
+ */
+DArray *DArray_init_small(double max_pool_size, double expand_rate, uint32_t flags, Allocator *allocator, int *res);
+
+/**
+ * @brief Whether a darray's values are in the inline slots of `DArray_init_small`
+ *
+ * @param darray DArray to check
+ *
+ * @return Non-0 if the store is inline, otherwise 0
+ */
+static inline int DArray_is_inline(const DArray *darray)
+{
+    return (darray->flags & DA_FLAG_SMALL) && (const void *)darray->items == (const void *)(darray + 1);
+}
+
 /**
  * @brief Destroy a DArray and free its memory
  *
@@ -79,6 +317,54 @@ enum darray_err_init {
  */
 void DArray_destroy(DArray *darray);
 
+/**
+ * @brief Free a DArray, handing its backing store to the caller
+ *
+ * The values are first moved to the start of the store, so afterwards they occupy `items[0]`
+ * to `items[length - 1]`. The store was allocated from the array's allocator, and should be
+ * freed with `Allocator_free(allocator, items, store_size * sizeof(void *))`. A store which
+ * has grown into an anonymous mapping (see `DARRAY_MAP_THRESHOLD`) is copied to one from
+ * `malloc` first, so that it can be freed in the usual way. A borrowed store (see
+ * `DA_FLAG_BORROWED`) is the caller's buffer, returned as is, while an inline store (see
+ * `DArray_init_small`) is copied to one from the array's allocator.<br>
+ * Performance: `O(1)` if the values start at the start of the store, otherwise `O(n)`
+ * @see DArray_from_buffer
+ *
+ * @param darray DArray to detach; freed on success
+ * @param [out] length Number of values in the store
+ * @param [out] store_size Number of slots in the store
+ * @param [out] res Result; 0 on success, otherwise `DA_ERR_ARGS` if `darray` is `NULL`, or
+ * `DA_ERR_MEMORY` if the values couldn't be moved, in which case the array is left intact
+ *
+ * @return Backing store on success, otherwise `NULL`
+ */
+void **DArray_detach(DArray *darray, DArraySize *length, DArraySize *store_size, int *res);
+
+/**
+ * @brief Exchange the contents of two DArrays
+ *
+ * The values, backing stores, settings and tuning of the two arrays trade places, without
+ * copying anything, except that an array with its values inline (see `DArray_init_small`) first
+ * moves them to the heap, since the slots can't leave its header.<br>
+ * Performance: `O(1)`, plus up to two allocations for inline arrays
+ * @see darray_err_swap for errors
+ *
+ * @param darray First DArray
+ * @param other Second DArray; must use the same allocator as `darray`
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_swap(DArray *darray, DArray *other);
+
+/**
+ * @brief DArray_swap errors
+ * @see DArray_swap
+ */
+enum darray_err_swap {
+    DA_SWAP_ALLOCATOR   = 0x10, ///< The arrays use different allocators, so can't exchange stores
+    DA_SWAP_SPILL       = 0x20  ///< Error moving inline values to the heap
+};
+
 /**
  * @brief Get item of a darray at an index
  *
@@ -87,13 +373,163 @@ void DArray_destroy(DArray *darray);
  *
  * @return Value at given index, or `NULL` if it does not exist
  */
-void *DArray_index(DArray *darray, uint32_t index);
+void *DArray_index(DArray *darray, DArraySize index);
+
+/**
+ * @brief Contiguous run of values in a backing store
+ * @see DArray_spans
+ */
+typedef struct DArraySpan {
+    void **values;      ///< First value of the run
+    DArraySize length;  ///< Number of values in the run
+} DArraySpan;
+
+/**
+ * @brief Get the values of a darray as contiguous runs of the backing store
+ *
+ * The values are one run, or two if a ring-mode array wraps around the end of its store. The
+ * runs stay valid until the array is next modified, other than by writing values through them.<br>
+ * Performance: `O(1)`
+ *
+ * @param darray DArray to get the values of
+ * @param [out] spans Runs of values, in order; a second run is given 0 values if unused
+ *
+ * @return Number of non-empty runs: 0, 1 or 2
+ */
+static inline uint32_t DArray_spans(const DArray *darray, DArraySpan spans[2])
+{
+    uint64_t end = (uint64_t)darray->start_index + darray->length;
+
+    spans[0].values = darray->items + darray->start_index;
+    spans[1].values = darray->items;
+
+    if(end <= darray->store_size) {
+        spans[0].length = darray->length;
+        spans[1].length = 0;
+        return darray->length > 0;
+    }
+
+    spans[0].length = darray->store_size - darray->start_index;
+    spans[1].length = (DArraySize)(end - darray->store_size);
+    return 2;
+}
+
+/**
+ * @brief Iterator over the values of a DArray
+ *
+ * Walks the runs from `DArray_spans` directly, so the loop needs no index arithmetic or bounds
+ * checks past one comparison per value, and can be inlined into the caller. The array must not
+ * be modified while it is iterated, apart from writing through the runs.
+ * @see DArray_iter
+ * @see DArray_foreach
+ */
+typedef struct DArrayIter {
+    void **next;            ///< Slot of the next value
+    void **end;             ///< End of the current run
+    void **wrapped;         ///< Start of the second run of a wrapped ring, or `NULL`
+    DArraySize wrapped_length;  ///< Number of values in the second run
+    uint32_t prefetch;      ///< Values ahead whose targets are prefetched; 0 for none
+} DArrayIter;
+
+/**
+ * @brief Create an iterator over the values of a darray, first to last
+ *
+ * @param darray DArray to iterate over
+ * @param prefetch How many values ahead to prefetch the memory each value points to, for
+ * iterations which dereference every value; 0 if the values aren't dereferenced
+ *
+ * @return Iterator positioned before the first value
+ */
+static inline DArrayIter DArray_iter(const DArray *darray, uint32_t prefetch)
+{
+    DArraySpan spans[2];
+    DArray_spans(darray, spans);
+
+    DArrayIter iter = {
+        spans[0].values, spans[0].values + spans[0].length,
+        spans[1].length > 0 ? spans[1].values : NULL, spans[1].length, prefetch
+    };
+
+    return iter;
+}
+
+/**
+ * @brief Advance an iterator
+ *
+ * @param iter Iterator from `DArray_iter`
+ * @param [out] value Next value
+ *
+ * @return 1 if there was a next value, otherwise 0
+ */
+static inline int DArray_iter_next(DArrayIter *iter, void **value)
+{
+    if(iter->next == iter->end) {
+        if(iter->wrapped == NULL) {
+            return 0;
+        }
+
+        iter->next = iter->wrapped;
+        iter->end = iter->wrapped + iter->wrapped_length;
+        iter->wrapped = NULL;
+    }
+
+    if(iter->prefetch > 0 && (uintptr_t)(iter->end - iter->next) > iter->prefetch) {
+        __builtin_prefetch(iter->next[iter->prefetch]);
+    }
+
+    *value = *iter->next++;
+    return 1;
+}
+
+/**
+ * @brief Loop over the values of a darray, first to last
+ *
+ * For example, `void *value; DArray_foreach(darray, value) { ... }`
+ * @see DArrayIter
+ *
+ * @param darray DArray to iterate over
+ * @param value Name of a `void *` variable set to each value in turn
+ */
+#define DArray_foreach(darray, value) \
+    for(DArrayIter da_iter_##value = DArray_iter((darray), 0); DArray_iter_next(&da_iter_##value, &(value));)
+
+/**
+ * @brief Callback for `DArray_visit_chunks`
+ *
+ * @param values First of a run of contiguous values, which may be written through
+ * @param count Number of values in the run
+ * @param index Index in the array of the first value
+ * @param ctx Context given to `DArray_visit_chunks`
+ *
+ * @return 0 to continue, otherwise non-0 to stop visiting
+ */
+typedef int (*DArray_visit)(void **values, DArraySize count, DArraySize index, void *ctx);
+
+/**
+ * @brief Hand the values of a darray to a callback as contiguous runs
+ *
+ * Each run is at most `chunk_size` values, and the runs cover the array in order. While one
+ * run is visited, the start of the next is prefetched. The array must not be modified during
+ * the visit, apart from writing through the runs.<br>
+ * Performance: `O(n / chunk_size)` calls
+ *
+ * @param darray DArray to visit
+ * @param chunk_size Maximum values in each run; 0 for runs as long as the store allows
+ * @param visit Callback
+ * @param ctx Context passed to `visit`
+ *
+ * @return 0 once every value has been visited, the non-0 result of `visit` if it stopped, or
+ * `DA_ERR_ARGS` if `darray` or `visit` is `NULL`
+ */
+int DArray_visit_chunks(DArray *darray, DArraySize chunk_size, DArray_visit visit, void *ctx);
 
 /**
  * @brief Expand the backing store of a DArray
  *
  * Performance is dependent on the performance of `realloc`; generally good unless element copying
- * is required by `realloc`
+ * is required by `realloc`. Stores at or above `map_threshold` are grown with `mremap` instead,
+ * which remaps pages rather than copying them
+ * @see DARRAY_MAP_THRESHOLD
  * @see darray_err_expand for errors
  *
  * @param darray DArray to expand
@@ -107,9 +543,122 @@ int DArray_expand(DArray *darray);
  * @see DArray_expand
  */
 enum darray_err_expand {
-    DA_EXPAND_REALLOC   = 0x10 ///< Error encountered in `realloc` call
+    DA_EXPAND_REALLOC   = 0x10, ///< Error encountered in `realloc` call
+    DA_EXPAND_LIMIT     = 0x20  ///< Backing store is already at the maximum size
+};
+
+/**
+ * @brief Ensure a darray can hold a number of values without expanding
+ *
+ * The backing store is resized once, to exactly the size required, if it is too small. For
+ * an array with a pool, `capacity` counts from the first value, so the pool is unaffected<br>
+ * Performance: `O(1)`, plus one `realloc` if the array lacks room
+ * @see darray_err_reserve for errors
+ *
+ * @param darray DArray to reserve space in
+ * @param capacity Number of values the array must be able to hold
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_reserve(DArray *darray, DArraySize capacity);
+
+/**
+ * @brief Ensure a darray has a pool of at least a given size
+ *
+ * Moves the values once if the pool is too small, leaving capacity at the end untouched. For
+ * a ring-mode array, any free slot can take an unshift, so this reserves `length + pool_size`.
+ * Note that shifting trims the pool to `max_pool_size`, so a pool which exceeds that will be
+ * shrunk by the next shift<br>
+ * Performance: `O(1)` if the pool is large enough, otherwise `O(n)`
+ * @see darray_err_reserve for errors
+ *
+ * @param darray DArray to reserve space in
+ * @param pool_size Number of values the array must be able to unshift without moving
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_reserve_front(DArray *darray, DArraySize pool_size);
+
+/**
+ * @brief DArray_reserve and DArray_reserve_front errors
+ * @see DArray_reserve
+ * @see DArray_reserve_front
+ */
+enum darray_err_reserve {
+    DA_RESERVE_EXPAND   = 0x10, ///< Error encountered expanding the store, see secondary detail for error
+    DA_RESERVE_MOVE     = 0x20  ///< Error encountered in `DArray_move`, see secondary detail for error
 };
 
+/**
+ * @brief Release unused capacity of a darray
+ *
+ * Shrinks the backing store to the values plus whatever part of the pool `max_pool_size`
+ * allows for the current length; ring-mode arrays are linearised and keep no free slots. An
+ * empty array keeps one slot. An array from `DArray_init_small` whose values fit in its inline
+ * slots moves them back there and frees its heap store<br>
+ * Performance: `O(n)` as the values may need moving; `O(1)` if nothing can be released
+ * @see darray_err_shrink for errors
+ *
+ * @param darray DArray to shrink
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_shrink_to_fit(DArray *darray);
+
+/**
+ * @brief DArray_shrink_to_fit errors
+ * @see DArray_shrink_to_fit
+ */
+enum darray_err_shrink {
+    DA_SHRINK_REALLOC   = 0x10  ///< Error encountered in `realloc` call or linearising the array
+};
+
+/**
+ * @brief Let a darray tune its own `expand_rate` and `max_pool_size` as its workload changes
+ *
+ * The array counts the values added and removed, and revisits its parameters only at the events
+ * they govern, so the hot paths gain just a counter:
+ *
+ * - On expansion, if at least half of the operations since the last expansion were net growth,
+ *   the array is filling, and `expand_rate` moves halfway to `max_expand_rate` to cut the number
+ *   of reallocations and copies. Otherwise values are churning, and it moves halfway to
+ *   `min_expand_rate` to cut the memory held at the peak.
+ * - When an unshift finds the pool empty, or a shift finds it past `max_pool_size`, the values
+ *   are moved. If that move copies more values than the operations served since the last such
+ *   event, moves dominate, and `max_pool_size` moves halfway to its upper bound.
+ *   If instead a shift finds the pool has gone unused by unshifts and the move was cheap, the
+ *   pool is idle, and `max_pool_size` moves halfway to its lower bound.
+ *
+ * Calling this on an array which is already tuning resets its counters and bounds. The current
+ * parameters are clamped into the bounds.
+ * Performance: `O(1)`
+ * @see darray_err_tuning for errors
+ *
+ * @param darray DArray to tune
+ * @param min_expand_rate Lowest expansion rate; greater than 1. Suitable value 1.25
+ * @param max_expand_rate Highest expansion rate; at least `min_expand_rate`. Suitable value 2
+ * @param min_pool_size Lowest maximum pool size; between 0 and 1. Suitable value 0
+ * @param max_pool_size Highest maximum pool size; between `min_pool_size` and 1. Suitable value 0.5
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_enable_tuning(DArray *darray, double min_expand_rate, double max_expand_rate, double min_pool_size, double max_pool_size);
+
+/**
+ * @brief DArray_enable_tuning errors
+ * @see DArray_enable_tuning
+ */
+enum darray_err_tuning {
+    DA_TUNING_BOUNDS    = 0x10  ///< Bounds out of range or reversed
+};
+
+/**
+ * @brief Stop a darray tuning itself, keeping its current parameters
+ *
+ * @param darray DArray to stop tuning
+ */
+void DArray_disable_tuning(DArray *darray);
+
 /**
  * @brief Move all elements of a darray
  *
@@ -123,16 +672,32 @@ enum darray_err_expand {
  *
  * @return Result; 0 on success, otherwise non-0
  */
-int DArray_move(DArray *darray, int dist);
+int DArray_move(DArray *darray, int64_t dist);
 
 /**
  * @brief DArray_move errors
  * @see DArray_move
  */
 enum darray_err_move {
-    DA_MOVE_EXPAND  = 0x10 ///< Error encountered in `DArray_expand`, see secondary detail for error
+    DA_MOVE_EXPAND  = 0x10, ///< Error encountered in `DArray_expand`, see secondary detail for error
+    DA_MOVE_RANGE   = 0x20, ///< Move would place values before the start of the backing store
+    DA_MOVE_RING    = 0x30  ///< DArray is in ring mode; values cannot be moved
 };
 
+/**
+ * @brief Make the values of a darray contiguous in the backing store
+ *
+ * Only ring-mode arrays can be non-contiguous; for any other array this does nothing.
+ * Afterwards the values occupy `items[start_index]` to `items[start_index + length - 1]`
+ * until the next unshift or push wraps around again<br>
+ * Performance: `O(n)` if the values wrap, otherwise `O(1)`
+ *
+ * @param darray DArray to linearise
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_MEMORY`
+ */
+int DArray_linearise(DArray *darray);
+
 /**
  * @brief Push a value onto the end of a darray
  *
@@ -213,8 +778,206 @@ enum darray_err_shift {
 };
 
 /**
- * @brief Quicksort a darray (not yet implemented)
+ * @brief Push several values onto the end of a darray
+ *
+ * The backing store is expanded at most once, to fit the whole batch, and the values are then
+ * copied in with a single `memcpy`<br>
+ * Performance: `O(count)`, plus one expansion if the array lacks room
+ * @see darray_err_push for errors
+ *
+ * @param darray DArray to push values onto
+ * @param values Values to push, in order
+ * @param count Number of values
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_push_n(DArray *darray, void **values, DArraySize count);
+
+/**
+ * @brief Unshift several values onto the start of a darray
+ *
+ * Afterwards `values[0]` is at index 0, `values[1]` at index 1, and so on. If the pool is too
+ * small for the batch, the array is moved once to fit it and a rebuilt pool<br>
+ * Best-case performance: `O(count)` if the pool can hold the values<br>
+ * Worst-case performance: `O(count) + move`
+ * @see darray_err_unshift for errors
+ *
+ * @param darray DArray to unshift values onto
+ * @param values Values to unshift, in order
+ * @param count Number of values
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_unshift_n(DArray *darray, void **values, DArraySize count);
+
+/**
+ * @brief Pop several values from the end of a darray
+ *
+ * The removed values are copied out in array order, so `values[0]` is the value which was at
+ * index `length - count`<br>
+ * Performance: `O(count)`
+ *
+ * @param darray DArray to pop values from
+ * @param [out] values Destination for at least `count` values, or `NULL` to discard them
+ * @param count Maximum number of values to pop
+ *
+ * @return Number of values popped
+ */
+DArraySize DArray_pop_n(DArray *darray, void **values, DArraySize count);
+
+/**
+ * @brief Shift several values from the start of a darray
+ *
+ * The removed values are copied out in array order. The pool is resized at most once<br>
+ * Best-case performance: `O(count)` if the pool does not require shrinking<br>
+ * Worst-case performance: `O(count) + move`
+ * @see darray_err_shift for errors
+ *
+ * @param darray DArray to shift values from
+ * @param [out] values Destination for at least `count` values, or `NULL` to discard them
+ * @param count Maximum number of values to shift
+ * @param [out] res Result; 0 on success, non-0 otherwise
+ *
+ * @return Number of values shifted
+ */
+DArraySize DArray_shift_n(DArray *darray, void **values, DArraySize count, int *res);
+
+/**
+ * @brief Replace a range of values in a darray
+ *
+ * Removes `remove` values starting at `index` and inserts `count` values in their place. Only
+ * the values on the shorter side of the range are moved: when that is the head, it is moved
+ * into the pool (if the pool can fit it), otherwise the tail is moved<br>
+ * Performance: `O(count + remove + min(index, length - index - remove))`, plus at most one
+ * expansion
+ * @see darray_err_splice for errors
+ *
+ * @param darray DArray to splice
+ * @param index Index of the first value to remove, or of the insertion point
+ * @param remove Number of values to remove
+ * @param [out] removed Destination for the `remove` removed values, or `NULL` to discard them
+ * @param values Values to insert, in order
+ * @param count Number of values to insert
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_splice(DArray *darray, DArraySize index, DArraySize remove, void **removed, void **values, DArraySize count);
+
+/**
+ * @brief DArray_splice errors
+ * @see DArray_splice
+ */
+enum darray_err_splice {
+    DA_SPLICE_RANGE     = 0x10, ///< Removed range extends past the end of the array
+    DA_SPLICE_EXPAND    = 0x20  ///< Error encountered in `DArray_expand`, see secondary detail for error
+};
+
+/**
+ * @brief Insert a value into a darray before an index
+ *
+ * Equivalent to a `DArray_splice` which removes nothing, so only the shorter side moves<br>
+ * Performance: `O(min(index, length - index))`, plus expansion if required
+ * @see darray_err_splice for errors
+ *
+ * @param darray DArray to insert into
+ * @param index Index the value will have; may be `length` to append
+ * @param value Value to insert
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_insert(DArray *darray, DArraySize index, void *value);
+
+/**
+ * @brief Comparison function for DArray values
+ *
+ * Returns a value less than, equal to or greater than 0 when `val1` sorts before, alongside
+ * or after `val2` respectively
+ */
+typedef int (*DArray_compare)(void *val1, void *val2);
+
+/**
+ * @brief Sort the values of a darray in place
+ *
+ * Introspective quicksort over the values of the array (the pool is untouched): median-of-three
+ * pivots, insertion sort for small partitions, and a heapsort fallback if partitioning degrades<br>
+ * Performance: `O(n log n)`; the sort is not stable<br>
+ * Each comparison is an indirect call through `compare`; use `DARRAY_QSORT_DEFINE` from
+ * `darray_sort.h` to generate a sort with an inline comparison<br>
+ * Ring-mode arrays are linearised first; the array is left unsorted if that fails
+ *
+ * @param darray DArray to sort
+ * @param compare Comparison function
  */
 void DArray_qsort(DArray *darray, int (compare)(void *val1, void *val2));
 
+/**
+ * @brief Index returned by searches when no value matches
+ */
+#define DA_NOT_FOUND DARRAY_SIZE_MAX
+
+/**
+ * @brief Find where a value would be inserted before any equal values in a sorted darray
+ *
+ * The array must be sorted by `compare`. Each halving step selects the next range without a
+ * data-dependent branch. Performance: `O(log n)`
+ *
+ * @param darray DArray to search
+ * @param value Value to search for
+ * @param compare Comparison the array is sorted by
+ *
+ * @return Index of the first value which does not sort before `value`; `length` if there is none
+ */
+DArraySize DArray_lower_bound(DArray *darray, void *value, DArray_compare compare);
+
+/**
+ * @brief Find where a value would be inserted after any equal values in a sorted darray
+ *
+ * The array must be sorted by `compare`. Performance: `O(log n)`
+ *
+ * @param darray DArray to search
+ * @param value Value to search for
+ * @param compare Comparison the array is sorted by
+ *
+ * @return Index of the first value which sorts after `value`; `length` if there is none
+ */
+DArraySize DArray_upper_bound(DArray *darray, void *value, DArray_compare compare);
+
+/**
+ * @brief Find a value in a sorted darray
+ *
+ * The array must be sorted by `compare`. Performance: `O(log n)`
+ *
+ * @param darray DArray to search
+ * @param value Value to search for
+ * @param compare Comparison the array is sorted by
+ *
+ * @return Index of the first value equal to `value` under `compare`, or `DA_NOT_FOUND`
+ */
+DArraySize DArray_bsearch(DArray *darray, void *value, DArray_compare compare);
+
+/**
+ * @brief Insert a value into a sorted darray, after any values equal to it
+ *
+ * Only the shorter side of the insertion point moves, as for `DArray_insert`. When the head is
+ * the shorter side but the pool is exhausted, the pool is first rebuilt at its maximum size as
+ * `DArray_unshift` does, so inserts near the front stay amortised `O(1)` moves.
+ * Performance: `O(log n + min(index, length - index))`
+ * @see darray_err_splice and darray_err_insert_sorted for errors
+ *
+ * @param darray DArray sorted by `compare`
+ * @param value Value to insert
+ * @param compare Comparison the array is sorted by
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DArray_insert_sorted(DArray *darray, void *value, DArray_compare compare);
+
+/**
+ * @brief DArray_insert_sorted errors
+ * @see DArray_insert_sorted
+ */
+enum darray_err_insert_sorted {
+    DA_INSERT_SORTED_MOVE = 0x30    ///< Error encountered in `DArray_move`, see secondary detail for error
+};
+
 #endif
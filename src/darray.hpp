@@ -0,0 +1,108 @@
+/**
+ * @file darray.hpp
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief C++ wrapper for arrays generated by `DARRAY_DEFINE`
+ *
+ * @code
+ * DARRAY_DEFINE(IntArray, int)
+ *
+ * darray::Array<IntArray> values;
+ * values.push(42);
+ * @endcode
+ */
+
+#ifndef DArray_hpp
+#define DArray_hpp
+
+#include "darray_define.h"
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace darray {
+
+/**
+ * @brief Owning wrapper around an array type generated by `DARRAY_DEFINE`
+ *
+ * Every call forwards to the generated `static inline` functions, so there is no overhead over
+ * using them directly from C. Results are returned as from C, except that construction throws
+ * `std::bad_alloc` if the array cannot be created.
+ *
+ * A moved-from `Array` holds no array: `size` is 0 and `empty` is true, `get` returns `NULL`,
+ * and otherwise it may only be destroyed or assigned to.
+ *
+ * @tparam A Array type named in `DARRAY_DEFINE`
+ */
+template<typename A>
+class Array {
+public:
+    typedef typename darray_traits<A>::value_type value_type;
+
+    /**
+     * @brief Create an array; parameters are as for `DVArray_init_with_pool`
+     */
+    explicit Array(uint32_t length = 8, double max_pool_size = 0.3, double expand_rate = 1.5, uint32_t pool_size = 0)
+        : array_(darray_traits<A>::init_with_pool(length, max_pool_size, expand_rate, pool_size, NULL))
+    {
+        if(array_ == NULL) {
+            throw std::bad_alloc();
+        }
+    }
+
+    ~Array() { darray_traits<A>::destroy(array_); }
+
+    Array(const Array &) = delete;
+    Array &operator=(const Array &) = delete;
+
+    Array(Array &&other) noexcept : array_(other.array_) { other.array_ = NULL; }
+
+    Array &operator=(Array &&other) noexcept
+    {
+        std::swap(array_, other.array_);
+        return *this;
+    }
+
+    /// Number of values in the array; 0 if moved from
+    DArraySize size() const { return array_ != NULL ? array_->length : 0; }
+
+    /// Whether the array has no values; true if moved from
+    bool empty() const { return size() == 0; }
+
+    /// Value at an index; unchecked
+    value_type &operator[](uint32_t index) { return array_->items[array_->start_index + index]; }
+
+    /// Value at an index; unchecked
+    const value_type &operator[](uint32_t index) const { return array_->items[array_->start_index + index]; }
+
+    /// @see DVArray_index
+    value_type *index(uint32_t index) { return darray_traits<A>::index(array_, index); }
+
+    value_type *begin() { return array_->items + array_->start_index; }
+    value_type *end() { return begin() + array_->length; }
+    const value_type *begin() const { return array_->items + array_->start_index; }
+    const value_type *end() const { return begin() + array_->length; }
+
+    /// @see DVArray_push
+    int push(const value_type &value) { return darray_traits<A>::push(array_, value); }
+
+    /// @see DVArray_pop
+    int pop(value_type *value = NULL) { return darray_traits<A>::pop(array_, value); }
+
+    /// @see DVArray_unshift
+    int unshift(const value_type &value) { return darray_traits<A>::unshift(array_, value); }
+
+    /// @see DVArray_shift
+    int shift(value_type *value = NULL) { return darray_traits<A>::shift(array_, value); }
+
+    /// Underlying C array, for use with the generated functions
+    A *get() { return array_; }
+
+private:
+    A *array_;
+};
+
+}
+
+#endif
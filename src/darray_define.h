@@ -0,0 +1,275 @@
+/**
+ * @file darray_define.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Generator macros for type-specialised dynamic arrays
+ *
+ * `DArray` stores `void *`, so storing anything else means allocating it separately and every
+ * access goes through a pointer. The macros in this file emit a dynamic array for a concrete
+ * element type, stored inline, with the same pool semantics and API shape as `DVArray`. All
+ * generated functions are `static inline`, so the compiler can inline and vectorise them.
+ * @see DVArray
+ */
+
+#ifndef DArray_define_h
+#define DArray_define_h
+
+#include "darray.h"
+#include "darray_sort.h"
+#include "dvarray.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+/**
+ * @brief Access to a generated array type from C++; specialised by `DARRAY_DEFINE`
+ * @see darray.hpp
+ */
+template<typename A> struct darray_traits;
+
+#define DARRAY_DEFINE_TRAITS(name, T)                                                               \
+    template<> struct darray_traits<name> {                                                         \
+        typedef T value_type;                                                                       \
+        static name *init_with_pool(uint32_t length, double max_pool_size, double expand_rate,      \
+                uint32_t pool_size, int *res)                                                       \
+        { return name##_init_with_pool(length, max_pool_size, expand_rate, pool_size, res); }       \
+        static void destroy(name *array) { name##_destroy(array); }                                 \
+        static T *index(name *array, uint32_t index) { return name##_index(array, index); }         \
+        static int push(name *array, T value) { return name##_push(array, value); }                 \
+        static int pop(name *array, T *value) { return name##_pop(array, value); }                  \
+        static int unshift(name *array, T value) { return name##_unshift(array, value); }           \
+        static int shift(name *array, T *value) { return name##_shift(array, value); }              \
+    };
+#else
+#define DARRAY_DEFINE_TRAITS(name, T)
+#endif
+
+/**
+ * @brief Define a dynamic array of `T`
+ *
+ * Emits `typedef struct name { ... } name;` with the same fields as `DVArray` except that
+ * `items` is a `T *`, and the following functions, each behaving as its `DVArray` counterpart
+ * and returning the same errors:
+ *
+ * - `name *name_init_with_pool(uint32_t length, double max_pool_size, double expand_rate, uint32_t pool_size, int *res)`
+ * - `void name_destroy(name *array)`
+ * - `T *name_index(name *array, uint32_t index)`
+ * - `int name_expand(name *array)`
+ * - `int name_move(name *array, int64_t dist)`
+ * - `int name_push(name *array, T value)`
+ * - `int name_pop(name *array, T *value)`
+ * - `int name_unshift(name *array, T value)`
+ * - `int name_shift(name *array, T *value)`
+ *
+ * Use at file scope; in C++ this also specialises `darray_traits` for `darray.hpp`.
+ *
+ * @param name Name of the generated type, and prefix of the generated functions
+ * @param T Element type; must be copyable by assignment
+ */
+#define DARRAY_DEFINE(name, T)                                                                      \
+    typedef struct name {                                                                           \
+        uint32_t length;                                                                            \
+        uint32_t store_size;                                                                        \
+        uint32_t start_index;                                                                       \
+        double expand_rate;                                                                         \
+        double max_pool_size;                                                                       \
+        T *items;                                                                                   \
+    } name;                                                                                         \
+                                                                                                    \
+    static inline name *name##_init_with_pool(uint32_t length, double max_pool_size,                \
+            double expand_rate, uint32_t pool_size, int *res)                                       \
+    {                                                                                               \
+        int err = 0;                                                                                \
+        name *array = NULL;                                                                         \
+        if(length == 0) {                                                                           \
+            err = DA_ERR_ARGS | DA_INIT_LENGTH;                                                     \
+        } else if(!(max_pool_size >= 0 && max_pool_size <= 1)) {                                    \
+            err = DA_ERR_ARGS | DA_INIT_M_POOL_SIZE;                                                \
+        } else if(!(expand_rate > 1)) {                                                             \
+            err = DA_ERR_ARGS | DA_INIT_EXPAND_RATE;                                                \
+        } else if(pool_size >= length) {                                                            \
+            err = DA_ERR_ARGS | DA_INIT_POOL_SIZE;                                                  \
+        } else if((array = (name *)malloc(sizeof(name))) == NULL) {                                 \
+            err = DA_ERR_MEMORY;                                                                    \
+        } else if((array->items = (T *)malloc((size_t)length * sizeof(T))) == NULL) {               \
+            free(array);                                                                            \
+            array = NULL;                                                                           \
+            err = DA_ERR_MEMORY;                                                                    \
+        } else {                                                                                    \
+            array->length = 0;                                                                      \
+            array->store_size = length;                                                             \
+            array->start_index = pool_size;                                                         \
+            array->expand_rate = expand_rate;                                                       \
+            array->max_pool_size = max_pool_size;                                                   \
+        }                                                                                           \
+        if(res != NULL) {                                                                           \
+            *res = err;                                                                             \
+        }                                                                                           \
+        return array;                                                                               \
+    }                                                                                               \
+                                                                                                    \
+    static inline void name##_destroy(name *array)                                                  \
+    {                                                                                               \
+        if(array != NULL) {                                                                         \
+            free(array->items);                                                                     \
+            free(array);                                                                            \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline T *name##_index(name *array, uint32_t index)                                      \
+    {                                                                                               \
+        if(array == NULL || index >= array->length) {                                               \
+            return NULL;                                                                            \
+        }                                                                                           \
+        return array->items + array->start_index + index;                                           \
+    }                                                                                               \
+                                                                                                    \
+    /* Grow the store to hold at least needed values, by at least expand_rate, in one realloc */    \
+    static inline int name##_grow(name *array, uint64_t needed)                                     \
+    {                                                                                               \
+        if(needed <= array->store_size) {                                                           \
+            return 0;                                                                               \
+        }                                                                                           \
+        if(needed > UINT32_MAX) {                                                                   \
+            return DA_ERR_MEMORY | DA_EXPAND_LIMIT;                                                 \
+        }                                                                                           \
+        double scaled = array->store_size * array->expand_rate;                                     \
+        uint32_t new_size = scaled >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)scaled;           \
+        new_size = new_size > needed ? new_size : (uint32_t)needed;                                 \
+        T *items = (T *)realloc(array->items, (size_t)new_size * sizeof(T));                        \
+        if(items == NULL) {                                                                         \
+            return DA_ERR_MEMORY | DA_EXPAND_REALLOC;                                               \
+        }                                                                                           \
+        array->items = items;                                                                       \
+        array->store_size = new_size;                                                               \
+        return 0;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline int name##_expand(name *array)                                                    \
+    {                                                                                               \
+        if(array == NULL) {                                                                         \
+            return DA_ERR_ARGS;                                                                     \
+        }                                                                                           \
+        return name##_grow(array, (uint64_t)array->store_size + 1);                                 \
+    }                                                                                               \
+                                                                                                    \
+    static inline int name##_move(name *array, int64_t dist)                                        \
+    {                                                                                               \
+        if(array == NULL) {                                                                         \
+            return DA_ERR_ARGS;                                                                     \
+        }                                                                                           \
+        int64_t start = (int64_t)array->start_index + dist;                                         \
+        if(start < 0) {                                                                             \
+            return DA_ERR_ARGS | DA_MOVE_RANGE;                                                     \
+        }                                                                                           \
+        int rc = name##_grow(array, (uint64_t)start + array->length);                               \
+        if(rc != 0) {                                                                               \
+            return da_chain(DA_MOVE_EXPAND, rc);                                                    \
+        }                                                                                           \
+        memmove(array->items + start, array->items + array->start_index,                            \
+                (size_t)array->length * sizeof(T));                                                 \
+        array->start_index = (uint32_t)start;                                                       \
+        return 0;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline int name##_push(name *array, T value)                                             \
+    {                                                                                               \
+        if(array == NULL) {                                                                         \
+            return DA_ERR_ARGS;                                                                     \
+        }                                                                                           \
+        if(array->start_index + array->length == array->store_size) {                               \
+            int rc = name##_expand(array);                                                          \
+            if(rc != 0) {                                                                           \
+                return da_chain(DA_PUSH_EXPAND, rc);                                                \
+            }                                                                                       \
+        }                                                                                           \
+        array->items[array->start_index + array->length] = value;                                   \
+        array->length++;                                                                            \
+        return 0;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline int name##_pop(name *array, T *value)                                             \
+    {                                                                                               \
+        if(array == NULL || array->length == 0) {                                                   \
+            return DA_ERR_ARGS | DV_EMPTY;                                                          \
+        }                                                                                           \
+        array->length--;                                                                            \
+        if(value != NULL) {                                                                         \
+            *value = array->items[array->start_index + array->length];                              \
+        }                                                                                           \
+        return 0;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline int name##_unshift(name *array, T value)                                          \
+    {                                                                                               \
+        if(array == NULL) {                                                                         \
+            return DA_ERR_ARGS;                                                                     \
+        }                                                                                           \
+        if(array->start_index == 0) {                                                               \
+            /* Pool exhausted; rebuild it at its maximum size */                                    \
+            uint32_t pool = (uint32_t)(array->store_size * array->max_pool_size);                   \
+            int rc = name##_move(array, pool > 0 ? (int64_t)pool : 1);                              \
+            if(rc != 0) {                                                                           \
+                return da_chain(DA_UNSHIFT_MOVE, rc);                                               \
+            }                                                                                       \
+        }                                                                                           \
+        array->start_index--;                                                                       \
+        array->items[array->start_index] = value;                                                   \
+        array->length++;                                                                            \
+        return 0;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline int name##_shift(name *array, T *value)                                           \
+    {                                                                                               \
+        if(array == NULL || array->length == 0) {                                                   \
+            return DA_ERR_ARGS | DV_EMPTY;                                                          \
+        }                                                                                           \
+        if(value != NULL) {                                                                         \
+            *value = array->items[array->start_index];                                              \
+        }                                                                                           \
+        array->start_index++;                                                                       \
+        array->length--;                                                                            \
+        /* Pool has outgrown its maximum; shrink it to half that */                                 \
+        uint32_t limit = (uint32_t)(array->store_size * array->max_pool_size);                      \
+        if(array->start_index > limit) {                                                            \
+            if(array->length == 0) {                                                                \
+                array->start_index = limit / 2;                                                     \
+            } else {                                                                                \
+                int rc = name##_move(array, -(int64_t)(array->start_index - limit / 2));            \
+                if(rc != 0) {                                                                       \
+                    return da_chain(DA_SHIFT_MOVE, rc);                                             \
+                }                                                                                   \
+            }                                                                                       \
+        }                                                                                           \
+        return 0;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    DARRAY_DEFINE_TRAITS(name, T)
+
+/**
+ * @brief Define a sort for an array generated by `DARRAY_DEFINE`
+ *
+ * Emits `static void name_sort(name *array)`, an introsort of the values of `array` in place.
+ * `less(a, b)` is given two `T` values and must evaluate to non-0 when `a` sorts before `b`.
+ * @see DARRAY_SORT_DEFINE
+ *
+ * @param name Name given to `DARRAY_DEFINE`
+ * @param T Element type given to `DARRAY_DEFINE`
+ * @param less Comparison; `less(a, b)`
+ */
+#define DARRAY_DEFINE_SORT(name, T, less)                                                           \
+    static inline int name##_sort_less(T a, T b, int ctx)                                           \
+    {                                                                                               \
+        (void)ctx;                                                                                  \
+        return less(a, b);                                                                          \
+    }                                                                                               \
+    DARRAY_SORT_DEFINE(name##_sort_items, T, int, name##_sort_less)                                 \
+    static inline void name##_sort(name *array)                                                     \
+    {                                                                                               \
+        if(array != NULL) {                                                                         \
+            name##_sort_items(array->items + array->start_index, array->length, 0);                 \
+        }                                                                                           \
+    }
+
+#endif
@@ -0,0 +1,109 @@
+#include "darray_eytzinger.h"
+#include "dbg.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief Alignment of the tree; the eight descendants three levels below a node then share one
+ * cache line
+ */
+#define EY_CACHE_LINE 64
+
+// Fill the subtree rooted at k with values from index i on, in order; returns the next index
+static DArraySize ey_fill(DAEytzinger *eytzinger, DArray *darray, DArraySize i, uint64_t k)
+{
+    if(k <= eytzinger->length) {
+        i = ey_fill(eytzinger, darray, i, 2 * k);
+        eytzinger->tree[k] = DArray_index(darray, i);
+        eytzinger->rank[k] = i;
+        i = ey_fill(eytzinger, darray, i + 1, 2 * k + 1);
+    }
+
+    return i;
+}
+
+DAEytzinger *DAEytzinger_init(DArray *darray, int *res)
+{
+    DAEytzinger *eytzinger = NULL;
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    eytzinger = calloc(1, sizeof(DAEytzinger));
+    check_err(eytzinger != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    size_t size = ((size_t)darray->length + 1) * sizeof(void *);
+    eytzinger->length = darray->length;
+    eytzinger->tree = aligned_alloc(EY_CACHE_LINE, (size + EY_CACHE_LINE - 1) & ~(size_t)(EY_CACHE_LINE - 1));
+    eytzinger->rank = malloc(((size_t)darray->length + 1) * sizeof(DArraySize));
+    check_err(eytzinger->tree != NULL && eytzinger->rank != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    eytzinger->tree[0] = NULL;
+    eytzinger->rank[0] = darray->length;
+    ey_fill(eytzinger, darray, 0, 1);
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return eytzinger;
+
+error:
+    DAEytzinger_destroy(eytzinger);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void DAEytzinger_destroy(DAEytzinger *eytzinger)
+{
+    if(eytzinger == NULL) {
+        return;
+    }
+
+    free(eytzinger->tree);
+    free(eytzinger->rank);
+    free(eytzinger);
+}
+
+// Node of the first value which does not sort before value, or 0 if there is none
+static uint64_t ey_descend(DAEytzinger *eytzinger, void *value, DArray_compare compare)
+{
+    void **tree = eytzinger->tree;
+    uint64_t length = eytzinger->length;
+    uint64_t k = 1;
+
+    // Go right past every value which sorts before value, fetching three levels ahead
+    while(k <= length) {
+        __builtin_prefetch(tree + (8 * k <= length ? 8 * k : 0));
+        k = 2 * k + (compare(tree[k], value) < 0);
+    }
+
+    // The answer is the last node where the descent went left: drop the trailing rights and it
+    return k >> __builtin_ffsll((long long)~k);
+}
+
+DArraySize DAEytzinger_lower_bound(DAEytzinger *eytzinger, void *value, DArray_compare compare)
+{
+    if(eytzinger == NULL || compare == NULL) {
+        return 0;
+    }
+
+    return eytzinger->rank[ey_descend(eytzinger, value, compare)];
+}
+
+DArraySize DAEytzinger_bsearch(DAEytzinger *eytzinger, void *value, DArray_compare compare)
+{
+    if(eytzinger == NULL || compare == NULL) {
+        return DA_NOT_FOUND;
+    }
+
+    uint64_t k = ey_descend(eytzinger, value, compare);
+    if(k == 0 || compare(eytzinger->tree[k], value) != 0) {
+        return DA_NOT_FOUND;
+    }
+
+    return eytzinger->rank[k];
+}
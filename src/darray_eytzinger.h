@@ -0,0 +1,84 @@
+/**
+ * @file darray_eytzinger.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Eytzinger-layout search index over a sorted DArray
+ *
+ * A binary search over a sorted array touches a new cache line at almost every step once the
+ * array is much larger than the cache, and which line comes next depends on the comparison just
+ * made. Laid out in breadth-first (Eytzinger) order instead, the candidates for the next few
+ * steps are adjacent in memory, so they can be prefetched before they are needed, and the
+ * descent needs no branch other than its loop. Building the layout costs a copy of the array,
+ * so it suits arrays which are searched far more often than they change.
+ */
+
+#ifndef DArray_eytzinger_h
+#define DArray_eytzinger_h
+
+#include "darray.h"
+#include "stdint.h"
+
+/**
+ * @brief Values of a sorted DArray in Eytzinger order
+ *
+ * `tree[1]` is the root and the children of `tree[k]` are `tree[2k]` and `tree[2k + 1]`. The
+ * index is a snapshot; rebuild it after changing the array.
+ */
+typedef struct DAEytzinger {
+    DArraySize length;  ///< Number of values
+    void **tree;        ///< Values in breadth-first order; `length + 1` slots, of which slot 0 is unused
+    DArraySize *rank;   ///< Index in the DArray of each value of `tree`
+} DAEytzinger;
+
+/**
+ * @brief Build an Eytzinger index over a sorted darray
+ *
+ * Performance: `O(n)`
+ *
+ * @param darray DArray, sorted by the comparison later searches will use
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DAEytzinger on success, otherwise `NULL`
+ */
+DAEytzinger *DAEytzinger_init(DArray *darray, int *res);
+
+/**
+ * @brief Destroy a DAEytzinger and free its memory
+ *
+ * The values themselves are not freed.
+ *
+ * @param eytzinger DAEytzinger to free
+ */
+void DAEytzinger_destroy(DAEytzinger *eytzinger);
+
+/**
+ * @brief Find where a value would be inserted before any equal values in the indexed darray
+ *
+ * Equivalent to `DArray_lower_bound` on the darray the index was built from.
+ * Performance: `O(log n)`
+ *
+ * @param eytzinger DAEytzinger to search
+ * @param value Value to search for
+ * @param compare Comparison the darray is sorted by
+ *
+ * @return Index in the darray of the first value which does not sort before `value`; `length`
+ * if there is none
+ */
+DArraySize DAEytzinger_lower_bound(DAEytzinger *eytzinger, void *value, DArray_compare compare);
+
+/**
+ * @brief Find a value in the indexed darray
+ *
+ * Equivalent to `DArray_bsearch` on the darray the index was built from.
+ * Performance: `O(log n)`
+ *
+ * @param eytzinger DAEytzinger to search
+ * @param value Value to search for
+ * @param compare Comparison the darray is sorted by
+ *
+ * @return Index in the darray of the first value equal to `value` under `compare`, or
+ * `DA_NOT_FOUND`
+ */
+DArraySize DAEytzinger_bsearch(DAEytzinger *eytzinger, void *value, DArray_compare compare);
+
+#endif
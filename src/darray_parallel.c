@@ -0,0 +1,509 @@
+#include "darray_parallel.h"
+#include "darray_sort.h"
+#include "dbg.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DA_COMPARE_LESS(a, b, compare) ((compare)((a), (b)) < 0)
+
+DARRAY_SORT_DEFINE(dp_sort_items, void *, DArray_compare, DA_COMPARE_LESS)
+
+/**
+ * @brief Fewest values handed to one task
+ */
+#define DP_MIN_PIECE 4096
+
+// Sort a run in place, or merge runs a and b into out
+typedef struct DPTask {
+    DArray_compare compare;
+    void **a;
+    size_t a_len;
+    void **b;
+    size_t b_len;
+    void **out;
+} DPTask;
+
+static void dp_sort(void *arg)
+{
+    DPTask *task = arg;
+
+    dp_sort_items(task->a, task->a_len, task->compare);
+}
+
+static void dp_merge(void *arg)
+{
+    DPTask *task = arg;
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    while(i < task->a_len && j < task->b_len) {
+        if(DA_COMPARE_LESS(task->b[j], task->a[i], task->compare)) {
+            task->out[k++] = task->b[j++];
+        } else {
+            task->out[k++] = task->a[i++];
+        }
+    }
+
+    memcpy(task->out + k, task->a + i, (task->a_len - i) * sizeof(void *));
+    k += task->a_len - i;
+    memcpy(task->out + k, task->b + j, (task->b_len - j) * sizeof(void *));
+}
+
+// Number of values of a among the first k values of the merge of a and b
+static size_t dp_split(void **a, size_t a_len, void **b, size_t b_len, size_t k, DArray_compare compare)
+{
+    size_t lo = k > b_len ? k - b_len : 0;
+    size_t hi = k < a_len ? k : a_len;
+
+    // a[i] is among the first k while it does not sort after b[k - i - 1]
+    while(lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        if(!DA_COMPARE_LESS(b[k - i - 1], a[i], compare)) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+
+    return lo;
+}
+
+// Queue a task, or run it here if it cannot be queued
+static void dp_spawn(ThreadPool *pool, TPGroup *group, void (*fn)(void *arg), DPTask *task)
+{
+    if(ThreadPool_submit(pool, group, fn, task) != 0) {
+        fn(task);
+    }
+}
+
+int DArray_parallel_sort(DArray *darray, DArray_compare compare, ThreadPool *pool)
+{
+    void **scratch = NULL;
+    DPTask *tasks = NULL;
+    int err = 0;
+
+    check_err(darray != NULL && compare != NULL, err, DA_ERR_ARGS, "NULL darray or compare");
+
+    if(darray->length < 2) {
+        return 0;
+    }
+
+    int rc = DArray_linearise(darray);
+    check_err(rc == 0, err, da_chain(DA_PSORT_LINEARISE, rc), "Failed to linearise DArray for sort");
+
+    void **items = darray->items + darray->start_index;
+    size_t length = darray->length;
+
+    if(pool == NULL || length < DARRAY_PARALLEL_SORT_THRESHOLD) {
+        dp_sort_items(items, length, compare);
+        return 0;
+    }
+
+    // A few pieces per worker, so stealing can even out uneven ones
+    size_t piece = length / ((size_t)ThreadPool_threads(pool) * 4);
+    piece = piece > DP_MIN_PIECE ? piece : DP_MIN_PIECE;
+    size_t runs = (length + piece - 1) / piece;
+
+    // A round of merging has at most one task per piece of output, plus one per merge
+    scratch = malloc(length * sizeof(void *));
+    check_err(scratch != NULL, err, DA_ERR_MEMORY | DA_PSORT_SCRATCH, "Out of memory.");
+    tasks = malloc(2 * runs * sizeof(DPTask));
+    check_err(tasks != NULL, err, DA_ERR_MEMORY | DA_PSORT_SCRATCH, "Out of memory.");
+
+    TPGroup group = {0};
+
+    for(size_t r = 0; r < runs; r++) {
+        DPTask *task = &tasks[r];
+        task->compare = compare;
+        task->a = items + r * piece;
+        task->a_len = length - r * piece < piece ? length - r * piece : piece;
+        dp_spawn(pool, &group, dp_sort, task);
+    }
+    ThreadPool_wait(pool, &group);
+
+    void **src = items;
+    void **dst = scratch;
+
+    for(size_t width = piece; width < length; width *= 2) {
+        size_t count = 0;
+
+        for(size_t start = 0; start < length; start += 2 * width) {
+            void **a = src + start;
+            size_t a_len = length - start < width ? length - start : width;
+            void **b = a + a_len;
+            size_t rest = length - start - a_len;
+            size_t b_len = rest < width ? rest : width;
+            size_t total = a_len + b_len;
+
+            // Cut the merge where each piece of output starts, taking a's share of it
+            size_t i = 0;
+            for(size_t k = 0; k < total; k += piece) {
+                size_t end = total - k < piece ? total : k + piece;
+                size_t next = end == total ? a_len : dp_split(a, a_len, b, b_len, end, compare);
+
+                DPTask *task = &tasks[count++];
+                task->compare = compare;
+                task->a = a + i;
+                task->a_len = next - i;
+                task->b = b + (k - i);
+                task->b_len = (end - next) - (k - i);
+                task->out = dst + start + k;
+                dp_spawn(pool, &group, dp_merge, task);
+
+                i = next;
+            }
+        }
+        ThreadPool_wait(pool, &group);
+
+        void **tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if(src != items) {
+        memcpy(items, src, length * sizeof(void *));
+    }
+
+    free(tasks);
+    free(scratch);
+
+    return 0;
+
+error:
+    free(tasks);
+    free(scratch);
+
+    return err;
+}
+
+// Shared state of a parallel for, map, reduce or filter
+typedef struct DPJob {
+    DArray_visit visit;
+    DArray_map map;
+    DArray_reduce reduce;
+    DArray_keep keep;
+    void *ctx;
+    void *identity;
+    void **out;             // Map output, or filter scratch; indexed like the array
+    _Atomic int result;     // First non-0 result of visit
+} DPJob;
+
+// A run of contiguous values of the array, and what became of them
+typedef struct DPPiece {
+    DPJob *job;
+    void **values;
+    DArraySize count;
+    DArraySize index;         // Index in the array of the first value
+    DArraySize kept;          // Values kept by a filter
+    void **dest;            // Final place of the values kept by a filter
+    void *acc;              // Result of a reduce
+} DPPiece;
+
+static void dp_visit(void *arg)
+{
+    DPPiece *piece = arg;
+    DPJob *job = piece->job;
+
+    // Once one piece has stopped the job, skip any not yet started
+    if(atomic_load_explicit(&job->result, memory_order_relaxed) != 0) {
+        return;
+    }
+
+    int rc = job->visit(piece->values, piece->count, piece->index, job->ctx);
+    if(rc != 0) {
+        int expected = 0;
+        atomic_compare_exchange_strong_explicit(&job->result, &expected, rc, memory_order_relaxed, memory_order_relaxed);
+    }
+}
+
+static void dp_map(void *arg)
+{
+    DPPiece *piece = arg;
+    DPJob *job = piece->job;
+    void **out = job->out + piece->index;
+
+    for(DArraySize i = 0; i < piece->count; i++) {
+        out[i] = job->map(piece->values[i], job->ctx);
+    }
+}
+
+static void dp_reduce(void *arg)
+{
+    DPPiece *piece = arg;
+    DPJob *job = piece->job;
+    void *acc = job->identity;
+
+    for(DArraySize i = 0; i < piece->count; i++) {
+        acc = job->reduce(acc, piece->values[i], job->ctx);
+    }
+
+    piece->acc = acc;
+}
+
+// Pack the values a piece keeps at the start of its part of the scratch memory
+static void dp_filter(void *arg)
+{
+    DPPiece *piece = arg;
+    DPJob *job = piece->job;
+    void **out = job->out + piece->index;
+    DArraySize kept = 0;
+
+    for(DArraySize i = 0; i < piece->count; i++) {
+        if(job->keep(piece->values[i], job->ctx)) {
+            out[kept++] = piece->values[i];
+        }
+    }
+
+    piece->kept = kept;
+}
+
+static void dp_gather(void *arg)
+{
+    DPPiece *piece = arg;
+
+    memcpy(piece->dest, piece->job->out + piece->index, (size_t)piece->kept * sizeof(void *));
+}
+
+// Cut the values of a darray into pieces of at most grain values, never across the wrap of a ring
+static DPPiece *dp_pieces(DArray *darray, DPJob *job, DArraySize grain, ThreadPool *pool, DArraySize *count)
+{
+    if(grain == 0) {
+        grain = pool != NULL ? darray->length / (ThreadPool_threads(pool) * 4) : darray->length;
+        grain = grain > DARRAY_PARALLEL_GRAIN ? grain : DARRAY_PARALLEL_GRAIN;
+    }
+
+    DArraySpan spans[2];
+    uint32_t runs = DArray_spans(darray, spans);
+
+    // Each run may end with a short piece
+    size_t most = (size_t)darray->length / grain + runs;
+    DPPiece *pieces = malloc((most > 0 ? most : 1) * sizeof(DPPiece));
+    if(pieces == NULL) {
+        return NULL;
+    }
+
+    DArraySize n = 0;
+    DArraySize index = 0;
+    for(uint32_t s = 0; s < runs; s++) {
+        for(DArraySize done = 0; done < spans[s].length; done += grain) {
+            DPPiece *piece = &pieces[n++];
+            piece->job = job;
+            piece->values = spans[s].values + done;
+            piece->count = spans[s].length - done < grain ? spans[s].length - done : grain;
+            piece->index = index;
+            piece->kept = 0;
+            piece->dest = NULL;
+            piece->acc = job->identity;
+            index += piece->count;
+        }
+    }
+
+    *count = n;
+    return pieces;
+}
+
+// Run fn on every piece, dealing them out to the workers in contiguous blocks, in worker order
+static void dp_run(ThreadPool *pool, void (*fn)(void *arg), DPPiece *pieces, DArraySize count)
+{
+    if(pool == NULL || count < 2) {
+        for(DArraySize i = 0; i < count; i++) {
+            fn(&pieces[i]);
+        }
+        return;
+    }
+
+    TPGroup group = {0};
+    uint32_t threads = ThreadPool_threads(pool);
+
+    for(DArraySize i = 0; i < count; i++) {
+        uint32_t worker = (uint32_t)((uint64_t)i * threads / count);
+        if(ThreadPool_submit_to(pool, worker, &group, fn, &pieces[i]) != 0) {
+            fn(&pieces[i]);
+        }
+    }
+
+    ThreadPool_wait(pool, &group);
+}
+
+// Clear the job of an operation, other than its context
+static void dp_job_init(DPJob *job, void *ctx)
+{
+    job->visit = NULL;
+    job->map = NULL;
+    job->reduce = NULL;
+    job->keep = NULL;
+    job->ctx = ctx;
+    job->identity = NULL;
+    job->out = NULL;
+    atomic_init(&job->result, 0);
+}
+
+int DArray_parallel_for(DArray *darray, DArray_visit fn, void *ctx, DArraySize grain, ThreadPool *pool)
+{
+    DPPiece *pieces = NULL;
+    DArraySize count = 0;
+    DPJob job;
+    int err = 0;
+
+    dp_job_init(&job, ctx);
+    check_err(darray != NULL && fn != NULL, err, DA_ERR_ARGS, "NULL darray or fn");
+
+    job.visit = fn;
+
+    pieces = dp_pieces(darray, &job, grain, pool, &count);
+    check_err(pieces != NULL, err, DA_ERR_MEMORY | DA_PARALLEL_SCRATCH, "Out of memory.");
+
+    dp_run(pool, dp_visit, pieces, count);
+    free(pieces);
+
+    return atomic_load_explicit(&job.result, memory_order_relaxed);
+
+error:
+    return err;
+}
+
+DArray *DArray_parallel_map(DArray *darray, DArray_map map, void *ctx, DArraySize grain, ThreadPool *pool, int *res)
+{
+    DPPiece *pieces = NULL;
+    DArray *result = NULL;
+    DArraySize count = 0;
+    DPJob job;
+    int err = 0;
+
+    dp_job_init(&job, ctx);
+    check_err(darray != NULL && map != NULL, err, DA_ERR_ARGS, "NULL darray or map");
+
+    job.map = map;
+
+    // Left untouched here, so each worker is first to touch the part it fills
+    DArraySize size = darray->length > 0 ? darray->length : 1;
+    job.out = malloc((size_t)size * sizeof(void *));
+    check_err(job.out != NULL, err, DA_ERR_MEMORY | DA_PARALLEL_SCRATCH, "Out of memory.");
+
+    pieces = dp_pieces(darray, &job, grain, pool, &count);
+    check_err(pieces != NULL, err, DA_ERR_MEMORY | DA_PARALLEL_SCRATCH, "Out of memory.");
+
+    dp_run(pool, dp_map, pieces, count);
+
+    int rc = 0;
+    result = DArray_from_buffer(job.out, darray->length, size, DArray_max_pool_size(darray), DArray_expand_rate(darray), 0, NULL, &rc);
+    check_err(result != NULL, err, da_chain(DA_PARALLEL_OUTPUT, rc), "Failed to create mapped DArray");
+
+    free(pieces);
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return result;
+
+error:
+    free(pieces);
+    free(job.out);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void *DArray_parallel_reduce(DArray *darray, DArray_reduce reduce, void *identity, void *ctx, DArraySize grain, ThreadPool *pool, int *res)
+{
+    DPPiece *pieces = NULL;
+    DArraySize count = 0;
+    DPJob job;
+    int err = 0;
+
+    dp_job_init(&job, ctx);
+    check_err(darray != NULL && reduce != NULL, err, DA_ERR_ARGS, "NULL darray or reduce");
+
+    job.reduce = reduce;
+    job.identity = identity;
+
+    pieces = dp_pieces(darray, &job, grain, pool, &count);
+    check_err(pieces != NULL, err, DA_ERR_MEMORY | DA_PARALLEL_SCRATCH, "Out of memory.");
+
+    dp_run(pool, dp_reduce, pieces, count);
+
+    void *acc = count > 0 ? pieces[0].acc : identity;
+    for(DArraySize i = 1; i < count; i++) {
+        acc = reduce(acc, pieces[i].acc, ctx);
+    }
+
+    free(pieces);
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return acc;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+DArray *DArray_parallel_filter(DArray *darray, DArray_keep keep, void *ctx, DArraySize grain, ThreadPool *pool, int *res)
+{
+    DPPiece *pieces = NULL;
+    DArray *result = NULL;
+    void **kept = NULL;
+    DArraySize count = 0;
+    DPJob job;
+    int err = 0;
+
+    dp_job_init(&job, ctx);
+    check_err(darray != NULL && keep != NULL, err, DA_ERR_ARGS, "NULL darray or keep");
+
+    job.keep = keep;
+
+    job.out = malloc((size_t)(darray->length > 0 ? darray->length : 1) * sizeof(void *));
+    check_err(job.out != NULL, err, DA_ERR_MEMORY | DA_PARALLEL_SCRATCH, "Out of memory.");
+
+    pieces = dp_pieces(darray, &job, grain, pool, &count);
+    check_err(pieces != NULL, err, DA_ERR_MEMORY | DA_PARALLEL_SCRATCH, "Out of memory.");
+
+    dp_run(pool, dp_filter, pieces, count);
+
+    DArraySize total = 0;
+    for(DArraySize i = 0; i < count; i++) {
+        total += pieces[i].kept;
+    }
+
+    DArraySize size = total > 0 ? total : 1;
+    kept = malloc((size_t)size * sizeof(void *));
+    check_err(kept != NULL, err, DA_ERR_MEMORY | DA_PARALLEL_SCRATCH, "Out of memory.");
+
+    // Every piece's place in the output is known now, so the copies can run at once
+    DArraySize offset = 0;
+    for(DArraySize i = 0; i < count; i++) {
+        pieces[i].dest = kept + offset;
+        offset += pieces[i].kept;
+    }
+    dp_run(pool, dp_gather, pieces, count);
+
+    int rc = 0;
+    result = DArray_from_buffer(kept, total, size, DArray_max_pool_size(darray), DArray_expand_rate(darray), 0, NULL, &rc);
+    check_err(result != NULL, err, da_chain(DA_PARALLEL_OUTPUT, rc), "Failed to create filtered DArray");
+
+    free(pieces);
+    free(job.out);
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return result;
+
+error:
+    free(kept);
+    free(pieces);
+    free(job.out);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file darray_parallel.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Operations on a DArray spread across a ThreadPool
+ */
+
+#ifndef DArray_parallel_h
+#define DArray_parallel_h
+
+#include "darray.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Arrays shorter than this are sorted on the calling thread by `DArray_parallel_sort`
+ */
+#ifndef DARRAY_PARALLEL_SORT_THRESHOLD
+#define DARRAY_PARALLEL_SORT_THRESHOLD (1u << 16)
+#endif
+
+/**
+ * @brief Sort a darray using every worker of a ThreadPool
+ *
+ * The values are split into runs, several per worker, which are sorted in parallel with the same
+ * introsort as `DArray_qsort`; pairs of runs are then merged until one is left. Each merge is cut
+ * into pieces of equal output length by binary search, so every round of merging also uses the
+ * whole pool. Ring-mode arrays are linearised first.
+ *
+ * Falls back to `DArray_qsort` when `pool` is `NULL` or the array is shorter than
+ * `DARRAY_PARALLEL_SORT_THRESHOLD`. The sort is not stable.
+ * Performance: `O((n log n) / p)` for `p` workers, plus `n` slots of scratch memory
+ *
+ * @see darray_err_parallel_sort for errors
+ *
+ * @param darray DArray to sort
+ * @param compare Comparison; as for `DArray_qsort`
+ * @param pool ThreadPool to sort with; may be `NULL`
+ *
+ * @return Result; 0 on success, otherwise non-0. The array is unchanged on error
+ */
+int DArray_parallel_sort(DArray *darray, DArray_compare compare, ThreadPool *pool);
+
+/**
+ * @brief DArray_parallel_sort errors
+ * @see DArray_parallel_sort
+ */
+enum darray_err_parallel_sort {
+    DA_PSORT_LINEARISE  = 0x10, ///< Failed to linearise a ring; see chained errors
+    DA_PSORT_SCRATCH    = 0x20  ///< Failed to allocate scratch memory
+};
+
+/**
+ * @brief Values handed to each task by the parallel operations when no grain size is given
+ *
+ * The default grain is the array's length divided by four times the number of workers, but
+ * never less than this, so stealing can even out uneven pieces without tasks becoming too small
+ * to be worth queueing. Pass an explicit grain when each value is expensive to process.
+ */
+#ifndef DARRAY_PARALLEL_GRAIN
+#define DARRAY_PARALLEL_GRAIN 4096u
+#endif
+
+/**
+ * @brief Transformation for `DArray_parallel_map`
+ *
+ * @param value Value to transform
+ * @param ctx Context given to `DArray_parallel_map`
+ *
+ * @return Transformed value
+ */
+typedef void *(*DArray_map)(void *value, void *ctx);
+
+/**
+ * @brief Combination for `DArray_parallel_reduce`
+ *
+ * Must be associative, since values are combined in order within each piece and the pieces'
+ * results then combined in order with one another.
+ *
+ * @param acc Result so far
+ * @param value Value, or result of a later piece, to combine with it
+ * @param ctx Context given to `DArray_parallel_reduce`
+ *
+ * @return Combined result
+ */
+typedef void *(*DArray_reduce)(void *acc, void *value, void *ctx);
+
+/**
+ * @brief Predicate for `DArray_parallel_filter`
+ *
+ * @param value Value to test
+ * @param ctx Context given to `DArray_parallel_filter`
+ *
+ * @return Non-0 to keep the value, otherwise 0
+ */
+typedef int (*DArray_keep)(void *value, void *ctx);
+
+/**
+ * @brief Call a function on every value of a darray using every worker of a ThreadPool
+ *
+ * The values are cut into pieces of at most `grain` contiguous values, each of which `fn` is
+ * called on once, as with `DArray_visit_chunks`, but with many pieces at once. The pieces are
+ * dealt out to the workers in contiguous blocks, in worker order, so a worker takes the same
+ * part of an array of the same length on every call; with the pool pinned by `ThreadPool_pin`,
+ * that part stays in memory local to the worker's NUMA node once it has touched it. Idle workers
+ * still steal pieces from busy ones.
+ *
+ * `fn` may write through the values it is given, but nothing may change the array's layout until
+ * this returns. Runs on the calling thread when `pool` is `NULL` or there is only one piece.
+ * Performance: `O(n / p)` for `p` workers
+ *
+ * @see darray_err_parallel for errors
+ *
+ * @param darray DArray to visit
+ * @param fn Function to call on each piece; may run on many threads at once
+ * @param ctx Context passed to `fn`
+ * @param grain Most values in a piece; 0 for a default based on the length and pool size
+ * @param pool ThreadPool to run on; may be `NULL`
+ *
+ * @return 0 once every value has been visited, otherwise the non-0 result of one of the calls to
+ * `fn` which returned one, after which pieces not yet started are skipped; or an error
+ */
+int DArray_parallel_for(DArray *darray, DArray_visit fn, void *ctx, DArraySize grain, ThreadPool *pool);
+
+/**
+ * @brief Transform every value of a darray into a new DArray using every worker of a ThreadPool
+ *
+ * Value `i` of the new array is `map(value i of darray, ctx)`. The new store is allocated once at
+ * its final size and left for the workers to write, so each part of it is first touched, and on
+ * a NUMA system placed, by the worker which fills it. Pieces are dealt out as in
+ * `DArray_parallel_for`.
+ * Performance: `O(n / p)` for `p` workers
+ *
+ * @see darray_err_parallel for errors
+ *
+ * @param darray DArray to transform; unchanged
+ * @param map Transformation; may run on many threads at once
+ * @param ctx Context passed to `map`
+ * @param grain Most values in a piece; 0 for a default based on the length and pool size
+ * @param pool ThreadPool to run on; may be `NULL`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DArray of the same length, allocated with `malloc` and with `darray`'s
+ * `expand_rate` and `max_pool_size`, on success; otherwise `NULL`
+ */
+DArray *DArray_parallel_map(DArray *darray, DArray_map map, void *ctx, DArraySize grain, ThreadPool *pool, int *res);
+
+/**
+ * @brief Combine every value of a darray into one using every worker of a ThreadPool
+ *
+ * Each piece is folded from `identity` in order, then the pieces' results are folded together,
+ * in order, on the calling thread. Pieces are dealt out as in `DArray_parallel_for`.
+ * Performance: `O(n / p + pieces)` for `p` workers
+ *
+ * @see darray_err_parallel for errors
+ *
+ * @param darray DArray to reduce
+ * @param reduce Associative combination; may run on many threads at once
+ * @param identity Identity of `reduce`, which each piece starts from
+ * @param ctx Context passed to `reduce`
+ * @param grain Most values in a piece; 0 for a default based on the length and pool size
+ * @param pool ThreadPool to run on; may be `NULL`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return Combined result, `identity` for an empty array, or `NULL` on error
+ */
+void *DArray_parallel_reduce(DArray *darray, DArray_reduce reduce, void *identity, void *ctx, DArraySize grain, ThreadPool *pool, int *res);
+
+/**
+ * @brief Copy the values of a darray which pass a test into a new DArray using every worker of a
+ * ThreadPool
+ *
+ * The kept values stay in their original order. Each piece is tested and its kept values packed
+ * into scratch memory in parallel; once the counts are known, each piece's values are copied to
+ * their final place, again in parallel, so `keep` is called only once per value. Pieces are
+ * dealt out as in `DArray_parallel_for`.
+ * Performance: `O(n / p + pieces)` for `p` workers, plus `n` slots of scratch memory
+ *
+ * @see darray_err_parallel for errors
+ *
+ * @param darray DArray to filter; unchanged
+ * @param keep Predicate; may run on many threads at once
+ * @param ctx Context passed to `keep`
+ * @param grain Most values in a piece; 0 for a default based on the length and pool size
+ * @param pool ThreadPool to run on; may be `NULL`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DArray of the kept values, allocated with `malloc` and with `darray`'s
+ * `expand_rate` and `max_pool_size`, on success; otherwise `NULL`
+ */
+DArray *DArray_parallel_filter(DArray *darray, DArray_keep keep, void *ctx, DArraySize grain, ThreadPool *pool, int *res);
+
+/**
+ * @brief DArray_parallel_for, DArray_parallel_map, DArray_parallel_reduce and
+ * DArray_parallel_filter errors, in addition to `DA_ERR_ARGS` for `NULL` arguments
+ */
+enum darray_err_parallel {
+    DA_PARALLEL_SCRATCH = 0x10, ///< Failed to allocate pieces, scratch memory or the new store
+    DA_PARALLEL_OUTPUT  = 0x20  ///< Failed to create the new DArray; see chained errors
+};
+
+#endif
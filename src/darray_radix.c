@@ -0,0 +1,217 @@
+#include "darray_radix.h"
+#include "dbg.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Value of a darray with its key extracted
+typedef struct RadixPair {
+    uint64_t key;
+    void *value;
+} RadixPair;
+
+void DARadixBuffer_free(DARadixBuffer *buffer)
+{
+    if(buffer == NULL) {
+        return;
+    }
+
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+}
+
+// Grow a buffer to at least size bytes; the contents are not kept
+static int ra_reserve(DARadixBuffer *buffer, size_t size)
+{
+    if(buffer->size >= size) {
+        return 0;
+    }
+
+    void *data = malloc(size);
+    if(data == NULL) {
+        return DA_ERR_MEMORY | DA_RADIX_SCRATCH;
+    }
+
+    free(buffer->data);
+    buffer->data = data;
+    buffer->size = size;
+
+    return 0;
+}
+
+// Turn the counts of one digit into the offset of each bucket; 0 if every key shares the digit
+static int ra_offsets(DArraySize counts[256], DArraySize length, uint32_t digit)
+{
+    if(counts[digit] == length) {
+        return 0;
+    }
+
+    DArraySize offset = 0;
+    for(int bucket = 0; bucket < 256; bucket++) {
+        DArraySize count = counts[bucket];
+        counts[bucket] = offset;
+        offset += count;
+    }
+
+    return 1;
+}
+
+int DArray_radix_sort(DArray *darray, DArray_key key, DARadixBuffer *scratch)
+{
+    DARadixBuffer local = {0};
+    int err = 0;
+
+    check_err(darray != NULL && key != NULL, err, DA_ERR_ARGS, "NULL darray or key");
+
+    if(darray->length < 2) {
+        return 0;
+    }
+
+    int rc = DArray_linearise(darray);
+    check_err(rc == 0, err, da_chain(DA_RADIX_LINEARISE, rc), "Failed to linearise DArray for sort");
+
+    DArraySize length = darray->length;
+    scratch = scratch != NULL ? scratch : &local;
+    rc = ra_reserve(scratch, 2 * (size_t)length * sizeof(RadixPair));
+    check_err(rc == 0, err, rc, "Out of memory.");
+
+    void **items = darray->items + darray->start_index;
+    RadixPair *src = scratch->data;
+    RadixPair *dst = src + length;
+
+    // One pass counts every digit of every key, so all eight histograms stay in L1 cache
+    DArraySize counts[8][256];
+    memset(counts, 0, sizeof(counts));
+
+    for(DArraySize i = 0; i < length; i++) {
+        uint64_t k = key(items[i]);
+        src[i].key = k;
+        src[i].value = items[i];
+        for(int d = 0; d < 8; d++) {
+            counts[d][(k >> (8 * d)) & 0xFF]++;
+        }
+    }
+
+    for(int d = 0; d < 8; d++) {
+        int shift = 8 * d;
+        if(!ra_offsets(counts[d], length, (uint32_t)(src[0].key >> shift) & 0xFF)) {
+            continue;
+        }
+
+        for(DArraySize i = 0; i < length; i++) {
+            dst[counts[d][(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        RadixPair *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    for(DArraySize i = 0; i < length; i++) {
+        items[i] = src[i].value;
+    }
+
+    DARadixBuffer_free(&local);
+
+    return 0;
+
+error:
+    DARadixBuffer_free(&local);
+
+    return err;
+}
+
+// Key of a value of a dvarray, with the sign bit flipped for signed keys
+static inline uint64_t ra_key(const char *value, uint32_t key_size, uint64_t flip)
+{
+    uint64_t key;
+
+    switch(key_size) {
+        case 1: { uint8_t k; memcpy(&k, value, 1); key = k; break; }
+        case 2: { uint16_t k; memcpy(&k, value, 2); key = k; break; }
+        case 4: { uint32_t k; memcpy(&k, value, 4); key = k; break; }
+        default: { uint64_t k; memcpy(&k, value, 8); key = k; break; }
+    }
+
+    return key ^ flip;
+}
+
+// Distribute values by one digit; inlined with a constant elem_size for the common sizes
+static inline void ra_scatter(const char *src, char *dst, uint32_t length, uint32_t elem_size,
+        uint32_t key_offset, uint32_t key_size, uint64_t flip, int shift, DArraySize counts[256])
+{
+    for(uint32_t i = 0; i < length; i++) {
+        const char *value = src + (size_t)i * elem_size;
+        uint32_t bucket = (uint32_t)(ra_key(value + key_offset, key_size, flip) >> shift) & 0xFF;
+        memcpy(dst + (size_t)counts[bucket]++ * elem_size, value, elem_size);
+    }
+}
+
+int DVArray_radix_sort(DVArray *dvarray, uint32_t key_offset, uint32_t key_size, uint32_t flags, DARadixBuffer *scratch)
+{
+    DARadixBuffer local = {0};
+    int err = 0;
+
+    check_err(dvarray != NULL, err, DA_ERR_ARGS, "NULL dvarray");
+    check_err((key_size == 1 || key_size == 2 || key_size == 4 || key_size == 8) &&
+            (uint64_t)key_offset + key_size <= dvarray->elem_size,
+            err, DA_ERR_ARGS | DA_RADIX_KEY, "Invalid key of %u bytes at offset %u", key_size, key_offset);
+
+    if(dvarray->length < 2) {
+        return 0;
+    }
+
+    uint32_t length = dvarray->length;
+    uint32_t elem_size = dvarray->elem_size;
+    scratch = scratch != NULL ? scratch : &local;
+    int rc = ra_reserve(scratch, (size_t)length * elem_size);
+    check_err(rc == 0, err, rc, "Out of memory.");
+
+    char *items = (char *)dvarray->items + (size_t)dvarray->start_index * elem_size;
+    char *src = items;
+    char *dst = scratch->data;
+    uint64_t flip = (flags & DA_RADIX_SIGNED) ? UINT64_C(1) << (8 * key_size - 1) : 0;
+
+    DArraySize counts[8][256];
+    memset(counts, 0, sizeof(counts));
+
+    for(uint32_t i = 0; i < length; i++) {
+        uint64_t k = ra_key(items + (size_t)i * elem_size + key_offset, key_size, flip);
+        for(uint32_t d = 0; d < key_size; d++) {
+            counts[d][(k >> (8 * d)) & 0xFF]++;
+        }
+    }
+
+    uint64_t first = ra_key(items + key_offset, key_size, flip);
+    for(uint32_t d = 0; d < key_size; d++) {
+        int shift = 8 * (int)d;
+        if(!ra_offsets(counts[d], length, (uint32_t)(first >> shift) & 0xFF)) {
+            continue;
+        }
+
+        switch(elem_size) {
+            case 4: ra_scatter(src, dst, length, 4, key_offset, key_size, flip, shift, counts[d]); break;
+            case 8: ra_scatter(src, dst, length, 8, key_offset, key_size, flip, shift, counts[d]); break;
+            case 16: ra_scatter(src, dst, length, 16, key_offset, key_size, flip, shift, counts[d]); break;
+            default: ra_scatter(src, dst, length, elem_size, key_offset, key_size, flip, shift, counts[d]); break;
+        }
+
+        char *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if(src != items) {
+        memcpy(items, src, (size_t)length * elem_size);
+    }
+
+    DARadixBuffer_free(&local);
+
+    return 0;
+
+error:
+    DARadixBuffer_free(&local);
+
+    return err;
+}
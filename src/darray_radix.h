@@ -0,0 +1,109 @@
+/**
+ * @file darray_radix.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief LSD radix sorts for DArray and DVArray
+ *
+ * Sorting by an integer key with `DArray_qsort` costs `O(n log n)` comparisons, each an indirect
+ * call. The sorts in this file instead distribute the values by one byte of the key at a time,
+ * least significant first, which is `O(n)` for a fixed key width and never calls a comparator.
+ */
+
+#ifndef DArray_radix_h
+#define DArray_radix_h
+
+#include "darray.h"
+#include "dvarray.h"
+#include "stdint.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Get the sort key of a value of a darray
+ * @see DArray_radix_sort
+ */
+typedef uint64_t (*DArray_key)(void *value);
+
+/**
+ * @brief Map a signed 64-bit key onto an unsigned key in the same order
+ */
+#define DA_RADIX_KEY_I64(x) ((uint64_t)(int64_t)(x) ^ (UINT64_C(1) << 63))
+
+/**
+ * @brief Scratch memory for radix sorts, kept between calls
+ *
+ * Zero-initialise before first use, e.g. `DARadixBuffer buffer = {0};`, and free with
+ * `DARadixBuffer_free`. The buffer grows to the largest sort it is used for.
+ */
+typedef struct DARadixBuffer {
+    void *data;     ///< Scratch memory
+    size_t size;    ///< Size of `data` in bytes
+} DARadixBuffer;
+
+/**
+ * @brief Free the memory held by a DARadixBuffer
+ *
+ * The buffer is left empty and may be used again.
+ *
+ * @param buffer DARadixBuffer to empty
+ */
+void DARadixBuffer_free(DARadixBuffer *buffer);
+
+/**
+ * @brief Sort a darray by an unsigned 64-bit key
+ *
+ * Each key is extracted once. A single pass then counts every byte of every key, and bytes which
+ * are the same in all keys are skipped, so keys which only use their low 32 bits cost four
+ * passes, not eight. The sort is stable. Ring-mode arrays are linearised first.
+ * Performance: `O(n)`, using `32 * n` bytes of scratch memory
+ *
+ * @see darray_err_radix_sort for errors
+ *
+ * @param darray DArray to sort
+ * @param key Key of each value; use `DA_RADIX_KEY_I64` to sort by a signed key
+ * @param scratch Scratch memory to reuse; `NULL` to allocate for this call only
+ *
+ * @return Result; 0 on success, otherwise non-0. The array is unchanged on error
+ */
+int DArray_radix_sort(DArray *darray, DArray_key key, DARadixBuffer *scratch);
+
+/**
+ * @brief Sort a dvarray by an integer key stored in each value
+ *
+ * The key is `key_size` bytes at `key_offset` within each value, in host byte order, and is
+ * compared as unsigned unless `DA_RADIX_SIGNED` is set. To sort a dvarray of `int32_t` use
+ * `DVArray_radix_sort(dvarray, 0, 4, DA_RADIX_SIGNED, NULL)`. Values are moved whole and
+ * the sort is stable. Performance: `O(n)`, using `n * elem_size` bytes of scratch memory
+ *
+ * @see darray_err_radix_sort for errors
+ *
+ * @param dvarray DVArray to sort
+ * @param key_offset Offset of the key within each value, in bytes
+ * @param key_size Size of the key in bytes; 1, 2, 4 or 8
+ * @param flags `darray_radix_flag`s
+ * @param scratch Scratch memory to reuse; `NULL` to allocate for this call only
+ *
+ * @return Result; 0 on success, otherwise non-0. The array is unchanged on error
+ */
+int DVArray_radix_sort(DVArray *dvarray, uint32_t key_offset, uint32_t key_size, uint32_t flags, DARadixBuffer *scratch);
+
+/**
+ * @brief DVArray_radix_sort flags
+ * @see DVArray_radix_sort
+ */
+enum darray_radix_flag {
+    DA_RADIX_SIGNED = 0x1   ///< Key is a two's complement signed integer
+};
+
+/**
+ * @brief DArray_radix_sort and DVArray_radix_sort errors
+ * @see DArray_radix_sort
+ * @see DVArray_radix_sort
+ */
+enum darray_err_radix_sort {
+    DA_RADIX_LINEARISE  = 0x10, ///< Failed to linearise a ring; see chained errors
+    DA_RADIX_SCRATCH    = 0x20, ///< Failed to allocate scratch memory
+    DA_RADIX_KEY        = 0x30  ///< Invalid key size, or key does not fit within a value
+};
+
+#endif
@@ -0,0 +1,1110 @@
+#include "darray_simd.h"
+#include "dbg.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(DARRAY_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DA_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if !defined(DARRAY_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define DA_SIMD_ARM 1
+#include <arm_neon.h>
+#endif
+
+/*
+ * Kernels work on runs of raw values; n is the number of values and find returns n when
+ * nothing matches. The filter and compact kernels compact in place and return the number kept.
+ */
+typedef struct DAKernels {
+    size_t (*find_u32)(const uint32_t *items, size_t n, uint32_t value);
+    size_t (*count_u32)(const uint32_t *items, size_t n, uint32_t value);
+    size_t (*find_u64)(const uint64_t *items, size_t n, uint64_t value);
+    size_t (*count_u64)(const uint64_t *items, size_t n, uint64_t value);
+    size_t (*compact_u64)(uint64_t *items, size_t n);
+    void (*minmax_i32)(const int32_t *items, size_t n, int32_t *min, int32_t *max);
+    void (*minmax_i64)(const int64_t *items, size_t n, int64_t *min, int64_t *max);
+    int64_t (*sum_i32)(const int32_t *items, size_t n);
+    uint64_t (*sum_i64)(const int64_t *items, size_t n);
+    size_t (*filter_i32)(int32_t *items, size_t n, int op, int32_t operand);
+} DAKernels;
+
+/*
+ * Scalar
+ */
+
+static size_t scalar_find_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    for(size_t i = 0; i < n; i++) {
+        if(items[i] == value) {
+            return i;
+        }
+    }
+
+    return n;
+}
+
+static size_t scalar_count_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < n; i++) {
+        count += items[i] == value;
+    }
+
+    return count;
+}
+
+static size_t scalar_find_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    for(size_t i = 0; i < n; i++) {
+        if(items[i] == value) {
+            return i;
+        }
+    }
+
+    return n;
+}
+
+static size_t scalar_count_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < n; i++) {
+        count += items[i] == value;
+    }
+
+    return count;
+}
+
+static size_t scalar_compact_u64(uint64_t *items, size_t n)
+{
+    size_t kept = 0;
+    for(size_t i = 0; i < n; i++) {
+        items[kept] = items[i];
+        kept += items[i] != 0;
+    }
+
+    return kept;
+}
+
+static void scalar_minmax_i32(const int32_t *items, size_t n, int32_t *min, int32_t *max)
+{
+    int32_t lo = items[0];
+    int32_t hi = items[0];
+    for(size_t i = 1; i < n; i++) {
+        lo = items[i] < lo ? items[i] : lo;
+        hi = items[i] > hi ? items[i] : hi;
+    }
+
+    *min = lo;
+    *max = hi;
+}
+
+static void scalar_minmax_i64(const int64_t *items, size_t n, int64_t *min, int64_t *max)
+{
+    int64_t lo = items[0];
+    int64_t hi = items[0];
+    for(size_t i = 1; i < n; i++) {
+        lo = items[i] < lo ? items[i] : lo;
+        hi = items[i] > hi ? items[i] : hi;
+    }
+
+    *min = lo;
+    *max = hi;
+}
+
+static int64_t scalar_sum_i32(const int32_t *items, size_t n)
+{
+    int64_t sum = 0;
+    for(size_t i = 0; i < n; i++) {
+        sum += items[i];
+    }
+
+    return sum;
+}
+
+static uint64_t scalar_sum_i64(const int64_t *items, size_t n)
+{
+    uint64_t sum = 0;
+    for(size_t i = 0; i < n; i++) {
+        sum += (uint64_t)items[i];
+    }
+
+    return sum;
+}
+
+static inline int da_cmp(int32_t value, int op, int32_t operand)
+{
+    switch(op) {
+        case DA_CMP_EQ: return value == operand;
+        case DA_CMP_NE: return value != operand;
+        case DA_CMP_LT: return value < operand;
+        case DA_CMP_LE: return value <= operand;
+        case DA_CMP_GT: return value > operand;
+        default:        return value >= operand;
+    }
+}
+
+static size_t scalar_filter_i32(int32_t *items, size_t n, int op, int32_t operand)
+{
+    size_t kept = 0;
+    for(size_t i = 0; i < n; i++) {
+        int32_t value = items[i];
+        items[kept] = value;
+        kept += (size_t)da_cmp(value, op, operand);
+    }
+
+    return kept;
+}
+
+static const DAKernels scalar_kernels = {
+    scalar_find_u32, scalar_count_u32, scalar_find_u64, scalar_count_u64, scalar_compact_u64,
+    scalar_minmax_i32, scalar_minmax_i64, scalar_sum_i32, scalar_sum_i64, scalar_filter_i32
+};
+
+#ifdef DA_SIMD_X86
+
+/*
+ * AVX2
+ */
+
+// Permutations which pack the selected lanes of a vector to the front, indexed by lane mask;
+// 32-bit lanes for filters and pairs of them for 64-bit lanes
+static uint32_t avx2_pack32[256][8];
+static uint32_t avx2_pack64[16][8];
+
+static void avx2_build_tables(void)
+{
+    for(uint32_t mask = 0; mask < 256; mask++) {
+        uint32_t k = 0;
+        for(uint32_t lane = 0; lane < 8; lane++) {
+            if(mask & (1u << lane)) {
+                avx2_pack32[mask][k++] = lane;
+            }
+        }
+    }
+
+    for(uint32_t mask = 0; mask < 16; mask++) {
+        uint32_t k = 0;
+        for(uint32_t lane = 0; lane < 4; lane++) {
+            if(mask & (1u << lane)) {
+                avx2_pack64[mask][k++] = 2 * lane;
+                avx2_pack64[mask][k++] = 2 * lane + 1;
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_find_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    __m256i needle = _mm256_set1_epi32((int)value);
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, needle)));
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + scalar_find_u32(items + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_count_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    __m256i needle = _mm256_set1_epi32((int)value);
+    size_t count = 0;
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, needle)));
+        count += (size_t)__builtin_popcount(mask);
+    }
+
+    return count + scalar_count_u32(items + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_find_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    __m256i needle = _mm256_set1_epi64x((long long)value);
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        unsigned mask = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, needle)));
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + scalar_find_u64(items + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_count_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    __m256i needle = _mm256_set1_epi64x((long long)value);
+    size_t count = 0;
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        unsigned mask = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, needle)));
+        count += (size_t)__builtin_popcount(mask);
+    }
+
+    return count + scalar_count_u64(items + i, n - i, value);
+}
+
+// Stores are never more than one vector behind loads, so compacting in place is safe
+__attribute__((target("avx2")))
+static size_t avx2_compact_u64(uint64_t *items, size_t n)
+{
+    size_t kept = 0;
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        unsigned zero = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, _mm256_setzero_si256())));
+        unsigned keep = ~zero & 0xF;
+        __m256i perm = _mm256_loadu_si256((const __m256i *)avx2_pack64[keep]);
+        _mm256_storeu_si256((__m256i *)(items + kept), _mm256_permutevar8x32_epi32(v, perm));
+        kept += (size_t)__builtin_popcount(keep);
+    }
+
+    for(; i < n; i++) {
+        items[kept] = items[i];
+        kept += items[i] != 0;
+    }
+
+    return kept;
+}
+
+__attribute__((target("avx2")))
+static void avx2_minmax_i32(const int32_t *items, size_t n, int32_t *min, int32_t *max)
+{
+    if(n < 8) {
+        scalar_minmax_i32(items, n, min, max);
+        return;
+    }
+
+    __m256i lo = _mm256_loadu_si256((const __m256i *)items);
+    __m256i hi = lo;
+    size_t i = 8;
+
+    for(; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        lo = _mm256_min_epi32(lo, v);
+        hi = _mm256_max_epi32(hi, v);
+    }
+
+    int32_t lanes_lo[8];
+    int32_t lanes_hi[8];
+    _mm256_storeu_si256((__m256i *)lanes_lo, lo);
+    _mm256_storeu_si256((__m256i *)lanes_hi, hi);
+
+    int32_t tail_lo = lanes_lo[0];
+    int32_t tail_hi = lanes_hi[0];
+    if(i < n) {
+        scalar_minmax_i32(items + i, n - i, &tail_lo, &tail_hi);
+    }
+
+    for(int lane = 0; lane < 8; lane++) {
+        tail_lo = lanes_lo[lane] < tail_lo ? lanes_lo[lane] : tail_lo;
+        tail_hi = lanes_hi[lane] > tail_hi ? lanes_hi[lane] : tail_hi;
+    }
+
+    *min = tail_lo;
+    *max = tail_hi;
+}
+
+// AVX2 has no 64-bit min/max; select with a signed compare instead
+__attribute__((target("avx2")))
+static void avx2_minmax_i64(const int64_t *items, size_t n, int64_t *min, int64_t *max)
+{
+    if(n < 4) {
+        scalar_minmax_i64(items, n, min, max);
+        return;
+    }
+
+    __m256i lo = _mm256_loadu_si256((const __m256i *)items);
+    __m256i hi = lo;
+    size_t i = 4;
+
+    for(; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        lo = _mm256_blendv_epi8(lo, v, _mm256_cmpgt_epi64(lo, v));
+        hi = _mm256_blendv_epi8(hi, v, _mm256_cmpgt_epi64(v, hi));
+    }
+
+    int64_t lanes_lo[4];
+    int64_t lanes_hi[4];
+    _mm256_storeu_si256((__m256i *)lanes_lo, lo);
+    _mm256_storeu_si256((__m256i *)lanes_hi, hi);
+
+    int64_t tail_lo = lanes_lo[0];
+    int64_t tail_hi = lanes_hi[0];
+    if(i < n) {
+        scalar_minmax_i64(items + i, n - i, &tail_lo, &tail_hi);
+    }
+
+    for(int lane = 0; lane < 4; lane++) {
+        tail_lo = lanes_lo[lane] < tail_lo ? lanes_lo[lane] : tail_lo;
+        tail_hi = lanes_hi[lane] > tail_hi ? lanes_hi[lane] : tail_hi;
+    }
+
+    *min = tail_lo;
+    *max = tail_hi;
+}
+
+__attribute__((target("avx2")))
+static int64_t avx2_sum_i32(const int32_t *items, size_t n)
+{
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+
+    // Widen each half to 64 bits so the sum cannot overflow
+    for(; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalar_sum_i32(items + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t avx2_sum_i64(const int64_t *items, size_t n)
+{
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        sum = _mm256_add_epi64(sum, _mm256_loadu_si256((const __m256i *)(items + i)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalar_sum_i64(items + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_cmp_i32(__m256i v, __m256i operand, int op)
+{
+    __m256i ones = _mm256_set1_epi32(-1);
+
+    switch(op) {
+        case DA_CMP_EQ: return _mm256_cmpeq_epi32(v, operand);
+        case DA_CMP_NE: return _mm256_xor_si256(_mm256_cmpeq_epi32(v, operand), ones);
+        case DA_CMP_LT: return _mm256_cmpgt_epi32(operand, v);
+        case DA_CMP_LE: return _mm256_xor_si256(_mm256_cmpgt_epi32(v, operand), ones);
+        case DA_CMP_GT: return _mm256_cmpgt_epi32(v, operand);
+        default:        return _mm256_xor_si256(_mm256_cmpgt_epi32(operand, v), ones);
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t avx2_filter_i32(int32_t *items, size_t n, int op, int32_t operand)
+{
+    __m256i rhs = _mm256_set1_epi32(operand);
+    size_t kept = 0;
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        unsigned keep = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(avx2_cmp_i32(v, rhs, op)));
+        __m256i perm = _mm256_loadu_si256((const __m256i *)avx2_pack32[keep]);
+        _mm256_storeu_si256((__m256i *)(items + kept), _mm256_permutevar8x32_epi32(v, perm));
+        kept += (size_t)__builtin_popcount(keep);
+    }
+
+    for(; i < n; i++) {
+        int32_t value = items[i];
+        items[kept] = value;
+        kept += (size_t)da_cmp(value, op, operand);
+    }
+
+    return kept;
+}
+
+static const DAKernels avx2_kernels = {
+    avx2_find_u32, avx2_count_u32, avx2_find_u64, avx2_count_u64, avx2_compact_u64,
+    avx2_minmax_i32, avx2_minmax_i64, avx2_sum_i32, avx2_sum_i64, avx2_filter_i32
+};
+
+/*
+ * AVX-512
+ */
+
+__attribute__((target("avx512f")))
+static size_t avx512_find_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    __m512i needle = _mm512_set1_epi32((int)value);
+    size_t i = 0;
+
+    for(; i + 16 <= n; i += 16) {
+        __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(items + i), needle);
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + scalar_find_u32(items + i, n - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t avx512_count_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    __m512i needle = _mm512_set1_epi32((int)value);
+    size_t count = 0;
+    size_t i = 0;
+
+    for(; i + 16 <= n; i += 16) {
+        count += (size_t)__builtin_popcount(_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(items + i), needle));
+    }
+
+    return count + scalar_count_u32(items + i, n - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t avx512_find_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    __m512i needle = _mm512_set1_epi64((long long)value);
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        __mmask8 mask = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(items + i), needle);
+        if(mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + scalar_find_u64(items + i, n - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t avx512_count_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    __m512i needle = _mm512_set1_epi64((long long)value);
+    size_t count = 0;
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        count += (size_t)__builtin_popcount(_mm512_cmpeq_epi64_mask(_mm512_loadu_si512(items + i), needle));
+    }
+
+    return count + scalar_count_u64(items + i, n - i, value);
+}
+
+__attribute__((target("avx512f")))
+static size_t avx512_compact_u64(uint64_t *items, size_t n)
+{
+    size_t kept = 0;
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        __m512i v = _mm512_loadu_si512(items + i);
+        __mmask8 keep = _mm512_test_epi64_mask(v, v);
+        _mm512_mask_compressstoreu_epi64(items + kept, keep, v);
+        kept += (size_t)__builtin_popcount(keep);
+    }
+
+    for(; i < n; i++) {
+        items[kept] = items[i];
+        kept += items[i] != 0;
+    }
+
+    return kept;
+}
+
+__attribute__((target("avx512f")))
+static void avx512_minmax_i32(const int32_t *items, size_t n, int32_t *min, int32_t *max)
+{
+    if(n < 16) {
+        scalar_minmax_i32(items, n, min, max);
+        return;
+    }
+
+    __m512i lo = _mm512_loadu_si512(items);
+    __m512i hi = lo;
+    size_t i = 16;
+
+    for(; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(items + i);
+        lo = _mm512_min_epi32(lo, v);
+        hi = _mm512_max_epi32(hi, v);
+    }
+
+    int32_t tail_lo = _mm512_reduce_min_epi32(lo);
+    int32_t tail_hi = _mm512_reduce_max_epi32(hi);
+    if(i < n) {
+        int32_t rest_lo, rest_hi;
+        scalar_minmax_i32(items + i, n - i, &rest_lo, &rest_hi);
+        tail_lo = rest_lo < tail_lo ? rest_lo : tail_lo;
+        tail_hi = rest_hi > tail_hi ? rest_hi : tail_hi;
+    }
+
+    *min = tail_lo;
+    *max = tail_hi;
+}
+
+__attribute__((target("avx512f")))
+static void avx512_minmax_i64(const int64_t *items, size_t n, int64_t *min, int64_t *max)
+{
+    if(n < 8) {
+        scalar_minmax_i64(items, n, min, max);
+        return;
+    }
+
+    __m512i lo = _mm512_loadu_si512(items);
+    __m512i hi = lo;
+    size_t i = 8;
+
+    for(; i + 8 <= n; i += 8) {
+        __m512i v = _mm512_loadu_si512(items + i);
+        lo = _mm512_min_epi64(lo, v);
+        hi = _mm512_max_epi64(hi, v);
+    }
+
+    int64_t tail_lo = _mm512_reduce_min_epi64(lo);
+    int64_t tail_hi = _mm512_reduce_max_epi64(hi);
+    if(i < n) {
+        int64_t rest_lo, rest_hi;
+        scalar_minmax_i64(items + i, n - i, &rest_lo, &rest_hi);
+        tail_lo = rest_lo < tail_lo ? rest_lo : tail_lo;
+        tail_hi = rest_hi > tail_hi ? rest_hi : tail_hi;
+    }
+
+    *min = tail_lo;
+    *max = tail_hi;
+}
+
+__attribute__((target("avx512f")))
+static int64_t avx512_sum_i32(const int32_t *items, size_t n)
+{
+    __m512i sum = _mm512_setzero_si512();
+    size_t i = 0;
+
+    for(; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(items + i);
+        sum = _mm512_add_epi64(sum, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        sum = _mm512_add_epi64(sum, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+
+    return _mm512_reduce_add_epi64(sum) + scalar_sum_i32(items + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t avx512_sum_i64(const int64_t *items, size_t n)
+{
+    __m512i sum = _mm512_setzero_si512();
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8) {
+        sum = _mm512_add_epi64(sum, _mm512_loadu_si512(items + i));
+    }
+
+    return (uint64_t)_mm512_reduce_add_epi64(sum) + scalar_sum_i64(items + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static inline __mmask16 avx512_cmp_i32(__m512i v, __m512i operand, int op)
+{
+    switch(op) {
+        case DA_CMP_EQ: return _mm512_cmp_epi32_mask(v, operand, _MM_CMPINT_EQ);
+        case DA_CMP_NE: return _mm512_cmp_epi32_mask(v, operand, _MM_CMPINT_NE);
+        case DA_CMP_LT: return _mm512_cmp_epi32_mask(v, operand, _MM_CMPINT_LT);
+        case DA_CMP_LE: return _mm512_cmp_epi32_mask(v, operand, _MM_CMPINT_LE);
+        case DA_CMP_GT: return _mm512_cmp_epi32_mask(v, operand, _MM_CMPINT_NLE);
+        default:        return _mm512_cmp_epi32_mask(v, operand, _MM_CMPINT_NLT);
+    }
+}
+
+__attribute__((target("avx512f")))
+static size_t avx512_filter_i32(int32_t *items, size_t n, int op, int32_t operand)
+{
+    __m512i rhs = _mm512_set1_epi32(operand);
+    size_t kept = 0;
+    size_t i = 0;
+
+    for(; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(items + i);
+        __mmask16 keep = avx512_cmp_i32(v, rhs, op);
+        _mm512_mask_compressstoreu_epi32(items + kept, keep, v);
+        kept += (size_t)__builtin_popcount(keep);
+    }
+
+    for(; i < n; i++) {
+        int32_t value = items[i];
+        items[kept] = value;
+        kept += (size_t)da_cmp(value, op, operand);
+    }
+
+    return kept;
+}
+
+static const DAKernels avx512_kernels = {
+    avx512_find_u32, avx512_count_u32, avx512_find_u64, avx512_count_u64, avx512_compact_u64,
+    avx512_minmax_i32, avx512_minmax_i64, avx512_sum_i32, avx512_sum_i64, avx512_filter_i32
+};
+
+#endif
+
+#ifdef DA_SIMD_ARM
+
+/*
+ * NEON
+ */
+
+static size_t neon_find_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    uint32x4_t needle = vdupq_n_u32(value);
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        uint32x4_t eq = vceqq_u32(vld1q_u32(items + i), needle);
+        if(vmaxvq_u32(eq) != 0) {
+            return i + scalar_find_u32(items + i, 4, value);
+        }
+    }
+
+    return i + scalar_find_u32(items + i, n - i, value);
+}
+
+static size_t neon_count_u32(const uint32_t *items, size_t n, uint32_t value)
+{
+    uint32x4_t needle = vdupq_n_u32(value);
+    uint32x4_t count = vdupq_n_u32(0);
+    size_t i = 0;
+
+    // Matches are all-ones lanes, so subtracting them counts; no lane sees more than n / 4
+    for(; i + 4 <= n; i += 4) {
+        count = vsubq_u32(count, vceqq_u32(vld1q_u32(items + i), needle));
+    }
+
+    return (size_t)vaddvq_u32(count) + scalar_count_u32(items + i, n - i, value);
+}
+
+static size_t neon_find_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    uint64x2_t needle = vdupq_n_u64(value);
+    size_t i = 0;
+
+    for(; i + 2 <= n; i += 2) {
+        uint64x2_t eq = vceqq_u64(vld1q_u64(items + i), needle);
+        if(vmaxvq_u32(vreinterpretq_u32_u64(eq)) != 0) {
+            return i + scalar_find_u64(items + i, 2, value);
+        }
+    }
+
+    return i + scalar_find_u64(items + i, n - i, value);
+}
+
+static size_t neon_count_u64(const uint64_t *items, size_t n, uint64_t value)
+{
+    uint64x2_t needle = vdupq_n_u64(value);
+    uint64x2_t count = vdupq_n_u64(0);
+    size_t i = 0;
+
+    for(; i + 2 <= n; i += 2) {
+        count = vsubq_u64(count, vceqq_u64(vld1q_u64(items + i), needle));
+    }
+
+    return (size_t)vaddvq_u64(count) + scalar_count_u64(items + i, n - i, value);
+}
+
+static void neon_minmax_i32(const int32_t *items, size_t n, int32_t *min, int32_t *max)
+{
+    if(n < 4) {
+        scalar_minmax_i32(items, n, min, max);
+        return;
+    }
+
+    int32x4_t lo = vld1q_s32(items);
+    int32x4_t hi = lo;
+    size_t i = 4;
+
+    for(; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(items + i);
+        lo = vminq_s32(lo, v);
+        hi = vmaxq_s32(hi, v);
+    }
+
+    int32_t tail_lo = vminvq_s32(lo);
+    int32_t tail_hi = vmaxvq_s32(hi);
+    if(i < n) {
+        int32_t rest_lo, rest_hi;
+        scalar_minmax_i32(items + i, n - i, &rest_lo, &rest_hi);
+        tail_lo = rest_lo < tail_lo ? rest_lo : tail_lo;
+        tail_hi = rest_hi > tail_hi ? rest_hi : tail_hi;
+    }
+
+    *min = tail_lo;
+    *max = tail_hi;
+}
+
+static int64_t neon_sum_i32(const int32_t *items, size_t n)
+{
+    int64x2_t sum = vdupq_n_s64(0);
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4) {
+        sum = vpadalq_s32(sum, vld1q_s32(items + i));
+    }
+
+    return vaddvq_s64(sum) + scalar_sum_i32(items + i, n - i);
+}
+
+static uint64_t neon_sum_i64(const int64_t *items, size_t n)
+{
+    uint64x2_t sum = vdupq_n_u64(0);
+    size_t i = 0;
+
+    for(; i + 2 <= n; i += 2) {
+        sum = vaddq_u64(sum, vreinterpretq_u64_s64(vld1q_s64(items + i)));
+    }
+
+    return vaddvq_u64(sum) + scalar_sum_i64(items + i, n - i);
+}
+
+// NEON has no compress instruction; the scalar compaction loops are branchless already, so
+// they are used for compact, filter and 64-bit min/max
+static const DAKernels neon_kernels = {
+    neon_find_u32, neon_count_u32, neon_find_u64, neon_count_u64, scalar_compact_u64,
+    neon_minmax_i32, scalar_minmax_i64, neon_sum_i32, neon_sum_i64, scalar_filter_i32
+};
+
+#endif
+
+/*
+ * Dispatch
+ */
+
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT;
+static int simd_best = DA_SIMD_SCALAR;
+static _Atomic int simd_level = DA_SIMD_SCALAR;
+
+static void simd_init(void)
+{
+#ifdef DA_SIMD_X86
+    __builtin_cpu_init();
+    avx2_build_tables();
+    if(__builtin_cpu_supports("avx512f")) {
+        simd_best = DA_SIMD_AVX512;
+    } else if(__builtin_cpu_supports("avx2")) {
+        simd_best = DA_SIMD_AVX2;
+    }
+#endif
+#ifdef DA_SIMD_ARM
+    simd_best = DA_SIMD_NEON;
+#endif
+
+    atomic_store_explicit(&simd_level, simd_best, memory_order_relaxed);
+}
+
+static const DAKernels *simd_kernels(void)
+{
+    pthread_once(&simd_once, simd_init);
+
+    switch(atomic_load_explicit(&simd_level, memory_order_relaxed)) {
+#ifdef DA_SIMD_X86
+        case DA_SIMD_AVX512: return &avx512_kernels;
+        case DA_SIMD_AVX2: return &avx2_kernels;
+#endif
+#ifdef DA_SIMD_ARM
+        case DA_SIMD_NEON: return &neon_kernels;
+#endif
+        default: return &scalar_kernels;
+    }
+}
+
+int DArray_simd_level(void)
+{
+    pthread_once(&simd_once, simd_init);
+
+    return atomic_load_explicit(&simd_level, memory_order_relaxed);
+}
+
+int DArray_simd_set_level(int level)
+{
+    pthread_once(&simd_once, simd_init);
+
+    // Levels only count down within an architecture; NEON and AVX never coexist
+    if(level < DA_SIMD_SCALAR || level > simd_best || (simd_best >= DA_SIMD_AVX2 && level == DA_SIMD_NEON)) {
+        level = level > simd_best ? simd_best : DA_SIMD_SCALAR;
+    }
+
+    atomic_store_explicit(&simd_level, level, memory_order_relaxed);
+
+    return level;
+}
+
+/*
+ * DArray
+ */
+
+// The live values of a darray as up to two runs of the backing store
+static inline DArraySize da_runs(const DArray *darray, void ***first, DArraySize *first_len, void ***second)
+{
+    *first = darray->items + darray->start_index;
+    *second = darray->items;
+
+    uint64_t end = (uint64_t)darray->start_index + darray->length;
+    if((darray->flags & DA_FLAG_RING) && end > darray->store_size) {
+        *first_len = darray->store_size - darray->start_index;
+        return darray->length - *first_len;
+    }
+
+    *first_len = darray->length;
+    return 0;
+}
+
+// Search a run of pointers with the kernel matching the pointer size
+static inline size_t da_find_run(const DAKernels *kernels, void **items, size_t n, void *value)
+{
+    if(sizeof(void *) == sizeof(uint64_t)) {
+        return kernels->find_u64((const uint64_t *)(void *)items, n, (uint64_t)(uintptr_t)value);
+    }
+
+    return kernels->find_u32((const uint32_t *)(void *)items, n, (uint32_t)(uintptr_t)value);
+}
+
+static inline size_t da_count_run(const DAKernels *kernels, void **items, size_t n, void *value)
+{
+    if(sizeof(void *) == sizeof(uint64_t)) {
+        return kernels->count_u64((const uint64_t *)(void *)items, n, (uint64_t)(uintptr_t)value);
+    }
+
+    return kernels->count_u32((const uint32_t *)(void *)items, n, (uint32_t)(uintptr_t)value);
+}
+
+DArraySize DArray_find(DArray *darray, void *value)
+{
+    if(darray == NULL) {
+        return DA_NOT_FOUND;
+    }
+
+    const DAKernels *kernels = simd_kernels();
+    void **first, **second;
+    DArraySize first_len;
+    DArraySize second_len = da_runs(darray, &first, &first_len, &second);
+
+    size_t found = da_find_run(kernels, first, first_len, value);
+    if(found < first_len) {
+        return (DArraySize)found;
+    }
+
+    found = da_find_run(kernels, second, second_len, value);
+    return found < second_len ? first_len + (DArraySize)found : DA_NOT_FOUND;
+}
+
+DArraySize DArray_count(DArray *darray, void *value)
+{
+    if(darray == NULL) {
+        return 0;
+    }
+
+    const DAKernels *kernels = simd_kernels();
+    void **first, **second;
+    DArraySize first_len;
+    DArraySize second_len = da_runs(darray, &first, &first_len, &second);
+
+    return (DArraySize)(da_count_run(kernels, first, first_len, value) + da_count_run(kernels, second, second_len, value));
+}
+
+DArraySize DArray_compact(DArray *darray, int *res)
+{
+    int err = 0;
+    DArraySize removed = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+
+    int rc = DArray_linearise(darray);
+    check_err(rc == 0, err, rc, "Failed to linearise DArray for compact");
+
+    void **items = darray->items + darray->start_index;
+    size_t kept;
+    if(sizeof(void *) == sizeof(uint64_t)) {
+        kept = simd_kernels()->compact_u64((uint64_t *)(void *)items, darray->length);
+    } else {
+        kept = 0;
+        for(DArraySize i = 0; i < darray->length; i++) {
+            items[kept] = items[i];
+            kept += items[i] != NULL;
+        }
+    }
+
+    // Slots past the live values must stay NULL
+    removed = darray->length - (DArraySize)kept;
+    memset(items + kept, 0, (size_t)removed * sizeof(void *));
+    darray->length = (DArraySize)kept;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return removed;
+}
+
+/*
+ * DVArray
+ */
+
+static inline void *dv_start(const DVArray *dvarray)
+{
+    return (char *)dvarray->items + (size_t)dvarray->start_index * dvarray->elem_size;
+}
+
+DArraySize DVArray_find(DVArray *dvarray, const void *value)
+{
+    if(dvarray == NULL || value == NULL) {
+        return DA_NOT_FOUND;
+    }
+
+    size_t found;
+    if(dvarray->elem_size == 4) {
+        uint32_t needle;
+        memcpy(&needle, value, sizeof(needle));
+        found = simd_kernels()->find_u32(dv_start(dvarray), dvarray->length, needle);
+    } else if(dvarray->elem_size == 8) {
+        uint64_t needle;
+        memcpy(&needle, value, sizeof(needle));
+        found = simd_kernels()->find_u64(dv_start(dvarray), dvarray->length, needle);
+    } else {
+        const char *items = dv_start(dvarray);
+        for(found = 0; found < dvarray->length; found++) {
+            if(memcmp(items + found * dvarray->elem_size, value, dvarray->elem_size) == 0) {
+                break;
+            }
+        }
+    }
+
+    return found < dvarray->length ? (DArraySize)found : DA_NOT_FOUND;
+}
+
+uint32_t DVArray_count(DVArray *dvarray, const void *value)
+{
+    if(dvarray == NULL || value == NULL) {
+        return 0;
+    }
+
+    if(dvarray->elem_size == 4) {
+        uint32_t needle;
+        memcpy(&needle, value, sizeof(needle));
+        return (uint32_t)simd_kernels()->count_u32(dv_start(dvarray), dvarray->length, needle);
+    }
+
+    if(dvarray->elem_size == 8) {
+        uint64_t needle;
+        memcpy(&needle, value, sizeof(needle));
+        return (uint32_t)simd_kernels()->count_u64(dv_start(dvarray), dvarray->length, needle);
+    }
+
+    uint32_t count = 0;
+    const char *items = dv_start(dvarray);
+    for(uint32_t i = 0; i < dvarray->length; i++) {
+        count += memcmp(items + (size_t)i * dvarray->elem_size, value, dvarray->elem_size) == 0;
+    }
+
+    return count;
+}
+
+int DVArray_minmax_i32(DVArray *dvarray, int32_t *min, int32_t *max)
+{
+    if(dvarray == NULL || dvarray->elem_size != sizeof(int32_t)) {
+        return DA_ERR_ARGS;
+    }
+    if(dvarray->length == 0) {
+        return DA_ERR_ARGS | DV_EMPTY;
+    }
+
+    int32_t lo, hi;
+    simd_kernels()->minmax_i32(dv_start(dvarray), dvarray->length, &lo, &hi);
+
+    if(min != NULL) {
+        *min = lo;
+    }
+    if(max != NULL) {
+        *max = hi;
+    }
+
+    return 0;
+}
+
+int DVArray_minmax_i64(DVArray *dvarray, int64_t *min, int64_t *max)
+{
+    if(dvarray == NULL || dvarray->elem_size != sizeof(int64_t)) {
+        return DA_ERR_ARGS;
+    }
+    if(dvarray->length == 0) {
+        return DA_ERR_ARGS | DV_EMPTY;
+    }
+
+    int64_t lo, hi;
+    simd_kernels()->minmax_i64(dv_start(dvarray), dvarray->length, &lo, &hi);
+
+    if(min != NULL) {
+        *min = lo;
+    }
+    if(max != NULL) {
+        *max = hi;
+    }
+
+    return 0;
+}
+
+int DVArray_sum_i32(DVArray *dvarray, int64_t *sum)
+{
+    if(dvarray == NULL || sum == NULL || dvarray->elem_size != sizeof(int32_t)) {
+        return DA_ERR_ARGS;
+    }
+
+    *sum = simd_kernels()->sum_i32(dv_start(dvarray), dvarray->length);
+
+    return 0;
+}
+
+int DVArray_sum_i64(DVArray *dvarray, int64_t *sum)
+{
+    if(dvarray == NULL || sum == NULL || dvarray->elem_size != sizeof(int64_t)) {
+        return DA_ERR_ARGS;
+    }
+
+    uint64_t total = simd_kernels()->sum_i64(dv_start(dvarray), dvarray->length);
+    memcpy(sum, &total, sizeof(*sum));
+
+    return 0;
+}
+
+uint32_t DVArray_filter_i32(DVArray *dvarray, int op, int32_t operand, int *res)
+{
+    int err = 0;
+    uint32_t removed = 0;
+
+    check_err(dvarray != NULL && dvarray->elem_size == sizeof(int32_t), err, DA_ERR_ARGS, "NULL dvarray or elem_size not 4");
+    check_err(op >= DA_CMP_EQ && op <= DA_CMP_GE, err, DA_ERR_ARGS, "Invalid comparison: %d", op);
+
+    size_t kept = simd_kernels()->filter_i32(dv_start(dvarray), dvarray->length, op, operand);
+    removed = dvarray->length - (uint32_t)kept;
+    dvarray->length = (uint32_t)kept;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return removed;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file darray_simd.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Vectorised search, reduction and filter kernels for DArray and DVArray
+ *
+ * Each function scans only the live values of its array, and is aware of the pool and of ring
+ * mode. Kernels are implemented with AVX2 and AVX-512 on x86-64 and with NEON on AArch64, and
+ * the best set the CPU supports is chosen at runtime; everything falls back to scalar loops
+ * elsewhere, or when built with `DARRAY_NO_SIMD`.
+ */
+
+#ifndef DArray_simd_h
+#define DArray_simd_h
+
+#include "darray.h"
+#include "dvarray.h"
+#include "stdint.h"
+
+/**
+ * @brief Kernel sets
+ * @see DArray_simd_level
+ */
+enum darray_simd_level {
+    DA_SIMD_SCALAR  = 0,    ///< Portable scalar loops
+    DA_SIMD_NEON    = 1,    ///< AArch64 Advanced SIMD
+    DA_SIMD_AVX2    = 2,    ///< x86-64 AVX2
+    DA_SIMD_AVX512  = 3     ///< x86-64 AVX-512F
+};
+
+/**
+ * @brief Comparisons for the filter functions
+ * @see DVArray_filter_i32
+ */
+enum darray_cmp {
+    DA_CMP_EQ,  ///< Keep values equal to the operand
+    DA_CMP_NE,  ///< Keep values not equal to the operand
+    DA_CMP_LT,  ///< Keep values less than the operand
+    DA_CMP_LE,  ///< Keep values less than or equal to the operand
+    DA_CMP_GT,  ///< Keep values greater than the operand
+    DA_CMP_GE   ///< Keep values greater than or equal to the operand
+};
+
+/**
+ * @brief Get the kernel set in use
+ *
+ * @return A `darray_simd_level`; the best the CPU supports unless changed with
+ * `DArray_simd_set_level`
+ */
+int DArray_simd_level(void);
+
+/**
+ * @brief Choose the kernel set to use, for testing and benchmarking
+ *
+ * @param level A `darray_simd_level`; clamped to what the CPU supports
+ *
+ * @return The level now in use
+ */
+int DArray_simd_set_level(int level);
+
+/**
+ * @brief Find the first occurrence of a value in a darray
+ *
+ * Performance: `O(n)`
+ *
+ * @param darray DArray to search
+ * @param value Value to find
+ *
+ * @return Index of the first value equal to `value`, or `DA_NOT_FOUND`
+ */
+DArraySize DArray_find(DArray *darray, void *value);
+
+/**
+ * @brief Count the occurrences of a value in a darray
+ *
+ * Performance: `O(n)`
+ *
+ * @param darray DArray to search
+ * @param value Value to count
+ *
+ * @return Number of values equal to `value`
+ */
+DArraySize DArray_count(DArray *darray, void *value);
+
+/**
+ * @brief Remove every `NULL` value from a darray, keeping the order of the rest
+ *
+ * A ring is linearised first. Performance: `O(n)`
+ *
+ * @param darray DArray to compact
+ * @param [out] res Result; 0 on success, otherwise non-0; may be `NULL`
+ *
+ * @return Number of values removed
+ */
+DArraySize DArray_compact(DArray *darray, int *res);
+
+/**
+ * @brief Find the first occurrence of a value in a dvarray
+ *
+ * Vectorised for 4- and 8-byte values; other sizes are compared with `memcmp`.
+ * Performance: `O(n)`
+ *
+ * @param dvarray DVArray to search
+ * @param value Value to find; `elem_size` bytes
+ *
+ * @return Index of the first value bytewise equal to `value`, or `DA_NOT_FOUND`
+ */
+DArraySize DVArray_find(DVArray *dvarray, const void *value);
+
+/**
+ * @brief Count the occurrences of a value in a dvarray
+ *
+ * Vectorised for 4- and 8-byte values; other sizes are compared with `memcmp`.
+ * Performance: `O(n)`
+ *
+ * @param dvarray DVArray to search
+ * @param value Value to count; `elem_size` bytes
+ *
+ * @return Number of values bytewise equal to `value`
+ */
+uint32_t DVArray_count(DVArray *dvarray, const void *value);
+
+/**
+ * @brief Get the smallest and largest values of a dvarray of `int32_t`
+ *
+ * @param dvarray DVArray with an `elem_size` of 4
+ * @param [out] min Smallest value; may be `NULL`
+ * @param [out] max Largest value; may be `NULL`
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS`, OR'd with `DV_EMPTY` if the array is empty
+ */
+int DVArray_minmax_i32(DVArray *dvarray, int32_t *min, int32_t *max);
+
+/**
+ * @brief Get the smallest and largest values of a dvarray of `int64_t`
+ *
+ * @param dvarray DVArray with an `elem_size` of 8
+ * @param [out] min Smallest value; may be `NULL`
+ * @param [out] max Largest value; may be `NULL`
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS`, OR'd with `DV_EMPTY` if the array is empty
+ */
+int DVArray_minmax_i64(DVArray *dvarray, int64_t *min, int64_t *max);
+
+/**
+ * @brief Sum the values of a dvarray of `int32_t`
+ *
+ * The sum is accumulated in 64 bits, so cannot overflow.
+ *
+ * @param dvarray DVArray with an `elem_size` of 4
+ * @param [out] sum Sum of the values; 0 for an empty array
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS`
+ */
+int DVArray_sum_i32(DVArray *dvarray, int64_t *sum);
+
+/**
+ * @brief Sum the values of a dvarray of `int64_t`
+ *
+ * The sum wraps on overflow.
+ *
+ * @param dvarray DVArray with an `elem_size` of 8
+ * @param [out] sum Sum of the values; 0 for an empty array
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS`
+ */
+int DVArray_sum_i64(DVArray *dvarray, int64_t *sum);
+
+/**
+ * @brief Keep only the values of a dvarray of `int32_t` which satisfy a comparison
+ *
+ * The values kept stay in order, and are compacted in place. Performance: `O(n)`
+ *
+ * @param dvarray DVArray with an `elem_size` of 4
+ * @param op Comparison of each value against `operand`; a `darray_cmp`
+ * @param operand Right-hand side of the comparison
+ * @param [out] res Result; 0 on success, otherwise `DA_ERR_ARGS`; may be `NULL`
+ *
+ * @return Number of values removed
+ */
+uint32_t DVArray_filter_i32(DVArray *dvarray, int op, int32_t operand, int *res);
+
+#endif
@@ -0,0 +1,165 @@
+/**
+ * @file darray_sort.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Generator macros for specialised DArray sorts
+ *
+ * `DArray_qsort` takes its comparator as a function pointer, so every comparison is an
+ * indirect call. The macros in this file emit an introsort for a concrete element type
+ * and comparison, which the compiler is free to inline.
+ */
+
+#ifndef DArray_sort_h
+#define DArray_sort_h
+
+#include <stddef.h>
+
+/**
+ * @brief Partitions at or below this size are finished with an insertion sort
+ */
+#define DARRAY_SORT_CUTOFF 16
+
+/**
+ * @brief Define an introsort over an array of `T`
+ *
+ * Emits `static void name(T *items, size_t length, ctx_t ctx)`, along with helper functions
+ * prefixed with `name`. `less(a, b, ctx)` must evaluate to non-0 when `a` sorts before `b`;
+ * it may be a function or a function-like macro.<br>
+ * The sort uses median-of-three pivots, finishes partitions of `DARRAY_SORT_CUTOFF` elements
+ * or fewer with an insertion sort, and falls back to a heapsort when the recursion depth
+ * exceeds `2 * log2(length)`, so it is `O(n log n)` in the worst case. It is not stable.
+ *
+ * @param name Name of the generated sort function
+ * @param T Element type
+ * @param ctx_t Type of the context value passed through to `less`
+ * @param less Comparison; `less(a, b, ctx)`
+ */
+#define DARRAY_SORT_DEFINE(name, T, ctx_t, less)                                    \
+    static inline void name##_insertion(T *items, size_t length, ctx_t ctx)         \
+    {                                                                               \
+        (void)ctx;                                                                  \
+        for(size_t i = 1; i < length; i++) {                                        \
+            T tmp = items[i];                                                       \
+            size_t j = i;                                                           \
+            while(j > 0 && less(tmp, items[j - 1], ctx)) {                          \
+                items[j] = items[j - 1];                                            \
+                j--;                                                                \
+            }                                                                       \
+            items[j] = tmp;                                                         \
+        }                                                                           \
+    }                                                                               \
+                                                                                    \
+    static inline void name##_sift(T *items, size_t root, size_t length, ctx_t ctx) \
+    {                                                                               \
+        (void)ctx;                                                                  \
+        T tmp = items[root];                                                        \
+        size_t child;                                                               \
+        while((child = 2 * root + 1) < length) {                                    \
+            if(child + 1 < length && less(items[child], items[child + 1], ctx)) {   \
+                child++;                                                            \
+            }                                                                       \
+            if(!less(tmp, items[child], ctx)) {                                     \
+                break;                                                              \
+            }                                                                       \
+            items[root] = items[child];                                             \
+            root = child;                                                           \
+        }                                                                           \
+        items[root] = tmp;                                                          \
+    }                                                                               \
+                                                                                    \
+    static inline void name##_heapsort(T *items, size_t length, ctx_t ctx)          \
+    {                                                                               \
+        for(size_t i = length / 2; i > 0; i--) {                                    \
+            name##_sift(items, i - 1, length, ctx);                                 \
+        }                                                                           \
+        for(size_t i = length - 1; i > 0; i--) {                                    \
+            T tmp = items[0];                                                       \
+            items[0] = items[i];                                                    \
+            items[i] = tmp;                                                         \
+            name##_sift(items, 0, i, ctx);                                          \
+        }                                                                           \
+    }                                                                               \
+                                                                                    \
+    static void name##_intro(T *items, size_t length, unsigned depth, ctx_t ctx)    \
+    {                                                                               \
+        while(length > DARRAY_SORT_CUTOFF) {                                        \
+            if(depth == 0) {                                                        \
+                name##_heapsort(items, length, ctx);                                \
+                return;                                                             \
+            }                                                                       \
+            depth--;                                                                \
+                                                                                    \
+            /* Order first, middle and last; the two ends then bound both scans */  \
+            size_t mid = length / 2;                                                \
+            T tmp;                                                                  \
+            if(less(items[mid], items[0], ctx)) {                                   \
+                tmp = items[mid]; items[mid] = items[0]; items[0] = tmp;            \
+            }                                                                       \
+            if(less(items[length - 1], items[mid], ctx)) {                          \
+                tmp = items[mid]; items[mid] = items[length - 1];                   \
+                items[length - 1] = tmp;                                            \
+                if(less(items[mid], items[0], ctx)) {                               \
+                    tmp = items[mid]; items[mid] = items[0]; items[0] = tmp;        \
+                }                                                                   \
+            }                                                                       \
+                                                                                    \
+            T pivot = items[mid];                                                   \
+            size_t i = 0;                                                           \
+            size_t j = length - 1;                                                  \
+            for(;;) {                                                               \
+                do { i++; } while(less(items[i], pivot, ctx));                      \
+                do { j--; } while(less(pivot, items[j], ctx));                      \
+                if(i >= j) {                                                        \
+                    break;                                                          \
+                }                                                                   \
+                tmp = items[i]; items[i] = items[j]; items[j] = tmp;                \
+            }                                                                       \
+                                                                                    \
+            /* Recurse into the smaller side to bound stack depth */                \
+            if(i < length - i) {                                                    \
+                name##_intro(items, i, depth, ctx);                                 \
+                items += i;                                                         \
+                length -= i;                                                        \
+            } else {                                                                \
+                name##_intro(items + i, length - i, depth, ctx);                    \
+                length = i;                                                         \
+            }                                                                       \
+        }                                                                           \
+        name##_insertion(items, length, ctx);                                       \
+    }                                                                               \
+                                                                                    \
+    static void name(T *items, size_t length, ctx_t ctx)                            \
+    {                                                                               \
+        unsigned depth = 0;                                                         \
+        for(size_t n = length; n > 1; n >>= 1) {                                    \
+            depth += 2;                                                             \
+        }                                                                           \
+        name##_intro(items, length, depth, ctx);                                    \
+    }
+
+/**
+ * @brief Define a DArray sort with an inline comparison
+ *
+ * Emits `static void name(DArray *darray)`, which sorts the values of `darray` in place.
+ * `less(a, b)` is given two `void *` values and must evaluate to non-0 when `a` sorts
+ * before `b`. Include `darray.h` before using this macro.
+ *
+ * @param name Name of the generated sort function
+ * @param less Comparison; `less(a, b)`
+ */
+#define DARRAY_QSORT_DEFINE(name, less)                                             \
+    static inline int name##_less(void *a, void *b, void *ctx)                      \
+    {                                                                               \
+        (void)ctx;                                                                  \
+        return less(a, b);                                                          \
+    }                                                                               \
+    DARRAY_SORT_DEFINE(name##_items, void *, void *, name##_less)                   \
+    static void name(DArray *array)                                                 \
+    {                                                                               \
+        if(array == NULL || array->length < 2 || DArray_linearise(array) != 0) {    \
+            return;                                                                 \
+        }                                                                           \
+        name##_items(array->items + array->start_index, array->length, NULL);       \
+    }
+
+#endif
@@ -0,0 +1,176 @@
+#include "darray_stats.h"
+#include "darray_stats_internal.h"
+
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+// Histogram updated concurrently from the resize and move paths
+typedef struct DAStatHistogram {
+    _Atomic uint64_t count;
+    _Atomic uint64_t total;
+    _Atomic uint64_t max;
+    _Atomic uint64_t buckets[DA_HIST_BUCKETS];
+} DAStatHistogram;
+
+_Atomic uint64_t da_stat_counters[DA_STAT_COUNT];
+static DAStatHistogram da_stat_latency[DA_TIMER_COUNT];
+
+static const char *const da_stat_names[DA_STAT_COUNT] = {
+    "push", "pop", "unshift", "shift", "splice", "expand", "shrink", "move", "pool_rebuild",
+    "pool_shrink", "realloc", "realloc_moved", "mremap", "bytes_copied", "bytes_moved"
+};
+
+static const char *const da_timer_names[DA_TIMER_COUNT] = { "resize", "move" };
+
+// Values below 16 have a bucket each; above, the top four bits pick one of 8 per power of two
+static inline uint32_t hist_bucket(uint64_t value)
+{
+    if(value < 16) {
+        return (uint32_t)value;
+    }
+
+    uint32_t shift = 60 - (uint32_t)__builtin_clzll(value);
+
+    return shift * 8 + (uint32_t)(value >> shift);
+}
+
+// Largest value which falls in a bucket
+static inline uint64_t hist_bucket_max(uint32_t bucket)
+{
+    if(bucket < 16) {
+        return bucket;
+    }
+
+    uint32_t shift = bucket / 8 - 1;
+    uint64_t top = bucket - shift * 8 + 1;
+
+    return shift + 4 >= 64 ? UINT64_MAX : (top << shift) - 1;
+}
+
+uint64_t da_stat_clock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void da_stat_record(int timer, uint64_t start)
+{
+    uint64_t elapsed = da_stat_clock() - start;
+    DAStatHistogram *histogram = &da_stat_latency[timer];
+
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->total, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->buckets[hist_bucket(elapsed)], 1, memory_order_relaxed);
+
+    uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while(elapsed > max && !atomic_compare_exchange_weak_explicit(&histogram->max, &max, elapsed,
+                memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+int DArray_stats_enabled(void)
+{
+#if defined(DARRAY_STATS_LATENCY)
+    return 2;
+#elif defined(DARRAY_STATS)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void DArray_stats(DArrayStats *stats)
+{
+    if(stats == NULL) {
+        return;
+    }
+
+    for(int i = 0; i < DA_STAT_COUNT; i++) {
+        stats->counters[i] = atomic_load_explicit(&da_stat_counters[i], memory_order_relaxed);
+    }
+
+    for(int t = 0; t < DA_TIMER_COUNT; t++) {
+        DAStatHistogram *histogram = &da_stat_latency[t];
+        stats->latency[t].count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+        stats->latency[t].total = atomic_load_explicit(&histogram->total, memory_order_relaxed);
+        stats->latency[t].max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+        for(int b = 0; b < DA_HIST_BUCKETS; b++) {
+            stats->latency[t].buckets[b] = atomic_load_explicit(&histogram->buckets[b], memory_order_relaxed);
+        }
+    }
+}
+
+void DArray_stats_reset(void)
+{
+    for(int i = 0; i < DA_STAT_COUNT; i++) {
+        atomic_store_explicit(&da_stat_counters[i], 0, memory_order_relaxed);
+    }
+
+    for(int t = 0; t < DA_TIMER_COUNT; t++) {
+        DAStatHistogram *histogram = &da_stat_latency[t];
+        atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+        atomic_store_explicit(&histogram->total, 0, memory_order_relaxed);
+        atomic_store_explicit(&histogram->max, 0, memory_order_relaxed);
+        for(int b = 0; b < DA_HIST_BUCKETS; b++) {
+            atomic_store_explicit(&histogram->buckets[b], 0, memory_order_relaxed);
+        }
+    }
+}
+
+const char *DArray_stat_name(int stat)
+{
+    return stat >= 0 && stat < DA_STAT_COUNT ? da_stat_names[stat] : NULL;
+}
+
+uint64_t DAHistogram_percentile(const DAHistogram *histogram, double percentile)
+{
+    if(histogram == NULL || histogram->count == 0) {
+        return 0;
+    }
+
+    // Rank of the value wanted, from 1
+    double rank = percentile / 100.0 * (double)histogram->count;
+    uint64_t target = (uint64_t)rank;
+    target += (double)target < rank || target == 0;
+    target = target < histogram->count ? target : histogram->count;
+
+    uint64_t seen = 0;
+    for(uint32_t b = 0; b < DA_HIST_BUCKETS; b++) {
+        seen += histogram->buckets[b];
+        if(seen >= target) {
+            uint64_t bound = hist_bucket_max(b);
+            return bound < histogram->max ? bound : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+void DArray_stats_dump(const DArrayStats *stats, FILE *out)
+{
+    if(stats == NULL || out == NULL) {
+        return;
+    }
+
+    for(int i = 0; i < DA_STAT_COUNT; i++) {
+        fprintf(out, "%-16s %llu\n", da_stat_names[i], (unsigned long long)stats->counters[i]);
+    }
+
+    for(int t = 0; t < DA_TIMER_COUNT; t++) {
+        const DAHistogram *histogram = &stats->latency[t];
+        if(histogram->count == 0) {
+            continue;
+        }
+
+        fprintf(out, "%-16s count %llu mean %lluns p50 %lluns p99 %lluns p99.9 %lluns max %lluns\n",
+                da_timer_names[t], (unsigned long long)histogram->count,
+                (unsigned long long)(histogram->total / histogram->count),
+                (unsigned long long)DAHistogram_percentile(histogram, 50.0),
+                (unsigned long long)DAHistogram_percentile(histogram, 99.0),
+                (unsigned long long)DAHistogram_percentile(histogram, 99.9),
+                (unsigned long long)histogram->max);
+    }
+}
@@ -0,0 +1,136 @@
+/**
+ * @file darray_stats.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Operation counters and latency histograms for DArray
+ *
+ * Counting is compiled out unless the library is built with `DARRAY_STATS` defined (`make
+ * stats`), so a normal build pays nothing. `DARRAY_STATS_LATENCY` additionally times every
+ * resize and move of a backing store into a histogram, and implies `DARRAY_STATS`.
+ *
+ * The counters are global to the process and updated with relaxed atomics, so they can be read
+ * while other threads work; a snapshot taken that way is not a single point in time. Without
+ * `DARRAY_STATS` the query functions still exist and report zeros.
+ */
+
+#ifndef DArray_stats_h
+#define DArray_stats_h
+
+#include "stdint.h"
+
+#include <stdio.h>
+
+#if defined(DARRAY_STATS_LATENCY) && !defined(DARRAY_STATS)
+#define DARRAY_STATS
+#endif
+
+/**
+ * @brief DArray operation counters
+ * @see DArrayStats
+ */
+enum darray_stat {
+    DA_STAT_PUSH,           ///< Values pushed, singly or with `DArray_push_n`
+    DA_STAT_POP,            ///< Values popped
+    DA_STAT_UNSHIFT,        ///< Values unshifted
+    DA_STAT_SHIFT,          ///< Values shifted
+    DA_STAT_SPLICE,         ///< Splices, including inserts
+    DA_STAT_EXPAND,         ///< Backing store grown
+    DA_STAT_SHRINK,         ///< Backing store shrunk by `DArray_shrink_to_fit`
+    DA_STAT_MOVE,           ///< Calls to `DArray_move`, including those below
+    DA_STAT_POOL_REBUILD,   ///< Pool rebuilt by an unshift which found it empty
+    DA_STAT_POOL_SHRINK,    ///< Pool shrunk by a shift which found it past `max_pool_size`
+    DA_STAT_REALLOC,        ///< Backing store reallocations through `realloc` or the allocator
+    DA_STAT_REALLOC_MOVED,  ///< Reallocations which returned a new address
+    DA_STAT_MREMAP,         ///< Backing store resizes with `mremap`
+    DA_STAT_BYTES_COPIED,   ///< Bytes copied when a reallocation moved the store; an estimate
+    DA_STAT_BYTES_MOVED,    ///< Bytes moved within the store by moves, splices, linearising and ring rejoins
+    DA_STAT_COUNT           ///< Number of counters
+};
+
+/**
+ * @brief Timed DArray operations
+ * @see DArrayStats
+ */
+enum darray_timer {
+    DA_TIMER_RESIZE,        ///< Resizing the backing store, including rejoining a ring
+    DA_TIMER_MOVE,          ///< `DArray_move`, including any expansion
+    DA_TIMER_COUNT          ///< Number of timers
+};
+
+/**
+ * @brief Buckets in a `DAHistogram`
+ */
+#define DA_HIST_BUCKETS 496
+
+/**
+ * @brief Histogram of latencies in nanoseconds
+ *
+ * Buckets are log-linear, as in HDR histograms: each power of two is split into 8 equal
+ * buckets, so any recorded value is known to within 12.5%, and values below 16 exactly.
+ */
+typedef struct DAHistogram {
+    uint64_t count;                     ///< Number of values recorded
+    uint64_t total;                     ///< Sum of values recorded
+    uint64_t max;                       ///< Largest value recorded
+    uint64_t buckets[DA_HIST_BUCKETS];  ///< Values recorded in each bucket
+} DAHistogram;
+
+/**
+ * @brief Snapshot of every DArray counter and histogram
+ */
+typedef struct DArrayStats {
+    uint64_t counters[DA_STAT_COUNT];       ///< Counters, indexed by `darray_stat`
+    DAHistogram latency[DA_TIMER_COUNT];    ///< Latencies, indexed by `darray_timer`
+} DArrayStats;
+
+/**
+ * @brief Whether the library was built with counting enabled
+ *
+ * @return 2 with latency histograms, 1 with counters only, otherwise 0
+ */
+int DArray_stats_enabled(void);
+
+/**
+ * @brief Take a snapshot of the counters and histograms
+ *
+ * @param [out] stats Snapshot
+ */
+void DArray_stats(DArrayStats *stats);
+
+/**
+ * @brief Reset every counter and histogram to 0
+ */
+void DArray_stats_reset(void);
+
+/**
+ * @brief Get the name of a counter
+ *
+ * @param stat A `darray_stat`
+ *
+ * @return Name of the counter, or `NULL` if out of range
+ */
+const char *DArray_stat_name(int stat);
+
+/**
+ * @brief Estimate a percentile of a histogram
+ *
+ * @param histogram Histogram
+ * @param percentile Percentile to find, from 0 to 100
+ *
+ * @return Upper bound of the bucket holding the percentile, at most the largest value recorded;
+ * 0 if the histogram is empty
+ */
+uint64_t DAHistogram_percentile(const DAHistogram *histogram, double percentile);
+
+/**
+ * @brief Write a snapshot in a readable form
+ *
+ * Every counter is written, followed by the count, mean, 50th, 99th and 99.9th percentiles and
+ * maximum of each histogram which has recorded anything.
+ *
+ * @param stats Snapshot from `DArray_stats`
+ * @param out Stream to write to
+ */
+void DArray_stats_dump(const DArrayStats *stats, FILE *out);
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @file darray_stats_internal.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Counting and timing helpers for the DArray implementation files; not part of the public API
+ *
+ * Kept apart from the public headers, as `_Atomic` is C only; include it only from .c files.
+ * @see darray_stats.h
+ */
+
+#ifndef DArray_stats_internal_h
+#define DArray_stats_internal_h
+
+#include "darray_stats.h"
+
+#include <stdatomic.h>
+
+// Defined in darray_stats.c whether or not counting is enabled
+extern _Atomic uint64_t da_stat_counters[DA_STAT_COUNT];
+uint64_t da_stat_clock(void);
+void da_stat_record(int timer, uint64_t start);
+
+#ifdef DARRAY_STATS
+/**
+ * @brief Add to a `darray_stat` counter; compiled out without `DARRAY_STATS`
+ */
+#define DA_STAT_ADD(stat, n) atomic_fetch_add_explicit(&da_stat_counters[(stat)], (uint64_t)(n), memory_order_relaxed)
+#else
+#define DA_STAT_ADD(stat, n) ((void)0)
+#endif
+
+#ifdef DARRAY_STATS_LATENCY
+/**
+ * @brief Start timing into a local named `name`; compiled out without `DARRAY_STATS_LATENCY`
+ */
+#define DA_TIMER_START(name) uint64_t name = da_stat_clock()
+
+/**
+ * @brief Record the time since `DA_TIMER_START(name)` against a `darray_timer`
+ */
+#define DA_TIMER_STOP(timer, name) da_stat_record((timer), (name))
+#else
+#define DA_TIMER_START(name) ((void)0)
+#define DA_TIMER_STOP(timer, name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,599 @@
+#include "dbg.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Records each thread's ring holds before further records are dropped; a power of 2
+#ifndef DBG_RING_RECORDS
+#define DBG_RING_RECORDS 512
+#endif
+
+#define DBG_MAX_ARGS 8
+#define DBG_STRINGS 152
+#define DBG_CACHE_LINE 64
+
+// An argument copied from a log call, typed by the conversion which consumes it
+typedef union DbgArg {
+    long long i;            // Signed conversions, characters and '*' widths and precisions
+    unsigned long long u;   // Unsigned conversions
+    double d;               // Floating point conversions, including long doubles
+    const void *p;          // Pointers
+    size_t s;               // Strings, as offsets into the record's strings
+} DbgArg;
+
+// A log call, with its arguments copied so it can be formatted later; 256 bytes on LP64
+typedef struct DbgRecord {
+    const char *file;
+    const char *func;
+    const char *fmt;
+    int line;
+    int errnum;
+    unsigned char level;
+    unsigned char raw;                  // Arguments not captured; fmt is written as it stands
+    DbgArg args[DBG_MAX_ARGS];
+    char strings[DBG_STRINGS];          // Copies of %s arguments, each NUL-terminated
+} DbgRecord;
+
+// A ring of records written by one thread and read by the flusher, as in SPSCQueue
+typedef struct DbgRing {
+    _Alignas(DBG_CACHE_LINE) _Atomic uint32_t head;     // Records written out; written by the flusher
+    _Alignas(DBG_CACHE_LINE) _Atomic uint32_t tail;     // Records logged; written by the owner
+    uint32_t cached_head;                               // Owner's last view of head
+    _Atomic uint32_t dropped;                           // Records dropped because the ring was full
+    _Atomic int owned;                                  // Whether a live thread logs to this ring
+    struct DbgRing *next;                               // Next ring in dbg_rings
+    DbgRecord records[DBG_RING_RECORDS];
+} DbgRing;
+
+// Every ring ever created; rings outlive their threads and are reused by new ones
+static _Atomic(DbgRing *) dbg_rings = NULL;
+static _Thread_local DbgRing *dbg_thread_ring = NULL;
+static pthread_key_t dbg_ring_key;
+static pthread_once_t dbg_ring_once = PTHREAD_ONCE_INIT;
+
+// Flusher state; the lock also serialises writing out records
+static pthread_mutex_t dbg_flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dbg_flush_wake = PTHREAD_COND_INITIALIZER;
+static pthread_t dbg_flusher;
+static _Atomic int dbg_running = 0;
+static int dbg_stopping = 0;
+static unsigned int dbg_interval_ms = 0;
+static FILE *dbg_out = NULL;
+
+// Seconds for dbg_limit; NULL for the monotonic clock
+static uint64_t (*dbg_limit_clock)(void) = NULL;
+
+// Give a thread's ring back for reuse when the thread exits
+static void dbg_ring_release(void *ring)
+{
+    atomic_store_explicit(&((DbgRing *)ring)->owned, 0, memory_order_release);
+}
+
+static void dbg_ring_init(void)
+{
+    pthread_key_create(&dbg_ring_key, dbg_ring_release);
+}
+
+// The calling thread's ring, claiming a released one or creating one on first use
+static DbgRing *dbg_ring(void)
+{
+    if(dbg_thread_ring != NULL) {
+        return dbg_thread_ring;
+    }
+
+    pthread_once(&dbg_ring_once, dbg_ring_init);
+
+    DbgRing *ring = atomic_load_explicit(&dbg_rings, memory_order_acquire);
+    for(; ring != NULL; ring = ring->next) {
+        int expected = 0;
+        if(atomic_compare_exchange_strong_explicit(&ring->owned, &expected, 1,
+                    memory_order_acquire, memory_order_relaxed)) {
+            ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+            break;
+        }
+    }
+
+    if(ring == NULL) {
+        ring = aligned_alloc(DBG_CACHE_LINE, sizeof(DbgRing));
+        if(ring == NULL) {
+            return NULL;
+        }
+
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->dropped, 0);
+        atomic_init(&ring->owned, 1);
+        ring->cached_head = 0;
+
+        ring->next = atomic_load_explicit(&dbg_rings, memory_order_relaxed);
+        while(!atomic_compare_exchange_weak_explicit(&dbg_rings, &ring->next, ring,
+                    memory_order_release, memory_order_relaxed)) {
+        }
+    }
+
+    pthread_setspecific(dbg_ring_key, ring);
+    dbg_thread_ring = ring;
+
+    return ring;
+}
+
+// Length modifier of a conversion, with hh as 'H' and ll as 'q'; 0 if none
+static char dbg_length(const char **c)
+{
+    const char *s = *c;
+
+    if((s[0] == 'h' || s[0] == 'l') && s[1] == s[0]) {
+        *c += 2;
+        return s[0] == 'h' ? 'H' : 'q';
+    }
+    if(s[0] != '\0' && strchr("hljztLq", s[0]) != NULL) {
+        *c += 1;
+        return s[0];
+    }
+
+    return 0;
+}
+
+static long long dbg_signed(char length, va_list *ap)
+{
+    switch(length) {
+        case 'H': return (signed char)va_arg(*ap, int);
+        case 'h': return (short)va_arg(*ap, int);
+        case 'l': return va_arg(*ap, long);
+        case 'q': return va_arg(*ap, long long);
+        case 'j': return va_arg(*ap, intmax_t);
+        case 'z':
+        case 't': return va_arg(*ap, ptrdiff_t);
+        default: return va_arg(*ap, int);
+    }
+}
+
+static unsigned long long dbg_unsigned(char length, va_list *ap)
+{
+    switch(length) {
+        case 'H': return (unsigned char)va_arg(*ap, unsigned int);
+        case 'h': return (unsigned short)va_arg(*ap, unsigned int);
+        case 'l': return va_arg(*ap, unsigned long);
+        case 'q': return va_arg(*ap, unsigned long long);
+        case 'j': return va_arg(*ap, uintmax_t);
+        case 'z':
+        case 't': return va_arg(*ap, size_t);
+        default: return va_arg(*ap, unsigned int);
+    }
+}
+
+// Copy the arguments of a log call into its record, walking the format as printf would but
+// without formatting anything; sets raw if the format holds something that can't be copied
+static void dbg_capture(DbgRecord *record, va_list *ap)
+{
+    const char *c = record->fmt;
+    size_t used = 0;
+    int count = 0;
+
+    while((c = strchr(c, '%')) != NULL) {
+        c++;
+        if(*c == '%') {
+            c++;
+            continue;
+        }
+
+        c += strspn(c, "-+ #0'");
+        for(int part = 0; part < 2; part++) {
+            if(part == 1) {
+                if(*c != '.') {
+                    break;
+                }
+                c++;
+            }
+
+            if(*c == '*') {
+                if(count == DBG_MAX_ARGS) {
+                    goto raw;
+                }
+                record->args[count++].i = va_arg(*ap, int);
+                c++;
+            } else {
+                c += strspn(c, "0123456789");
+            }
+        }
+
+        char length = dbg_length(&c);
+        if(count == DBG_MAX_ARGS) {
+            goto raw;
+        }
+
+        DbgArg *arg = &record->args[count++];
+        const char *s = NULL;
+        switch(*c) {
+            case 'd':
+            case 'i':
+                arg->i = dbg_signed(length, ap);
+                break;
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                arg->u = dbg_unsigned(length, ap);
+                break;
+            case 'c':
+                if(length != 0) {
+                    goto raw;
+                }
+                arg->i = va_arg(*ap, int);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                arg->d = length == 'L' ? (double)va_arg(*ap, long double) : va_arg(*ap, double);
+                break;
+            case 'p':
+                arg->p = va_arg(*ap, void *);
+                break;
+            case 's':
+                if(length != 0) {
+                    goto raw;
+                }
+                s = va_arg(*ap, const char *);
+                s = s == NULL ? "(null)" : s;
+                if(used == DBG_STRINGS) {
+                    // The last byte always ends the previous string, so this reads as ""
+                    arg->s = DBG_STRINGS - 1;
+                } else {
+                    size_t n = strnlen(s, DBG_STRINGS - used - 1);
+                    memcpy(record->strings + used, s, n);
+                    record->strings[used + n] = '\0';
+                    arg->s = used;
+                    used += n + 1;
+                }
+                break;
+            default:
+                goto raw;
+        }
+        c++;
+    }
+
+    record->raw = 0;
+    return;
+
+raw:
+    record->raw = 1;
+}
+
+static void dbg_prefix(FILE *out, int level, const char *file, const char *func, int line, int errnum)
+{
+    const char *error = errnum == 0 ? "None" : strerror(errnum);
+
+    switch(level) {
+        case DBG_LEVEL_DEBUG:
+            fprintf(out, "DEBUG %s:%s:%d: ", file, func, line);
+            break;
+        case DBG_LEVEL_INFO:
+            fprintf(out, "[INFO] (%s:%s:%d) ", file, func, line);
+            break;
+        case DBG_LEVEL_WARN:
+            fprintf(out, "[WARN] (%s:%s:%d; errno: %s) ", file, func, line, error);
+            break;
+        default:
+            fprintf(out, "[ERROR] (%s:%s:%d; errno: %s) ", file, func, line, error);
+            break;
+    }
+}
+
+// Append up to n bytes to a conversion specification, leaving room for its length and conversion
+static void dbg_spec_append(char *spec, size_t *len, size_t size, const char *src, size_t n)
+{
+    n = n < size - 4 - *len ? n : size - 4 - *len;
+    memcpy(spec + *len, src, n);
+    *len += n;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+// Format a captured record, one conversion at a time, with every integer widened to long long
+static void dbg_format(FILE *out, const DbgRecord *record)
+{
+    const char *c = record->fmt;
+    int count = 0;
+
+    for(;;) {
+        const char *percent = strchr(c, '%');
+        if(percent == NULL) {
+            fputs(c, out);
+            return;
+        }
+        fwrite(c, 1, (size_t)(percent - c), out);
+        c = percent + 1;
+
+        if(*c == '%') {
+            fputc('%', out);
+            c++;
+            continue;
+        }
+
+        char spec[48] = "%";
+        size_t len = 1;
+        size_t n = strspn(c, "-+ #0'");
+        dbg_spec_append(spec, &len, sizeof(spec), c, n);
+        c += n;
+
+        for(int part = 0; part < 2; part++) {
+            if(part == 1) {
+                if(*c != '.') {
+                    break;
+                }
+                dbg_spec_append(spec, &len, sizeof(spec), c++, 1);
+            }
+
+            if(*c == '*') {
+                char number[16];
+                int digits = snprintf(number, sizeof(number), "%d", (int)record->args[count++].i);
+                dbg_spec_append(spec, &len, sizeof(spec), number, (size_t)digits);
+                c++;
+            } else {
+                n = strspn(c, "0123456789");
+                dbg_spec_append(spec, &len, sizeof(spec), c, n);
+                c += n;
+            }
+        }
+
+        dbg_length(&c);
+        char conversion = *c++;
+        const DbgArg *arg = &record->args[count++];
+
+        if(strchr("diouxX", conversion) != NULL) {
+            spec[len++] = 'l';
+            spec[len++] = 'l';
+        }
+        spec[len++] = conversion;
+        spec[len] = '\0';
+
+        switch(conversion) {
+            case 'd':
+            case 'i':
+                fprintf(out, spec, arg->i);
+                break;
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                fprintf(out, spec, arg->u);
+                break;
+            case 'c':
+                fprintf(out, spec, (int)arg->i);
+                break;
+            case 'p':
+                fprintf(out, spec, arg->p);
+                break;
+            case 's':
+                fprintf(out, spec, record->strings + arg->s);
+                break;
+            default:
+                fprintf(out, spec, arg->d);
+                break;
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+static void dbg_write(FILE *out, const DbgRecord *record)
+{
+    dbg_prefix(out, record->level, record->file, record->func, record->line, record->errnum);
+    if(record->raw) {
+        fputs(record->fmt, out);
+    } else {
+        dbg_format(out, record);
+    }
+    fputc('\n', out);
+}
+
+// Write out every record the rings hold now; dbg_flush_lock must be held
+static void dbg_drain(FILE *out)
+{
+    for(DbgRing *ring = atomic_load_explicit(&dbg_rings, memory_order_acquire); ring != NULL; ring = ring->next) {
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        for(; head != tail; head++) {
+            dbg_write(out, &ring->records[head & (DBG_RING_RECORDS - 1)]);
+        }
+        atomic_store_explicit(&ring->head, head, memory_order_release);
+
+        uint32_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+        if(dropped > 0) {
+            fprintf(out, "[WARN] (dbg) %u log records dropped: ring full\n", dropped);
+        }
+    }
+
+    fflush(out);
+}
+
+void dbg_log(int level, const char *file, const char *func, int line, int errnum, const char *fmt, ...)
+{
+    va_list ap;
+    DbgRing *ring = NULL;
+
+    if(atomic_load_explicit(&dbg_running, memory_order_acquire)) {
+        ring = dbg_ring();
+    }
+
+    if(ring == NULL) {
+        va_start(ap, fmt);
+        dbg_prefix(stderr, level, file, func, line, errnum);
+        vfprintf(stderr, fmt, ap);
+        fputc('\n', stderr);
+        va_end(ap);
+        return;
+    }
+
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if(tail - ring->cached_head == DBG_RING_RECORDS) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if(tail - ring->cached_head == DBG_RING_RECORDS) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    DbgRecord *record = &ring->records[tail & (DBG_RING_RECORDS - 1)];
+    record->file = file;
+    record->func = func;
+    record->fmt = fmt;
+    record->line = line;
+    record->errnum = errnum;
+    record->level = (unsigned char)level;
+
+    va_start(ap, fmt);
+    dbg_capture(record, &ap);
+    va_end(ap);
+
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    // Pairs with the fence in dbg_log_stop: either its last drain sees this record, or this sees
+    // that stopping has begun and writes the record out itself
+    atomic_thread_fence(memory_order_seq_cst);
+    if(!atomic_load_explicit(&dbg_running, memory_order_relaxed)) {
+        dbg_log_flush();
+    }
+}
+
+static void *dbg_flush_main(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&dbg_flush_lock);
+    while(!dbg_stopping) {
+        struct timespec wake;
+        clock_gettime(CLOCK_REALTIME, &wake);
+        wake.tv_sec += dbg_interval_ms / 1000;
+        wake.tv_nsec += (long)(dbg_interval_ms % 1000) * 1000000;
+        if(wake.tv_nsec >= 1000000000) {
+            wake.tv_sec++;
+            wake.tv_nsec -= 1000000000;
+        }
+
+        // Wait out the whole interval, through spurious wakeups; stopping does the last drain
+        int rc = 0;
+        while(!dbg_stopping && rc != ETIMEDOUT) {
+            rc = pthread_cond_timedwait(&dbg_flush_wake, &dbg_flush_lock, &wake);
+        }
+        if(!dbg_stopping) {
+            dbg_drain(dbg_out);
+        }
+    }
+    pthread_mutex_unlock(&dbg_flush_lock);
+
+    return NULL;
+}
+
+int dbg_log_start(FILE *out, unsigned int interval_ms)
+{
+    int rc = 0;
+
+    pthread_mutex_lock(&dbg_flush_lock);
+    if(atomic_load_explicit(&dbg_running, memory_order_relaxed) || out == NULL) {
+        rc = -1;
+    } else {
+        dbg_out = out;
+        dbg_interval_ms = interval_ms;
+        dbg_stopping = 0;
+        rc = pthread_create(&dbg_flusher, NULL, dbg_flush_main, NULL);
+        if(rc == 0) {
+            atomic_store_explicit(&dbg_running, 1, memory_order_release);
+        }
+    }
+    pthread_mutex_unlock(&dbg_flush_lock);
+
+    return rc;
+}
+
+void dbg_log_flush(void)
+{
+    pthread_mutex_lock(&dbg_flush_lock);
+    dbg_drain(dbg_out != NULL ? dbg_out : stderr);
+    pthread_mutex_unlock(&dbg_flush_lock);
+}
+
+void dbg_log_stop(void)
+{
+    pthread_mutex_lock(&dbg_flush_lock);
+    if(!atomic_load_explicit(&dbg_running, memory_order_relaxed)) {
+        pthread_mutex_unlock(&dbg_flush_lock);
+        return;
+    }
+    atomic_store_explicit(&dbg_running, 0, memory_order_release);
+    dbg_stopping = 1;
+    pthread_cond_signal(&dbg_flush_wake);
+    pthread_mutex_unlock(&dbg_flush_lock);
+
+    pthread_join(dbg_flusher, NULL);
+
+    // Pairs with the fence in dbg_log; see there
+    atomic_thread_fence(memory_order_seq_cst);
+    pthread_mutex_lock(&dbg_flush_lock);
+    dbg_drain(dbg_out);
+    dbg_out = NULL;
+    pthread_mutex_unlock(&dbg_flush_lock);
+}
+
+_Static_assert(sizeof(DbgLimit) == sizeof(_Atomic uint64_t) && _Alignof(DbgLimit) >= _Alignof(_Atomic uint64_t),
+        "DbgLimit must be laid out as an atomic uint64_t");
+
+// DbgLimit's state as the atomic it is used as
+static inline _Atomic uint64_t *dbg_limit_state(DbgLimit *site)
+{
+    return (_Atomic uint64_t *)(void *)&site->state;
+}
+
+int dbg_limit(DbgLimit *site, uint32_t limit, const char *file, const char *func, int line)
+{
+    _Atomic uint64_t *slot = dbg_limit_state(site);
+    uint64_t second;
+    if(dbg_limit_clock != NULL) {
+        second = dbg_limit_clock() & UINT32_MAX;
+    } else {
+        struct timespec now;
+#ifdef CLOCK_MONOTONIC_COARSE
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+#else
+        clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+        second = (uint64_t)now.tv_sec & UINT32_MAX;
+    }
+
+    uint64_t state = atomic_load_explicit(slot, memory_order_relaxed);
+    for(;;) {
+        uint64_t seen = state & UINT32_MAX;
+
+        if(state >> 32 != second) {
+            if(atomic_compare_exchange_weak_explicit(slot, &state, second << 32 | 1,
+                        memory_order_relaxed, memory_order_relaxed)) {
+                if(seen > limit) {
+                    dbg_log(DBG_LEVEL_WARN, file, func, line, 0, "%llu messages suppressed",
+                            (unsigned long long)(seen - limit));
+                }
+                return 1;
+            }
+        } else if(seen == UINT32_MAX) {
+            return 0;
+        } else if(atomic_compare_exchange_weak_explicit(slot, &state, state + 1,
+                        memory_order_relaxed, memory_order_relaxed)) {
+            return seen < limit;
+        }
+    }
+}
+
+void dbg_limit_set_clock(uint64_t (*clock)(void))
+{
+    dbg_limit_clock = clock;
+}
@@ -4,27 +4,80 @@
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <stdint.h>
 
-// Disable debug() calls if NDEBUG set
+// Log levels, lowest first
+#define DBG_LEVEL_DEBUG 0
+#define DBG_LEVEL_INFO 1
+#define DBG_LEVEL_WARN 2
+#define DBG_LEVEL_ERR 3
+#define DBG_LEVEL_NONE 4
+
+// Calls below DBG_LEVEL compile to nothing; by default debug() is only kept without NDEBUG
+#ifndef DBG_LEVEL
 #ifdef NDEBUG
-#define debug(M, ...)
+#define DBG_LEVEL DBG_LEVEL_INFO
 #else
-#define debug(M, ...) fprintf(stderr, "DEBUG %s:%s:%d: " M "\n", __FILE__, __func__, __LINE__, ##__VA_ARGS__)
+#define DBG_LEVEL DBG_LEVEL_DEBUG
+#endif
 #endif
 
 // Get clean errno
 #define clean_errno() (errno == 0 ? "None" : strerror(errno))
 
 // Log functions
-#define log_err(M, ...) fprintf(stderr, "[ERROR] (%s:%s:%d; errno: %s) " M "\n", __FILE__, __func__, __LINE__, clean_errno(), ##__VA_ARGS__)
-#define log_warn(M, ...) fprintf(stderr, "[WARN] (%s:%s:%d; errno: %s) " M "\n", __FILE__, __func__, __LINE__, clean_errno(), ##__VA_ARGS__)
-#define log_info(M, ...) fprintf(stderr, "[INFO] (%s:%s:%d) " M "\n", __FILE__, __func__, __LINE__, ##__VA_ARGS__)
+// With DBG_RING defined, calls copy their arguments into a per-thread ring and a background
+// thread started by dbg_log_start formats them; until it is started they are written directly
+#ifdef DBG_RING
+#define dbg_debug(M, ...) dbg_log(DBG_LEVEL_DEBUG, __FILE__, __func__, __LINE__, errno, M, ##__VA_ARGS__)
+#define dbg_err(M, ...) dbg_log(DBG_LEVEL_ERR, __FILE__, __func__, __LINE__, errno, M, ##__VA_ARGS__)
+#define dbg_warn(M, ...) dbg_log(DBG_LEVEL_WARN, __FILE__, __func__, __LINE__, errno, M, ##__VA_ARGS__)
+#define dbg_info(M, ...) dbg_log(DBG_LEVEL_INFO, __FILE__, __func__, __LINE__, errno, M, ##__VA_ARGS__)
+#else
+#define dbg_debug(M, ...) fprintf(stderr, "DEBUG %s:%s:%d: " M "\n", __FILE__, __func__, __LINE__, ##__VA_ARGS__)
+#define dbg_err(M, ...) fprintf(stderr, "[ERROR] (%s:%s:%d; errno: %s) " M "\n", __FILE__, __func__, __LINE__, clean_errno(), ##__VA_ARGS__)
+#define dbg_warn(M, ...) fprintf(stderr, "[WARN] (%s:%s:%d; errno: %s) " M "\n", __FILE__, __func__, __LINE__, clean_errno(), ##__VA_ARGS__)
+#define dbg_info(M, ...) fprintf(stderr, "[INFO] (%s:%s:%d) " M "\n", __FILE__, __func__, __LINE__, ##__VA_ARGS__)
+#endif
+
+#if DBG_LEVEL <= DBG_LEVEL_DEBUG
+#define debug(M, ...) dbg_debug(M, ##__VA_ARGS__)
+#else
+#define debug(M, ...) ((void)0)
+#endif
+
+#if DBG_LEVEL <= DBG_LEVEL_ERR
+#define log_err(M, ...) dbg_err(M, ##__VA_ARGS__)
+#else
+#define log_err(M, ...) ((void)0)
+#endif
+
+#if DBG_LEVEL <= DBG_LEVEL_WARN
+#define log_warn(M, ...) dbg_warn(M, ##__VA_ARGS__)
+#else
+#define log_warn(M, ...) ((void)0)
+#endif
+
+#if DBG_LEVEL <= DBG_LEVEL_INFO
+#define log_info(M, ...) dbg_info(M, ##__VA_ARGS__)
+#else
+#define log_info(M, ...) ((void)0)
+#endif
+
+// Logging from check() and sentinel(), limited to DBG_RATE_LIMIT messages a second from each
+// call site when that is defined; the count suppressed is logged once the next second begins
+#if defined(DBG_RATE_LIMIT) && DBG_RATE_LIMIT > 0
+#define log_limited(M, ...) { static DbgLimit dbg_site; \
+    if(dbg_limit(&dbg_site, DBG_RATE_LIMIT, __FILE__, __func__, __LINE__)) { log_err(M, ##__VA_ARGS__); } }
+#else
+#define log_limited(M, ...) log_err(M, ##__VA_ARGS__)
+#endif
 
 // Manual verification functions
 // Only log if not compiled for library using LIB
-#ifndef LIB
-#define check(A, M, ...) if(!(A)) {log_err(M, ##__VA_ARGS__); errno=0; goto error; }
-#define sentinel(M, ...) { log_err(M, ##__VA_ARGS__); errno=0; goto error; }
+#if !defined(LIB) && DBG_LEVEL <= DBG_LEVEL_ERR
+#define check(A, M, ...) if(!(A)) {log_limited(M, ##__VA_ARGS__); errno=0; goto error; }
+#define sentinel(M, ...) { log_limited(M, ##__VA_ARGS__); errno=0; goto error; }
 #else
 #define check(A, M, ...) if(!(A)) {errno=0; goto error; }
 #define sentinel(M, ...) {errno=0; goto error; }
@@ -32,6 +85,45 @@
 
 // Convenience verification functions
 #define check_mem(A) check((A), "Out of memory.")
+#define check_err(A, V, E, M, ...) if(!(A)) { (V) = (E); sentinel(M, ##__VA_ARGS__); }
 #define check_debug(A, M, ...) if(!(A)) { debug(M, ##__VA_ARGS__); errno=0; goto error; }
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-call-site state for log_limited; only dbg.c touches state, and does so atomically, which
+// keeps this header usable from C++
+typedef struct DbgLimit {
+    uint64_t state __attribute__((aligned(8)));     // Second of the current window, and messages seen in it
+} DbgLimit;
+
+// Log a record through the ring; see DBG_RING. Arguments are copied, with %s strings truncated
+// to fit the record, and formatting waits for the flusher. %n and wide characters and strings
+// are not supported: such records are written with their format as it stands
+void dbg_log(int level, const char *file, const char *func, int line, int errnum, const char *fmt, ...)
+    __attribute__((format(printf, 6, 7)));
+
+// Start the flusher thread, writing records to out once every interval_ms milliseconds have passed;
+// 0 on success, otherwise non-0 if it is already running or the thread couldn't be created
+int dbg_log_start(FILE *out, unsigned int interval_ms);
+
+// Write every record the rings hold now; safe from any thread whether or not the flusher runs
+void dbg_log_flush(void);
+
+// Stop the flusher after writing every record the rings hold; later records go straight to stderr.
+// A call which raced with stopping and reached a ring writes the rings out itself, so none are lost
+void dbg_log_stop(void);
+
+// Whether a log_limited call site may log now; non-0 if so
+int dbg_limit(DbgLimit *site, uint32_t limit, const char *file, const char *func, int line);
+
+// Replace the clock dbg_limit counts seconds with, for tests; NULL restores the monotonic clock.
+// Set it while nothing logs through log_limited
+void dbg_limit_set_clock(uint64_t (*clock)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,270 @@
+#include "dheap.h"
+#include "dbg.h"
+
+#include <stdlib.h>
+
+static inline void dh_place(DHeap *heap, void **items, DArraySize index, void *value)
+{
+    items[index] = value;
+    if(heap->moved != NULL) {
+        heap->moved(value, index);
+    }
+}
+
+static inline void **dh_items(DHeap *heap)
+{
+    return heap->items->items + heap->items->start_index;
+}
+
+// Move the value at i towards the top while it sorts before its parent; returns its new index
+static DArraySize dh_sift_up(DHeap *heap, DArraySize i)
+{
+    void **items = dh_items(heap);
+    void *value = items[i];
+
+    while(i > 0) {
+        DArraySize parent = (i - 1) / heap->arity;
+        if(heap->compare(value, items[parent]) >= 0) {
+            break;
+        }
+
+        dh_place(heap, items, i, items[parent]);
+        i = parent;
+    }
+
+    dh_place(heap, items, i, value);
+
+    return i;
+}
+
+// Move the value at i down while a child sorts before it
+static void dh_sift_down(DHeap *heap, DArraySize i)
+{
+    void **items = dh_items(heap);
+    DArraySize length = heap->items->length;
+    void *value = items[i];
+
+    for(;;) {
+        uint64_t first = (uint64_t)i * heap->arity + 1;
+        if(first >= length) {
+            break;
+        }
+
+        uint64_t end = first + heap->arity < length ? first + heap->arity : length;
+        DArraySize best = (DArraySize)first;
+        for(DArraySize c = best + 1; c < end; c++) {
+            best = heap->compare(items[c], items[best]) < 0 ? c : best;
+        }
+
+        if(heap->compare(items[best], value) >= 0) {
+            break;
+        }
+
+        dh_place(heap, items, i, items[best]);
+        i = best;
+    }
+
+    dh_place(heap, items, i, value);
+}
+
+// Put every value in heap order, bottom up, then report every index
+static void dh_heapify(DHeap *heap)
+{
+    DArraySize length = heap->items->length;
+    DHeap_moved moved = heap->moved;
+
+    // Positions settle only at the end, so report them once rather than on every move
+    heap->moved = NULL;
+    if(length > 1) {
+        for(DArraySize i = (length - 2) / heap->arity + 1; i > 0; i--) {
+            dh_sift_down(heap, i - 1);
+        }
+    }
+    heap->moved = moved;
+
+    if(moved != NULL) {
+        void **items = dh_items(heap);
+        for(DArraySize i = 0; i < length; i++) {
+            moved(items[i], i);
+        }
+    }
+}
+
+// Allocate a heap around an existing store
+static DHeap *dh_alloc(DArray *darray, uint32_t arity, DArray_compare compare, DHeap_moved moved, int *res)
+{
+    DHeap *heap = NULL;
+    int err = 0;
+
+    arity = arity > 0 ? arity : DHEAP_ARITY;
+    check_err(compare != NULL, err, DA_ERR_ARGS, "NULL compare");
+    check_err(arity >= 2, err, DA_ERR_ARGS | DH_INIT_ARITY, "Invalid arity: %u", arity);
+
+    heap = malloc(sizeof(DHeap));
+    check_err(heap != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    heap->items = darray;
+    heap->compare = compare;
+    heap->moved = moved;
+    heap->arity = arity;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return heap;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+DHeap *DHeap_init(uint32_t arity, DArray_compare compare, DHeap_moved moved, int *res)
+{
+    int rc = 0;
+
+    // Values only come and go at the end, so the store needs no pool
+    DArray *darray = DArray_init_with_pool(16, 0.0, 2.0, 0, &rc);
+    if(darray == NULL) {
+        if(res != NULL) {
+            *res = rc;
+        }
+        return NULL;
+    }
+
+    DHeap *heap = dh_alloc(darray, arity, compare, moved, res);
+    if(heap == NULL) {
+        DArray_destroy(darray);
+    }
+
+    return heap;
+}
+
+DHeap *DHeap_from_darray(DArray *darray, uint32_t arity, DArray_compare compare, DHeap_moved moved, int *res)
+{
+    int err = 0;
+
+    check_err(darray != NULL, err, DA_ERR_ARGS, "NULL darray");
+    check_err(!(darray->flags & DA_FLAG_RING), err, DA_ERR_ARGS | DH_INIT_RING, "DArray in ring mode");
+
+    DHeap *heap = dh_alloc(darray, arity, compare, moved, res);
+    if(heap != NULL) {
+        dh_heapify(heap);
+    }
+
+    return heap;
+
+error:
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void DHeap_destroy(DHeap *heap)
+{
+    if(heap == NULL) {
+        return;
+    }
+
+    DArray_destroy(heap->items);
+    free(heap);
+}
+
+void *DHeap_peek(DHeap *heap)
+{
+    if(heap == NULL || heap->items->length == 0) {
+        return NULL;
+    }
+
+    return dh_items(heap)[0];
+}
+
+int DHeap_push(DHeap *heap, void *value)
+{
+    int err = 0;
+
+    check_err(heap != NULL, err, DA_ERR_ARGS, "NULL heap");
+
+    int rc = DArray_push(heap->items, value);
+    check_err(rc == 0, err, rc, "Failed to push onto DHeap");
+
+    dh_sift_up(heap, heap->items->length - 1);
+
+    return 0;
+
+error:
+    return err;
+}
+
+void *DHeap_pop(DHeap *heap)
+{
+    return DHeap_remove(heap, 0);
+}
+
+int DHeap_update(DHeap *heap, DArraySize index)
+{
+    if(heap == NULL || index >= heap->items->length) {
+        return DA_ERR_ARGS;
+    }
+
+    if(dh_sift_up(heap, index) == index) {
+        dh_sift_down(heap, index);
+    }
+
+    return 0;
+}
+
+void *DHeap_remove(DHeap *heap, DArraySize index)
+{
+    if(heap == NULL || index >= heap->items->length) {
+        return NULL;
+    }
+
+    void *value = dh_items(heap)[index];
+    void *last = DArray_pop(heap->items);
+
+    // Fill the gap with the last value, which may belong above or below it
+    if(index < heap->items->length) {
+        dh_items(heap)[index] = last;
+        DHeap_update(heap, index);
+    }
+
+    return value;
+}
+
+int DHeap_merge(DHeap *heap, DHeap *other)
+{
+    int err = 0;
+
+    check_err(heap != NULL && other != NULL && heap != other, err, DA_ERR_ARGS, "NULL or identical heaps");
+
+    DArraySize length = heap->items->length;
+    DArraySize count = other->items->length;
+    int rc = DArray_push_n(heap->items, dh_items(other), count);
+    check_err(rc == 0, err, rc, "Failed to merge DHeaps");
+    DArray_pop_n(other->items, NULL, count);
+
+    // Sifting each value up costs about log_d(n) comparisons; rebuilding costs about 2 per value
+    DArraySize depth = 1;
+    for(uint64_t size = heap->arity; size < (uint64_t)length + count; size *= heap->arity) {
+        depth++;
+    }
+
+    if((uint64_t)count * depth > 2 * ((uint64_t)length + count)) {
+        dh_heapify(heap);
+    } else {
+        for(DArraySize i = length; i < length + count; i++) {
+            dh_sift_up(heap, i);
+        }
+    }
+
+    return 0;
+
+error:
+    return err;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file dheap.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for DHeap implementation
+ *
+ */
+
+#ifndef DHeap_h
+#define DHeap_h
+
+#include "darray.h"
+#include "stdint.h"
+
+/**
+ * @brief Arity used when 0 is given to `DHeap_init`
+ */
+#define DHEAP_ARITY 4
+
+/**
+ * @brief Called whenever a value is placed at a new index in a DHeap
+ *
+ * Storing `index` with the value gives a handle for `DHeap_update` and `DHeap_remove`.
+ */
+typedef void (*DHeap_moved)(void *value, DArraySize index);
+
+/**
+ * @brief d-ary min-heap of pointers, stored in a DArray
+ *
+ * Each value sorts no earlier than its parent under `compare`, so index 0 holds the smallest.
+ * The children of index `i` are `arity * i + 1` to `arity * i + arity`. A wider node makes the
+ * heap shallower, and the children compared at each step of a sift down sit together in one or
+ * two cache lines; 4 is usually fastest. `DHEAP_DEFINE` generates the same operations with an
+ * inline comparison and a constant arity.
+ */
+typedef struct DHeap {
+    DArray *items;          ///< Values in heap order, from index 0
+    DArray_compare compare; ///< Comparison; the smallest value is at the top
+    DHeap_moved moved;      ///< Index callback; may be `NULL`
+    uint32_t arity;         ///< Children per node
+} DHeap;
+
+/**
+ * @brief Initialise an empty DHeap
+ *
+ * @see dheap_err_init for errors
+ *
+ * @param arity Children per node; 0 for `DHEAP_ARITY`, otherwise at least 2
+ * @param compare Comparison; as for `DArray_qsort`
+ * @param moved Index callback; may be `NULL`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DHeap on success, otherwise `NULL`
+ */
+DHeap *DHeap_init(uint32_t arity, DArray_compare compare, DHeap_moved moved, int *res);
+
+/**
+ * @brief Build a DHeap from the values of a darray
+ *
+ * The darray is taken over by the heap and reordered in place, bottom up.
+ * Performance: `O(n)`
+ *
+ * @see dheap_err_init for errors
+ *
+ * @param darray DArray to take over; must not be in ring mode. Left to the caller on error
+ * @param arity Children per node; 0 for `DHEAP_ARITY`, otherwise at least 2
+ * @param compare Comparison; as for `DArray_qsort`
+ * @param moved Index callback; may be `NULL`. Called for every value
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DHeap on success, otherwise `NULL`
+ */
+DHeap *DHeap_from_darray(DArray *darray, uint32_t arity, DArray_compare compare, DHeap_moved moved, int *res);
+
+/**
+ * @brief DHeap_init and DHeap_from_darray errors
+ * @see DHeap_init
+ * @see DHeap_from_darray
+ */
+enum dheap_err_init {
+    DH_INIT_ARITY   = 0x10, ///< Arity of 1
+    DH_INIT_RING    = 0x20  ///< DArray is in ring mode
+};
+
+/**
+ * @brief Destroy a DHeap and free its memory
+ *
+ * Values still in the heap are not freed.
+ *
+ * @param heap DHeap to free
+ */
+void DHeap_destroy(DHeap *heap);
+
+/**
+ * @brief Get the number of values in a DHeap
+ *
+ * @param heap DHeap
+ *
+ * @return Number of values
+ */
+static inline DArraySize DHeap_length(const DHeap *heap)
+{
+    return heap->items->length;
+}
+
+/**
+ * @brief Get the smallest value of a DHeap without removing it
+ *
+ * Performance: `O(1)`
+ *
+ * @param heap DHeap
+ *
+ * @return Smallest value, or `NULL` if the heap is empty
+ */
+void *DHeap_peek(DHeap *heap);
+
+/**
+ * @brief Add a value to a DHeap
+ *
+ * Performance: `O(log n)`, plus expansion if required
+ * @see darray_err_push for errors
+ *
+ * @param heap DHeap to add to
+ * @param value Value to add
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DHeap_push(DHeap *heap, void *value);
+
+/**
+ * @brief Remove the smallest value from a DHeap
+ *
+ * Performance: `O(d log n)` for arity `d`
+ *
+ * @param heap DHeap to remove from
+ *
+ * @return Smallest value, or `NULL` if the heap is empty
+ */
+void *DHeap_pop(DHeap *heap);
+
+/**
+ * @brief Restore heap order after the value at an index has changed
+ *
+ * Call after changing the key of the value at `index`, e.g. to decrease it. The value moves up or
+ * down as needed. Performance: `O(log n)` for a decrease, `O(d log n)` for an increase
+ *
+ * @param heap DHeap
+ * @param index Index of the value, as reported to the `moved` callback
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS`
+ */
+int DHeap_update(DHeap *heap, DArraySize index);
+
+/**
+ * @brief Remove the value at an index from a DHeap
+ *
+ * Performance: `O(d log n)`
+ *
+ * @param heap DHeap
+ * @param index Index of the value, as reported to the `moved` callback
+ *
+ * @return Value removed, or `NULL` if `index` is out of range
+ */
+void *DHeap_remove(DHeap *heap, DArraySize index);
+
+/**
+ * @brief Move every value of one DHeap into another
+ *
+ * The values are appended in one batch. A few are then sifted up one by one, while a batch
+ * comparable in size to the heap is merged by rebuilding the whole heap bottom up.
+ * Performance: `O(min(m log n, n + m))` for `m` values merged into `n`
+ * @see darray_err_push for errors
+ *
+ * @param heap DHeap to merge into
+ * @param other DHeap to merge from; left empty. Must use the same comparison
+ *
+ * @return Result; 0 on success, otherwise non-0. Neither heap is changed on error
+ */
+int DHeap_merge(DHeap *heap, DHeap *other);
+
+/**
+ * @brief Define heap operations with an inline comparison and constant arity
+ *
+ * Emits the following, operating on the values of a darray which is not in ring mode:
+ *
+ * - `static void name_heapify(DArray *darray)` - put the values in heap order; `O(n)`
+ * - `static int name_push(DArray *darray, void *value)` - as `DHeap_push`
+ * - `static void *name_pop(DArray *darray)` - as `DHeap_pop`
+ *
+ * `less(a, b)` must evaluate to non-0 when `a` sorts before `b`. There is no index callback.
+ *
+ * @param name Prefix of the generated functions
+ * @param arity Children per node; at least 2
+ * @param less Comparison; `less(a, b)`
+ */
+#define DHEAP_DEFINE(name, arity, less)                                                     \
+    static inline void name##_sift_up(void **items, DArraySize i)                           \
+    {                                                                                       \
+        void *value = items[i];                                                             \
+        while(i > 0) {                                                                      \
+            DArraySize parent = (i - 1) / (arity);                                          \
+            if(!less(value, items[parent])) {                                               \
+                break;                                                                      \
+            }                                                                               \
+            items[i] = items[parent];                                                       \
+            i = parent;                                                                     \
+        }                                                                                   \
+        items[i] = value;                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void name##_sift_down(void **items, DArraySize length, DArraySize i)      \
+    {                                                                                       \
+        void *value = items[i];                                                             \
+        for(;;) {                                                                           \
+            uint64_t first = (uint64_t)i * (arity) + 1;                                     \
+            if(first >= length) {                                                           \
+                break;                                                                      \
+            }                                                                               \
+            uint64_t end = first + (arity) < length ? first + (arity) : length;             \
+            DArraySize best = (DArraySize)first;                                            \
+            for(DArraySize c = best + 1; c < end; c++) {                                    \
+                best = less(items[c], items[best]) ? c : best;                              \
+            }                                                                               \
+            if(!less(items[best], value)) {                                                 \
+                break;                                                                      \
+            }                                                                               \
+            items[i] = items[best];                                                         \
+            i = best;                                                                       \
+        }                                                                                   \
+        items[i] = value;                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static void name##_heapify(DArray *darray)                                              \
+    {                                                                                       \
+        if(darray == NULL || darray->length < 2) {                                          \
+            return;                                                                         \
+        }                                                                                   \
+        void **items = darray->items + darray->start_index;                                 \
+        for(DArraySize i = (darray->length - 2) / (arity) + 1; i > 0; i--) {                \
+            name##_sift_down(items, darray->length, i - 1);                                 \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static int name##_push(DArray *darray, void *value)                                     \
+    {                                                                                       \
+        int rc = DArray_push(darray, value);                                                \
+        if(rc == 0) {                                                                       \
+            name##_sift_up(darray->items + darray->start_index, darray->length - 1);        \
+        }                                                                                   \
+        return rc;                                                                          \
+    }                                                                                       \
+                                                                                            \
+    static void *name##_pop(DArray *darray)                                                 \
+    {                                                                                       \
+        if(darray == NULL || darray->length == 0) {                                         \
+            return NULL;                                                                    \
+        }                                                                                   \
+        void **items = darray->items + darray->start_index;                                 \
+        void *top = items[0];                                                               \
+        void *last = DArray_pop(darray);                                                    \
+        if(darray->length > 0) {                                                            \
+            items[0] = last;                                                                \
+            name##_sift_down(items, darray->length, 0);                                     \
+        }                                                                                   \
+        return top;                                                                         \
+    }
+
+#endif
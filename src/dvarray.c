@@ -0,0 +1,244 @@
+#include "dvarray.h"
+#include "dbg.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Address of a slot in the backing store
+static inline char *dv_slot(const DVArray *dvarray, uint64_t slot)
+{
+    return (char *)dvarray->items + slot * dvarray->elem_size;
+}
+
+// Slots the pool may reach before shift shrinks it
+static inline uint32_t dv_pool_limit(const DVArray *dvarray)
+{
+    return (uint32_t)(dvarray->store_size * dvarray->max_pool_size);
+}
+
+DVArray *DVArray_init_with_pool(uint32_t elem_size, uint32_t length, double max_pool_size, double expand_rate, uint32_t pool_size, int *res)
+{
+    return DVArray_init_with_allocator(elem_size, length, max_pool_size, expand_rate, pool_size, NULL, res);
+}
+
+DVArray *DVArray_init_with_allocator(uint32_t elem_size, uint32_t length, double max_pool_size, double expand_rate, uint32_t pool_size, Allocator *allocator, int *res)
+{
+    DVArray *dvarray = NULL;
+    int err = 0;
+
+    check_err(elem_size > 0, err, DA_ERR_ARGS | DV_INIT_ELEM_SIZE, "Invalid elem_size: %u", elem_size);
+    check_err(length > 0, err, DA_ERR_ARGS | DA_INIT_LENGTH, "Invalid length: %u", length);
+    check_err(max_pool_size >= 0 && max_pool_size <= 1, err, DA_ERR_ARGS | DA_INIT_M_POOL_SIZE, "Invalid max_pool_size: %f", max_pool_size);
+    check_err(expand_rate > 1, err, DA_ERR_ARGS | DA_INIT_EXPAND_RATE, "Invalid expand_rate: %f", expand_rate);
+    check_err(pool_size < length, err, DA_ERR_ARGS | DA_INIT_POOL_SIZE, "Invalid pool_size: %u", pool_size);
+
+    dvarray = Allocator_alloc(allocator, sizeof(DVArray));
+    check_err(dvarray != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    dvarray->items = Allocator_alloc(allocator, (size_t)length * elem_size);
+    check_err(dvarray->items != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+    memset(dvarray->items, 0, (size_t)length * elem_size);
+
+    dvarray->length = 0;
+    dvarray->store_size = length;
+    dvarray->start_index = pool_size;
+    dvarray->elem_size = elem_size;
+    dvarray->expand_rate = expand_rate;
+    dvarray->max_pool_size = max_pool_size;
+    dvarray->allocator = allocator;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return dvarray;
+
+error:
+    Allocator_free(allocator, dvarray, sizeof(DVArray));
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void DVArray_destroy(DVArray *dvarray)
+{
+    if(dvarray == NULL) {
+        return;
+    }
+
+    Allocator_free(dvarray->allocator, dvarray->items, (size_t)dvarray->store_size * dvarray->elem_size);
+    Allocator_free(dvarray->allocator, dvarray, sizeof(DVArray));
+}
+
+void *DVArray_index(DVArray *dvarray, uint32_t index)
+{
+    if(dvarray == NULL || index >= dvarray->length) {
+        return NULL;
+    }
+
+    return dv_slot(dvarray, (uint64_t)dvarray->start_index + index);
+}
+
+int DVArray_get(DVArray *dvarray, uint32_t index, void *value)
+{
+    void *slot = DVArray_index(dvarray, index);
+    if(slot == NULL || value == NULL) {
+        return DA_ERR_ARGS;
+    }
+
+    memcpy(value, slot, dvarray->elem_size);
+
+    return 0;
+}
+
+// Expand the backing store to hold at least needed values, growing at least geometrically
+static int dv_grow(DVArray *dvarray, uint64_t needed)
+{
+    int err = 0;
+
+    if(needed <= dvarray->store_size) {
+        return 0;
+    }
+    check_err(needed <= UINT32_MAX, err, DA_ERR_MEMORY | DA_EXPAND_LIMIT, "DVArray at maximum size");
+
+    uint32_t old_size = dvarray->store_size;
+    double scaled = old_size * dvarray->expand_rate;
+    uint32_t new_size = scaled >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)scaled;
+    if(new_size < needed) {
+        new_size = (uint32_t)needed;
+    }
+
+    void *items = Allocator_realloc(dvarray->allocator, dvarray->items, (size_t)old_size * dvarray->elem_size, (size_t)new_size * dvarray->elem_size);
+    check_err(items != NULL, err, DA_ERR_MEMORY | DA_EXPAND_REALLOC, "Out of memory.");
+
+    dvarray->items = items;
+    dvarray->store_size = new_size;
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DVArray_expand(DVArray *dvarray)
+{
+    int err = 0;
+
+    check_err(dvarray != NULL, err, DA_ERR_ARGS, "NULL dvarray");
+
+    return dv_grow(dvarray, (uint64_t)dvarray->store_size + 1);
+
+error:
+    return err;
+}
+
+int DVArray_move(DVArray *dvarray, int64_t dist)
+{
+    int err = 0;
+
+    check_err(dvarray != NULL, err, DA_ERR_ARGS, "NULL dvarray");
+
+    int64_t start = (int64_t)dvarray->start_index + dist;
+    check_err(start >= 0, err, DA_ERR_ARGS | DA_MOVE_RANGE, "Move of %" PRId64 " from %u out of range", dist, dvarray->start_index);
+
+    int rc = dv_grow(dvarray, (uint64_t)start + dvarray->length);
+    check_err(rc == 0, err, da_chain(DA_MOVE_EXPAND, rc), "Failed to expand DVArray for move");
+
+    memmove(dv_slot(dvarray, (uint64_t)start), dv_slot(dvarray, dvarray->start_index), (size_t)dvarray->length * dvarray->elem_size);
+    dvarray->start_index = (uint32_t)start;
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DVArray_push(DVArray *dvarray, const void *value)
+{
+    int err = 0;
+
+    check_err(dvarray != NULL && value != NULL, err, DA_ERR_ARGS, "NULL dvarray or value");
+
+    if(dvarray->start_index + dvarray->length == dvarray->store_size) {
+        int rc = DVArray_expand(dvarray);
+        check_err(rc == 0, err, da_chain(DA_PUSH_EXPAND, rc), "Failed to expand DVArray for push");
+    }
+
+    memcpy(dv_slot(dvarray, (uint64_t)dvarray->start_index + dvarray->length), value, dvarray->elem_size);
+    dvarray->length++;
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DVArray_pop(DVArray *dvarray, void *value)
+{
+    if(dvarray == NULL || dvarray->length == 0) {
+        return DA_ERR_ARGS | DV_EMPTY;
+    }
+
+    dvarray->length--;
+    if(value != NULL) {
+        memcpy(value, dv_slot(dvarray, (uint64_t)dvarray->start_index + dvarray->length), dvarray->elem_size);
+    }
+
+    return 0;
+}
+
+int DVArray_unshift(DVArray *dvarray, const void *value)
+{
+    int err = 0;
+
+    check_err(dvarray != NULL && value != NULL, err, DA_ERR_ARGS, "NULL dvarray or value");
+
+    if(dvarray->start_index == 0) {
+        // Pool exhausted; rebuild it at its maximum size
+        uint32_t pool = dv_pool_limit(dvarray);
+        int rc = DVArray_move(dvarray, pool > 0 ? (int64_t)pool : 1);
+        check_err(rc == 0, err, da_chain(DA_UNSHIFT_MOVE, rc), "Failed to move DVArray for unshift");
+    }
+
+    dvarray->start_index--;
+    memcpy(dv_slot(dvarray, dvarray->start_index), value, dvarray->elem_size);
+    dvarray->length++;
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DVArray_shift(DVArray *dvarray, void *value)
+{
+    int err = 0;
+
+    check_err(dvarray != NULL, err, DA_ERR_ARGS, "NULL dvarray");
+    check_err(dvarray->length > 0, err, DA_ERR_ARGS | DV_EMPTY, "Shift from empty DVArray");
+
+    if(value != NULL) {
+        memcpy(value, dv_slot(dvarray, dvarray->start_index), dvarray->elem_size);
+    }
+    dvarray->start_index++;
+    dvarray->length--;
+
+    // Pool has outgrown its maximum; shrink it to half that
+    uint32_t limit = dv_pool_limit(dvarray);
+    if(dvarray->start_index > limit) {
+        if(dvarray->length == 0) {
+            dvarray->start_index = limit / 2;
+        } else {
+            int rc = DVArray_move(dvarray, -(int64_t)(dvarray->start_index - limit / 2));
+            check_err(rc == 0, err, da_chain(DA_SHIFT_MOVE, rc), "Failed to move DVArray for shift");
+        }
+    }
+
+    return 0;
+
+error:
+    return err;
+}
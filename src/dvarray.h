@@ -0,0 +1,202 @@
+/**
+ * @file dvarray.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for DVArray implementation
+ *
+ */
+
+#ifndef DVArray_h
+#define DVArray_h
+
+#include "darray.h"
+#include "stdint.h"
+
+/**
+ * @brief Dynamic array of inline values
+ *
+ * A sibling of `DArray` which stores fixed-size values directly in its backing store rather
+ * than storing pointers to them, so there is no allocation per value and a linear scan reads
+ * one contiguous block of memory. Values are copied in when added and copied out when removed.
+ *
+ * The pool works exactly as it does for a DArray: empty slots at the start of the store are
+ * used for `O(1)` unshifts, and the pool is shrunk on shift once `(size of pool)/(size of store)`
+ * exceeds `max_pool_size`. Errors are reported with the DArray error codes.
+ * @see DArray
+ */
+typedef struct DVArray {
+    uint32_t length;        ///< Number of values in the dynamic array
+    uint32_t store_size;    ///< Maximum number of values in backing store
+    uint32_t start_index;   ///< Index of the first value in the array within the backing store
+    uint32_t elem_size;     ///< Size of each value in bytes
+    double expand_rate;     ///< Expansion rate of the dynamic array
+    double max_pool_size;   ///< Maximum size of the array's pool
+    void *items;            ///< Backing store of the array; `store_size * elem_size` bytes
+    Allocator *allocator;   ///< Allocator for the array and its backing store; `NULL` for `malloc`
+} DVArray;
+
+/**
+ * @brief Initialise a DVArray with a pool
+ *
+ * @see darray_err_init and dvarray_err_init for errors
+ *
+ * @param elem_size Size of each value in bytes; must be greater than 0
+ * @param length Length of array to create
+ * @param max_pool_size Maximum size of initial pool; must be between 0 and 1
+ * @param expand_rate Expansion rate of array; suitable value 1.5; must be greater than 1
+ * @param pool_size Initial size of pool; must be less than the length
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DVArray on success, otherwise `NULL`
+ */
+DVArray *DVArray_init_with_pool(uint32_t elem_size, uint32_t length, double max_pool_size, double expand_rate, uint32_t pool_size, int *res);
+
+/**
+ * @brief Initialise a DVArray which allocates through an allocator
+ *
+ * The DVArray itself and its backing store are allocated from `allocator`, which must outlive
+ * the array.
+ * @see darray_err_init and dvarray_err_init for errors
+ * @see allocator.h
+ *
+ * @param elem_size Size of each value in bytes; must be greater than 0
+ * @param length Length of array to create
+ * @param max_pool_size Maximum size of initial pool; must be between 0 and 1
+ * @param expand_rate Expansion rate of array; suitable value 1.5; must be greater than 1
+ * @param pool_size Initial size of pool; must be less than the length
+ * @param allocator Allocator to use; `NULL` for `malloc`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DVArray on success, otherwise `NULL`
+ */
+DVArray *DVArray_init_with_allocator(uint32_t elem_size, uint32_t length, double max_pool_size, double expand_rate, uint32_t pool_size, Allocator *allocator, int *res);
+
+/**
+ * @brief DVArray_init errors, in addition to `darray_err_init`
+ * @see DVArray_init_with_pool
+ */
+enum dvarray_err_init {
+    DV_INIT_ELEM_SIZE   = 0x50  ///< Invalid elem_size: 0
+};
+
+/**
+ * @brief Destroy a DVArray and free its memory
+ *
+ * @param dvarray DVArray to free
+ */
+void DVArray_destroy(DVArray *dvarray);
+
+/**
+ * @brief Get a pointer to the value of a dvarray at an index
+ *
+ * The pointer refers to the backing store, and is invalidated by any call which adds or removes
+ * values
+ *
+ * @param dvarray DVArray to index into
+ * @param index Index of value to get
+ *
+ * @return Pointer to value at given index, or `NULL` if it does not exist
+ */
+void *DVArray_index(DVArray *dvarray, uint32_t index);
+
+/**
+ * @brief Copy the value of a dvarray at an index
+ *
+ * @param dvarray DVArray to index into
+ * @param index Index of value to get
+ * @param [out] value Destination for the value; `elem_size` bytes
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS`
+ */
+int DVArray_get(DVArray *dvarray, uint32_t index, void *value);
+
+/**
+ * @brief Expand the backing store of a DVArray
+ *
+ * Performance is dependent on the performance of `realloc`
+ * @see darray_err_expand for errors
+ *
+ * @param dvarray DVArray to expand
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_expand(DVArray *dvarray);
+
+/**
+ * @brief Move all values of a dvarray
+ *
+ * Best-case performance: `O(n)` as each value requires moving<br>
+ * Worst-case perforance: `O(n) + expansion` if array is full
+ * @see darray_err_move for errors
+ *
+ * @param dvarray DVArray to shift values of
+ * @param dist Distance to move and direction
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_move(DVArray *dvarray, int64_t dist);
+
+/**
+ * @brief Push a copy of a value onto the end of a dvarray
+ *
+ * Best-case performance: `O(1)`<br>
+ * Worst-case performance: `O(1) + expansion` if array is full
+ * @see darray_err_push for errors
+ *
+ * @param dvarray Array to push value onto
+ * @param value Value to copy in; `elem_size` bytes
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_push(DVArray *dvarray, const void *value);
+
+/**
+ * @brief Pop a value from the end of a dvarray
+ *
+ * Performance: `O(1)`
+ *
+ * @param dvarray Array to pop value from
+ * @param [out] value Destination for the value; `elem_size` bytes, or `NULL` to discard it
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS | DV_EMPTY`
+ */
+int DVArray_pop(DVArray *dvarray, void *value);
+
+/**
+ * @brief Unshift a copy of a value onto the start of a dvarray
+ *
+ * Best-case performance: `O(1)` if a pool is present<br>
+ * Worst-case performance: `O(1) + move` if no pool available
+ * @see darray_err_unshift for errors
+ *
+ * @param dvarray DVArray to push onto
+ * @param value Value to copy in; `elem_size` bytes
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_unshift(DVArray *dvarray, const void *value);
+
+/**
+ * @brief Shift a value from the start of a dvarray
+ *
+ * Best-case performance: `O(1)` if pool can be used<br>
+ * Worst-case performance: `O(1) + move` if pool requires shrinking
+ * @see darray_err_shift for errors
+ *
+ * @param dvarray DVArray to shift from
+ * @param [out] value Destination for the value; `elem_size` bytes, or `NULL` to discard it
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_shift(DVArray *dvarray, void *value);
+
+/**
+ * @brief DVArray_pop and DVArray_shift errors
+ * @see DVArray_pop
+ * @see DVArray_shift
+ */
+enum dvarray_err_remove {
+    DV_EMPTY        = 0x20  ///< Array has no values to remove
+};
+
+#endif
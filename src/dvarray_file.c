@@ -0,0 +1,255 @@
+#include "dvarray_file.h"
+#include "dbg.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define DVFILE_BYTE_ORDER 0x01020304u
+
+_Static_assert(sizeof(DVFileHeader) == 64, "DVFileHeader must be 64 bytes");
+
+/*
+ * An opened array lives in one block with its allocator. The allocator hands out heap memory as
+ * usual, except that it recognises the mapped store: resizing it copies it to the heap and
+ * unmaps the file, and freeing the array's header frees the whole block.
+ */
+typedef struct DVFileMap {
+    Allocator allocator;    // Allocator of the opened array; its ctx is this block
+    DVArray dvarray;        // The opened array
+    void *base;             // Mapping of the file, or NULL once released
+    size_t map_length;      // Length of the mapping
+    void *items;            // Store within the mapping
+} DVFileMap;
+
+static void dvf_unmap(DVFileMap *map)
+{
+    if(map->base != NULL) {
+        munmap(map->base, map->map_length);
+        map->base = NULL;
+        map->items = NULL;
+    }
+}
+
+static void *dvf_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+
+    return malloc(size);
+}
+
+static void *dvf_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    DVFileMap *map = ctx;
+
+    if(ptr == NULL || ptr != map->items) {
+        return realloc(ptr, new_size);
+    }
+
+    void *store = malloc(new_size);
+    if(store == NULL) {
+        return NULL;
+    }
+
+    memcpy(store, ptr, old_size < new_size ? old_size : new_size);
+    dvf_unmap(map);
+
+    return store;
+}
+
+static void dvf_free(void *ctx, void *ptr, size_t size)
+{
+    DVFileMap *map = ctx;
+    (void)size;
+
+    if(ptr == &map->dvarray) {
+        dvf_unmap(map);
+        free(map);
+    } else if(ptr == map->items) {
+        dvf_unmap(map);
+    } else {
+        free(ptr);
+    }
+}
+
+// Write every byte of the header and store, resuming after short writes
+static int dvf_write_all(int fd, struct iovec *iov, int count)
+{
+    while(count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        size_t done = (size_t)written;
+        while(count > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if(count > 0) {
+            iov->iov_base = (char *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+
+    return 0;
+}
+
+int DVArray_save(DVArray *dvarray, const char *path)
+{
+    char *tmp_path = NULL;
+    int fd = -1;
+    int err = 0;
+
+    check_err(dvarray != NULL && path != NULL, err, DA_ERR_ARGS, "NULL dvarray or path");
+
+    // The pool and values; an empty array with no pool still saves its first slot
+    uint64_t slots = (uint64_t)dvarray->start_index + dvarray->length;
+    slots = slots > 0 ? slots : 1;
+
+    DVFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DVFILE_MAGIC, sizeof(DVFILE_MAGIC));
+    header.version = DVFILE_VERSION;
+    header.byte_order = DVFILE_BYTE_ORDER;
+    header.elem_size = dvarray->elem_size;
+    header.length = dvarray->length;
+    header.store_size = dvarray->store_size;
+    header.start_index = dvarray->start_index;
+    header.expand_rate = dvarray->expand_rate;
+    header.max_pool_size = dvarray->max_pool_size;
+    header.data_size = slots * dvarray->elem_size;
+
+    size_t path_length = strlen(path);
+    tmp_path = malloc(path_length + sizeof(".tmp"));
+    check_err(tmp_path != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+    memcpy(tmp_path, path, path_length);
+    memcpy(tmp_path + path_length, ".tmp", sizeof(".tmp"));
+
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    check_err(fd >= 0, err, DA_ERR_DATA | DV_FILE_IO, "Failed to create %s", tmp_path);
+
+    struct iovec iov[2] = {
+        { &header, sizeof(header) },
+        { dvarray->items, (size_t)header.data_size }
+    };
+    check_err(dvf_write_all(fd, iov, 2) == 0, err, DA_ERR_DATA | DV_FILE_IO, "Failed to write %s", tmp_path);
+
+    int rc = close(fd);
+    fd = -1;
+    check_err(rc == 0, err, DA_ERR_DATA | DV_FILE_IO, "Failed to write %s", tmp_path);
+    check_err(rename(tmp_path, path) == 0, err, DA_ERR_DATA | DV_FILE_IO, "Failed to replace %s", path);
+
+    free(tmp_path);
+
+    return 0;
+
+error:
+    if(fd >= 0) {
+        close(fd);
+    }
+    if(tmp_path != NULL) {
+        unlink(tmp_path);
+        free(tmp_path);
+    }
+
+    return err;
+}
+
+// Check a header describes a usable array within a file of size bytes
+static int dvf_valid(const DVFileHeader *header, uint64_t size)
+{
+    if(memcmp(header->magic, DVFILE_MAGIC, sizeof(DVFILE_MAGIC)) != 0 || header->version != DVFILE_VERSION ||
+            header->byte_order != DVFILE_BYTE_ORDER || header->elem_size == 0) {
+        return 0;
+    }
+
+    uint64_t slots = header->data_size / header->elem_size;
+
+    return header->data_size % header->elem_size == 0 && slots > 0 && slots <= UINT32_MAX &&
+        (uint64_t)header->start_index + header->length <= slots &&
+        header->data_size <= size - sizeof(DVFileHeader) &&
+        header->expand_rate > 1 && header->max_pool_size >= 0 && header->max_pool_size <= 1;
+}
+
+DVArray *DVArray_open(const char *path, int mode, int *res)
+{
+    DVFileMap *map = NULL;
+    void *base = MAP_FAILED;
+    size_t map_length = 0;
+    int fd = -1;
+    int err = 0;
+
+    check_err(path != NULL && (mode == DV_OPEN_READ || mode == DV_OPEN_COPY), err, DA_ERR_ARGS, "NULL path or invalid mode: %d", mode);
+
+    fd = open(path, O_RDONLY);
+    check_err(fd >= 0, err, DA_ERR_DATA | DV_FILE_IO, "Failed to open %s", path);
+
+    struct stat st;
+    check_err(fstat(fd, &st) == 0, err, DA_ERR_DATA | DV_FILE_IO, "Failed to stat %s", path);
+    check_err((uint64_t)st.st_size >= sizeof(DVFileHeader), err, DA_ERR_DATA | DV_FILE_FORMAT, "%s is too short", path);
+
+    map_length = (size_t)st.st_size;
+    if(mode == DV_OPEN_COPY) {
+        base = mmap(NULL, map_length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    } else {
+        base = mmap(NULL, map_length, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    check_err(base != MAP_FAILED, err, DA_ERR_DATA | DV_FILE_IO, "Failed to map %s", path);
+
+    close(fd);
+    fd = -1;
+
+    DVFileHeader header;
+    memcpy(&header, base, sizeof(header));
+    check_err(dvf_valid(&header, map_length), err, DA_ERR_DATA | DV_FILE_FORMAT, "%s is not a valid array file", path);
+
+    map = malloc(sizeof(DVFileMap));
+    check_err(map != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    map->allocator.alloc = dvf_alloc;
+    map->allocator.realloc = dvf_realloc;
+    map->allocator.free = dvf_free;
+    map->allocator.destroy = NULL;
+    map->allocator.ctx = map;
+    map->base = base;
+    map->map_length = map_length;
+    map->items = (char *)base + sizeof(DVFileHeader);
+
+    map->dvarray.length = header.length;
+    map->dvarray.store_size = (uint32_t)(header.data_size / header.elem_size);
+    map->dvarray.start_index = header.start_index;
+    map->dvarray.elem_size = header.elem_size;
+    map->dvarray.expand_rate = header.expand_rate;
+    map->dvarray.max_pool_size = header.max_pool_size;
+    map->dvarray.items = map->items;
+    map->dvarray.allocator = &map->allocator;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return &map->dvarray;
+
+error:
+    if(base != MAP_FAILED) {
+        munmap(base, map_length);
+    }
+    if(fd >= 0) {
+        close(fd);
+    }
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
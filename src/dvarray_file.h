@@ -0,0 +1,105 @@
+/**
+ * @file dvarray_file.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Save a DVArray to a file, and open one without deserialising it
+ *
+ * A saved array is a 64-byte `DVFileHeader` followed by its backing store, from the start of the
+ * pool to the end of the values. The store is written exactly as it is in memory, so opening a
+ * file maps it and points the array straight at the mapping: nothing is read until it is
+ * touched, and pages are then faulted in on demand.
+ */
+
+#ifndef DVArray_file_h
+#define DVArray_file_h
+
+#include "dvarray.h"
+#include "stdint.h"
+
+/**
+ * @brief Identifies an array file
+ */
+#define DVFILE_MAGIC "DVARRAY"
+
+/**
+ * @brief Version of the array file format written by `DVArray_save`
+ */
+#define DVFILE_VERSION 1
+
+/**
+ * @brief Header of an array file
+ *
+ * Fields are in host byte order; `byte_order` is written as `0x01020304` so that a file from a
+ * machine of the other order is rejected rather than misread.
+ */
+typedef struct DVFileHeader {
+    char magic[8];          ///< `DVFILE_MAGIC`, NUL-terminated
+    uint32_t version;       ///< `DVFILE_VERSION`
+    uint32_t byte_order;    ///< `0x01020304`
+    uint32_t elem_size;     ///< Size of each value in bytes
+    uint32_t length;        ///< Number of values
+    uint32_t store_size;    ///< Size of the backing store when saved, in values
+    uint32_t start_index;   ///< Index of the first value within the saved store
+    double expand_rate;     ///< Expansion rate of the array
+    double max_pool_size;   ///< Maximum size of the array's pool
+    uint64_t data_size;     ///< Bytes of store following the header
+    uint8_t reserved[8];    ///< Zero
+} DVFileHeader;
+
+/**
+ * @brief How `DVArray_open` maps a file
+ * @see DVArray_open
+ */
+enum dvarray_open_mode {
+    DV_OPEN_READ    = 0,    ///< Read-only; the array must not be modified in place
+    DV_OPEN_COPY    = 1     ///< Copy-on-write; modifications stay private to this process
+};
+
+/**
+ * @brief Save a dvarray to a file
+ *
+ * The header and store go out in a single `writev` to a temporary file, which then replaces
+ * `path`, so readers which have the old file open keep a consistent view of it.
+ * Performance: `O(n)`
+ *
+ * @see dvarray_err_file for errors
+ *
+ * @param dvarray DVArray to save
+ * @param path File to write
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_save(DVArray *dvarray, const char *path);
+
+/**
+ * @brief Open a file saved by `DVArray_save` as a dvarray
+ *
+ * The file is mapped and the array's store is the mapping, so opening costs `O(1)` regardless
+ * of the size of the file. The opened array's `store_size` covers the saved pool and values;
+ * growing it copies the store to the heap and releases the mapping.
+ *
+ * With `DV_OPEN_READ`, values may be read and the array destroyed, but anything which writes to
+ * the store (set through `DVArray_index`, unshift, shift, and so on) faults. With `DV_OPEN_COPY`
+ * the array may be used as any other, and the file is never changed.
+ *
+ * @see dvarray_err_file for errors
+ *
+ * @param path File to open
+ * @param mode A `dvarray_open_mode`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DVArray on success, otherwise `NULL`. Free with `DVArray_destroy`
+ */
+DVArray *DVArray_open(const char *path, int mode, int *res);
+
+/**
+ * @brief DVArray_save and DVArray_open errors
+ * @see DVArray_save
+ * @see DVArray_open
+ */
+enum dvarray_err_file {
+    DV_FILE_IO      = 0x10, ///< Failed to create, write, open or map the file; see `errno`
+    DV_FILE_FORMAT  = 0x20  ///< File is not a valid array file for this machine
+};
+
+#endif
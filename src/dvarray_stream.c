@@ -0,0 +1,353 @@
+#include "dvarray_stream.h"
+#include "dbg.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(DARRAY_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DVS_CRC_X86 1
+#include <immintrin.h>
+#endif
+
+_Static_assert(sizeof(DVStreamFrame) == 32, "DVStreamFrame must be 32 bytes");
+
+// Chunks per writev or readv; each takes two iovecs, and a batch stays within L2 at the default size
+#define DVS_BATCH 16
+
+/*
+ * CRC32C
+ */
+
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+static uint32_t crc_table[8][256];
+static uint32_t (*crc_update)(uint32_t crc, const unsigned char *data, size_t size);
+
+static uint32_t crc_slice8(uint32_t crc, const unsigned char *data, size_t size)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for(; size >= 8; size -= 8, data += 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        word ^= crc;
+        crc = crc_table[7][word & 0xFF] ^ crc_table[6][(word >> 8) & 0xFF] ^
+            crc_table[5][(word >> 16) & 0xFF] ^ crc_table[4][(word >> 24) & 0xFF] ^
+            crc_table[3][(word >> 32) & 0xFF] ^ crc_table[2][(word >> 40) & 0xFF] ^
+            crc_table[1][(word >> 48) & 0xFF] ^ crc_table[0][word >> 56];
+    }
+#endif
+    for(; size > 0; size--, data++) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *data) & 0xFF];
+    }
+
+    return crc;
+}
+
+#ifdef DVS_CRC_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc_sse42(uint32_t crc, const unsigned char *data, size_t size)
+{
+    uint64_t wide = crc;
+    for(; size >= 8; size -= 8, data += 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        wide = _mm_crc32_u64(wide, word);
+    }
+
+    crc = (uint32_t)wide;
+    for(; size > 0; size--, data++) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+
+    return crc;
+}
+#endif
+
+static void crc_init(void)
+{
+    for(uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for(int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+        }
+        crc_table[0][i] = crc;
+    }
+    for(uint32_t i = 0; i < 256; i++) {
+        for(int k = 1; k < 8; k++) {
+            crc_table[k][i] = (crc_table[k - 1][i] >> 8) ^ crc_table[0][crc_table[k - 1][i] & 0xFF];
+        }
+    }
+
+    crc_update = crc_slice8;
+#ifdef DVS_CRC_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.2")) {
+        crc_update = crc_sse42;
+    }
+#endif
+}
+
+uint32_t DVStream_crc32c(uint32_t crc, const void *data, size_t size)
+{
+    pthread_once(&crc_once, crc_init);
+
+    return ~crc_update(~crc, data, size);
+}
+
+/*
+ * Frames
+ */
+
+// Transfer every byte described by iov, resuming after short transfers; iov is consumed
+static int dvs_transfer(DVStream *stream, struct iovec *iov, int count, int writing)
+{
+    int started = 0;
+
+    while(count > 0) {
+        ssize_t moved;
+        if(writing) {
+            moved = stream->write != NULL ? stream->write(stream->ctx, iov, count) : writev(stream->fd, iov, count);
+        } else {
+            moved = stream->read != NULL ? stream->read(stream->ctx, iov, count) : readv(stream->fd, iov, count);
+        }
+
+        if(moved < 0 && errno == EINTR) {
+            continue;
+        }
+        if(moved == 0 && !writing && !started) {
+            return DA_ERR_DATA | DV_STREAM_END;
+        }
+        if(moved <= 0) {
+            return DA_ERR_DATA | DV_STREAM_IO;
+        }
+
+        started = 1;
+        size_t done = (size_t)moved;
+        while(count > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if(count > 0) {
+            iov->iov_base = (char *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+
+    return 0;
+}
+
+static uint32_t dvs_chunk_values(uint32_t chunk_size, uint32_t elem_size)
+{
+    uint32_t values = (chunk_size > 0 ? chunk_size : DVSTREAM_CHUNK) / elem_size;
+
+    return values > 0 ? values : 1;
+}
+
+static uint32_t dvs_frame_crc(const DVStreamFrame *frame)
+{
+    return DVStream_crc32c(0, frame, offsetof(DVStreamFrame, crc));
+}
+
+// Write a frame of the values from index from on; the header goes out with the first batch
+static int dvs_write(DVArray *dvarray, uint32_t kind, uint32_t from, DVStream *stream, uint32_t chunk_size)
+{
+    uint32_t elem_size = dvarray->elem_size;
+    uint32_t count = dvarray->length - from;
+
+    DVStreamFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    memcpy(frame.magic, DVSTREAM_MAGIC, sizeof(frame.magic));
+    frame.kind = kind;
+    frame.elem_size = elem_size;
+    frame.base = from;
+    frame.count = count;
+    frame.chunk_values = dvs_chunk_values(chunk_size, elem_size);
+    frame.crc = dvs_frame_crc(&frame);
+
+    char *values = (char *)dvarray->items + ((size_t)dvarray->start_index + from) * elem_size;
+    struct iovec iov[2 * DVS_BATCH + 1];
+    uint32_t crcs[DVS_BATCH];
+    uint32_t done = 0;
+
+    iov[0].iov_base = &frame;
+    iov[0].iov_len = sizeof(frame);
+    int n = 1;
+
+    do {
+        for(int chunk = 0; chunk < DVS_BATCH && done < count; chunk++) {
+            uint32_t chunk_count = count - done < frame.chunk_values ? count - done : frame.chunk_values;
+            char *data = values + (size_t)done * elem_size;
+            size_t bytes = (size_t)chunk_count * elem_size;
+
+            crcs[chunk] = DVStream_crc32c(0, data, bytes);
+            iov[n].iov_base = data;
+            iov[n++].iov_len = bytes;
+            iov[n].iov_base = &crcs[chunk];
+            iov[n++].iov_len = sizeof(uint32_t);
+            done += chunk_count;
+        }
+
+        int rc = dvs_transfer(stream, iov, n, 1);
+        if(rc != 0) {
+            return rc;
+        }
+        n = 0;
+    } while(done < count);
+
+    return 0;
+}
+
+int DVArray_write_snapshot(DVArray *dvarray, DVStream *stream, uint32_t chunk_size)
+{
+    int err = 0;
+
+    check_err(dvarray != NULL && stream != NULL, err, DA_ERR_ARGS, "NULL dvarray or stream");
+
+    err = dvs_write(dvarray, DV_FRAME_SNAPSHOT, 0, stream, chunk_size);
+    check_err(err == 0, err, err, "Failed to write snapshot");
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DVArray_write_delta(DVArray *dvarray, uint32_t from, DVStream *stream, uint32_t chunk_size)
+{
+    int err = 0;
+
+    check_err(dvarray != NULL && stream != NULL, err, DA_ERR_ARGS, "NULL dvarray or stream");
+    check_err(from <= dvarray->length, err, DA_ERR_ARGS | DV_STREAM_BASE, "Delta from %u past length %u", from, dvarray->length);
+
+    err = dvs_write(dvarray, DV_FRAME_DELTA, from, stream, chunk_size);
+    check_err(err == 0, err, err, "Failed to write delta");
+
+    return 0;
+
+error:
+    return err;
+}
+
+// Make room for size values in the store, growing by at least the expansion rate
+static int dvs_reserve(DVArray *dvarray, uint64_t size)
+{
+    if(size <= dvarray->store_size) {
+        return 0;
+    }
+    if(size > UINT32_MAX) {
+        return DA_ERR_MEMORY | DA_EXPAND_LIMIT;
+    }
+
+    double scaled = dvarray->store_size * dvarray->expand_rate;
+    uint32_t new_size = scaled >= (double)UINT32_MAX ? UINT32_MAX : (uint32_t)scaled;
+    new_size = new_size > size ? new_size : (uint32_t)size;
+
+    void *items = Allocator_realloc(dvarray->allocator, dvarray->items, (size_t)dvarray->store_size * dvarray->elem_size, (size_t)new_size * dvarray->elem_size);
+    if(items == NULL) {
+        return DA_ERR_MEMORY | DA_EXPAND_REALLOC;
+    }
+
+    dvarray->items = items;
+    dvarray->store_size = new_size;
+
+    return 0;
+}
+
+// Read count values into the store from offset on, checking each chunk as its batch arrives
+static int dvs_read_values(DVArray *dvarray, const DVStreamFrame *frame, uint32_t offset, DVStream *stream)
+{
+    uint32_t elem_size = dvarray->elem_size;
+    uint32_t count = frame->count;
+    char *values = (char *)dvarray->items + ((size_t)dvarray->start_index + offset) * elem_size;
+    struct iovec iov[2 * DVS_BATCH];
+    uint32_t crcs[DVS_BATCH];
+    uint32_t done = 0;
+
+    while(done < count) {
+        uint32_t first = done;
+        int chunks = 0;
+        for(; chunks < DVS_BATCH && done < count; chunks++) {
+            uint32_t chunk_count = count - done < frame->chunk_values ? count - done : frame->chunk_values;
+            iov[2 * chunks].iov_base = values + (size_t)done * elem_size;
+            iov[2 * chunks].iov_len = (size_t)chunk_count * elem_size;
+            iov[2 * chunks + 1].iov_base = &crcs[chunks];
+            iov[2 * chunks + 1].iov_len = sizeof(uint32_t);
+            done += chunk_count;
+        }
+
+        int rc = dvs_transfer(stream, iov, 2 * chunks, 0);
+        if(rc != 0) {
+            return DA_ERR_DATA | DV_STREAM_IO;
+        }
+
+        for(int chunk = 0; chunk < chunks; chunk++) {
+            uint32_t chunk_count = count - first < frame->chunk_values ? count - first : frame->chunk_values;
+            const char *data = values + (size_t)first * elem_size;
+            if(DVStream_crc32c(0, data, (size_t)chunk_count * elem_size) != crcs[chunk]) {
+                return DA_ERR_DATA | DV_STREAM_CHECKSUM;
+            }
+            first += chunk_count;
+        }
+    }
+
+    return 0;
+}
+
+int DVArray_read_frame(DVArray **dvarray, DVStream *stream)
+{
+    DVArray *created = NULL;
+    int err = 0;
+
+    check_err(dvarray != NULL && stream != NULL, err, DA_ERR_ARGS, "NULL dvarray or stream");
+
+    DVStreamFrame frame;
+    struct iovec iov = { &frame, sizeof(frame) };
+    int rc = dvs_transfer(stream, &iov, 1, 0);
+    if(rc == (DA_ERR_DATA | DV_STREAM_END)) {
+        return rc;
+    }
+    check_err(rc == 0, err, rc, "Failed to read frame header");
+
+    check_err(memcmp(frame.magic, DVSTREAM_MAGIC, sizeof(frame.magic)) == 0 && frame.crc == dvs_frame_crc(&frame) &&
+            (frame.kind == DV_FRAME_SNAPSHOT || frame.kind == DV_FRAME_DELTA) && frame.elem_size > 0 &&
+            frame.chunk_values > 0 && frame.reserved == 0 && (frame.kind == DV_FRAME_DELTA || frame.base == 0),
+            err, DA_ERR_DATA | DV_STREAM_FORMAT, "Invalid frame header");
+
+    DVArray *target = *dvarray;
+    if(target == NULL) {
+        check_err(frame.kind == DV_FRAME_SNAPSHOT, err, DA_ERR_ARGS, "NULL dvarray for delta");
+        created = DVArray_init_with_pool(frame.elem_size, frame.count > 0 ? frame.count : 1, 0.0, 1.5, 0, &rc);
+        check_err(created != NULL, err, rc, "Failed to create DVArray for snapshot");
+        target = created;
+    }
+
+    check_err(target->elem_size == frame.elem_size, err, DA_ERR_DATA | DV_STREAM_FORMAT,
+            "Frame elem_size %u differs from DVArray elem_size %u", frame.elem_size, target->elem_size);
+
+    uint32_t offset = 0;
+    if(frame.kind == DV_FRAME_DELTA) {
+        check_err(frame.base == target->length, err, DA_ERR_DATA | DV_STREAM_BASE,
+                "Delta follows length %u, not %u", frame.base, target->length);
+        offset = target->length;
+    } else {
+        target->length = 0;
+    }
+
+    rc = dvs_reserve(target, (uint64_t)target->start_index + offset + frame.count);
+    check_err(rc == 0, err, rc, "Failed to expand DVArray for frame");
+
+    rc = dvs_read_values(target, &frame, offset, stream);
+    check_err(rc == 0, err, rc, "Failed to read frame values");
+
+    target->length = offset + frame.count;
+    *dvarray = target;
+
+    return 0;
+
+error:
+    DVArray_destroy(created);
+
+    return err;
+}
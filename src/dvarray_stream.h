@@ -0,0 +1,164 @@
+/**
+ * @file dvarray_stream.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Stream a DVArray through a pipe, socket or callback in checksummed chunks
+ *
+ * A stream is a sequence of frames. Each frame is a 32-byte `DVStreamFrame` followed by its
+ * values, split into chunks of `chunk_values` values which are each followed by the CRC32C of
+ * their bytes. A snapshot frame carries every value of an array; a delta frame carries the
+ * values pushed since an earlier frame, so a replica can catch up without receiving the whole
+ * array again.
+ *
+ * Values go straight between the array's store and the stream with `writev` and `readv`, a
+ * batch of chunks and their checksums at a time, so there is never a copy of the whole array.
+ * Fields and values are in host byte order, so both ends must share it.
+ */
+
+#ifndef DVArray_stream_h
+#define DVArray_stream_h
+
+#include "dvarray.h"
+#include "stdint.h"
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * @brief Identifies a frame
+ */
+#define DVSTREAM_MAGIC "DVS1"
+
+/**
+ * @brief Chunk size in bytes used when 0 is given to a writer
+ */
+#define DVSTREAM_CHUNK (64 * 1024)
+
+/**
+ * @brief Where a stream's bytes go to and come from
+ *
+ * The callbacks behave as `writev` and `readv`: they may transfer fewer bytes than asked, return
+ * -1 on error, and `read` returns 0 at the end of the stream. When a callback is `NULL` the
+ * stream uses the system call on `fd` instead; `DVStream_fd` makes such a stream.
+ */
+typedef struct DVStream {
+    ssize_t (*write)(void *ctx, const struct iovec *iov, int count);    ///< Write callback; may be `NULL`
+    ssize_t (*read)(void *ctx, const struct iovec *iov, int count);     ///< Read callback; may be `NULL`
+    void *ctx;                                                          ///< Passed to each callback
+    int fd;                                                             ///< File descriptor used without callbacks
+} DVStream;
+
+/**
+ * @brief Kinds of frame
+ */
+enum dvarray_stream_kind {
+    DV_FRAME_SNAPSHOT   = 1,    ///< Every value of an array
+    DV_FRAME_DELTA      = 2     ///< Values appended to an array of length `base`
+};
+
+/**
+ * @brief Header of a frame
+ */
+typedef struct DVStreamFrame {
+    char magic[4];          ///< `DVSTREAM_MAGIC`, without NUL
+    uint32_t kind;          ///< A `dvarray_stream_kind`
+    uint32_t elem_size;     ///< Size of each value in bytes
+    uint32_t base;          ///< Length of the array before the values; 0 for a snapshot
+    uint32_t count;         ///< Number of values following
+    uint32_t chunk_values;  ///< Values per chunk; the last chunk may be shorter
+    uint32_t reserved;      ///< Zero
+    uint32_t crc;           ///< CRC32C of the preceding fields
+} DVStreamFrame;
+
+/**
+ * @brief Make a stream on a file descriptor
+ *
+ * @param fd Descriptor of a file, pipe or socket
+ *
+ * @return Stream using `writev` and `readv` on `fd`
+ */
+static inline DVStream DVStream_fd(int fd)
+{
+    DVStream stream = { NULL, NULL, NULL, fd };
+
+    return stream;
+}
+
+/**
+ * @brief CRC32C of a block of bytes
+ *
+ * Uses the SSE4.2 `crc32` instruction where available, otherwise slicing-by-8 tables.
+ *
+ * @param crc CRC of the bytes before `data`; 0 to start
+ * @param data Bytes to add
+ * @param size Number of bytes
+ *
+ * @return CRC of the bytes so far
+ */
+uint32_t DVStream_crc32c(uint32_t crc, const void *data, size_t size);
+
+/**
+ * @brief Write every value of a dvarray to a stream as a snapshot frame
+ *
+ * Performance: `O(n)`
+ * @see dvarray_err_stream for errors
+ *
+ * @param dvarray DVArray to write
+ * @param stream Stream to write to
+ * @param chunk_size Bytes per chunk, rounded down to whole values; 0 for `DVSTREAM_CHUNK`
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_write_snapshot(DVArray *dvarray, DVStream *stream, uint32_t chunk_size);
+
+/**
+ * @brief Write the values of a dvarray from an index on as a delta frame
+ *
+ * To follow a frame written when the array had length `n`, pass `n` as `from` and values pushed
+ * since are sent. Values before `from` must not have changed.
+ * Performance: `O(length - from)`
+ * @see dvarray_err_stream for errors
+ *
+ * @param dvarray DVArray to write
+ * @param from Index of the first value to write; at most the length of the array
+ * @param stream Stream to write to
+ * @param chunk_size Bytes per chunk, rounded down to whole values; 0 for `DVSTREAM_CHUNK`
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVArray_write_delta(DVArray *dvarray, uint32_t from, DVStream *stream, uint32_t chunk_size);
+
+/**
+ * @brief Read one frame from a stream into a dvarray
+ *
+ * A snapshot replaces the values of `*dvarray`, or of a new array stored to `*dvarray` if it is
+ * `NULL`. A delta is appended to `*dvarray`, whose length must be the frame's `base`. Values are
+ * read straight into spare room at the end of the store and only become part of the array once
+ * every checksum has matched, so on error a delta leaves the array unchanged apart from its
+ * capacity, and a snapshot leaves it empty. The stream may be left part way through the frame.
+ * Performance: `O(count)`, plus expansion if required
+ * @see dvarray_err_stream for errors
+ *
+ * @param [in,out] dvarray DVArray to read into, or `NULL` to create one for a snapshot
+ * @param stream Stream to read from
+ *
+ * @return Result; 0 on success, otherwise non-0. `DA_ERR_DATA | DV_STREAM_END` at the end of the
+ * stream
+ */
+int DVArray_read_frame(DVArray **dvarray, DVStream *stream);
+
+/**
+ * @brief DVArray stream errors
+ * @see DVArray_write_snapshot
+ * @see DVArray_write_delta
+ * @see DVArray_read_frame
+ */
+enum dvarray_err_stream {
+    DV_STREAM_IO        = 0x10, ///< Stream failed or ended part way through a frame; see `errno`
+    DV_STREAM_FORMAT    = 0x20, ///< Frame header invalid, or element size differs from the array
+    DV_STREAM_CHECKSUM  = 0x30, ///< Chunk does not match its checksum
+    DV_STREAM_BASE      = 0x40, ///< Delta does not follow the array's length
+    DV_STREAM_END       = 0x50  ///< Stream ended before a frame
+};
+
+#endif
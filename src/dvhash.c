@@ -0,0 +1,486 @@
+#include "dvhash.h"
+#include "dbg.h"
+
+#include <string.h>
+
+#if !defined(DARRAY_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VH_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+_Static_assert(sizeof(DVHashMeta) == 64, "DVHashMeta must be 64 bytes");
+
+// Control bytes; a full slot holds the low 7 bits of its key's hash, so has the top bit clear
+#define VH_EMPTY 0x80
+#define VH_DELETED 0xFE
+
+#define VH_MIN_SLOTS DVHASH_GROUP
+#define VH_MAX_SLOTS (UINT32_C(1) << 31)
+#define VH_SEED UINT64_C(0x9E3779B97F4A7C15)
+
+// Entries which may fill a table of slots, keeping 1/8 of it empty so every probe ends
+static inline uint32_t vh_growth(uint32_t slots)
+{
+    return slots - slots / 8;
+}
+
+static inline uint64_t vh_mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= UINT64_C(0xFF51AFD7ED558CCD);
+    x ^= x >> 33;
+    x *= UINT64_C(0xC4CEB9FE1A85EC53);
+    x ^= x >> 33;
+
+    return x;
+}
+
+// Hash a key 8 bytes at a time; the result only has to match on this machine
+static inline uint64_t vh_hash(const DVHash *hash, const void *key)
+{
+    const unsigned char *bytes = key;
+    uint32_t size = hash->key_size;
+    uint64_t h = hash->seed ^ ((uint64_t)size * VH_SEED);
+    uint64_t word = 0;
+
+    for(; size >= 8; size -= 8, bytes += 8) {
+        memcpy(&word, bytes, 8);
+        h = vh_mix(h ^ word);
+    }
+    if(size > 0) {
+        word = 0;
+        memcpy(&word, bytes, size);
+        h = vh_mix(h ^ word);
+    }
+
+    return h;
+}
+
+static inline uint8_t vh_h2(uint64_t h)
+{
+    return (uint8_t)(h & 0x7F);
+}
+
+/*
+ * Group matching: each returns a mask with bit i set if control byte i of the group matches
+ */
+
+#ifdef VH_SIMD_X86
+
+static inline uint32_t vh_match(const uint8_t *group, uint8_t h2)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)(const void *)group);
+
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+}
+
+static inline uint32_t vh_match_empty(const uint8_t *group)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)(const void *)group);
+
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)VH_EMPTY)));
+}
+
+// Empty or deleted: the only control bytes with the top bit set
+static inline uint32_t vh_match_free(const uint8_t *group)
+{
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(const void *)group));
+}
+
+#else
+
+static inline uint32_t vh_match(const uint8_t *group, uint8_t h2)
+{
+    uint32_t mask = 0;
+    for(uint32_t i = 0; i < DVHASH_GROUP; i++) {
+        mask |= (uint32_t)(group[i] == h2) << i;
+    }
+
+    return mask;
+}
+
+static inline uint32_t vh_match_empty(const uint8_t *group)
+{
+    return vh_match(group, VH_EMPTY);
+}
+
+static inline uint32_t vh_match_free(const uint8_t *group)
+{
+    uint32_t mask = 0;
+    for(uint32_t i = 0; i < DVHASH_GROUP; i++) {
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    }
+
+    return mask;
+}
+
+#endif
+
+static inline char *vh_entry(const DVHash *hash, uint32_t slot)
+{
+    return hash->entries + (size_t)slot * hash->entry_size;
+}
+
+// Set a control byte, and its copy after the last slot if it is in the first group
+static inline void vh_set_ctrl(DVHash *hash, uint32_t slot, uint8_t ctrl)
+{
+    hash->ctrl[slot] = ctrl;
+    if(slot < DVHASH_GROUP) {
+        hash->ctrl[hash->mask + 1 + slot] = ctrl;
+    }
+}
+
+// Elements of a store of entry_size bytes taken by the meta block and control bytes
+static inline uint64_t vh_ctrl_elems(uint32_t slots, uint32_t entry_size)
+{
+    uint64_t bytes = sizeof(DVHashMeta) + (uint64_t)slots + DVHASH_GROUP;
+
+    return (bytes + entry_size - 1) / entry_size;
+}
+
+// Point a table at the control bytes and entries of a store of slots
+static void vh_attach(DVHash *hash, DVArray *store, uint32_t slots)
+{
+    hash->store = store;
+    hash->ctrl = (uint8_t *)store->items + sizeof(DVHashMeta);
+    hash->entries = (char *)store->items + vh_ctrl_elems(slots, hash->entry_size) * hash->entry_size;
+    hash->mask = slots - 1;
+}
+
+// Slot of a key, or UINT32_MAX if it isn't in the table
+static uint32_t vh_find(const DVHash *hash, const void *key, uint64_t h)
+{
+    uint8_t h2 = vh_h2(h);
+    uint32_t pos = (uint32_t)(h >> 7) & hash->mask;
+
+    // Triangular steps of whole groups visit every group once the slots are a power of 2
+    for(uint32_t step = DVHASH_GROUP; ; step += DVHASH_GROUP) {
+        const uint8_t *group = hash->ctrl + pos;
+
+        for(uint32_t match = vh_match(group, h2); match != 0; match &= match - 1) {
+            uint32_t slot = (pos + (uint32_t)__builtin_ctz(match)) & hash->mask;
+            if(memcmp(vh_entry(hash, slot), key, hash->key_size) == 0) {
+                return slot;
+            }
+        }
+        if(vh_match_empty(group) != 0) {
+            return UINT32_MAX;
+        }
+
+        pos = (pos + step) & hash->mask;
+    }
+}
+
+// First empty or deleted slot on the probe sequence of a hash
+static uint32_t vh_find_free(const DVHash *hash, uint64_t h)
+{
+    uint32_t pos = (uint32_t)(h >> 7) & hash->mask;
+
+    for(uint32_t step = DVHASH_GROUP; ; step += DVHASH_GROUP) {
+        uint32_t match = vh_match_free(hash->ctrl + pos);
+        if(match != 0) {
+            return (pos + (uint32_t)__builtin_ctz(match)) & hash->mask;
+        }
+
+        pos = (pos + step) & hash->mask;
+    }
+}
+
+// Create an empty store of slots for a table, with its meta block filled in
+static DVArray *vh_store(DVHash *hash, uint32_t value_size, uint32_t slots, int *res)
+{
+    uint64_t elems = vh_ctrl_elems(slots, hash->entry_size) + slots;
+    if(elems > UINT32_MAX) {
+        *res = DA_ERR_ARGS | VH_INIT_CAPACITY;
+        return NULL;
+    }
+
+    DVArray *store = DVArray_init_with_allocator(hash->entry_size, (uint32_t)elems, 0, 1.5, 0, hash->allocator, res);
+    if(store == NULL) {
+        return NULL;
+    }
+
+    // The table manages the whole store itself, so all of it counts as values
+    store->length = (uint32_t)elems;
+
+    DVHashMeta *meta = store->items;
+    memcpy(meta->magic, DVHASH_MAGIC, sizeof(DVHASH_MAGIC));
+    meta->key_size = hash->key_size;
+    meta->value_size = value_size;
+    meta->slots = slots;
+    meta->seed = hash->seed;
+    memset((char *)store->items + sizeof(DVHashMeta), VH_EMPTY, (size_t)slots + DVHASH_GROUP);
+
+    return store;
+}
+
+// Move every entry into a new store of slots
+static int vh_rehash(DVHash *hash, uint32_t slots)
+{
+    int rc = 0;
+    DVArray *store = vh_store(hash, hash->entry_size - hash->key_size, slots, &rc);
+    if(store == NULL) {
+        return rc;
+    }
+
+    DVArray *old_store = hash->store;
+    uint8_t *old_ctrl = hash->ctrl;
+    char *old_entries = hash->entries;
+    uint32_t old_slots = hash->mask + 1;
+
+    vh_attach(hash, store, slots);
+    for(uint32_t i = 0; i < old_slots; i++) {
+        if(old_ctrl[i] & 0x80) {
+            continue;
+        }
+
+        char *entry = old_entries + (size_t)i * hash->entry_size;
+        uint64_t h = vh_hash(hash, entry);
+        uint32_t slot = vh_find_free(hash, h);
+        vh_set_ctrl(hash, slot, vh_h2(h));
+        memcpy(vh_entry(hash, slot), entry, hash->entry_size);
+    }
+    hash->growth_left = vh_growth(slots) - hash->count;
+
+    DVArray_destroy(old_store);
+
+    return 0;
+}
+
+DVHash *DVHash_init(uint32_t key_size, uint32_t value_size, uint32_t capacity, Allocator *allocator, int *res)
+{
+    DVHash *hash = NULL;
+    int err = 0;
+
+    check_err(key_size > 0 && value_size <= UINT32_MAX - key_size, err, DA_ERR_ARGS | VH_INIT_KEY_SIZE, "Invalid key_size: %u", key_size);
+    check_err(capacity <= vh_growth(VH_MAX_SLOTS), err, DA_ERR_ARGS | VH_INIT_CAPACITY, "Invalid capacity: %u", capacity);
+
+    uint32_t slots = VH_MIN_SLOTS;
+    while(vh_growth(slots) < capacity) {
+        slots <<= 1;
+    }
+
+    hash = Allocator_alloc(allocator, sizeof(DVHash));
+    check_err(hash != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    hash->key_size = key_size;
+    hash->entry_size = key_size + value_size;
+    hash->count = 0;
+    hash->growth_left = vh_growth(slots);
+    hash->seed = VH_SEED;
+    hash->allocator = allocator;
+
+    int rc = 0;
+    DVArray *store = vh_store(hash, value_size, slots, &rc);
+    check_err(store != NULL, err, rc, "Failed to create DVHash store");
+    vh_attach(hash, store, slots);
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return hash;
+
+error:
+    Allocator_free(allocator, hash, sizeof(DVHash));
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void DVHash_destroy(DVHash *hash)
+{
+    if(hash == NULL) {
+        return;
+    }
+
+    DVArray_destroy(hash->store);
+    Allocator_free(hash->allocator, hash, sizeof(DVHash));
+}
+
+void *DVHash_get(DVHash *hash, const void *key)
+{
+    if(hash == NULL || key == NULL) {
+        return NULL;
+    }
+
+    uint32_t slot = vh_find(hash, key, vh_hash(hash, key));
+
+    return slot != UINT32_MAX ? vh_entry(hash, slot) + hash->key_size : NULL;
+}
+
+int DVHash_put(DVHash *hash, const void *key, const void *value)
+{
+    int err = 0;
+
+    check_err(hash != NULL && key != NULL && (value != NULL || hash->entry_size == hash->key_size), err, DA_ERR_ARGS, "NULL hash, key or value");
+
+    uint64_t h = vh_hash(hash, key);
+    uint32_t slot = vh_find(hash, key, h);
+
+    if(slot == UINT32_MAX) {
+        slot = vh_find_free(hash, h);
+
+        // Reusing a deleted slot keeps as many empty ones; filling an empty one needs room
+        if(hash->ctrl[slot] == VH_EMPTY && hash->growth_left == 0) {
+            // Rehash in place if deleted slots are what filled the table, otherwise grow it
+            uint32_t slots = hash->mask + 1;
+            if(hash->count >= slots / 2) {
+                check_err(slots < VH_MAX_SLOTS, err, DA_ERR_MEMORY | VH_PUT_REHASH, "DVHash at maximum size");
+                slots <<= 1;
+            }
+
+            int rc = vh_rehash(hash, slots);
+            check_err(rc == 0, err, da_chain(VH_PUT_REHASH, rc), "Failed to rehash DVHash");
+            slot = vh_find_free(hash, h);
+        }
+
+        if(hash->ctrl[slot] == VH_EMPTY) {
+            hash->growth_left--;
+        }
+        vh_set_ctrl(hash, slot, vh_h2(h));
+        memcpy(vh_entry(hash, slot), key, hash->key_size);
+        hash->count++;
+    }
+
+    if(hash->entry_size > hash->key_size) {
+        memcpy(vh_entry(hash, slot) + hash->key_size, value, hash->entry_size - hash->key_size);
+    }
+
+    return 0;
+
+error:
+    return err;
+}
+
+int DVHash_remove(DVHash *hash, const void *key, void *value)
+{
+    if(hash == NULL || key == NULL) {
+        return DA_ERR_ARGS;
+    }
+
+    uint32_t slot = vh_find(hash, key, vh_hash(hash, key));
+    if(slot == UINT32_MAX) {
+        return DA_ERR_ARGS | VH_REMOVE_MISSING;
+    }
+
+    if(value != NULL) {
+        memcpy(value, vh_entry(hash, slot) + hash->key_size, hash->entry_size - hash->key_size);
+    }
+
+    // If the full slots around this one are fewer than a group, no probe can have passed over
+    // it without also seeing an empty slot, so it may be emptied rather than marked deleted
+    uint32_t after = vh_match_empty(hash->ctrl + slot);
+    uint32_t before = vh_match_empty(hash->ctrl + ((slot - DVHASH_GROUP) & hash->mask));
+    if(after != 0 && before != 0 &&
+            (uint32_t)__builtin_ctz(after) + (uint32_t)__builtin_clz(before) - (32 - DVHASH_GROUP) < DVHASH_GROUP) {
+        vh_set_ctrl(hash, slot, VH_EMPTY);
+        hash->growth_left++;
+    } else {
+        vh_set_ctrl(hash, slot, VH_DELETED);
+    }
+    hash->count--;
+
+    return 0;
+}
+
+int DVHash_next(const DVHash *hash, uint32_t *slot, void **key, void **value)
+{
+    if(hash == NULL || slot == NULL) {
+        return 0;
+    }
+
+    for(uint32_t i = *slot; i <= hash->mask; i++) {
+        if(hash->ctrl[i] & 0x80) {
+            continue;
+        }
+
+        char *entry = vh_entry(hash, i);
+        if(key != NULL) {
+            *key = entry;
+        }
+        if(value != NULL) {
+            *value = entry + hash->key_size;
+        }
+        *slot = i + 1;
+
+        return 1;
+    }
+
+    *slot = hash->mask + 1;
+    return 0;
+}
+
+int DVHash_save(DVHash *hash, const char *path)
+{
+    if(hash == NULL) {
+        return DA_ERR_ARGS;
+    }
+
+    // A read-only table can't have changed, so only write the meta block when it is stale
+    DVHashMeta *meta = hash->store->items;
+    if(meta->count != hash->count || meta->growth_left != hash->growth_left) {
+        meta->count = hash->count;
+        meta->growth_left = hash->growth_left;
+    }
+
+    return DVArray_save(hash->store, path);
+}
+
+// Check a meta block describes the store it heads
+static int vh_valid(const DVHashMeta *meta, const DVArray *store)
+{
+    if(store->start_index != 0 || (uint64_t)store->length * store->elem_size < sizeof(DVHashMeta)) {
+        return 0;
+    }
+    if(memcmp(meta->magic, DVHASH_MAGIC, sizeof(DVHASH_MAGIC)) != 0 || meta->key_size == 0 ||
+            (uint64_t)meta->key_size + meta->value_size != store->elem_size) {
+        return 0;
+    }
+
+    uint32_t slots = meta->slots;
+    return slots >= VH_MIN_SLOTS && slots <= VH_MAX_SLOTS && (slots & (slots - 1)) == 0 &&
+        vh_ctrl_elems(slots, store->elem_size) + slots == store->length &&
+        meta->count <= vh_growth(slots) && meta->growth_left <= vh_growth(slots) - meta->count;
+}
+
+DVHash *DVHash_open(const char *path, int mode, int *res)
+{
+    DVArray *store = NULL;
+    DVHash *hash = NULL;
+    int err = 0;
+
+    int rc = 0;
+    store = DVArray_open(path, mode, &rc);
+    check_err(store != NULL, err, rc, "Failed to open DVHash %s", path);
+
+    DVHashMeta *meta = store->items;
+    check_err(vh_valid(meta, store), err, DA_ERR_DATA | DV_FILE_FORMAT, "%s is not a valid DVHash file", path);
+
+    hash = malloc(sizeof(DVHash));
+    check_err(hash != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    hash->key_size = meta->key_size;
+    hash->entry_size = store->elem_size;
+    hash->count = meta->count;
+    hash->growth_left = meta->growth_left;
+    hash->seed = meta->seed;
+    hash->allocator = NULL;
+    vh_attach(hash, store, meta->slots);
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return hash;
+
+error:
+    DVArray_destroy(store);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
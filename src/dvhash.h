@@ -0,0 +1,208 @@
+/**
+ * @file dvhash.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for DVHash implementation
+ *
+ */
+
+#ifndef DVHash_h
+#define DVHash_h
+
+#include "dvarray.h"
+#include "dvarray_file.h"
+#include "stdint.h"
+
+/**
+ * @brief Number of control bytes compared at once by a probe
+ */
+#define DVHASH_GROUP 16
+
+/**
+ * @brief Identifies the store of a saved DVHash
+ */
+#define DVHASH_MAGIC "DVHASH1"
+
+/**
+ * @brief Open-addressing hash table of inline keys and values
+ *
+ * Laid out as a SwissTable: every slot has a control byte which is empty, deleted, or holds 7
+ * bits of the hash of the slot's key. A lookup loads the `DVHASH_GROUP` control bytes at its
+ * probe position and compares them with the hash all at once, with SSE2 where available, then
+ * compares keys only in the slots which match. A hit usually reads one cache line of control
+ * bytes and one of entries. Groups are probed quadratically, and the table is rehashed into
+ * twice the slots once 7/8 of them are used.
+ *
+ * The table's storage is a single DVArray: a `DVHashMeta` block, then the control bytes, then
+ * the entries, each a key followed by its value. It is allocated through the table's allocator,
+ * and saved and opened in the DVArray file format, so `DVHash_open` maps a file in `O(1)`.
+ * Keys are compared bytewise, so must not contain padding. Pointers into the table are aligned
+ * only as far as the entry size allows, as for DVArray values.
+ * @see DVArray
+ * @see dvarray_file.h
+ */
+typedef struct DVHash {
+    uint8_t *ctrl;          ///< Control byte of each slot, followed by a copy of the first group
+    char *entries;          ///< Entries, `entry_size` bytes each
+    uint32_t mask;          ///< Number of slots - 1; the number of slots is a power of 2
+    uint32_t key_size;      ///< Size of each key in bytes
+    uint32_t entry_size;    ///< Size of each entry in bytes: the key, then the value
+    uint32_t count;         ///< Number of entries in the table
+    uint32_t growth_left;   ///< Empty slots which may be filled before the table is rehashed
+    uint64_t seed;          ///< Seed of the hash function
+    DVArray *store;         ///< Backing store of the meta block, control bytes and entries
+    Allocator *allocator;   ///< Allocator for the table and its store; `NULL` for `malloc`
+} DVHash;
+
+/**
+ * @brief Meta block at the start of a DVHash store
+ *
+ * Brought up to date by `DVHash_save`, and checked by `DVHash_open`.
+ */
+typedef struct DVHashMeta {
+    char magic[8];          ///< `DVHASH_MAGIC`, NUL-terminated
+    uint32_t key_size;      ///< Size of each key in bytes
+    uint32_t value_size;    ///< Size of each value in bytes
+    uint32_t slots;         ///< Number of slots
+    uint32_t count;         ///< Number of entries
+    uint32_t growth_left;   ///< Empty slots which may be filled before the table is rehashed
+    uint32_t reserved0;     ///< Zero
+    uint64_t seed;          ///< Seed of the hash function
+    uint8_t reserved[24];   ///< Zero
+} DVHashMeta;
+
+/**
+ * @brief Initialise a DVHash
+ *
+ * @see dvhash_err_init for errors
+ *
+ * @param key_size Size of each key in bytes; must be greater than 0
+ * @param value_size Size of each value in bytes; may be 0 for a set
+ * @param capacity Number of entries to make room for before the first rehash; 0 for the minimum
+ * @param allocator Allocator to use; `NULL` for `malloc`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DVHash on success, otherwise `NULL`
+ */
+DVHash *DVHash_init(uint32_t key_size, uint32_t value_size, uint32_t capacity, Allocator *allocator, int *res);
+
+/**
+ * @brief DVHash_init errors
+ * @see DVHash_init
+ */
+enum dvhash_err_init {
+    VH_INIT_KEY_SIZE    = 0x10, ///< Invalid key_size: 0, or the entry is too large
+    VH_INIT_CAPACITY    = 0x20  ///< Invalid capacity: more slots than can be stored
+};
+
+/**
+ * @brief Destroy a DVHash and free its memory
+ *
+ * @param hash DVHash to free
+ */
+void DVHash_destroy(DVHash *hash);
+
+/**
+ * @brief Look up the value of a key
+ *
+ * Performance: `O(1)` expected
+ *
+ * @param hash DVHash to search
+ * @param key Key to find; `key_size` bytes
+ *
+ * @return Pointer to the key's value in the table, or `NULL` if it is not in the table. The
+ * pointer is invalidated by any call which adds or removes entries
+ */
+void *DVHash_get(DVHash *hash, const void *key);
+
+/**
+ * @brief Add a key and value to a dvhash, or replace the value of a key already in it
+ *
+ * Performance: `O(1)` expected; `O(n)` when the table is rehashed
+ * @see dvhash_err_put for errors
+ *
+ * @param hash DVHash to add to
+ * @param key Key to add; `key_size` bytes
+ * @param value Value to copy in; `value_size` bytes, and may be `NULL` only if that is 0
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVHash_put(DVHash *hash, const void *key, const void *value);
+
+/**
+ * @brief DVHash_put errors
+ * @see DVHash_put
+ */
+enum dvhash_err_put {
+    VH_PUT_REHASH       = 0x10  ///< Failed to rehash a full table, see secondary detail for error
+};
+
+/**
+ * @brief Remove a key from a dvhash
+ *
+ * Performance: `O(1)` expected
+ *
+ * @param hash DVHash to remove from
+ * @param key Key to remove; `key_size` bytes
+ * @param [out] value Destination for the key's value; `value_size` bytes, or `NULL` to discard it
+ *
+ * @return Result; 0 on success, `DA_ERR_ARGS | VH_REMOVE_MISSING` if the key is not in the table,
+ * otherwise `DA_ERR_ARGS`
+ */
+int DVHash_remove(DVHash *hash, const void *key, void *value);
+
+/**
+ * @brief DVHash_remove errors
+ * @see DVHash_remove
+ */
+enum dvhash_err_remove {
+    VH_REMOVE_MISSING   = 0x10  ///< Key not in the table
+};
+
+/**
+ * @brief Step through the entries of a dvhash, in slot order
+ *
+ * Start with `*slot` at 0. Entries must not be added or removed while the table is walked.
+ *
+ * @param hash DVHash to walk
+ * @param [in,out] slot Slot to search from; set past the entry found
+ * @param [out] key Key of the entry found; may be `NULL`
+ * @param [out] value Value of the entry found; may be `NULL`
+ *
+ * @return 1 if an entry was found, otherwise 0
+ */
+int DVHash_next(const DVHash *hash, uint32_t *slot, void **key, void **value);
+
+/**
+ * @brief Save a dvhash to a file
+ *
+ * The store is saved with `DVArray_save`, with the same atomic replacement of `path`.
+ * Performance: `O(slots)`
+ *
+ * @see dvarray_err_file for errors
+ *
+ * @param hash DVHash to save
+ * @param path File to write
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int DVHash_save(DVHash *hash, const char *path);
+
+/**
+ * @brief Open a file saved by `DVHash_save` as a dvhash
+ *
+ * The file is opened with `DVArray_open`, so the table is read straight from the mapping in the
+ * same modes. A table opened with `DV_OPEN_READ` may only be looked up, walked, saved and
+ * destroyed. With `DV_OPEN_COPY` it may be used as any other; a rehash moves it to the heap.
+ *
+ * @see dvarray_err_file for errors
+ *
+ * @param path File to open
+ * @param mode A `dvarray_open_mode`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New DVHash on success, otherwise `NULL`. Free with `DVHash_destroy`
+ */
+DVHash *DVHash_open(const char *path, int mode, int *res);
+
+#endif
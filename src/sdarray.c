@@ -0,0 +1,448 @@
+#include "sdarray.h"
+#include "dbg.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A chunk; the directory and callers only ever see its slots
+typedef struct SDChunk {
+    _Atomic uint32_t refs;  // Directories holding the chunk
+    void *slots[];
+} SDChunk;
+
+static inline SDChunk *sd_header(void **chunk)
+{
+    return (SDChunk *)(void *)((char *)chunk - offsetof(SDChunk, slots));
+}
+
+// Chunk holding the slot at a position counted from the start of the first chunk
+static inline void **sd_chunk(const SDArray *sdarray, uint64_t pos)
+{
+    return sdarray->chunks->items[sdarray->chunks->start_index + (pos >> sdarray->chunk_shift)];
+}
+
+// Take the spare chunk, or allocate a new one, held by one directory
+static void **sd_chunk_alloc(SDArray *sdarray)
+{
+    SDChunk *chunk = NULL;
+
+    if(sdarray->spare != NULL) {
+        chunk = sd_header(sdarray->spare);
+        sdarray->spare = NULL;
+    } else {
+        chunk = malloc(sizeof(SDChunk) + ((size_t)sdarray->chunk_mask + 1) * sizeof(void *));
+        if(chunk == NULL) {
+            return NULL;
+        }
+    }
+
+    atomic_init(&chunk->refs, 1);
+    return chunk->slots;
+}
+
+static void sd_chunk_free(void **chunk)
+{
+    if(chunk != NULL) {
+        free(sd_header(chunk));
+    }
+}
+
+// Drop a directory's hold on a chunk; once no directory holds it, keep it as the spare, or
+// free it if there already is one
+static void sd_chunk_release(SDArray *sdarray, void **chunk)
+{
+    if(atomic_fetch_sub_explicit(&sd_header(chunk)->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if(sdarray->spare == NULL) {
+        sdarray->spare = chunk;
+    } else {
+        sd_chunk_free(chunk);
+    }
+}
+
+// Drop a version's hold on a directory, releasing its chunks if it was the last
+static void sd_directory_release(DArray *chunks, _Atomic uint32_t *shares)
+{
+    if(shares != NULL && atomic_fetch_sub_explicit(shares, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    for(DArraySize i = 0; i < chunks->length; i++) {
+        void **chunk = DArray_index(chunks, i);
+        if(atomic_fetch_sub_explicit(&sd_header(chunk)->refs, 1, memory_order_acq_rel) == 1) {
+            sd_chunk_free(chunk);
+        }
+    }
+
+    DArray_destroy(chunks);
+    free(shares);
+}
+
+// Give a version its own copy of a shared directory, holding the same chunks
+static int sd_copy_directory(SDArray *sdarray)
+{
+    DArray *old = sdarray->chunks;
+    _Atomic uint32_t *old_shares = sdarray->shares;
+    DArray *chunks = NULL;
+    int err = 0;
+
+    _Atomic uint32_t *shares = malloc(sizeof(*shares));
+    check_err(shares != NULL, err, DA_ERR_MEMORY | SD_GROW_COPY, "Out of memory.");
+
+    chunks = DArray_init_with_pool(old->length + 8, 0.5, 2.0, 4, NULL);
+    check_err(chunks != NULL, err, DA_ERR_MEMORY | SD_GROW_COPY, "Failed to copy SDArray directory");
+    check_err(DArray_push_n(chunks, old->items + old->start_index, old->length) == 0, err,
+            DA_ERR_MEMORY | SD_GROW_COPY, "Failed to copy SDArray directory");
+
+    // The old directory keeps every chunk alive, so the counts can't reach 0 meanwhile
+    for(DArraySize i = 0; i < chunks->length; i++) {
+        atomic_fetch_add_explicit(&sd_header(DArray_index(chunks, i))->refs, 1, memory_order_relaxed);
+    }
+
+    atomic_init(shares, 1);
+    sdarray->chunks = chunks;
+    sdarray->shares = shares;
+    sd_directory_release(old, old_shares);
+
+    return 0;
+
+error:
+    DArray_destroy(chunks);
+    free(shares);
+    return err;
+}
+
+// Make sure a version's directory is its own before it is changed
+static inline int sd_own_directory(SDArray *sdarray)
+{
+    if(sdarray->shares == NULL || atomic_load_explicit(sdarray->shares, memory_order_acquire) == 1) {
+        return 0;
+    }
+
+    return sd_copy_directory(sdarray);
+}
+
+// Chunk holding a position, copying it and the directory first if they are shared
+static void **sd_chunk_copy(SDArray *sdarray, uint64_t pos)
+{
+    if(sd_own_directory(sdarray) != 0) {
+        return NULL;
+    }
+
+    void ***entry = (void ***)(sdarray->chunks->items + sdarray->chunks->start_index) + (pos >> sdarray->chunk_shift);
+    void **chunk = *entry;
+    if(atomic_load_explicit(&sd_header(chunk)->refs, memory_order_acquire) == 1) {
+        return chunk;
+    }
+
+    void **copy = sd_chunk_alloc(sdarray);
+    if(copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, chunk, ((size_t)sdarray->chunk_mask + 1) * sizeof(void *));
+    *entry = copy;
+    sd_chunk_release(sdarray, chunk);
+
+    return copy;
+}
+
+// Chunk holding a position, which may be written; NULL if a shared chunk couldn't be copied
+static inline void **sd_chunk_writable(SDArray *sdarray, uint64_t pos)
+{
+    return sdarray->shares == NULL ? sd_chunk(sdarray, pos) : sd_chunk_copy(sdarray, pos);
+}
+
+SDArray *SDArray_init(uint32_t chunk_size, int *res)
+{
+    SDArray *sdarray = NULL;
+    int err = 0;
+
+    chunk_size = chunk_size > 0 ? chunk_size : SDARRAY_CHUNK_SIZE;
+    check_err((chunk_size & (chunk_size - 1)) == 0, err, DA_ERR_ARGS | SD_INIT_CHUNK_SIZE, "Invalid chunk_size: %u", chunk_size);
+
+    sdarray = malloc(sizeof(SDArray));
+    check_err(sdarray != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    // A pool in the directory makes adding chunks at the front O(1)
+    int rc = 0;
+    sdarray->chunks = DArray_init_with_pool(8, 0.5, 2.0, 4, &rc);
+    check_err(sdarray->chunks != NULL, err, rc, "Failed to create SDArray directory");
+
+    uint32_t shift = 0;
+    while((UINT32_C(1) << shift) < chunk_size) {
+        shift++;
+    }
+
+    sdarray->length = 0;
+    sdarray->chunk_shift = shift;
+    sdarray->chunk_mask = chunk_size - 1;
+    sdarray->offset = 0;
+    sdarray->spare = NULL;
+    sdarray->shares = NULL;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return sdarray;
+
+error:
+    free(sdarray);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void SDArray_destroy(SDArray *sdarray)
+{
+    if(sdarray == NULL) {
+        return;
+    }
+
+    sd_directory_release(sdarray->chunks, sdarray->shares);
+    sd_chunk_free(sdarray->spare);
+    free(sdarray);
+}
+
+SDArray *SDArray_snapshot(SDArray *sdarray, int *res)
+{
+    SDArray *snapshot = NULL;
+    int err = 0;
+
+    check_err(sdarray != NULL, err, DA_ERR_ARGS, "NULL sdarray");
+
+    snapshot = malloc(sizeof(SDArray));
+    check_err(snapshot != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    if(sdarray->shares == NULL) {
+        sdarray->shares = malloc(sizeof(*sdarray->shares));
+        check_err(sdarray->shares != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+        atomic_init(sdarray->shares, 1);
+    }
+    atomic_fetch_add_explicit(sdarray->shares, 1, memory_order_relaxed);
+
+    *snapshot = *sdarray;
+    snapshot->spare = NULL;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return snapshot;
+
+error:
+    free(snapshot);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void **SDArray_slot(SDArray *sdarray, uint32_t index)
+{
+    if(sdarray == NULL || index >= sdarray->length) {
+        return NULL;
+    }
+
+    uint64_t pos = (uint64_t)sdarray->offset + index;
+    void **chunk = sd_chunk_writable(sdarray, pos);
+
+    return chunk != NULL ? chunk + (pos & sdarray->chunk_mask) : NULL;
+}
+
+void *SDArray_index(SDArray *sdarray, uint32_t index)
+{
+    if(sdarray == NULL || index >= sdarray->length) {
+        return NULL;
+    }
+
+    uint64_t pos = (uint64_t)sdarray->offset + index;
+
+    return sd_chunk(sdarray, pos)[pos & sdarray->chunk_mask];
+}
+
+int SDArray_visit_chunks(SDArray *sdarray, uint32_t chunk_size, DArray_visit visit, void *ctx)
+{
+    if(sdarray == NULL || visit == NULL) {
+        return DA_ERR_ARGS;
+    }
+
+    uint32_t slots = sdarray->chunk_mask + 1;
+    uint32_t step = chunk_size > 0 && chunk_size < slots ? chunk_size : slots;
+    void ***chunk = (void ***)(sdarray->chunks->items + sdarray->chunks->start_index);
+    uint32_t index = 0;
+
+    // Runs never cross a chunk, so split at chunk boundaries as well as every step values
+    while(index < sdarray->length) {
+        uint64_t pos = (uint64_t)sdarray->offset + index;
+        uint32_t slot = (uint32_t)(pos & sdarray->chunk_mask);
+        uint32_t count = slots - slot < step ? slots - slot : step;
+        count = count < sdarray->length - index ? count : sdarray->length - index;
+
+        void **values = chunk[pos >> sdarray->chunk_shift] + slot;
+        if(index + count < sdarray->length) {
+            uint64_t next = pos + count;
+            __builtin_prefetch(chunk[next >> sdarray->chunk_shift] + (next & sdarray->chunk_mask));
+        }
+
+        int rc = visit(values, count, index, ctx);
+        if(rc != 0) {
+            return rc;
+        }
+        index += count;
+    }
+
+    return 0;
+}
+
+int SDArray_set(SDArray *sdarray, uint32_t index, void *value)
+{
+    if(sdarray == NULL || index >= sdarray->length) {
+        return DA_ERR_ARGS;
+    }
+
+    uint64_t pos = (uint64_t)sdarray->offset + index;
+    void **chunk = sd_chunk_writable(sdarray, pos);
+    if(chunk == NULL) {
+        return DA_ERR_MEMORY | SD_GROW_COPY;
+    }
+
+    chunk[pos & sdarray->chunk_mask] = value;
+
+    return 0;
+}
+
+// Release every chunk once the array is empty, so the next value starts a fresh chunk
+static void sd_clear(SDArray *sdarray)
+{
+    for(void **chunk = DArray_pop(sdarray->chunks); chunk != NULL; chunk = DArray_pop(sdarray->chunks)) {
+        sd_chunk_release(sdarray, chunk);
+    }
+
+    sdarray->offset = 0;
+}
+
+int SDArray_push(SDArray *sdarray, void *value)
+{
+    int err = 0;
+
+    check_err(sdarray != NULL, err, DA_ERR_ARGS, "NULL sdarray");
+    check_err(sdarray->length < UINT32_MAX, err, DA_ERR_MEMORY | SD_GROW_LIMIT, "SDArray at maximum length");
+
+    uint64_t pos = (uint64_t)sdarray->offset + sdarray->length;
+    if((pos >> sdarray->chunk_shift) == sdarray->chunks->length) {
+        err = sd_own_directory(sdarray);
+        check(err == 0, "Failed to add chunk to SDArray");
+
+        void **chunk = sd_chunk_alloc(sdarray);
+        check_err(chunk != NULL, err, DA_ERR_MEMORY | SD_GROW_CHUNK, "Out of memory.");
+
+        int rc = DArray_push(sdarray->chunks, chunk);
+        if(rc != 0) {
+            sd_chunk_release(sdarray, chunk);
+        }
+        check_err(rc == 0, err, da_chain(SD_GROW_DIRECTORY, rc), "Failed to add chunk to SDArray");
+    }
+
+    void **chunk = sd_chunk_writable(sdarray, pos);
+    check_err(chunk != NULL, err, DA_ERR_MEMORY | SD_GROW_COPY, "Failed to copy SDArray chunk");
+
+    chunk[pos & sdarray->chunk_mask] = value;
+    sdarray->length++;
+
+    return 0;
+
+error:
+    return err;
+}
+
+void *SDArray_pop(SDArray *sdarray)
+{
+    if(sdarray == NULL || sdarray->length == 0) {
+        return NULL;
+    }
+
+    uint64_t pos = (uint64_t)sdarray->offset + sdarray->length - 1;
+    int emptied = sdarray->length == 1 || (pos & sdarray->chunk_mask) == 0;
+    if(emptied && sd_own_directory(sdarray) != 0) {
+        return NULL;
+    }
+
+    void *value = sd_chunk(sdarray, pos)[pos & sdarray->chunk_mask];
+    sdarray->length--;
+
+    if(sdarray->length == 0) {
+        sd_clear(sdarray);
+    } else if((pos & sdarray->chunk_mask) == 0) {
+        sd_chunk_release(sdarray, DArray_pop(sdarray->chunks));
+    }
+
+    return value;
+}
+
+int SDArray_unshift(SDArray *sdarray, void *value)
+{
+    int err = 0;
+
+    check_err(sdarray != NULL, err, DA_ERR_ARGS, "NULL sdarray");
+    check_err(sdarray->length < UINT32_MAX, err, DA_ERR_MEMORY | SD_GROW_LIMIT, "SDArray at maximum length");
+
+    if(sdarray->offset == 0) {
+        err = sd_own_directory(sdarray);
+        check(err == 0, "Failed to add chunk to SDArray");
+
+        void **chunk = sd_chunk_alloc(sdarray);
+        check_err(chunk != NULL, err, DA_ERR_MEMORY | SD_GROW_CHUNK, "Out of memory.");
+
+        int rc = DArray_unshift(sdarray->chunks, chunk);
+        if(rc != 0) {
+            sd_chunk_release(sdarray, chunk);
+        }
+        check_err(rc == 0, err, da_chain(SD_GROW_DIRECTORY, rc), "Failed to add chunk to SDArray");
+
+        sdarray->offset = sdarray->chunk_mask + 1;
+    }
+
+    void **chunk = sd_chunk_writable(sdarray, sdarray->offset - 1);
+    check_err(chunk != NULL, err, DA_ERR_MEMORY | SD_GROW_COPY, "Failed to copy SDArray chunk");
+
+    sdarray->offset--;
+    chunk[sdarray->offset] = value;
+    sdarray->length++;
+
+    return 0;
+
+error:
+    return err;
+}
+
+void *SDArray_shift(SDArray *sdarray)
+{
+    if(sdarray == NULL || sdarray->length == 0) {
+        return NULL;
+    }
+
+    int emptied = sdarray->length == 1 || sdarray->offset == sdarray->chunk_mask;
+    if(emptied && sd_own_directory(sdarray) != 0) {
+        return NULL;
+    }
+
+    void *value = sd_chunk(sdarray, sdarray->offset)[sdarray->offset];
+    sdarray->offset++;
+    sdarray->length--;
+
+    if(sdarray->length == 0) {
+        sd_clear(sdarray);
+    } else if(sdarray->offset > sdarray->chunk_mask) {
+        sd_chunk_release(sdarray, DArray_shift(sdarray->chunks, NULL));
+        sdarray->offset = 0;
+    }
+
+    return value;
+}
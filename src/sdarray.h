@@ -0,0 +1,299 @@
+/**
+ * @file sdarray.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for SDArray implementation
+ *
+ */
+
+#ifndef SDArray_h
+#define SDArray_h
+
+#include "darray.h"
+#include "stdint.h"
+
+#include <stdatomic.h>
+
+/**
+ * @brief Default number of slots in each chunk of an SDArray
+ */
+#ifndef SDARRAY_CHUNK_SIZE
+#define SDARRAY_CHUNK_SIZE 512
+#endif
+
+/**
+ * @brief Segmented dynamic array
+ *
+ * A DArray variant which stores its values in fixed-size chunks rather than one backing store.
+ * The chunks are held in order in a directory, which is itself a DArray with a pool, so adding
+ * a value at either end allocates at most one chunk and never copies existing values; only the
+ * directory of chunk pointers is ever moved or reallocated. Indexing stays `O(1)`, with a shift
+ * and a mask to find the chunk and slot.
+ *
+ * A slot keeps its address for as long as its value stays in the array, wherever values are
+ * added or removed, so pointers from `SDArray_slot` remain valid. The exception is a chunk
+ * shared with a snapshot, which is copied the first time it is written; see `SDArray_snapshot`.
+ * @see DArray
+ */
+typedef struct SDArray {
+    uint32_t length;        ///< Number of values in the array
+    uint32_t chunk_shift;   ///< log2 of the number of slots in each chunk
+    uint32_t chunk_mask;    ///< Number of slots in each chunk - 1
+    uint32_t offset;        ///< Slot of the first value in the first chunk
+    DArray *chunks;         ///< Directory of chunks, first to last
+    void **spare;           ///< Most recently emptied chunk, kept to avoid churn at a chunk boundary
+    _Atomic uint32_t *shares;   ///< Versions sharing `chunks`; `NULL` until the array is first snapshotted
+} SDArray;
+
+/**
+ * @brief Initialise an SDArray
+ *
+ * @see darray_err_init and sdarray_err_init for errors
+ *
+ * @param chunk_size Number of slots in each chunk; must be a power of 2, or 0 for
+ * `SDARRAY_CHUNK_SIZE`
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New SDArray on success, otherwise `NULL`
+ */
+SDArray *SDArray_init(uint32_t chunk_size, int *res);
+
+/**
+ * @brief SDArray_init errors, in addition to `darray_err_init`
+ * @see SDArray_init
+ */
+enum sdarray_err_init {
+    SD_INIT_CHUNK_SIZE  = 0x50  ///< Invalid chunk_size: not a power of 2
+};
+
+/**
+ * @brief Destroy an SDArray and free its memory
+ *
+ * @param sdarray SDArray to free
+ */
+void SDArray_destroy(SDArray *sdarray);
+
+/**
+ * @brief Take an `O(1)` copy-on-write snapshot of an sdarray
+ *
+ * The snapshot is a new SDArray holding the same values, which shares the directory and every
+ * chunk with `sdarray`. Either may then be read, written or snapshotted again independently and
+ * from different threads: the first write to a version whose directory is shared copies the
+ * directory, in `O(n / chunk size)`, and the first write to a shared chunk copies just that
+ * chunk. Shared chunks and directories are reference counted and freed once the last version
+ * holding them is destroyed. Taking a snapshot is itself a write to `sdarray`, so must not
+ * overlap other use of it.
+ *
+ * @param sdarray SDArray to snapshot
+ * @param [out] res Result; 0 on success, otherwise `DA_ERR_ARGS` or `DA_ERR_MEMORY`
+ *
+ * @return New SDArray on success, to be freed with `SDArray_destroy`, otherwise `NULL`
+ */
+SDArray *SDArray_snapshot(SDArray *sdarray, int *res);
+
+/**
+ * @brief Get the address of the slot holding the value at an index
+ *
+ * The address stays valid until the value is removed from the array, or until the array is
+ * next snapshotted. A chunk shared with a snapshot is copied first, so that the slot may be
+ * written.
+ *
+ * @param sdarray SDArray to index into
+ * @param index Index of slot to get
+ *
+ * @return Address of slot at given index, or `NULL` if it does not exist or its chunk could not
+ * be copied
+ */
+void **SDArray_slot(SDArray *sdarray, uint32_t index);
+
+/**
+ * @brief Get the value of an sdarray at an index
+ *
+ * Performance: `O(1)`
+ *
+ * @param sdarray SDArray to index into
+ * @param index Index of value to get
+ *
+ * @return Value at given index, or `NULL` if it does not exist
+ */
+void *SDArray_index(SDArray *sdarray, uint32_t index);
+
+/**
+ * @brief Iterator over the values of an SDArray
+ *
+ * Walks each chunk as a contiguous run, reading the directory once per chunk. The array must
+ * not have values added or removed while it is iterated.
+ * @see SDArray_iter
+ * @see SDArray_foreach
+ * @see DArrayIter
+ */
+typedef struct SDArrayIter {
+    void **next;            ///< Slot of the next value
+    void **end;             ///< End of the current chunk's values
+    void ***chunk;          ///< Directory entry of the next chunk
+    uint32_t remaining;     ///< Values in the chunks after the current one
+    uint32_t chunk_size;    ///< Number of slots in each chunk
+    uint32_t prefetch;      ///< Values ahead whose targets are prefetched; 0 for none
+} SDArrayIter;
+
+/**
+ * @brief Create an iterator over the values of an sdarray, first to last
+ *
+ * @param sdarray SDArray to iterate over
+ * @param prefetch How many values ahead to prefetch the memory each value points to; 0 for none
+ *
+ * @return Iterator positioned before the first value
+ */
+static inline SDArrayIter SDArray_iter(const SDArray *sdarray, uint32_t prefetch)
+{
+    uint32_t chunk_size = sdarray->chunk_mask + 1;
+    SDArrayIter iter = { NULL, NULL, NULL, 0, chunk_size, prefetch };
+
+    if(sdarray->length > 0) {
+        void ***chunk = (void ***)(sdarray->chunks->items + sdarray->chunks->start_index);
+        uint32_t first = chunk_size - sdarray->offset;
+        first = first < sdarray->length ? first : sdarray->length;
+
+        iter.next = chunk[0] + sdarray->offset;
+        iter.end = iter.next + first;
+        iter.chunk = chunk + 1;
+        iter.remaining = sdarray->length - first;
+    }
+
+    return iter;
+}
+
+/**
+ * @brief Advance an iterator
+ *
+ * @param iter Iterator from `SDArray_iter`
+ * @param [out] value Next value
+ *
+ * @return 1 if there was a next value, otherwise 0
+ */
+static inline int SDArray_iter_next(SDArrayIter *iter, void **value)
+{
+    if(iter->next == iter->end) {
+        if(iter->remaining == 0) {
+            return 0;
+        }
+
+        uint32_t count = iter->remaining < iter->chunk_size ? iter->remaining : iter->chunk_size;
+        iter->next = *iter->chunk++;
+        iter->end = iter->next + count;
+        iter->remaining -= count;
+    }
+
+    if(iter->prefetch > 0 && (uintptr_t)(iter->end - iter->next) > iter->prefetch) {
+        __builtin_prefetch(iter->next[iter->prefetch]);
+    }
+
+    *value = *iter->next++;
+    return 1;
+}
+
+/**
+ * @brief Loop over the values of an sdarray, first to last
+ *
+ * @see DArray_foreach
+ *
+ * @param sdarray SDArray to iterate over
+ * @param value Name of a `void *` variable set to each value in turn
+ */
+#define SDArray_foreach(sdarray, value) \
+    for(SDArrayIter sd_iter_##value = SDArray_iter((sdarray), 0); SDArray_iter_next(&sd_iter_##value, &(value));)
+
+/**
+ * @brief Hand the values of an sdarray to a callback as contiguous runs
+ *
+ * Each run lies within one chunk and is at most `chunk_size` values, and the runs cover the
+ * array in order. While one run is visited, the start of the next is prefetched. Values must
+ * not be added or removed during the visit.<br>
+ * Performance: `O(n / min(chunk_size, chunk size of the array))` calls
+ * @see DArray_visit_chunks
+ *
+ * @param sdarray SDArray to visit
+ * @param chunk_size Maximum values in each run; 0 for whole chunks
+ * @param visit Callback
+ * @param ctx Context passed to `visit`
+ *
+ * @return 0 once every value has been visited, the non-0 result of `visit` if it stopped, or
+ * `DA_ERR_ARGS` if `sdarray` or `visit` is `NULL`
+ */
+int SDArray_visit_chunks(SDArray *sdarray, uint32_t chunk_size, DArray_visit visit, void *ctx);
+
+/**
+ * @brief Replace the value of an sdarray at an index
+ *
+ * @param sdarray SDArray to modify
+ * @param index Index of value to replace
+ * @param value New value
+ *
+ * @return Result; 0 on success, `DA_ERR_ARGS` if there is no such index, or
+ * `DA_ERR_MEMORY | SD_GROW_COPY` if its chunk was shared and could not be copied
+ */
+int SDArray_set(SDArray *sdarray, uint32_t index, void *value);
+
+/**
+ * @brief Push a value onto the end of an sdarray
+ *
+ * Performance: `O(1)`; allocates a chunk when the last one is full
+ * @see sdarray_err_grow for errors
+ *
+ * @param sdarray Array to push value onto
+ * @param value Value to push
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int SDArray_push(SDArray *sdarray, void *value);
+
+/**
+ * @brief Pop a value from the end of an sdarray
+ *
+ * Performance: `O(1)`; frees a chunk when the last one is emptied
+ *
+ * @param sdarray Array to pop value from
+ *
+ * @return Value which was popped, or `NULL` if the array is empty or emptying a chunk needed
+ * a shared directory copied and that failed
+ */
+void *SDArray_pop(SDArray *sdarray);
+
+/**
+ * @brief Unshift a value onto the start of an sdarray
+ *
+ * Performance: `O(1)`; allocates a chunk when the first one is full
+ * @see sdarray_err_grow for errors
+ *
+ * @param sdarray Array to unshift value onto
+ * @param value Value to unshift
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int SDArray_unshift(SDArray *sdarray, void *value);
+
+/**
+ * @brief Shift a value from the start of an sdarray
+ *
+ * Performance: `O(1)`; frees a chunk when the first one is emptied
+ *
+ * @param sdarray Array to shift value from
+ *
+ * @return Value which was shifted, or `NULL` if the array is empty or emptying a chunk needed
+ * a shared directory copied and that failed
+ */
+void *SDArray_shift(SDArray *sdarray);
+
+/**
+ * @brief SDArray_push and SDArray_unshift errors
+ * @see SDArray_push
+ * @see SDArray_unshift
+ */
+enum sdarray_err_grow {
+    SD_GROW_CHUNK       = 0x10, ///< Failed to allocate a chunk
+    SD_GROW_DIRECTORY   = 0x20, ///< Error adding a chunk to the directory, see secondary detail for error
+    SD_GROW_LIMIT       = 0x30, ///< Array at maximum length
+    SD_GROW_COPY        = 0x40  ///< Failed to copy a chunk or directory shared with a snapshot
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "spsc_queue.h"
+#include "dbg.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+SPSCQueue *SPSCQueue_init(uint32_t capacity, int *res)
+{
+    SPSCQueue *queue = NULL;
+    int err = 0;
+
+    check_err(capacity > 0 && capacity <= (UINT32_C(1) << 31), err, DA_ERR_ARGS | SQ_INIT_CAPACITY, "Invalid capacity: %u", capacity);
+
+    uint32_t size = 1;
+    while(size < capacity) {
+        size <<= 1;
+    }
+
+    queue = aligned_alloc(SPSC_CACHE_LINE, sizeof(SPSCQueue));
+    check_err(queue != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    int rc = 0;
+    queue->store = DArray_init_with_pool(size, 0.0, 2.0, 0, &rc);
+    check_err(queue->store != NULL, err, rc, "Failed to create SPSCQueue store");
+
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cached_head = 0;
+    queue->cached_tail = 0;
+    queue->mask = size - 1;
+    queue->items = queue->store->items;
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return queue;
+
+error:
+    free(queue);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void SPSCQueue_destroy(SPSCQueue *queue)
+{
+    if(queue == NULL) {
+        return;
+    }
+
+    DArray_destroy(queue->store);
+    free(queue);
+}
+
+uint32_t SPSCQueue_length(SPSCQueue *queue)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    return tail - head;
+}
+
+// Free slots the producer can see, refreshing its view of head only when it needs more than that
+static inline uint32_t sq_free(SPSCQueue *queue, uint32_t tail, uint32_t wanted)
+{
+    uint32_t free_slots = SPSCQueue_capacity(queue) - (tail - queue->cached_head);
+
+    if(free_slots < wanted) {
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        free_slots = SPSCQueue_capacity(queue) - (tail - queue->cached_head);
+    }
+
+    return free_slots;
+}
+
+// Values the consumer can see, refreshing its view of tail only when it needs more than that
+static inline uint32_t sq_ready(SPSCQueue *queue, uint32_t head, uint32_t wanted)
+{
+    uint32_t ready = queue->cached_tail - head;
+
+    if(ready < wanted) {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        ready = queue->cached_tail - head;
+    }
+
+    return ready;
+}
+
+int SPSCQueue_try_push(SPSCQueue *queue, void *value)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    if(sq_free(queue, tail, 1) == 0) {
+        return DA_ERR_ARGS | SQ_FULL;
+    }
+
+    queue->items[tail & queue->mask] = value;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+
+    return 0;
+}
+
+int SPSCQueue_try_pop(SPSCQueue *queue, void **value)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    if(sq_ready(queue, head, 1) == 0) {
+        return DA_ERR_ARGS | SQ_EMPTY;
+    }
+
+    *value = queue->items[head & queue->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+
+    return 0;
+}
+
+uint32_t SPSCQueue_try_push_n(SPSCQueue *queue, void **values, uint32_t count)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint32_t free_slots = sq_free(queue, tail, count);
+    count = count < free_slots ? count : free_slots;
+
+    // The run may wrap around the end of the store
+    uint32_t slot = tail & queue->mask;
+    uint32_t first = SPSCQueue_capacity(queue) - slot;
+    first = first < count ? first : count;
+
+    memcpy(queue->items + slot, values, (size_t)first * sizeof(void *));
+    memcpy(queue->items, values + first, (size_t)(count - first) * sizeof(void *));
+    atomic_store_explicit(&queue->tail, tail + count, memory_order_release);
+
+    return count;
+}
+
+uint32_t SPSCQueue_try_pop_n(SPSCQueue *queue, void **values, uint32_t count)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint32_t ready = sq_ready(queue, head, count);
+    count = count < ready ? count : ready;
+
+    uint32_t slot = head & queue->mask;
+    uint32_t first = SPSCQueue_capacity(queue) - slot;
+    first = first < count ? first : count;
+
+    memcpy(values, queue->items + slot, (size_t)first * sizeof(void *));
+    memcpy(values + first, queue->items, (size_t)(count - first) * sizeof(void *));
+    atomic_store_explicit(&queue->head, head + count, memory_order_release);
+
+    return count;
+}
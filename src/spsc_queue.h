@@ -0,0 +1,168 @@
+/**
+ * @file spsc_queue.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for SPSCQueue implementation
+ *
+ */
+
+#ifndef SPSCQueue_h
+#define SPSCQueue_h
+
+#include "darray.h"
+#include "stdint.h"
+
+#include <stdatomic.h>
+
+/**
+ * @brief Size of a cache line, used to keep the producer's and consumer's indices apart
+ */
+#ifndef SPSC_CACHE_LINE
+#define SPSC_CACHE_LINE 64
+#endif
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer queue
+ *
+ * A fixed-capacity queue of pointers for handing values from one thread to another without a
+ * lock. The values are kept in the backing store of a DArray, which is used as a ring indexed by
+ * free-running `head` and `tail` counters; the capacity is rounded up to a power of 2 so a slot
+ * is found with a mask.
+ *
+ * `tail` is only written by the producer and `head` only by the consumer, each on its own cache
+ * line. A push writes its slot and then publishes it with a release store of `tail`, which the
+ * consumer reads with acquire ordering before reading the slot, and the same in reverse for pops.
+ * Each side also keeps a cached copy of the other side's index, so the shared cache line is only
+ * read when the queue appears full or empty.
+ *
+ * Exactly one thread may push and exactly one thread may pop at a time; all other functions must
+ * not run concurrently with either.
+ */
+typedef struct SPSCQueue {
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t head;    ///< Count of values popped; written by the consumer
+    uint32_t cached_tail;                               ///< Consumer's last view of `tail`
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t tail;    ///< Count of values pushed; written by the producer
+    uint32_t cached_head;                               ///< Producer's last view of `head`
+    _Alignas(SPSC_CACHE_LINE) uint32_t mask;            ///< Capacity - 1
+    void **items;                                       ///< Slots of the queue; the backing store of `store`
+    DArray *store;                                      ///< DArray owning the slots
+} SPSCQueue;
+
+/**
+ * @brief Initialise an SPSCQueue
+ *
+ * @see spsc_err_init for errors
+ *
+ * @param capacity Minimum number of values the queue can hold; rounded up to a power of 2, and
+ * must be between 1 and 2^31
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New SPSCQueue on success, otherwise `NULL`
+ */
+SPSCQueue *SPSCQueue_init(uint32_t capacity, int *res);
+
+/**
+ * @brief SPSCQueue_init errors
+ * @see SPSCQueue_init
+ */
+enum spsc_err_init {
+    SQ_INIT_CAPACITY    = 0x10  ///< Invalid capacity: 0 or greater than 2^31
+};
+
+/**
+ * @brief Destroy an SPSCQueue and free its memory
+ *
+ * Values still in the queue are not freed.
+ *
+ * @param queue SPSCQueue to free
+ */
+void SPSCQueue_destroy(SPSCQueue *queue);
+
+/**
+ * @brief Get the capacity of an SPSCQueue
+ *
+ * @param queue SPSCQueue
+ *
+ * @return Number of values the queue can hold
+ */
+static inline uint32_t SPSCQueue_capacity(const SPSCQueue *queue)
+{
+    return queue->mask + 1;
+}
+
+/**
+ * @brief Get the number of values in an SPSCQueue
+ *
+ * Exact when called from the producer or consumer with the other side idle; otherwise a snapshot
+ * which may already be out of date.
+ *
+ * @param queue SPSCQueue
+ *
+ * @return Number of values in the queue
+ */
+uint32_t SPSCQueue_length(SPSCQueue *queue);
+
+/**
+ * @brief Push a value onto an SPSCQueue without blocking
+ *
+ * Producer only. Performance: `O(1)`
+ *
+ * @param queue SPSCQueue to push onto
+ * @param value Value to push
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS | SQ_FULL`
+ */
+int SPSCQueue_try_push(SPSCQueue *queue, void *value);
+
+/**
+ * @brief Pop a value from an SPSCQueue without blocking
+ *
+ * Consumer only. Performance: `O(1)`
+ *
+ * @param queue SPSCQueue to pop from
+ * @param [out] value Destination for the value
+ *
+ * @return Result; 0 on success, otherwise `DA_ERR_ARGS | SQ_EMPTY`
+ */
+int SPSCQueue_try_pop(SPSCQueue *queue, void **value);
+
+/**
+ * @brief SPSCQueue_try_push and SPSCQueue_try_pop errors
+ * @see SPSCQueue_try_push
+ * @see SPSCQueue_try_pop
+ */
+enum spsc_err_transfer {
+    SQ_FULL     = 0x10, ///< Queue has no free slots
+    SQ_EMPTY    = 0x20  ///< Queue has no values
+};
+
+/**
+ * @brief Push as many of a run of values onto an SPSCQueue as fit, without blocking
+ *
+ * Producer only. The values are published together with one release store, so a batch costs
+ * about the same synchronisation as a single push.
+ * Performance: `O(n)`
+ *
+ * @param queue SPSCQueue to push onto
+ * @param values Values to push, in order
+ * @param count Number of values in `values`
+ *
+ * @return Number of values pushed, from the start of `values`
+ */
+uint32_t SPSCQueue_try_push_n(SPSCQueue *queue, void **values, uint32_t count);
+
+/**
+ * @brief Pop up to a given number of values from an SPSCQueue, without blocking
+ *
+ * Consumer only. The slots are released together with one release store.
+ * Performance: `O(n)`
+ *
+ * @param queue SPSCQueue to pop from
+ * @param [out] values Destination for the values, in queue order
+ * @param count Maximum number of values to pop
+ *
+ * @return Number of values popped
+ */
+uint32_t SPSCQueue_try_pop_n(SPSCQueue *queue, void **values, uint32_t count);
+
+#endif
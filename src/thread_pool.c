@@ -0,0 +1,307 @@
+#define _GNU_SOURCE
+
+#include "thread_pool.h"
+#include "dbg.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Worker running on the current thread, if any
+static _Thread_local TPWorker *tp_self = NULL;
+
+// Queue of the current thread in pool, or pool->threads if it is not one of its workers
+static inline uint32_t tp_self_index(const ThreadPool *pool)
+{
+    return (tp_self != NULL && tp_self->pool == pool) ? tp_self->index : pool->threads;
+}
+
+// Take a task from our own queue, or steal the oldest from another
+static int tp_take(ThreadPool *pool, uint32_t self, TPTask *task)
+{
+    int rc = -1;
+
+    if(self < pool->threads) {
+        TPWorker *worker = &pool->workers[self];
+        pthread_mutex_lock(&worker->lock);
+        rc = DVArray_pop(worker->tasks, task);
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    for(uint32_t i = 1; rc != 0 && i <= pool->threads; i++) {
+        TPWorker *victim = &pool->workers[(self + i) % pool->threads];
+        if(victim->index == self) {
+            continue;
+        }
+
+        pthread_mutex_lock(&victim->lock);
+        if(victim->tasks->length > 0) {
+            rc = DVArray_shift(victim->tasks, task);
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+
+    if(rc != 0) {
+        return 0;
+    }
+
+    atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_relaxed);
+    return 1;
+}
+
+static void tp_run(TPTask *task)
+{
+    task->fn(task->arg);
+
+    if(task->group != NULL) {
+        atomic_fetch_sub_explicit(&task->group->outstanding, 1, memory_order_release);
+    }
+}
+
+static void *tp_worker(void *arg)
+{
+    TPWorker *worker = arg;
+    ThreadPool *pool = worker->pool;
+    TPTask task;
+
+    tp_self = worker;
+
+    for(;;) {
+        if(tp_take(pool, worker->index, &task)) {
+            tp_run(&task);
+            continue;
+        }
+
+        // Announce ourselves before checking for work, so a submitter either sees us or we see it
+        pthread_mutex_lock(&pool->sleep_lock);
+        atomic_fetch_add(&pool->sleeping, 1);
+        while(atomic_load(&pool->pending) == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->wake, &pool->sleep_lock);
+        }
+        atomic_fetch_sub(&pool->sleeping, 1);
+
+        int done = pool->shutdown && atomic_load(&pool->pending) == 0;
+        pthread_mutex_unlock(&pool->sleep_lock);
+
+        if(done) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+// Stop and join the first started workers, then free every queue and the pool
+static void tp_free(ThreadPool *pool, uint32_t started)
+{
+    pthread_mutex_lock(&pool->sleep_lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->sleep_lock);
+
+    for(uint32_t i = 0; i < started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    for(uint32_t i = 0; i < pool->threads; i++) {
+        pthread_mutex_destroy(&pool->workers[i].lock);
+        DVArray_destroy(pool->workers[i].tasks);
+    }
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->sleep_lock);
+    free(pool->workers);
+    free(pool);
+}
+
+ThreadPool *ThreadPool_init(uint32_t threads, int *res)
+{
+    ThreadPool *pool = NULL;
+    int err = 0;
+
+    if(threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+
+    pool = malloc(sizeof(ThreadPool));
+    check_err(pool != NULL, err, DA_ERR_MEMORY, "Out of memory.");
+
+    pool->workers = aligned_alloc(TP_CACHE_LINE, (size_t)threads * sizeof(TPWorker));
+    if(pool->workers == NULL) {
+        free(pool);
+        pool = NULL;
+        err = DA_ERR_MEMORY;
+        sentinel("Out of memory.");
+    }
+
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->next, 0);
+    atomic_init(&pool->sleeping, 0);
+    pool->shutdown = 0;
+    pthread_mutex_init(&pool->sleep_lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    // Create every queue before starting any worker, since workers steal from all of them
+    for(pool->threads = 0; pool->threads < threads; pool->threads++) {
+        TPWorker *worker = &pool->workers[pool->threads];
+        worker->tasks = DVArray_init_with_pool(sizeof(TPTask), 16, 0.5, 2.0, 0, NULL);
+        if(worker->tasks == NULL) {
+            tp_free(pool, 0);
+            pool = NULL;
+            err = DA_ERR_MEMORY | TP_INIT_THREAD;
+            sentinel("Failed to create ThreadPool queue");
+        }
+
+        pthread_mutex_init(&worker->lock, NULL);
+        worker->pool = pool;
+        worker->index = pool->threads;
+    }
+
+    for(uint32_t i = 0; i < threads; i++) {
+        if(pthread_create(&pool->workers[i].thread, NULL, tp_worker, &pool->workers[i]) != 0) {
+            tp_free(pool, i);
+            pool = NULL;
+            err = DA_ERR_MEMORY | TP_INIT_THREAD;
+            sentinel("Failed to start ThreadPool worker %u", i);
+        }
+    }
+
+    if(res != NULL) {
+        *res = 0;
+    }
+
+    return pool;
+
+error:
+    free(pool);
+    if(res != NULL) {
+        *res = err;
+    }
+
+    return NULL;
+}
+
+void ThreadPool_destroy(ThreadPool *pool)
+{
+    if(pool == NULL) {
+        return;
+    }
+
+    tp_free(pool, pool->threads);
+}
+
+// Queue a task on the queue of worker index
+static int tp_submit(ThreadPool *pool, uint32_t index, TPGroup *group, void (*fn)(void *arg), void *arg)
+{
+    int err = 0;
+    TPTask task = { fn, arg, group };
+
+    // Count the task before it can be taken, so a waiter never sees the group finish early
+    if(group != NULL) {
+        atomic_fetch_add_explicit(&group->outstanding, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add(&pool->pending, 1);
+
+    TPWorker *worker = &pool->workers[index];
+    pthread_mutex_lock(&worker->lock);
+    int rc = DVArray_push(worker->tasks, &task);
+    pthread_mutex_unlock(&worker->lock);
+
+    if(rc != 0) {
+        atomic_fetch_sub(&pool->pending, 1);
+        if(group != NULL) {
+            atomic_fetch_sub_explicit(&group->outstanding, 1, memory_order_relaxed);
+        }
+    }
+    check_err(rc == 0, err, da_chain(TP_SUBMIT_PUSH, rc), "Failed to queue task");
+
+    if(atomic_load(&pool->sleeping) > 0) {
+        pthread_mutex_lock(&pool->sleep_lock);
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->sleep_lock);
+    }
+
+    return 0;
+
+error:
+    return err;
+}
+
+int ThreadPool_submit(ThreadPool *pool, TPGroup *group, void (*fn)(void *arg), void *arg)
+{
+    if(pool == NULL || fn == NULL) {
+        return DA_ERR_ARGS;
+    }
+
+    uint32_t index = tp_self_index(pool);
+    if(index == pool->threads) {
+        index = atomic_fetch_add_explicit(&pool->next, 1, memory_order_relaxed) % pool->threads;
+    }
+
+    return tp_submit(pool, index, group, fn, arg);
+}
+
+int ThreadPool_submit_to(ThreadPool *pool, uint32_t worker, TPGroup *group, void (*fn)(void *arg), void *arg)
+{
+    if(pool == NULL || fn == NULL) {
+        return DA_ERR_ARGS;
+    }
+
+    return tp_submit(pool, worker % pool->threads, group, fn, arg);
+}
+
+int ThreadPool_pin(ThreadPool *pool)
+{
+    int err = 0;
+
+    check_err(pool != NULL, err, DA_ERR_ARGS, "NULL pool");
+
+#ifdef __linux__
+    cpu_set_t allowed;
+    check_err(sched_getaffinity(0, sizeof(allowed), &allowed) == 0, err, DA_ERR_ARGS | TP_PIN_AFFINITY, "Failed to get CPU affinity");
+
+    int cpus = CPU_COUNT(&allowed);
+    check_err(cpus > 0, err, DA_ERR_ARGS | TP_PIN_AFFINITY, "No CPUs available");
+
+    size_t cpu = (size_t)CPU_SETSIZE - 1;
+    for(uint32_t i = 0; i < pool->threads; i++) {
+        // Next allowed CPU after the last one used, wrapping around
+        do {
+            cpu = (cpu + 1) % (size_t)CPU_SETSIZE;
+        } while(!CPU_ISSET(cpu, &allowed));
+
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(cpu, &one);
+        check_err(pthread_setaffinity_np(pool->workers[i].thread, sizeof(one), &one) == 0, err,
+                DA_ERR_ARGS | TP_PIN_AFFINITY, "Failed to pin worker %u to CPU %zu", i, cpu);
+    }
+
+    return 0;
+#else
+    err = DA_ERR_ARGS | TP_PIN_AFFINITY;
+    sentinel("CPU affinity not supported");
+#endif
+
+error:
+    return err;
+}
+
+void ThreadPool_wait(ThreadPool *pool, TPGroup *group)
+{
+    if(pool == NULL || group == NULL) {
+        return;
+    }
+
+    uint32_t self = tp_self_index(pool);
+    TPTask task;
+
+    while(atomic_load_explicit(&group->outstanding, memory_order_acquire) > 0) {
+        if(tp_take(pool, self, &task)) {
+            tp_run(&task);
+        } else {
+            sched_yield();
+        }
+    }
+}
@@ -0,0 +1,201 @@
+/**
+ * @file thread_pool.h
+ * @author Andrew Walls
+ * @date 14 October 2026
+ * @brief Header file for ThreadPool implementation
+ *
+ */
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include "darray.h"
+#include "dvarray.h"
+#include "stdint.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * @brief Size of a cache line, used to keep the workers' queues apart
+ */
+#ifndef TP_CACHE_LINE
+#define TP_CACHE_LINE 64
+#endif
+
+/**
+ * @brief Set of tasks which can be waited on together
+ *
+ * Zero-initialise before first use, e.g. `TPGroup group = {0};`. A group may be reused once
+ * `ThreadPool_wait` has returned for it.
+ */
+typedef struct TPGroup {
+    _Atomic uint32_t outstanding;   ///< Tasks submitted to the group which have not finished
+} TPGroup;
+
+/**
+ * @brief Queued task
+ */
+typedef struct TPTask {
+    void (*fn)(void *arg);  ///< Function to run
+    void *arg;              ///< Argument to `fn`
+    TPGroup *group;         ///< Group to signal on completion; may be `NULL`
+} TPTask;
+
+/**
+ * @brief Worker thread and its queue of tasks
+ */
+typedef struct TPWorker {
+    _Alignas(TP_CACHE_LINE) pthread_mutex_t lock;   ///< Guards `tasks`
+    DVArray *tasks;                                 ///< Queue of `TPTask`s; the owner takes from the back, thieves from the front
+    struct ThreadPool *pool;                        ///< Pool the worker belongs to
+    uint32_t index;                                 ///< Position of the worker in the pool
+    pthread_t thread;                               ///< Worker thread
+} TPWorker;
+
+/**
+ * @brief Fixed-size pool of threads with work stealing
+ *
+ * Every worker has its own queue. Tasks submitted from a worker go on that worker's queue, which
+ * it runs newest first so fork/join work stays hot in its cache; tasks submitted from any other
+ * thread are spread across the queues in turn. A worker whose queue is empty steals the oldest
+ * task from another, which for divide-and-conquer work is the largest piece left.
+ *
+ * Waiting on a group runs queued tasks rather than blocking, so tasks may submit and wait on
+ * tasks of their own without exhausting the pool.
+ *
+ * All functions other than `ThreadPool_init` and `ThreadPool_destroy` may be called from any
+ * thread, including from tasks.
+ */
+typedef struct ThreadPool {
+    uint32_t threads;               ///< Number of workers
+    TPWorker *workers;              ///< Workers; `threads` of them
+    _Atomic uint64_t pending;       ///< Tasks queued and not yet taken
+    _Atomic uint32_t next;          ///< Queue for the next task submitted from outside the pool
+    _Atomic uint32_t sleeping;      ///< Workers waiting on `wake`
+    int shutdown;                   ///< Set by `ThreadPool_destroy`; guarded by `sleep_lock`
+    pthread_mutex_t sleep_lock;     ///< Guards sleeping workers
+    pthread_cond_t wake;            ///< Signalled when a task is queued
+} ThreadPool;
+
+/**
+ * @brief Initialise a ThreadPool and start its workers
+ *
+ * @see tp_err_init for errors
+ *
+ * @param threads Number of workers; 0 for one per online CPU
+ * @param [out] res Result; 0 on success, otherwise non-0
+ *
+ * @return New ThreadPool on success, otherwise `NULL`
+ */
+ThreadPool *ThreadPool_init(uint32_t threads, int *res);
+
+/**
+ * @brief ThreadPool_init errors
+ * @see ThreadPool_init
+ */
+enum tp_err_init {
+    TP_INIT_THREAD  = 0x10  ///< Failed to create a worker, its queue or its lock
+};
+
+/**
+ * @brief Finish every queued task, stop the workers and free a ThreadPool
+ *
+ * Must not be called from a task.
+ *
+ * @param pool ThreadPool to free
+ */
+void ThreadPool_destroy(ThreadPool *pool);
+
+/**
+ * @brief Get the number of workers in a ThreadPool
+ *
+ * @param pool ThreadPool
+ *
+ * @return Number of workers
+ */
+static inline uint32_t ThreadPool_threads(const ThreadPool *pool)
+{
+    return pool->threads;
+}
+
+/**
+ * @brief Queue a task on a ThreadPool
+ *
+ * Performance: `O(1)` amortised
+ *
+ * @see tp_err_submit for errors
+ *
+ * @param pool ThreadPool to run the task
+ * @param group Group to add the task to; may be `NULL`
+ * @param fn Function to run
+ * @param arg Argument to `fn`
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int ThreadPool_submit(ThreadPool *pool, TPGroup *group, void (*fn)(void *arg), void *arg);
+
+/**
+ * @brief ThreadPool_submit errors
+ * @see ThreadPool_submit
+ */
+enum tp_err_submit {
+    TP_SUBMIT_PUSH  = 0x10  ///< Failed to add the task to a queue; see chained errors
+};
+
+/**
+ * @brief Queue a task on a particular worker of a ThreadPool
+ *
+ * The task goes on the queue of worker `worker % threads` rather than the submitter's, so work
+ * on one part of an array can be kept with one worker across calls. Another worker may still
+ * steal it if the chosen one is busy.
+ * Performance: `O(1)` amortised
+ *
+ * @see tp_err_submit for errors
+ * @see ThreadPool_pin
+ *
+ * @param pool ThreadPool to run the task
+ * @param worker Worker whose queue takes the task
+ * @param group Group to add the task to; may be `NULL`
+ * @param fn Function to run
+ * @param arg Argument to `fn`
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int ThreadPool_submit_to(ThreadPool *pool, uint32_t worker, TPGroup *group, void (*fn)(void *arg), void *arg);
+
+/**
+ * @brief Pin each worker of a ThreadPool to its own CPU
+ *
+ * Worker `i` is bound to the `i`th CPU the process may run on, wrapping around if there are
+ * more workers than CPUs. With the workers pinned, memory a worker touches first is placed on
+ * its NUMA node by the kernel and stays local to it, which `ThreadPool_submit_to` can make use
+ * of. Only available on Linux.
+ *
+ * @see tp_err_pin for errors
+ *
+ * @param pool ThreadPool to pin
+ *
+ * @return Result; 0 on success, otherwise non-0
+ */
+int ThreadPool_pin(ThreadPool *pool);
+
+/**
+ * @brief ThreadPool_pin errors
+ * @see ThreadPool_pin
+ */
+enum tp_err_pin {
+    TP_PIN_AFFINITY = 0x10  ///< Failed to get or set a CPU affinity, or not supported on this platform
+};
+
+/**
+ * @brief Wait for every task in a group to finish
+ *
+ * The calling thread runs queued tasks, from any group, while it waits.
+ *
+ * @param pool ThreadPool the tasks were submitted to
+ * @param group Group to wait on
+ */
+void ThreadPool_wait(ThreadPool *pool, TPGroup *group);
+
+#endif
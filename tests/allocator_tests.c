@@ -0,0 +1,124 @@
+#include "allocator.h"
+#include "darray.h"
+#include "minunit.h"
+
+mu_suite_start();
+
+static Allocator *allocator;
+static int err;
+
+static char *test_arena(void)
+{
+    allocator = Allocator_arena(256, &err);
+    mu_assert(allocator != NULL && err == 0, "Error creating arena (%#04x)", err);
+
+    char *a = Allocator_alloc(allocator, 10);
+    char *b = Allocator_alloc(allocator, 10);
+    mu_assert(a != NULL && b == a + 16, "Arena allocations not sequential");
+
+    // The latest allocation grows in place
+    char *c = Allocator_realloc(allocator, b, 10, 100);
+    mu_assert(c == b, "Arena realloc of latest allocation moved it");
+
+    char *big = Allocator_alloc(allocator, 1000);
+    mu_assert(big != NULL, "Arena failed oversized allocation");
+
+    Allocator_arena_reset(allocator);
+    char *d = Allocator_alloc(allocator, 10);
+    mu_assert(d == a, "Arena reset did not reuse first block");
+
+    Allocator_destroy(allocator);
+    err = 0;
+    return NULL;
+}
+
+static char *test_pool(void)
+{
+    allocator = Allocator_pool(&err);
+    mu_assert(allocator != NULL && err == 0, "Error creating pool (%#04x)", err);
+
+    void *a = Allocator_alloc(allocator, 100);
+    Allocator_free(allocator, a, 100);
+
+    // Same size class reuses the freed block
+    void *b = Allocator_alloc(allocator, 120);
+    mu_assert(b == a, "Pool did not recycle block of same size class");
+
+    void *c = Allocator_realloc(allocator, b, 120, 128);
+    mu_assert(c == b, "Pool realloc within size class moved block");
+
+    Allocator_free(allocator, c, 128);
+
+    // Blocks still live at destroy are released with the pool, pooled or not
+    size_t size = 2 * 1024 * 1024;
+    char *live = Allocator_alloc(allocator, 100);
+    char *big = Allocator_alloc(allocator, size);
+    mu_assert(live != NULL && big != NULL, "Pool allocation failed");
+    big[0] = 1;
+    big[size - 1] = 2;
+
+    char *bigger = Allocator_realloc(allocator, big, size, 2 * size);
+    mu_assert(bigger != NULL && bigger[0] == 1 && bigger[size - 1] == 2, "Pool realloc lost contents");
+
+    Allocator_destroy(allocator);
+    err = 0;
+    return NULL;
+}
+
+static char *test_huge(void)
+{
+    allocator = Allocator_huge(0, &err);
+    mu_assert(allocator != NULL && err == 0, "Error creating huge allocator (%#04x)", err);
+
+    size_t size = 3 * 1024 * 1024;
+    char *a = Allocator_alloc(allocator, size);
+    mu_assert(a != NULL, "Huge allocation failed");
+    a[0] = 1;
+    a[size - 1] = 2;
+
+    char *b = Allocator_realloc(allocator, a, size, 2 * size);
+    mu_assert(b != NULL && b[0] == 1 && b[size - 1] == 2, "Huge realloc lost contents");
+
+    Allocator_free(allocator, b, 2 * size);
+    Allocator_destroy(allocator);
+
+    allocator = Allocator_huge(3000, &err);
+    mu_assert(allocator == NULL && err == DA_ERR_ARGS, "Invalid page size accepted (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_darray_with_allocator(void)
+{
+    allocator = Allocator_pool(&err);
+    DArray *darray = DArray_init_with_allocator(4, 0.3, 1.5, 1, 0, allocator, &err);
+    mu_assert(darray != NULL && err == 0, "Error in init with allocator (%#04x)", err);
+    mu_assert(darray->allocator == allocator, "Allocator not stored in darray");
+
+    int values[100];
+    for(int i = 0; i < 100; i++) {
+        err = DArray_push(darray, &values[i]);
+        mu_assert(err == 0, "Error in push with allocator (%#04x)", err);
+    }
+
+    for(uint32_t i = 0; i < 100; i++) {
+        mu_assert(DArray_index(darray, i) == &values[i], "Incorrect value at index %d with allocator", i);
+    }
+
+    DArray_destroy(darray);
+    Allocator_destroy(allocator);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_arena);
+    mu_run_test(test_pool);
+    mu_run_test(test_huge);
+    mu_run_test(test_darray_with_allocator);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
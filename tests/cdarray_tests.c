@@ -0,0 +1,214 @@
+#include "cdarray.h"
+#include "minunit.h"
+
+#include <pthread.h>
+
+mu_suite_start();
+
+static CDArray *cdarray;
+static int err;
+
+#define WRITERS 4
+#define READERS 2
+#define PUSHES 20000
+
+static char *test_init(void)
+{
+    cdarray = CDArray_init(10, 1.5, &err);
+    mu_assert(cdarray != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(CDArray_length(cdarray) == 0, "Initial length != 0");
+    CDArray_destroy(cdarray);
+
+    cdarray = CDArray_init(0, 1.5, &err);
+    mu_assert(cdarray == NULL && err == (DA_ERR_ARGS | DA_INIT_LENGTH), "Length of 0 allowed (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_push_index(void)
+{
+    cdarray = CDArray_init(2, 1.5, &err);
+    CDReader *reader = CDArray_reader_register(cdarray, &err);
+    mu_assert(reader != NULL && err == 0, "Error registering reader (%#04x)", err);
+
+    int values[100];
+    for(int i = 0; i < 100; i++) {
+        err = CDArray_push(cdarray, &values[i]);
+        mu_assert(err == 0, "Error in push (%#04x)", err);
+    }
+
+    err = CDArray_push(cdarray, NULL);
+    mu_assert(err == DA_ERR_ARGS, "Push of NULL allowed (%#04x)", err);
+
+    CDArray_read_begin(reader);
+    for(uint32_t i = 0; i < 100; i++) {
+        mu_assert(CDArray_index(cdarray, i) == &values[i], "Incorrect value at index %d", i);
+    }
+    mu_assert(CDArray_index(cdarray, 100) == NULL, "Value past end of array");
+    CDArray_read_end(reader);
+
+    // Nothing is pinned, so every retired store can go
+    CDArray_reclaim(cdarray);
+    mu_assert(cdarray->retired == NULL, "Retired stores not reclaimed");
+
+    CDArray_reader_unregister(reader);
+    CDArray_destroy(cdarray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_reader_limit(void)
+{
+    cdarray = CDArray_init(2, 1.5, &err);
+
+    for(int i = 0; i < CDARRAY_MAX_READERS; i++) {
+        mu_assert(CDArray_reader_register(cdarray, &err) != NULL, "Failed to register reader %d", i);
+    }
+
+    CDReader *reader = CDArray_reader_register(cdarray, &err);
+    mu_assert(reader == NULL && err == (DA_ERR_MEMORY | CD_READER_LIMIT), "Reader past limit registered (%#04x)", err);
+
+    CDArray_destroy(cdarray);
+    err = 0;
+    return NULL;
+}
+
+static uintptr_t tags[WRITERS];
+
+static void *writer(void *arg)
+{
+    uintptr_t id = (uintptr_t)arg;
+
+    for(uintptr_t i = 0; i < PUSHES; i++) {
+        // Tag with the writer so each writer's values can be checked for order
+        CDArray_push(cdarray, (void *)((i << 8) | id | 0x80));
+    }
+
+    return NULL;
+}
+
+static void *reader_thread(void *arg)
+{
+    CDReader *reader = arg;
+    uintptr_t bad = 0;
+
+    for(int pass = 0; pass < 200; pass++) {
+        CDArray_read_begin(reader);
+        uint32_t length = CDArray_length(cdarray);
+        for(uint32_t i = 0; i < length; i += 17) {
+            uintptr_t value = (uintptr_t)CDArray_index(cdarray, i);
+            if(value != 0 && !(value & 0x80)) {
+                bad++;
+            }
+        }
+        CDArray_read_end(reader);
+    }
+
+    return (void *)bad;
+}
+
+static char *test_threads(void)
+{
+    cdarray = CDArray_init(16, 1.5, &err);
+
+    pthread_t writers[WRITERS];
+    pthread_t readers[READERS];
+    CDReader *handles[READERS];
+
+    for(int i = 0; i < READERS; i++) {
+        handles[i] = CDArray_reader_register(cdarray, &err);
+        pthread_create(&readers[i], NULL, reader_thread, handles[i]);
+    }
+    for(uintptr_t i = 0; i < WRITERS; i++) {
+        pthread_create(&writers[i], NULL, writer, (void *)i);
+    }
+
+    for(int i = 0; i < WRITERS; i++) {
+        pthread_join(writers[i], NULL);
+    }
+    for(int i = 0; i < READERS; i++) {
+        void *bad;
+        pthread_join(readers[i], &bad);
+        mu_assert(bad == NULL, "Reader saw torn values");
+    }
+
+    mu_assert(CDArray_length(cdarray) == WRITERS * PUSHES, "Incorrect length after concurrent pushes (%d)", CDArray_length(cdarray));
+
+    // Each writer's values appear in the order it pushed them
+    CDArray_read_begin(handles[0]);
+    for(uint32_t i = 0; i < WRITERS * PUSHES; i++) {
+        uintptr_t value = (uintptr_t)CDArray_index(cdarray, i);
+        uintptr_t id = value & 0x7F;
+        mu_assert(id < WRITERS && value >> 8 == tags[id], "Value out of order at index %d", i);
+        tags[id]++;
+    }
+    CDArray_read_end(handles[0]);
+
+    CDArray_destroy(cdarray);
+    err = 0;
+    return NULL;
+}
+
+#define GROWERS 8
+#define GROWER_PUSHES 4000
+
+static void *grower(void *arg)
+{
+    uintptr_t id = (uintptr_t)arg;
+
+    for(uintptr_t i = 0; i < GROWER_PUSHES; i++) {
+        if(CDArray_push(cdarray, (void *)((i << 8) | id | 0x80)) != 0) {
+            return (void *)1;
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_push_growth(void)
+{
+    // A store of 1 growing by 1% grows on nearly every push, and with no readers pinned each
+    // retired store is freed as soon as it is replaced, so pushes constantly race growth
+    cdarray = CDArray_init(1, 1.01, &err);
+    mu_assert(cdarray != NULL, "Error in init (%#04x)", err);
+
+    pthread_t threads[GROWERS];
+    for(uintptr_t i = 0; i < GROWERS; i++) {
+        pthread_create(&threads[i], NULL, grower, (void *)i);
+    }
+    for(int i = 0; i < GROWERS; i++) {
+        void *failed;
+        pthread_join(threads[i], &failed);
+        mu_assert(failed == NULL, "Push failed during growth");
+    }
+
+    mu_assert(CDArray_length(cdarray) == GROWERS * GROWER_PUSHES, "Incorrect length after growth (%d)", CDArray_length(cdarray));
+    mu_assert(cdarray->size >= GROWERS * GROWER_PUSHES, "Size not updated by growth (%u)", cdarray->size);
+
+    uint32_t counts[GROWERS] = { 0 };
+    for(uint32_t i = 0; i < GROWERS * GROWER_PUSHES; i++) {
+        uintptr_t value = (uintptr_t)CDArray_index(cdarray, i);
+        mu_assert(value & 0x80, "Value lost in growth at index %d", i);
+        counts[value & 0x7F]++;
+    }
+    for(int i = 0; i < GROWERS; i++) {
+        mu_assert(counts[i] == GROWER_PUSHES, "Incorrect number of values from pusher %d (%u)", i, counts[i]);
+    }
+
+    CDArray_destroy(cdarray);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init);
+    mu_run_test(test_push_index);
+    mu_run_test(test_reader_limit);
+    mu_run_test(test_threads);
+    mu_run_test(test_push_growth);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,137 @@
+#include "darray_define.h"
+#include "minunit.h"
+
+mu_suite_start();
+
+typedef struct Point {
+    int x;
+    int y;
+} Point;
+
+#define INT_LESS(a, b) ((a) < (b))
+
+DARRAY_DEFINE(IntArray, int)
+DARRAY_DEFINE_SORT(IntArray, int, INT_LESS)
+DARRAY_DEFINE(PointArray, Point)
+
+static int err;
+
+static char *test_init(void)
+{
+    IntArray *array = IntArray_init_with_pool(10, 0.3, 1.5, 2, &err);
+    mu_assert(array != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(array->length == 0 && array->store_size == 10 && array->start_index == 2, "Incorrect initial layout");
+    IntArray_destroy(array);
+
+    array = IntArray_init_with_pool(10, 0.3, 1.5, 10, &err);
+    mu_assert(array == NULL && err == (DA_ERR_ARGS | DA_INIT_POOL_SIZE), "Pool size >= length allowed (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_push_pop(void)
+{
+    IntArray *array = IntArray_init_with_pool(4, 0.3, 1.5, 0, &err);
+
+    for(int i = 0; i < 100; i++) {
+        err = IntArray_push(array, i);
+        mu_assert(err == 0, "Error in push (%#04x)", err);
+    }
+
+    for(uint32_t i = 0; i < 100; i++) {
+        mu_assert(*IntArray_index(array, i) == (int)i, "Incorrect value at index %d", i);
+    }
+    mu_assert(IntArray_index(array, 100) == NULL, "Value past end of array");
+
+    int value = -1;
+    for(int i = 99; i >= 0; i--) {
+        err = IntArray_pop(array, &value);
+        mu_assert(err == 0 && value == i, "Incorrect value popped at %d", i);
+    }
+
+    err = IntArray_pop(array, &value);
+    mu_assert(err == (DA_ERR_ARGS | DV_EMPTY), "Pop from empty array allowed (%#04x)", err);
+
+    IntArray_destroy(array);
+    err = 0;
+    return NULL;
+}
+
+static char *test_shift_unshift(void)
+{
+    PointArray *array = PointArray_init_with_pool(4, 0.5, 1.5, 1, &err);
+
+    for(int i = 0; i < 50; i++) {
+        Point p = { i, -i };
+        err = PointArray_unshift(array, p);
+        mu_assert(err == 0, "Error in unshift (%#04x)", err);
+    }
+
+    mu_assert(PointArray_index(array, 0)->x == 49 && PointArray_index(array, 49)->y == 0, "Incorrect values after unshift");
+
+    Point p;
+    for(int i = 49; i >= 0; i--) {
+        err = PointArray_shift(array, &p);
+        mu_assert(err == 0 && p.x == i && p.y == -i, "Incorrect value shifted at %d", i);
+    }
+
+    PointArray_destroy(array);
+    err = 0;
+    return NULL;
+}
+
+static char *test_move(void)
+{
+    IntArray *array = IntArray_init_with_pool(10, 0.3, 1.01, 2, &err);
+    for(int i = 0; i < 5; i++) {
+        IntArray_push(array, i);
+    }
+
+    // A long move grows the store once, straight to the size it needs
+    err = IntArray_move(array, 1000);
+    mu_assert(err == 0 && array->start_index == 1002, "Error in move (%#04x)", err);
+    mu_assert(array->store_size == 1007, "Incorrect store_size after move (was %u, should be %d)", array->store_size, 1007);
+    for(uint32_t i = 0; i < 5; i++) {
+        mu_assert(*IntArray_index(array, i) == (int)i, "Incorrect value at index %u after move", i);
+    }
+
+    err = IntArray_move(array, -2000);
+    mu_assert(err == (DA_ERR_ARGS | DA_MOVE_RANGE), "Out of range move allowed (%#04x)", err);
+
+    IntArray_destroy(array);
+    err = 0;
+    return NULL;
+}
+
+static char *test_sort(void)
+{
+    IntArray *array = IntArray_init_with_pool(10, 0.3, 1.5, 3, &err);
+
+    unsigned seed = 1;
+    for(int i = 0; i < 1000; i++) {
+        seed = seed * 1103515245 + 12345;
+        IntArray_push(array, (int)(seed >> 16) % 500);
+    }
+
+    IntArray_sort(array);
+    for(uint32_t i = 1; i < array->length; i++) {
+        mu_assert(*IntArray_index(array, i - 1) <= *IntArray_index(array, i), "Values not sorted at %d", i);
+    }
+
+    IntArray_destroy(array);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init);
+    mu_run_test(test_push_pop);
+    mu_run_test(test_shift_unshift);
+    mu_run_test(test_move);
+    mu_run_test(test_sort);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,52 @@
+#include "darray_eytzinger.h"
+#include "minunit.h"
+
+mu_suite_start();
+
+static int err;
+
+static int compare_ints(void *val1, void *val2)
+{
+    return *(int *)val1 - *(int *)val2;
+}
+
+static char *test_search(void)
+{
+    static int values[1000];
+
+    // Every length up to a few levels, plus a larger one, to cover partial last levels
+    for(uint32_t length = 0; length <= 1000; length = length < 40 ? length + 1 : length + 480) {
+        DArray *darray = DArray_init_with_pool(8, 0.3, 2.0, 2, &err);
+        for(uint32_t i = 0; i < length; i++) {
+            values[i] = (int)(i / 3) * 2;
+            DArray_push(darray, &values[i]);
+        }
+
+        DAEytzinger *eytzinger = DAEytzinger_init(darray, &err);
+        mu_assert(eytzinger != NULL && err == 0, "Error in init (%#04x)", err);
+        mu_assert(eytzinger->length == length, "Incorrect length");
+
+        for(int key = -1; key <= (int)length; key++) {
+            DArraySize expected = DArray_lower_bound(darray, &key, compare_ints);
+            DArraySize lower = DAEytzinger_lower_bound(eytzinger, &key, compare_ints);
+            mu_assert(lower == expected, "Incorrect lower bound of %d in %u values (was %" PRIuDA ", should be %" PRIuDA ")", key, length, lower, expected);
+            mu_assert(DAEytzinger_bsearch(eytzinger, &key, compare_ints) == DArray_bsearch(darray, &key, compare_ints), "Incorrect bsearch of %d in %u values", key, length);
+        }
+
+        DAEytzinger_destroy(eytzinger);
+        DArray_destroy(darray);
+    }
+
+    mu_assert(DAEytzinger_init(NULL, &err) == NULL && err == DA_ERR_ARGS, "Index of NULL darray built (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_search);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,63 @@
+// Compiled as C++, so this checks darray.hpp, darray_define.h and minunit stay usable from C++
+#include "darray.hpp"
+#include "minunit.h"
+
+#include <type_traits>
+#include <utility>
+
+mu_suite_start();
+
+DARRAY_DEFINE(IntArray, int)
+
+static char *test_push_index()
+{
+    darray::Array<IntArray> values(2);
+
+    for(int i = 0; i < 100; i++) {
+        mu_assert(values.push(i) == 0, "Error in push");
+    }
+    mu_assert(values.size() == 100 && !values.empty(), "Incorrect size after push");
+    static_assert(std::is_same<decltype(values.size()), DArraySize>::value, "size() is not a DArraySize");
+
+    int sum = 0;
+    for(int value : values) {
+        sum += value;
+    }
+    mu_assert(sum == 4950, "Incorrect values iterated");
+    mu_assert(values[42] == 42 && *values.index(99) == 99, "Incorrect value indexed");
+    mu_assert(values.index(100) == NULL, "Value past end of array");
+
+    int value = -1;
+    mu_assert(values.shift(&value) == 0 && value == 0, "Incorrect value shifted");
+    mu_assert(values.pop(&value) == 0 && value == 99, "Incorrect value popped");
+    mu_assert(values.unshift(-1) == 0 && values[0] == -1, "Incorrect value unshifted");
+    mu_assert(IntArray_index(values.get(), 1) != NULL && *IntArray_index(values.get(), 1) == 1, "Underlying array differs");
+
+    return NULL;
+}
+
+static char *test_move()
+{
+    darray::Array<IntArray> values;
+    values.push(7);
+
+    darray::Array<IntArray> moved(std::move(values));
+    mu_assert(moved.size() == 1 && moved[0] == 7, "Values not moved");
+    mu_assert(values.size() == 0 && values.empty() && values.get() == NULL, "Moved-from array not empty");
+
+    // Assigning to a moved-from array makes it usable again
+    values = darray::Array<IntArray>(4);
+    mu_assert(values.push(1) == 0 && values.size() == 1, "Error using assigned array");
+
+    return NULL;
+}
+
+static char *all_tests()
+{
+    mu_run_test(test_push_index);
+    mu_run_test(test_move);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
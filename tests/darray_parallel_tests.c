@@ -0,0 +1,288 @@
+#include "darray_parallel.h"
+#include "minunit.h"
+
+#include <stdlib.h>
+
+mu_suite_start();
+
+static ThreadPool *pool;
+static int err;
+
+#define SORT_COUNT 200000
+
+static int values[SORT_COUNT];
+
+static int compare_ints(void *val1, void *val2)
+{
+    int a = *(int *)val1;
+    int b = *(int *)val2;
+
+    return (a > b) - (a < b);
+}
+
+static char *check_sorted(DArray *darray, uint32_t length)
+{
+    mu_assert(darray->length == length, "Length changed by sort (%" PRIuDA ")", darray->length);
+
+    long long total = 0;
+    for(uint32_t i = 0; i < length; i++) {
+        int *value = DArray_index(darray, i);
+        total += *value;
+        if(i > 0) {
+            mu_assert(*(int *)DArray_index(darray, i - 1) <= *value, "Values out of order after sort at index %u", i);
+        }
+    }
+
+    // Every value is its own index, so the sum shows nothing was lost or duplicated
+    long long expected = 0;
+    for(uint32_t i = 0; i < length; i++) {
+        expected += values[i];
+    }
+    mu_assert(total == expected, "Values lost by sort");
+
+    return NULL;
+}
+
+static DArray *shuffled(uint32_t length, uint32_t pool_size)
+{
+    DArray *darray = DArray_init_with_pool(length + pool_size + 1, 0.3, 2.0, pool_size, NULL);
+
+    for(uint32_t i = 0; i < length; i++) {
+        DArray_push(darray, &values[i]);
+    }
+
+    srand(42);
+    for(uint32_t i = length - 1; i > 0; i--) {
+        uint32_t j = (uint32_t)rand() % (i + 1);
+        void **items = darray->items + darray->start_index;
+        void *tmp = items[i];
+        items[i] = items[j];
+        items[j] = tmp;
+    }
+
+    return darray;
+}
+
+static char *test_sort(void)
+{
+    for(int i = 0; i < SORT_COUNT; i++) {
+        values[i] = i / 3;
+    }
+
+    pool = ThreadPool_init(4, &err);
+    mu_assert(pool != NULL, "Failed to create pool (%#04x)", err);
+
+    DArray *darray = shuffled(SORT_COUNT, 7);
+    err = DArray_parallel_sort(darray, compare_ints, pool);
+    mu_assert(err == 0, "Error in parallel sort (%#04x)", err);
+    char *msg = check_sorted(darray, SORT_COUNT);
+    DArray_destroy(darray);
+    if(msg != NULL) {
+        return msg;
+    }
+
+    // Uneven lengths leave a short last run and unpaired runs in some rounds
+    darray = shuffled(SORT_COUNT - 12345, 0);
+    err = DArray_parallel_sort(darray, compare_ints, pool);
+    mu_assert(err == 0, "Error in parallel sort (%#04x)", err);
+    msg = check_sorted(darray, SORT_COUNT - 12345);
+    DArray_destroy(darray);
+
+    return msg;
+}
+
+static char *test_fallback(void)
+{
+    DArray *darray = shuffled(1000, 3);
+    err = DArray_parallel_sort(darray, compare_ints, pool);
+    mu_assert(err == 0, "Error in small sort (%#04x)", err);
+    char *msg = check_sorted(darray, 1000);
+    DArray_destroy(darray);
+    if(msg != NULL) {
+        return msg;
+    }
+
+    darray = shuffled(SORT_COUNT, 0);
+    err = DArray_parallel_sort(darray, compare_ints, NULL);
+    mu_assert(err == 0, "Error in sort without pool (%#04x)", err);
+    msg = check_sorted(darray, SORT_COUNT);
+    DArray_destroy(darray);
+    if(msg != NULL) {
+        return msg;
+    }
+
+    err = DArray_parallel_sort(NULL, compare_ints, pool);
+    mu_assert(err == DA_ERR_ARGS, "NULL darray sorted (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_ring(void)
+{
+    DArray *darray = DArray_init_ring(SORT_COUNT, 2.0, &err);
+
+    // Wrap the values around the end of the store, in reverse order
+    for(int i = 0; i < 100; i++) {
+        DArray_push(darray, &values[0]);
+        DArray_shift(darray, NULL);
+    }
+    for(int i = SORT_COUNT - 1; i >= 0; i--) {
+        DArray_push(darray, &values[i]);
+    }
+
+    err = DArray_parallel_sort(darray, compare_ints, pool);
+    mu_assert(err == 0, "Error in ring sort (%#04x)", err);
+    char *msg = check_sorted(darray, SORT_COUNT);
+    DArray_destroy(darray);
+    ThreadPool_destroy(pool);
+
+    return msg;
+}
+
+#define VALUE_COUNT 300000
+
+static void *double_value(void *value, void *ctx)
+{
+    (void)ctx;
+
+    return (void *)((uintptr_t)value * 2);
+}
+
+static void *sum_values(void *acc, void *value, void *ctx)
+{
+    (void)ctx;
+
+    return (void *)((uintptr_t)acc + (uintptr_t)value);
+}
+
+static int keep_even(void *value, void *ctx)
+{
+    (void)ctx;
+
+    return (uintptr_t)value % 2 == 0;
+}
+
+static _Atomic uint32_t visited;
+
+// Add one to every value in place, counting the values seen
+static int increment_values(void **run, DArraySize count, DArraySize index, void *ctx)
+{
+    (void)ctx;
+
+    for(DArraySize i = 0; i < count; i++) {
+        if((uintptr_t)run[i] != index + i + 1) {
+            return -1;
+        }
+        run[i] = (void *)((uintptr_t)run[i] + 1);
+    }
+    atomic_fetch_add(&visited, count);
+
+    return 0;
+}
+
+static int stop_late(void **run, DArraySize count, DArraySize index, void *ctx)
+{
+    (void)run;
+    (void)count;
+    (void)ctx;
+
+    return index >= VALUE_COUNT / 2 ? 9 : 0;
+}
+
+// Ring of the values 1 to VALUE_COUNT, wrapped around the end of its store
+static DArray *wrapped_values(void)
+{
+    DArray *darray = DArray_init_ring(VALUE_COUNT, 2.0, NULL);
+
+    for(int i = 0; i < 1000; i++) {
+        DArray_push(darray, NULL);
+        DArray_shift(darray, NULL);
+    }
+    for(uintptr_t i = 1; i <= VALUE_COUNT; i++) {
+        DArray_push(darray, (void *)i);
+    }
+
+    return darray;
+}
+
+static char *test_map_reduce_filter(void)
+{
+    pool = ThreadPool_init(4, &err);
+    mu_assert(pool != NULL, "Failed to create pool (%#04x)", err);
+
+    DArray *darray = wrapped_values();
+    DArraySpan spans[2];
+    mu_assert(DArray_spans(darray, spans) == 2, "Values not wrapped");
+
+    // Map, with and without the pool
+    ThreadPool *pools[2] = { pool, NULL };
+    for(int p = 0; p < 2; p++) {
+        DArray *mapped = DArray_parallel_map(darray, double_value, NULL, 0, pools[p], &err);
+        mu_assert(mapped != NULL && err == 0, "Error in map (%#04x)", err);
+        mu_assert(mapped->length == VALUE_COUNT, "Incorrect mapped length (%" PRIuDA ")", mapped->length);
+        for(uint32_t i = 0; i < VALUE_COUNT; i++) {
+            mu_assert((uintptr_t)DArray_index(mapped, i) == 2 * ((uintptr_t)i + 1), "Incorrect mapped value at %u", i);
+        }
+        mu_assert(DArray_push(mapped, NULL) == 0, "Mapped DArray can't grow");
+        DArray_destroy(mapped);
+    }
+
+    // Reduce, with a small grain so there are many pieces to combine
+    uintptr_t expected = (uintptr_t)VALUE_COUNT * (VALUE_COUNT + 1) / 2;
+    void *sum = DArray_parallel_reduce(darray, sum_values, (void *)0, NULL, 1000, pool, &err);
+    mu_assert(err == 0 && (uintptr_t)sum == expected, "Incorrect parallel sum (%#04x)", err);
+    sum = DArray_parallel_reduce(darray, sum_values, (void *)0, NULL, 0, NULL, &err);
+    mu_assert(err == 0 && (uintptr_t)sum == expected, "Incorrect sum without pool (%#04x)", err);
+
+    // Filter keeps order
+    DArray *evens = DArray_parallel_filter(darray, keep_even, NULL, 777, pool, &err);
+    mu_assert(evens != NULL && err == 0, "Error in filter (%#04x)", err);
+    mu_assert(evens->length == VALUE_COUNT / 2, "Incorrect filtered length (%" PRIuDA ")", evens->length);
+    for(DArraySize i = 0; i < evens->length; i++) {
+        mu_assert((uintptr_t)DArray_index(evens, i) == 2 * ((uintptr_t)i + 1), "Incorrect filtered value at %" PRIuDA, i);
+    }
+    DArray_destroy(evens);
+
+    // For, writing in place
+    atomic_store(&visited, 0);
+    err = DArray_parallel_for(darray, increment_values, NULL, 5000, pool);
+    mu_assert(err == 0 && atomic_load(&visited) == VALUE_COUNT, "Error in parallel for (%d, %u visited)", err, atomic_load(&visited));
+    mu_assert((uintptr_t)DArray_index(darray, VALUE_COUNT - 1) == VALUE_COUNT + 1, "Values not written by parallel for");
+
+    err = DArray_parallel_for(darray, stop_late, NULL, 5000, pool);
+    mu_assert(err == 9, "Parallel for not stopped (%d)", err);
+
+    DArray_destroy(darray);
+
+    // Empty arrays give empty results
+    darray = DArray_init_with_pool(4, 0.3, 1.5, 0, &err);
+    DArray *mapped = DArray_parallel_map(darray, double_value, NULL, 0, pool, &err);
+    mu_assert(mapped != NULL && mapped->length == 0, "Error mapping empty array (%#04x)", err);
+    DArray_destroy(mapped);
+    evens = DArray_parallel_filter(darray, keep_even, NULL, 0, pool, &err);
+    mu_assert(evens != NULL && evens->length == 0, "Error filtering empty array (%#04x)", err);
+    DArray_destroy(evens);
+    sum = DArray_parallel_reduce(darray, sum_values, (void *)5, NULL, 0, pool, &err);
+    mu_assert(err == 0 && (uintptr_t)sum == 5, "Reduce of empty array not identity");
+
+    mu_assert(DArray_parallel_map(darray, NULL, NULL, 0, pool, &err) == NULL && err == DA_ERR_ARGS, "NULL map allowed");
+    mu_assert(DArray_parallel_filter(NULL, keep_even, NULL, 0, pool, &err) == NULL && err == DA_ERR_ARGS, "NULL darray filtered");
+    mu_assert(DArray_parallel_for(darray, NULL, NULL, 0, pool) == DA_ERR_ARGS, "NULL fn allowed");
+
+    DArray_destroy(darray);
+    ThreadPool_destroy(pool);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_sort);
+    mu_run_test(test_fallback);
+    mu_run_test(test_ring);
+    mu_run_test(test_map_reduce_filter);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
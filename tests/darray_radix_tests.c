@@ -0,0 +1,141 @@
+#include "darray_radix.h"
+#include "minunit.h"
+
+#include <stdlib.h>
+
+mu_suite_start();
+
+static int err;
+
+#define SORT_COUNT 10000
+
+typedef struct Record {
+    int64_t key;
+    uint32_t order;
+    uint32_t pad;
+} Record;
+
+static int64_t keys[SORT_COUNT];
+
+static uint64_t key_i64(void *value)
+{
+    return DA_RADIX_KEY_I64(*(int64_t *)value);
+}
+
+static uint64_t key_low_byte(void *value)
+{
+    return (uint64_t)*(int64_t *)value & 0xFF;
+}
+
+static char *test_darray(void)
+{
+    DArray *darray = DArray_init_with_pool(8, 0.3, 2.0, 2, &err);
+    DARadixBuffer buffer = {0};
+
+    srand(7);
+    for(int i = 0; i < SORT_COUNT; i++) {
+        keys[i] = ((int64_t)rand() << 20) - ((int64_t)rand() << 30);
+        DArray_push(darray, &keys[i]);
+    }
+
+    err = DArray_radix_sort(darray, key_i64, &buffer);
+    mu_assert(err == 0, "Error in radix sort (%#04x)", err);
+    mu_assert(darray->length == SORT_COUNT, "Length changed by sort");
+    for(uint32_t i = 1; i < SORT_COUNT; i++) {
+        mu_assert(*(int64_t *)DArray_index(darray, i - 1) <= *(int64_t *)DArray_index(darray, i), "Values out of order after sort at index %u", i);
+    }
+
+    // Sorting by the low byte reuses the buffer, and must keep the previous order within each byte
+    size_t size = buffer.size;
+    err = DArray_radix_sort(darray, key_low_byte, &buffer);
+    mu_assert(err == 0 && buffer.size == size, "Buffer not reused (%#04x)", err);
+    for(uint32_t i = 1; i < SORT_COUNT; i++) {
+        int64_t a = *(int64_t *)DArray_index(darray, i - 1);
+        int64_t b = *(int64_t *)DArray_index(darray, i);
+        mu_assert((a & 0xFF) < (b & 0xFF) || ((a & 0xFF) == (b & 0xFF) && a <= b), "Sort not stable at index %u", i);
+    }
+
+    DARadixBuffer_free(&buffer);
+    mu_assert(buffer.data == NULL && buffer.size == 0, "Buffer not emptied");
+
+    err = DArray_radix_sort(NULL, key_i64, NULL);
+    mu_assert(err == DA_ERR_ARGS, "NULL darray sorted (%#04x)", err);
+
+    DArray_destroy(darray);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_darray_ring(void)
+{
+    DArray *darray = DArray_init_ring(16, 2.0, &err);
+
+    for(int i = 0; i < 10; i++) {
+        DArray_push(darray, &keys[0]);
+        DArray_shift(darray, NULL);
+    }
+    for(int i = 0; i < 100; i++) {
+        DArray_push(darray, &keys[i]);
+    }
+
+    err = DArray_radix_sort(darray, key_i64, NULL);
+    mu_assert(err == 0 && darray->length == 100, "Error in ring sort (%#04x)", err);
+    for(uint32_t i = 1; i < 100; i++) {
+        mu_assert(*(int64_t *)DArray_index(darray, i - 1) <= *(int64_t *)DArray_index(darray, i), "Values out of order after ring sort at index %u", i);
+    }
+
+    DArray_destroy(darray);
+    return NULL;
+}
+
+static char *test_dvarray(void)
+{
+    DVArray *ints = DVArray_init_with_pool(sizeof(int32_t), 8, 0.3, 2.0, 1, &err);
+    DVArray *records = DVArray_init_with_pool(sizeof(Record), 8, 0.3, 2.0, 0, &err);
+    DARadixBuffer buffer = {0};
+
+    srand(11);
+    for(uint32_t i = 0; i < SORT_COUNT; i++) {
+        int32_t value = rand() - RAND_MAX / 2;
+        Record record = { (int64_t)(rand() % 100) - 50, i, 0 };
+        DVArray_push(ints, &value);
+        DVArray_push(records, &record);
+    }
+
+    err = DVArray_radix_sort(ints, 0, sizeof(int32_t), DA_RADIX_SIGNED, &buffer);
+    mu_assert(err == 0, "Error in int32 sort (%#04x)", err);
+    for(uint32_t i = 1; i < SORT_COUNT; i++) {
+        mu_assert(*(int32_t *)DVArray_index(ints, i - 1) <= *(int32_t *)DVArray_index(ints, i), "int32 values out of order at index %u", i);
+    }
+
+    err = DVArray_radix_sort(records, offsetof(Record, key), sizeof(int64_t), DA_RADIX_SIGNED, &buffer);
+    mu_assert(err == 0, "Error in record sort (%#04x)", err);
+    for(uint32_t i = 1; i < SORT_COUNT; i++) {
+        Record *a = DVArray_index(records, i - 1);
+        Record *b = DVArray_index(records, i);
+        mu_assert(a->key < b->key || (a->key == b->key && a->order < b->order), "Records out of order or unstable at index %u", i);
+    }
+
+    err = DVArray_radix_sort(ints, 2, sizeof(int32_t), 0, NULL);
+    mu_assert(err == (DA_ERR_ARGS | DA_RADIX_KEY), "Key past end of value allowed (%#04x)", err);
+    err = DVArray_radix_sort(records, 0, 3, 0, NULL);
+    mu_assert(err == (DA_ERR_ARGS | DA_RADIX_KEY), "Key of 3 bytes allowed (%#04x)", err);
+
+    DARadixBuffer_free(&buffer);
+    DVArray_destroy(ints);
+    DVArray_destroy(records);
+
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_darray);
+    mu_run_test(test_darray_ring);
+    mu_run_test(test_dvarray);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,272 @@
+#include "darray_simd.h"
+#include "minunit.h"
+
+mu_suite_start();
+
+#define VALUE_COUNT 1000
+
+static int values[VALUE_COUNT];
+static int err;
+
+// Kernel sets which exist on this CPU; scalar first so it is always the reference
+static int levels[4];
+static int level_count;
+
+static char *test_levels(void)
+{
+    int best = DArray_simd_level();
+    mu_assert(best >= DA_SIMD_SCALAR && best <= DA_SIMD_AVX512, "Invalid default level (%d)", best);
+
+    level_count = 0;
+    for(int level = DA_SIMD_SCALAR; level <= DA_SIMD_AVX512; level++) {
+        if(DArray_simd_set_level(level) == level) {
+            levels[level_count++] = level;
+        }
+    }
+    mu_assert(levels[0] == DA_SIMD_SCALAR, "Scalar kernels not available");
+    mu_assert(DArray_simd_set_level(DA_SIMD_AVX512 + 1) == best, "Level not clamped to best");
+
+    return NULL;
+}
+
+static char *test_find_count(void)
+{
+    DArray *darray = DArray_init_with_pool(8, 0.3, 2.0, 3, &err);
+
+    for(int i = 0; i < VALUE_COUNT; i++) {
+        DArray_push(darray, &values[i % 37]);
+    }
+
+    for(int l = 0; l < level_count; l++) {
+        DArray_simd_set_level(levels[l]);
+
+        mu_assert(DArray_find(darray, &values[0]) == 0, "Incorrect find at start (level %d)", levels[l]);
+        mu_assert(DArray_find(darray, &values[36]) == 36, "Incorrect find (level %d)", levels[l]);
+        mu_assert(DArray_find(darray, &values[40]) == DA_NOT_FOUND, "Missing value found (level %d)", levels[l]);
+        mu_assert(DArray_count(darray, &values[5]) == 27, "Incorrect count (level %d, was %" PRIuDA ")", levels[l], DArray_count(darray, &values[5]));
+        mu_assert(DArray_count(darray, &values[30]) == 27, "Incorrect count in tail (level %d)", levels[l]);
+        mu_assert(DArray_count(darray, &values[0]) == 28, "Incorrect count of first value (level %d)", levels[l]);
+    }
+
+    DArray_destroy(darray);
+    return NULL;
+}
+
+static char *test_find_ring(void)
+{
+    DArray *darray = DArray_init_ring(16, 2.0, &err);
+
+    // Wrap the values around the end of the store
+    for(int i = 0; i < 12; i++) {
+        DArray_push(darray, &values[0]);
+    }
+    for(int i = 0; i < 12; i++) {
+        DArray_shift(darray, NULL);
+    }
+    for(int i = 0; i < 14; i++) {
+        DArray_push(darray, &values[i]);
+    }
+    mu_assert(darray->start_index + darray->length > darray->store_size, "Ring did not wrap");
+
+    for(int l = 0; l < level_count; l++) {
+        DArray_simd_set_level(levels[l]);
+
+        for(uint32_t i = 0; i < 14; i++) {
+            mu_assert(DArray_find(darray, &values[i]) == i, "Incorrect find in ring at %u (level %d)", i, levels[l]);
+            mu_assert(DArray_count(darray, &values[i]) == 1, "Incorrect count in ring at %u (level %d)", i, levels[l]);
+        }
+        mu_assert(DArray_find(darray, &values[14]) == DA_NOT_FOUND, "Missing value found in ring (level %d)", levels[l]);
+    }
+
+    DArray_destroy(darray);
+    return NULL;
+}
+
+static char *test_compact(void)
+{
+    for(int l = 0; l < level_count; l++) {
+        DArray_simd_set_level(levels[l]);
+
+        DArray *darray = DArray_init_with_pool(8, 0.3, 2.0, 2, &err);
+        for(int i = 0; i < VALUE_COUNT; i++) {
+            DArray_push(darray, i % 3 == 0 ? NULL : &values[i]);
+        }
+
+        DArraySize removed = DArray_compact(darray, &err);
+        mu_assert(err == 0 && removed == 334, "Error in compact (level %d, %#04x, removed %" PRIuDA ")", levels[l], err, removed);
+        mu_assert(darray->length == 666, "Incorrect length after compact (%" PRIuDA ")", darray->length);
+
+        uint32_t index = 0;
+        for(int i = 0; i < VALUE_COUNT; i++) {
+            if(i % 3 != 0) {
+                mu_assert(DArray_index(darray, index) == &values[i], "Incorrect value at %u after compact (level %d)", index, levels[l]);
+                index++;
+            }
+        }
+        for(DArraySize i = darray->start_index + darray->length; i < darray->store_size; i++) {
+            mu_assert(darray->items[i] == NULL, "Slot %" PRIuDA " not cleared after compact", i);
+        }
+
+        DArray_destroy(darray);
+    }
+
+    DArray *ring = DArray_init_ring(8, 2.0, &err);
+    for(int i = 0; i < 6; i++) {
+        DArray_push(ring, NULL);
+    }
+    for(int i = 0; i < 6; i++) {
+        DArray_shift(ring, NULL);
+    }
+    for(int i = 0; i < 6; i++) {
+        DArray_push(ring, i % 2 ? &values[i] : NULL);
+    }
+
+    DArraySize removed = DArray_compact(ring, &err);
+    mu_assert(err == 0 && removed == 3 && ring->length == 3, "Error in ring compact (%#04x)", err);
+    for(uint32_t i = 0; i < 3; i++) {
+        mu_assert(DArray_index(ring, i) == &values[2 * i + 1], "Incorrect value at %u after ring compact", i);
+    }
+
+    DArray_destroy(ring);
+
+    DArray_compact(NULL, &err);
+    mu_assert(err == DA_ERR_ARGS, "NULL darray compacted (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_dvarray_find_count(void)
+{
+    DVArray *ints = DVArray_init_with_pool(sizeof(int32_t), 8, 0.3, 2.0, 0, &err);
+    DVArray *longs = DVArray_init_with_pool(sizeof(int64_t), 8, 0.3, 2.0, 0, &err);
+    DVArray *triples = DVArray_init_with_pool(3, 8, 0.3, 2.0, 0, &err);
+
+    for(int i = 0; i < VALUE_COUNT; i++) {
+        int32_t i32 = i % 101;
+        int64_t i64 = (int64_t)(i % 101) << 33;
+        char triple[3] = { (char)(i % 101), 0, 1 };
+        DVArray_push(ints, &i32);
+        DVArray_push(longs, &i64);
+        DVArray_push(triples, triple);
+    }
+
+    for(int l = 0; l < level_count; l++) {
+        DArray_simd_set_level(levels[l]);
+
+        int32_t i32 = 100;
+        int64_t i64 = (int64_t)100 << 33;
+        char triple[3] = { 100, 0, 1 };
+        mu_assert(DVArray_find(ints, &i32) == 100 && DVArray_count(ints, &i32) == 9, "Incorrect int32 find (level %d)", levels[l]);
+        mu_assert(DVArray_find(longs, &i64) == 100 && DVArray_count(longs, &i64) == 9, "Incorrect int64 find (level %d)", levels[l]);
+        mu_assert(DVArray_find(triples, triple) == 100 && DVArray_count(triples, triple) == 9, "Incorrect memcmp find (level %d)", levels[l]);
+
+        i64 = 100;
+        mu_assert(DVArray_find(longs, &i64) == DA_NOT_FOUND && DVArray_count(longs, &i64) == 0, "Partial int64 matched (level %d)", levels[l]);
+    }
+
+    DVArray_destroy(ints);
+    DVArray_destroy(longs);
+    DVArray_destroy(triples);
+    return NULL;
+}
+
+static char *test_dvarray_reduce(void)
+{
+    DVArray *ints = DVArray_init_with_pool(sizeof(int32_t), 8, 0.3, 2.0, 0, &err);
+    DVArray *longs = DVArray_init_with_pool(sizeof(int64_t), 8, 0.3, 2.0, 0, &err);
+
+    int32_t min32, max32;
+    int64_t min64, max64, sum;
+    mu_assert(DVArray_minmax_i32(ints, &min32, &max32) == (DA_ERR_ARGS | DV_EMPTY), "Empty array has a minimum");
+    mu_assert(DVArray_sum_i32(ints, &sum) == 0 && sum == 0, "Incorrect sum of empty array");
+    mu_assert(DVArray_minmax_i32(longs, &min32, &max32) == DA_ERR_ARGS, "Mismatched elem_size allowed");
+
+    for(int i = 0; i < VALUE_COUNT; i++) {
+        int32_t i32 = (i * 7919) % 2003 - 1000;
+        int64_t i64 = (int64_t)i32 * 10000000000;
+        if(i == 617) {
+            i32 = INT32_MAX;
+            i64 = INT64_MIN;
+        }
+        DVArray_push(ints, &i32);
+        DVArray_push(longs, &i64);
+    }
+
+    DArray_simd_set_level(DA_SIMD_SCALAR);
+    int32_t ref_min32, ref_max32;
+    int64_t ref_min64, ref_max64, ref_sum32, ref_sum64;
+    DVArray_minmax_i32(ints, &ref_min32, &ref_max32);
+    DVArray_minmax_i64(longs, &ref_min64, &ref_max64);
+    DVArray_sum_i32(ints, &ref_sum32);
+    DVArray_sum_i64(longs, &ref_sum64);
+    mu_assert(ref_max32 == INT32_MAX && ref_min64 == INT64_MIN, "Incorrect scalar minmax");
+
+    for(int l = 0; l < level_count; l++) {
+        DArray_simd_set_level(levels[l]);
+
+        mu_assert(DVArray_minmax_i32(ints, &min32, &max32) == 0, "Error in int32 minmax");
+        mu_assert(min32 == ref_min32 && max32 == ref_max32, "Incorrect int32 minmax (level %d)", levels[l]);
+        mu_assert(DVArray_minmax_i64(longs, &min64, &max64) == 0, "Error in int64 minmax");
+        mu_assert(min64 == ref_min64 && max64 == ref_max64, "Incorrect int64 minmax (level %d)", levels[l]);
+        mu_assert(DVArray_sum_i32(ints, &sum) == 0 && sum == ref_sum32, "Incorrect int32 sum (level %d)", levels[l]);
+        mu_assert(DVArray_sum_i64(longs, &sum) == 0 && sum == ref_sum64, "Incorrect int64 sum (level %d)", levels[l]);
+    }
+
+    DVArray_destroy(ints);
+    DVArray_destroy(longs);
+    return NULL;
+}
+
+static char *test_dvarray_filter(void)
+{
+    for(int l = 0; l < level_count; l++) {
+        DArray_simd_set_level(levels[l]);
+
+        for(int op = DA_CMP_EQ; op <= DA_CMP_GE; op++) {
+            DVArray *ints = DVArray_init_with_pool(sizeof(int32_t), 8, 0.3, 2.0, 1, &err);
+            for(int32_t i = 0; i < VALUE_COUNT; i++) {
+                int32_t value = (i * 31) % 17 - 8;
+                DVArray_push(ints, &value);
+            }
+
+            uint32_t removed = DVArray_filter_i32(ints, op, 0, &err);
+            mu_assert(err == 0 && removed + ints->length == VALUE_COUNT, "Error in filter (%#04x)", err);
+
+            uint32_t index = 0;
+            for(int32_t i = 0; i < VALUE_COUNT; i++) {
+                int32_t value = (i * 31) % 17 - 8;
+                int keep = op == DA_CMP_EQ ? value == 0 : op == DA_CMP_NE ? value != 0 : op == DA_CMP_LT ? value < 0 :
+                           op == DA_CMP_LE ? value <= 0 : op == DA_CMP_GT ? value > 0 : value >= 0;
+                if(keep) {
+                    int32_t *kept = DVArray_index(ints, index++);
+                    mu_assert(kept != NULL && *kept == value, "Incorrect value after filter (level %d, op %d)", levels[l], op);
+                }
+            }
+            mu_assert(index == ints->length, "Incorrect length after filter (level %d, op %d)", levels[l], op);
+
+            DVArray_destroy(ints);
+        }
+    }
+
+    DVArray_filter_i32(NULL, DA_CMP_EQ, 0, &err);
+    mu_assert(err == DA_ERR_ARGS, "NULL dvarray filtered (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_levels);
+    mu_run_test(test_find_count);
+    mu_run_test(test_find_ring);
+    mu_run_test(test_compact);
+    mu_run_test(test_dvarray_find_count);
+    mu_run_test(test_dvarray_reduce);
+    mu_run_test(test_dvarray_filter);
+
+    DArray_simd_set_level(DA_SIMD_AVX512);
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,91 @@
+#include "darray.h"
+#include "darray_stats.h"
+#include "minunit.h"
+
+mu_suite_start();
+
+static int err;
+static int values[1000];
+
+static char *test_counters(void)
+{
+    DArrayStats stats;
+
+    DArray_stats_reset();
+    DArray *darray = DArray_init_with_pool(4, 0.3, 2.0, 1, &err);
+
+    for(int i = 0; i < 1000; i++) {
+        DArray_push(darray, &values[i]);
+    }
+    for(int i = 0; i < 500; i++) {
+        DArray_shift(darray, &err);
+    }
+    for(int i = 0; i < 400; i++) {
+        DArray_unshift(darray, &values[i]);
+    }
+    DArray_insert(darray, 10, &values[0]);
+
+    DArray_stats(&stats);
+    DArray_destroy(darray);
+
+    if(!DArray_stats_enabled()) {
+        for(int i = 0; i < DA_STAT_COUNT; i++) {
+            mu_assert(stats.counters[i] == 0, "Counter %s non-zero without DARRAY_STATS", DArray_stat_name(i));
+        }
+        return NULL;
+    }
+
+    mu_assert(stats.counters[DA_STAT_PUSH] == 1000, "Incorrect push count (%llu)", (unsigned long long)stats.counters[DA_STAT_PUSH]);
+    mu_assert(stats.counters[DA_STAT_SHIFT] == 500, "Incorrect shift count");
+    mu_assert(stats.counters[DA_STAT_UNSHIFT] == 400, "Incorrect unshift count");
+    mu_assert(stats.counters[DA_STAT_SPLICE] == 1, "Incorrect splice count");
+    mu_assert(stats.counters[DA_STAT_EXPAND] >= 8, "Expansions not counted");
+    mu_assert(stats.counters[DA_STAT_REALLOC] == stats.counters[DA_STAT_EXPAND], "Reallocations not counted");
+    mu_assert(stats.counters[DA_STAT_POOL_SHRINK] > 0 && stats.counters[DA_STAT_POOL_REBUILD] > 0, "Pool resizes not counted");
+    mu_assert(stats.counters[DA_STAT_MOVE] >= stats.counters[DA_STAT_POOL_REBUILD], "Moves not counted");
+    mu_assert(stats.counters[DA_STAT_BYTES_MOVED] > 0, "Bytes moved not counted");
+
+    if(DArray_stats_enabled() == 2) {
+        mu_assert(stats.latency[DA_TIMER_RESIZE].count == stats.counters[DA_STAT_EXPAND], "Resizes not timed");
+        mu_assert(stats.latency[DA_TIMER_MOVE].count == stats.counters[DA_STAT_MOVE], "Moves not timed");
+    }
+
+    DArray_stats_dump(&stats, stderr);
+    DArray_stats_reset();
+    DArray_stats(&stats);
+    mu_assert(stats.counters[DA_STAT_PUSH] == 0, "Counters not reset");
+
+    return NULL;
+}
+
+static char *test_percentile(void)
+{
+    DAHistogram histogram = {0};
+
+    mu_assert(DAHistogram_percentile(&histogram, 50.0) == 0, "Percentile of empty histogram");
+
+    // 90 values of 5, and 10 values in the bucket for 960-1023
+    histogram.count = 100;
+    histogram.max = 1000;
+    histogram.buckets[5] = 90;
+    histogram.buckets[63] = 10;
+
+    mu_assert(DAHistogram_percentile(&histogram, 50.0) == 5, "Incorrect 50th percentile");
+    mu_assert(DAHistogram_percentile(&histogram, 90.0) == 5, "Incorrect 90th percentile");
+    mu_assert(DAHistogram_percentile(&histogram, 99.0) == 1000, "Incorrect 99th percentile");
+    mu_assert(DAHistogram_percentile(&histogram, 0.0) == 5, "Incorrect 0th percentile");
+
+    histogram.max = 5000;
+    mu_assert(DAHistogram_percentile(&histogram, 99.0) == 1023, "Percentile not bucket bound");
+
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_counters);
+    mu_run_test(test_percentile);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
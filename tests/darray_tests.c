@@ -1,4 +1,5 @@
 #include "darray.h"
+#include "darray_sort.h"
 #include "minunit.h"
 
 mu_suite_start();
@@ -14,11 +15,11 @@ static char *test_init_with_pool(void)
         mu_assert(err != 0, "darray initialised to NULL with no error");
     }
 
-    mu_assert(darray->length == 0, "Initial darray length != 0 (was %d)", darray->length);
-    mu_assert(darray->max_pool_size > 0, "max_pool_size set incorrectly (was %lf, should be %lf)", darray->max_pool_size, 0.1);
-    mu_assert(darray->expand_rate > 1, "expand_rate set incorrectly (was %lf, should be %lf)", darray->expand_rate, 1.5);
-    mu_assert(darray->start_index == 2, "start_index set incorrectly (was %d, should be %d)", darray->start_index, 2);
-    mu_assert(darray->store_size == 10, "store_size set incorrectly (was %d, should be %d)", darray->store_size, 10);
+    mu_assert(darray->length == 0, "Initial darray length != 0 (was %" PRIuDA ")", darray->length);
+    mu_assert(DArray_max_pool_size(darray) > 0, "max_pool_size set incorrectly (was %lf, should be %lf)", DArray_max_pool_size(darray), 0.1);
+    mu_assert(DArray_expand_rate(darray) > 1, "expand_rate set incorrectly (was %lf, should be %lf)", DArray_expand_rate(darray), 1.5);
+    mu_assert(darray->start_index == 2, "start_index set incorrectly (was %" PRIuDA ", should be %d)", darray->start_index, 2);
+    mu_assert(darray->store_size == 10, "store_size set incorrectly (was %" PRIuDA ", should be %d)", darray->store_size, 10);
 
     for(int i = 0; i < 10; i++) {
         mu_assert(darray->items[i] == 0, "items[%d] not initialised to 0", i);
@@ -33,27 +34,13 @@ static char *test_init_without_pool(void)
 {
     darray = DArray_init_with_pool(10, 0.0, 1.5, 0, &err);
 
-    mu_assert(darray->start_index == 0, "start_index set incorrectly for no pool (was %d)", darray->start_index);
+    mu_assert(darray->start_index == 0, "start_index set incorrectly for no pool (was %" PRIuDA ")", darray->start_index);
 
     DArray_destroy(darray);
     err = 0;
     return NULL;
 }
 
-#if 0
-I thought there was something to test here, but either I've forgotten or there never was.
-static char *test_destroy(void)
-{
-    darray = DArray_init_with_pool(10, 0.1, 1.5, 2, &err);
-
-
-
-    DArray_destroy(darray);
-    err = 0;
-    return NULL;
-}
-#endif
-
 static char *test_index_with_pool(void)
 {
     darray = DArray_init_with_pool(10, 0.3, 1.5, 2, &err);
@@ -65,10 +52,12 @@ static char *test_index_with_pool(void)
     darray->items[2] = &a;
     darray->items[3] = &b;
     darray->items[4] = &c;
+    darray->length = 3;
 
     mu_assert(DArray_index(darray, 0) == &a, "Incorrect value indexed (a)");
     mu_assert(DArray_index(darray, 1) == &b, "Incorrect value indexed (b)");
     mu_assert(DArray_index(darray, 2) == &c, "Incorrect value indexed (c)");
+    mu_assert(DArray_index(darray, 3) == NULL, "Value indexed past length");
 
     DArray_destroy(darray);
     err = 0;
@@ -86,10 +75,12 @@ static char *test_index_without_pool(void)
     darray->items[0] = &a;
     darray->items[1] = &b;
     darray->items[2] = &c;
+    darray->length = 3;
 
     mu_assert(DArray_index(darray, 0) == &a, "Incorrect value indexed (a)");
     mu_assert(DArray_index(darray, 1) == &b, "Incorrect value indexed (b)");
     mu_assert(DArray_index(darray, 2) == &c, "Incorrect value indexed (c)");
+    mu_assert(DArray_index(darray, 3) == NULL, "Value indexed past length");
 
     DArray_destroy(darray);
     err = 0;
@@ -103,7 +94,7 @@ static char *test_expand(void)
     // TODO: Try to find a way to verify the expansion has taken place
     err = DArray_expand(darray);
 
-    mu_assert(darray->store_size == (int)(10 * 1.5) && err == 0, "store_size set incorrectly after expand (was %d, should be %d)", darray->store_size, (int)(10 * 1.5));
+    mu_assert(darray->store_size == (int)(10 * 1.5) && err == 0, "store_size set incorrectly after expand (was %" PRIuDA ", should be %d)", darray->store_size, (int)(10 * 1.5));
 
     DArray_destroy(darray);
     err = 0;
@@ -121,19 +112,20 @@ static char *test_move_with_pool(void)
     darray->items[2] = &a;
     darray->items[3] = &b;
     darray->items[4] = &c;
+    darray->length = 3;
 
     err = DArray_move(darray, 1);
-    mu_assert(err != 0, "Error in move +1 (%#04x)", err);
+    mu_assert(err == 0, "Error in move +1 (%#04x)", err);
 
-    mu_assert(darray->start_index == 3, "start_index incorrect after move +1 (was %d, should be %d)",  darray->start_index, 3);
+    mu_assert(darray->start_index == 3, "start_index incorrect after move +1 (was %" PRIuDA ", should be %d)",  darray->start_index, 3);
     mu_assert(darray->items[3] == &a, "incorrect value for index 3 after move +1");
     mu_assert(darray->items[4] == &b, "incorrect value for index 4 after move +1");
     mu_assert(darray->items[5] == &c, "incorrect value for index 5 after move +1");
 
     err = DArray_move(darray, -2);
-    mu_assert(err != 0, "Error in move +1, -2 (%#04x)", err);
+    mu_assert(err == 0, "Error in move +1, -2 (%#04x)", err);
 
-    mu_assert(darray->start_index == 1, "start_index incorrect after move +1, -2 (was %d, should be %d)",  darray->start_index, 1);
+    mu_assert(darray->start_index == 1, "start_index incorrect after move +1, -2 (was %" PRIuDA ", should be %d)",  darray->start_index, 1);
     mu_assert(darray->items[1] == &a, "incorrect value for index 1 after move +1, -2");
     mu_assert(darray->items[2] == &b, "incorrect value for index 2 after move +1, -2");
     mu_assert(darray->items[3] == &c, "incorrect value for index 3 after move +1, -2");
@@ -154,16 +146,18 @@ static char *test_move_without_pool(void)
     darray->items[0] = &a;
     darray->items[1] = &b;
     darray->items[2] = &c;
+    darray->length = 3;
 
+    // There is no pool to move into
     err = DArray_move(darray, -1);
-    mu_assert(err != 0, "Error in move -1 without pool (%#04x)", err);
+    mu_assert(err == (DA_ERR_ARGS | DA_MOVE_RANGE), "Move -1 without pool allowed (%#04x)", err);
 
-    mu_assert(darray->start_index == 0, "start_index incorrect after move -1 without pool (was %d)", darray->start_index);
+    mu_assert(darray->start_index == 0, "start_index incorrect after move -1 without pool (was %" PRIuDA ")", darray->start_index);
 
     err = DArray_move(darray, 1);
-    mu_assert(err != 0, "Error in move +1 without pool (%#04x)", err);
+    mu_assert(err == 0, "Error in move +1 without pool (%#04x)", err);
 
-    mu_assert(darray->start_index == 1, "start_index incorrect after move +1 without pool (was %d)", darray->start_index);
+    mu_assert(darray->start_index == 1, "start_index incorrect after move +1 without pool (was %" PRIuDA ")", darray->start_index);
     mu_assert(darray->items[0] == NULL, "items[0] not NULL after move +1 without pool");
     mu_assert(darray->items[1] == &a, "incorrect value for index 1 after move +1, -2");
     mu_assert(darray->items[2] == &b, "incorrect value for index 2 after move +1, -2");
@@ -183,11 +177,11 @@ static char *test_push(void)
     int c = 0;
 
     err = DArray_push(darray, &a);
-    mu_assert(err != 0, "Error in push without pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push without pool (%#04x)", err);
     err = DArray_push(darray, &b);
-    mu_assert(err != 0, "Error in push without pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push without pool (%#04x)", err);
     err = DArray_push(darray, &c);
-    mu_assert(err != 0, "Error in push without pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push without pool (%#04x)", err);
 
     mu_assert(DArray_index(darray, 0) == &a, "Incorrect value pushed for a, index 0");
     mu_assert(DArray_index(darray, 1) == &b, "Incorrect value pushed for b, index 1");
@@ -207,11 +201,11 @@ static char *test_push_with_pool(void)
     int c = 0;
 
     err = DArray_push(darray, &a);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
     err = DArray_push(darray, &b);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
     err = DArray_push(darray, &c);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
 
     mu_assert(DArray_index(darray, 0) == &a, "Incorrect value pushed for a, index 0 with pool");
     mu_assert(DArray_index(darray, 1) == &b, "Incorrect value pushed for b, index 1 with pool");
@@ -231,11 +225,11 @@ static char *test_pop(void)
     int c = 0;
 
     err = DArray_push(darray, &a);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
     err = DArray_push(darray, &b);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
     err = DArray_push(darray, &c);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
 
     mu_assert(DArray_pop(darray) == &c, "Incorrect value popped for c");
     mu_assert(DArray_pop(darray) == &b, "Incorrect value popped for b");
@@ -255,16 +249,17 @@ static char *test_unshift_with_pool(void)
     int c = 2;
 
     err = DArray_unshift(darray, &a);
-    mu_assert(err != 0, "Error in unshift with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in unshift with pool (%#04x)", err);
     err = DArray_unshift(darray, &b);
-    mu_assert(err != 0, "Error in unshift with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in unshift with pool (%#04x)", err);
     err = DArray_unshift(darray, &c);
-    mu_assert(err != 0, "Error in unshift with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in unshift with pool (%#04x)", err);
 
-    mu_assert(darray->start_index == 0, "start_index set incorrectly after shifts (was %d, should be %d)", darray->start_index, 0);
-    mu_assert(DArray_index(darray, 0) == &a, "Incorrect value unshifted for a, index 0 with pool");
+    mu_assert(darray->start_index == 0, "start_index set incorrectly after shifts (was %" PRIuDA ", should be %d)", darray->start_index, 0);
+    // Each unshift goes in front of the last, so the values end up reversed
+    mu_assert(DArray_index(darray, 0) == &c, "Incorrect value unshifted for c, index 0 with pool");
     mu_assert(DArray_index(darray, 1) == &b, "Incorrect value unshifted for b, index 1 with pool");
-    mu_assert(DArray_index(darray, 2) == &c, "Incorrect value unshifted for c, index 2 with pool");
+    mu_assert(DArray_index(darray, 2) == &a, "Incorrect value unshifted for a, index 2 with pool");
 
     DArray_destroy(darray);
     err = 0;
@@ -280,16 +275,17 @@ static char *test_unshift_without_pool(void)
     int c = 2;
 
     err = DArray_unshift(darray, &a);
-    mu_assert(err != 0, "Error in unshift with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in unshift with pool (%#04x)", err);
     err = DArray_unshift(darray, &b);
-    mu_assert(err != 0, "Error in unshift with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in unshift with pool (%#04x)", err);
     err = DArray_unshift(darray, &c);
-    mu_assert(err != 0, "Error in unshift with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in unshift with pool (%#04x)", err);
 
-    mu_assert(darray->start_index == 0, "start_index set incorrectly after unshifts (was %d, should be %d)", darray->start_index, 0);
-    mu_assert(DArray_index(darray, 0) == &a, "Incorrect value unshifted for a, index 0 with pool");
+    mu_assert(darray->start_index == 0, "start_index set incorrectly after unshifts (was %" PRIuDA ", should be %d)", darray->start_index, 0);
+    // Each unshift goes in front of the last, so the values end up reversed
+    mu_assert(DArray_index(darray, 0) == &c, "Incorrect value unshifted for c, index 0 with pool");
     mu_assert(DArray_index(darray, 1) == &b, "Incorrect value unshifted for b, index 1 with pool");
-    mu_assert(DArray_index(darray, 2) == &c, "Incorrect value unshifted for c, index 2 with pool");
+    mu_assert(DArray_index(darray, 2) == &a, "Incorrect value unshifted for a, index 2 with pool");
 
     DArray_destroy(darray);
     err = 0;
@@ -298,31 +294,745 @@ static char *test_unshift_without_pool(void)
 
 static char *test_shift_with_pool(void)
 {
-    darray = DArray_init_with_pool(10, 0.1, 1.5, 2, &err);
+    // 10 slots at max_pool_size 0.5 allow a pool of 5, so these shifts only grow the pool
+    darray = DArray_init_with_pool(10, 0.5, 1.5, 2, &err);
 
     int a = 0;
     int b = 0;
     int c = 0;
 
     err = DArray_push(darray, &a);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
     err = DArray_push(darray, &b);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
     err = DArray_push(darray, &c);
-    mu_assert(err != 0, "Error in push with pool (%#04x)", err);
+    mu_assert(err == 0, "Error in push with pool (%#04x)", err);
+
+    mu_assert(DArray_shift(darray, &err) == &a && err == 0, "Incorrect value shifted for a with pool");
+    mu_assert(darray->start_index == 3, "start_index set incorrectly after shift (was %" PRIuDA ", should be %d)", darray->start_index, 3);
+    mu_assert(DArray_shift(darray, &err) == &b && err == 0, "Incorrect value shifted for b with pool");
+    mu_assert(darray->start_index == 4, "start_index set incorrectly after shift (was %" PRIuDA ", should be %d)", darray->start_index, 4);
+    mu_assert(DArray_shift(darray, &err) == &c && err == 0, "Incorrect value shifted for c with pool");
+    mu_assert(darray->start_index == 5, "start_index set incorrectly after shift (was %" PRIuDA ", should be %d)", darray->start_index, 5);
+    mu_assert(DArray_shift(darray, &err) == NULL && err == 0, "Value shifted from empty darray");
+
+    DArray_destroy(darray);
+
+    // At max_pool_size 0.1 the pool may hold 1 value; past that, a shift moves the values back
+    darray = DArray_init_with_pool(10, 0.1, 1.5, 2, &err);
+    DArray_push(darray, &a);
+    DArray_push(darray, &b);
 
-    mu_assert(DArray_shift(darray, &err) == &a, "Incorrect value shifted for a with pool");
-    mu_assert(darray->start_index == 1, "start_index set incorrectly after shift (was %d, should be %d)", darray->start_index, 1);
-    mu_assert(DArray_shift(darray, &err) == &b, "Incorrect value shifted for b with pool");
-    mu_assert(darray->start_index == 2, "start_index set incorrectly after shift (was %d, should be %d)", darray->start_index, 2);
-    mu_assert(DArray_shift(darray, &err) == &c, "Incorrect value shifted for c with pool");
-    mu_assert(darray->start_index == 3, "start_index set incorrectly after shift (was %d, should be %d)", darray->start_index, 3);
+    mu_assert(DArray_shift(darray, &err) == &a && err == 0, "Incorrect value shifted for a with small pool");
+    mu_assert(darray->start_index == 0 && DArray_index(darray, 0) == &b, "Pool not shrunk by shift (start_index %" PRIuDA ")", darray->start_index);
 
     DArray_destroy(darray);
     err = 0;
     return NULL;
 }
 
+static int compare_ints(void *val1, void *val2)
+{
+    return *(int *)val1 - *(int *)val2;
+}
+
+#define LESS_INTS(a, b) (*(int *)(a) < *(int *)(b))
+DARRAY_QSORT_DEFINE(sort_ints, LESS_INTS)
+
+static char *test_qsort(void)
+{
+    darray = DArray_init_with_pool(1000, 0.3, 1.5, 3, &err);
+
+    static int values[900];
+    for(int i = 0; i < 900; i++) {
+        values[i] = (i * 7919) % 211;
+        darray->items[3 + i] = &values[i];
+    }
+    darray->length = 900;
+
+    DArray_qsort(darray, compare_ints);
+
+    mu_assert(darray->items[2] == NULL, "qsort wrote into the pool");
+    for(uint32_t i = 1; i < darray->length; i++) {
+        mu_assert(*(int *)DArray_index(darray, i - 1) <= *(int *)DArray_index(darray, i), "Values out of order after qsort at index %d", i);
+    }
+
+    // Reverse the sorted values so the inline sort does real work
+    for(uint32_t i = 0; i < darray->length / 2; i++) {
+        void *tmp = darray->items[3 + i];
+        darray->items[3 + i] = darray->items[3 + darray->length - 1 - i];
+        darray->items[3 + darray->length - 1 - i] = tmp;
+    }
+
+    sort_ints(darray);
+
+    for(uint32_t i = 1; i < darray->length; i++) {
+        mu_assert(*(int *)DArray_index(darray, i - 1) <= *(int *)DArray_index(darray, i), "Values out of order after inline sort at index %d", i);
+    }
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_ring(void)
+{
+    darray = DArray_init_ring(4, 1.5, &err);
+    mu_assert(darray != NULL && err == 0, "Error in ring init (%#04x)", err);
+
+    int values[6] = {0, 1, 2, 3, 4, 5};
+
+    DArray_push(darray, &values[0]);
+    DArray_push(darray, &values[1]);
+    DArray_push(darray, &values[2]);
+    mu_assert(DArray_shift(darray, &err) == &values[0] && err == 0, "Incorrect value shifted from ring");
+    mu_assert(DArray_shift(darray, &err) == &values[1] && err == 0, "Incorrect value shifted from ring");
+
+    // Wraps around the end of the store without moving anything
+    DArray_push(darray, &values[3]);
+    DArray_push(darray, &values[4]);
+    mu_assert(darray->start_index == 2, "start_index moved in ring (was %" PRIuDA ", should be %d)", darray->start_index, 2);
+    mu_assert(darray->items[0] == &values[4], "Push did not wrap around the ring");
+
+    err = DArray_unshift(darray, &values[1]);
+    mu_assert(err == 0 && darray->start_index == 1, "Unshift into ring failed (%#04x)", err);
+
+    // Full ring; the next push expands and rejoins the wrapped values
+    err = DArray_push(darray, &values[5]);
+    mu_assert(err == 0 && darray->store_size == 6, "Ring push with expand failed (%#04x)", err);
+
+    for(uint32_t i = 0; i < 5; i++) {
+        mu_assert(DArray_index(darray, i) == &values[i + 1], "Incorrect value at ring index %d", i);
+    }
+
+    mu_assert(DArray_move(darray, 1) == (DA_ERR_ARGS | DA_MOVE_RING), "Move allowed on ring");
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_linearise(void)
+{
+    darray = DArray_init_ring(5, 1.5, &err);
+
+    int values[4] = {0, 1, 2, 3};
+
+    DArray_push(darray, &values[2]);
+    DArray_push(darray, &values[3]);
+    DArray_unshift(darray, &values[1]);
+    DArray_unshift(darray, &values[0]);
+    mu_assert(darray->start_index + darray->length > darray->store_size, "Ring did not wrap");
+
+    err = DArray_linearise(darray);
+    mu_assert(err == 0, "Error in linearise (%#04x)", err);
+    mu_assert(darray->start_index + darray->length <= darray->store_size, "Ring still wraps after linearise");
+
+    for(uint32_t i = 0; i < 4; i++) {
+        mu_assert(darray->items[darray->start_index + i] == &values[i], "Incorrect value at index %d after linearise", i);
+    }
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_push_n_pop_n(void)
+{
+    darray = DArray_init_with_pool(4, 0.3, 1.5, 1, &err);
+
+    int values[50];
+    void *in[50];
+    void *out[50];
+    for(int i = 0; i < 50; i++) {
+        in[i] = &values[i];
+    }
+
+    // One expansion covers the whole batch
+    err = DArray_push_n(darray, in, 50);
+    mu_assert(err == 0, "Error in push_n (%#04x)", err);
+    mu_assert(darray->length == 50 && darray->store_size == 51, "Incorrect length/store_size after push_n (%" PRIuDA "/%" PRIuDA ")", darray->length, darray->store_size);
+
+    DArraySize count = DArray_pop_n(darray, out, 10);
+    mu_assert(count == 10, "Incorrect count popped (was %" PRIuDA ", should be %d)", count, 10);
+    for(int i = 0; i < 10; i++) {
+        mu_assert(out[i] == &values[40 + i], "Incorrect value popped at %d", i);
+    }
+
+    count = DArray_pop_n(darray, NULL, 100);
+    mu_assert(count == 40 && darray->length == 0, "pop_n did not empty array (popped %" PRIuDA ")", count);
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_unshift_n_shift_n(void)
+{
+    darray = DArray_init_with_pool(10, 0.3, 1.5, 2, &err);
+
+    int values[8];
+    void *in[8];
+    void *out[8];
+    for(int i = 0; i < 8; i++) {
+        in[i] = &values[i];
+    }
+
+    DArray_push(darray, &values[7]);
+    err = DArray_unshift_n(darray, in, 7);
+    mu_assert(err == 0, "Error in unshift_n (%#04x)", err);
+
+    for(uint32_t i = 0; i < 8; i++) {
+        mu_assert(DArray_index(darray, i) == &values[i], "Incorrect value at index %d after unshift_n", i);
+    }
+
+    DArraySize count = DArray_shift_n(darray, out, 5, &err);
+    mu_assert(count == 5 && err == 0, "Error in shift_n (%#04x)", err);
+    for(int i = 0; i < 5; i++) {
+        mu_assert(out[i] == &values[i], "Incorrect value shifted at %d", i);
+    }
+    mu_assert(DArray_index(darray, 0) == &values[5], "Incorrect first value after shift_n");
+
+    count = DArray_shift_n(NULL, out, 5, &err);
+    mu_assert(count == 0 && err == DA_ERR_ARGS, "shift_n on NULL darray shifted %" PRIuDA " (%#04x)", count, err);
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_splice(void)
+{
+    darray = DArray_init_with_pool(20, 0.5, 1.5, 5, &err);
+
+    int values[12];
+    void *in[12];
+    for(int i = 0; i < 12; i++) {
+        in[i] = &values[i];
+    }
+
+    DArray_push_n(darray, in, 10);
+
+    // Head is the shorter side, so it moves into the pool
+    err = DArray_insert(darray, 2, &values[10]);
+    mu_assert(err == 0 && darray->start_index == 4, "Insert near head did not use pool (start_index %" PRIuDA ")", darray->start_index);
+    mu_assert(DArray_index(darray, 2) == &values[10] && DArray_index(darray, 3) == &values[2], "Incorrect values after insert");
+
+    void *removed[3];
+    err = DArray_splice(darray, 6, 3, removed, &in[11], 1);
+    mu_assert(err == 0 && darray->length == 9, "Error in splice (%#04x)", err);
+    mu_assert(removed[0] == &values[5] && removed[2] == &values[7], "Incorrect values removed by splice");
+    mu_assert(DArray_index(darray, 6) == &values[11] && DArray_index(darray, 7) == &values[8], "Incorrect values after splice");
+
+    err = DArray_splice(darray, 8, 2, NULL, NULL, 0);
+    mu_assert(err == (DA_ERR_ARGS | DA_SPLICE_RANGE), "Splice past end allowed (%#04x)", err);
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+// Allocator which fails every request while fail_alloc is set
+static int fail_alloc = 0;
+
+static void *failing_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+    return fail_alloc ? NULL : malloc(size);
+}
+
+static void *failing_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    (void)ctx;
+    (void)old_size;
+    return fail_alloc ? NULL : realloc(ptr, new_size);
+}
+
+static void failing_free(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    (void)size;
+    free(ptr);
+}
+
+static char *test_splice_failed_grow(void)
+{
+    Allocator failing = { failing_alloc, failing_realloc, failing_free, NULL, NULL };
+    int values[14];
+    void *in[14];
+    for(int i = 0; i < 14; i++) {
+        in[i] = &values[i];
+    }
+
+    // Full stores, so growing the tail side, or a ring at all, must expand
+    for(int ring = 0; ring < 2; ring++) {
+        darray = DArray_init_with_allocator(10, 0.0, 1.5, 0, ring ? DA_FLAG_RING : 0, &failing, &err);
+        mu_assert(darray != NULL && err == 0, "Error in init with failing allocator (%#04x)", err);
+        DArray_push_n(darray, in, 10);
+
+        fail_alloc = 1;
+        void *removed[2] = { NULL, NULL };
+        err = DArray_splice(darray, ring ? 2 : 5, 2, removed, &in[10], 4);
+        mu_assert(err == da_chain(DA_SPLICE_EXPAND, DA_ERR_MEMORY | DA_EXPAND_REALLOC), "Splice did not fail to grow (%#04x)", err);
+        mu_assert(removed[0] == NULL && removed[1] == NULL, "Failed splice removed values");
+
+        err = DArray_insert(darray, ring ? 1 : 8, &values[13]);
+        mu_assert(err == da_chain(DA_SPLICE_EXPAND, DA_ERR_MEMORY | DA_EXPAND_REALLOC), "Insert did not fail to grow (%#04x)", err);
+        fail_alloc = 0;
+
+        mu_assert(darray->length == 10, "Failed splice changed length (%" PRIuDA ")", darray->length);
+        for(uint32_t i = 0; i < 10; i++) {
+            mu_assert(DArray_index(darray, i) == &values[i], "Failed splice changed value at %d", i);
+        }
+
+        DArray_destroy(darray);
+    }
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_reserve_shrink(void)
+{
+    darray = DArray_init_with_pool(10, 0.5, 1.5, 2, &err);
+
+    err = DArray_reserve(darray, 1000);
+    mu_assert(err == 0 && darray->store_size == 1002, "Incorrect store_size after reserve (was %" PRIuDA ", should be %d)", darray->store_size, 1002);
+
+    err = DArray_reserve_front(darray, 20);
+    mu_assert(err == 0 && darray->start_index == 20, "Incorrect start_index after reserve_front (was %" PRIuDA ", should be %d)", darray->start_index, 20);
+
+    int values[10];
+    for(int i = 0; i < 10; i++) {
+        DArray_push(darray, &values[i]);
+    }
+
+    err = DArray_shrink_to_fit(darray);
+    mu_assert(err == 0, "Error in shrink_to_fit (%#04x)", err);
+    mu_assert(darray->start_index == 5 && darray->store_size == 15, "Incorrect layout after shrink_to_fit (start_index %" PRIuDA ", store_size %" PRIuDA ")", darray->start_index, darray->store_size);
+
+    for(uint32_t i = 0; i < 10; i++) {
+        mu_assert(DArray_index(darray, i) == &values[i], "Incorrect value at index %d after shrink_to_fit", i);
+    }
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_mapped_growth(void)
+{
+    darray = DArray_init_ring(16, 2, &err);
+    darray->map_threshold = 1024;
+
+    static int values[5000];
+    for(int i = 0; i < 5000; i++) {
+        err = i % 3 == 0 ? DArray_unshift(darray, &values[i]) : DArray_push(darray, &values[i]);
+        mu_assert(err == 0, "Error growing mapped DArray (%#04x)", err);
+    }
+
+#ifdef __linux__
+    mu_assert(darray->flags & DA_FLAG_MAPPED, "DArray past map_threshold not mapped");
+#endif
+
+    for(uint32_t i = 0; i < 5000; i++) {
+        void *expected = i < 1667 ? &values[(1666 - i) * 3] : &values[i - 1667 + (i - 1667) / 2 + 1];
+        mu_assert(DArray_index(darray, i) == expected, "Incorrect value at index %d in mapped DArray", i);
+    }
+
+    DArraySize removed = DArray_pop_n(darray, NULL, 4000);
+    mu_assert(removed == 4000, "Incorrect number of values popped (%" PRIuDA ")", removed);
+
+    err = DArray_shrink_to_fit(darray);
+    mu_assert(err == 0 && darray->store_size == 1000, "Error shrinking mapped DArray (%#04x)", err);
+    mu_assert(DArray_index(darray, 999) == &values[2001], "Incorrect value after shrinking mapped DArray");
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_sorted_search(void)
+{
+    darray = DArray_init_with_pool(8, 0.3, 2.0, 0, &err);
+
+    // Every even number from 0 to 98, each twice
+    static int values[100];
+    for(int i = 0; i < 100; i++) {
+        values[i] = (i / 2) * 2;
+        DArray_push(darray, &values[i]);
+    }
+
+    for(int key = -1; key <= 100; key++) {
+        uint32_t lower = key < 0 ? 0 : (uint32_t)((key + 1) / 2) * 2;
+        uint32_t upper = key < 0 ? 0 : key >= 98 ? 100 : (uint32_t)(key / 2 + 1) * 2;
+        mu_assert(DArray_lower_bound(darray, &key, compare_ints) == lower, "Incorrect lower bound of %d", key);
+        mu_assert(DArray_upper_bound(darray, &key, compare_ints) == upper, "Incorrect upper bound of %d", key);
+        DArraySize found = DArray_bsearch(darray, &key, compare_ints);
+        mu_assert(found == ((key >= 0 && key <= 98 && key % 2 == 0) ? lower : DA_NOT_FOUND), "Incorrect bsearch of %d", key);
+    }
+
+    DArray_destroy(darray);
+
+    // Sorted inserts at the front should rebuild and then use the pool, not move the tail
+    darray = DArray_init_with_pool(64, 0.5, 2.0, 0, &err);
+    static int inserted[60];
+    for(int i = 0; i < 60; i++) {
+        inserted[i] = (i * 37) % 60;
+        err = DArray_insert_sorted(darray, &inserted[i], compare_ints);
+        mu_assert(err == 0, "Error in insert_sorted (%#04x)", err);
+    }
+    for(uint32_t i = 0; i < 60; i++) {
+        mu_assert(*(int *)DArray_index(darray, i) == (int)i, "Incorrect value at %u after insert_sorted", i);
+    }
+
+    int small = -1;
+    DArraySize start = darray->start_index;
+    err = DArray_insert_sorted(darray, &small, compare_ints);
+    mu_assert(err == 0 && DArray_index(darray, 0) == &small, "Error inserting at front (%#04x)", err);
+    mu_assert(start == 0 || darray->start_index == start - 1, "Front insert did not use the pool");
+
+    // Equal values go after those already present
+    int dup = 30;
+    err = DArray_insert_sorted(darray, &dup, compare_ints);
+    mu_assert(err == 0 && DArray_index(darray, 32) == &dup, "Equal value not inserted after existing ones");
+
+    err = DArray_insert_sorted(NULL, &dup, compare_ints);
+    mu_assert(err == DA_ERR_ARGS, "Insert into NULL darray allowed (%#04x)", err);
+
+    DArray_destroy(darray);
+
+    // Searches follow the values round a ring
+    darray = DArray_init_ring(16, 2.0, &err);
+    for(int i = 0; i < 10; i++) {
+        DArray_push(darray, &values[0]);
+        DArray_shift(darray, NULL);
+    }
+    for(int i = 0; i < 14; i++) {
+        err = DArray_insert_sorted(darray, &values[(i * 5) % 14], compare_ints);
+        mu_assert(err == 0, "Error in ring insert_sorted (%#04x)", err);
+    }
+    for(uint32_t i = 1; i < darray->length; i++) {
+        mu_assert(*(int *)DArray_index(darray, i - 1) <= *(int *)DArray_index(darray, i), "Ring out of order at %u after insert_sorted", i);
+    }
+    int key = 6;
+    mu_assert(DArray_bsearch(darray, &key, compare_ints) == 6, "Incorrect bsearch in ring");
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_tuning(void)
+{
+    // Steady growth raises the expansion rate
+    darray = DArray_init_with_pool(16, 0.3, 1.5, 0, &err);
+    err = DArray_enable_tuning(darray, 1.25, 2.0, 0.0, 0.5);
+    mu_assert(err == 0 && darray->tuning != NULL, "Error enabling tuning (%#04x)", err);
+    for(int i = 0; i < 100000; i++) {
+        DArray_push(darray, &err);
+    }
+    mu_assert(DArray_expand_rate(darray) > 1.9 && DArray_expand_rate(darray) <= 2.0, "expand_rate not raised by growth (was %f)", DArray_expand_rate(darray));
+
+    // Churn around a slowly rising length lowers it
+    for(int i = 0; i < 2000000; i++) {
+        if(i % 5 < 3) {
+            DArray_push(darray, &err);
+        } else {
+            DArray_pop(darray);
+        }
+    }
+    mu_assert(DArray_expand_rate(darray) < 1.5 && DArray_expand_rate(darray) >= 1.25, "expand_rate not lowered by churn (was %f)", DArray_expand_rate(darray));
+    DArray_destroy(darray);
+
+    // Unshifts which keep rebuilding an empty pool widen it
+    darray = DArray_init_with_pool(16, 0.0, 2.0, 0, &err);
+    DArray_enable_tuning(darray, 1.25, 2.0, 0.0, 0.5);
+    for(int i = 0; i < 10000; i++) {
+        err = DArray_unshift(darray, &err);
+        mu_assert(err == 0, "Error in tuned unshift (%#04x)", err);
+    }
+    mu_assert(DArray_max_pool_size(darray) > 0.25 && DArray_max_pool_size(darray) <= 0.5, "Pool not widened by unshifts (was %f)", DArray_max_pool_size(darray));
+    DArray_destroy(darray);
+
+    // Draining from the front with no unshifts leaves the pool idle, so it is narrowed
+    darray = DArray_init_with_pool(16, 0.5, 2.0, 0, &err);
+    DArray_enable_tuning(darray, 1.25, 2.0, 0.0, 0.5);
+    for(int i = 0; i < 10000; i++) {
+        DArray_push(darray, &err);
+    }
+    while(darray->length > 0) {
+        mu_assert(DArray_shift(darray, &err) == &err && err == 0, "Error in tuned shift (%#04x)", err);
+    }
+    mu_assert(DArray_max_pool_size(darray) < 0.5, "Idle pool not narrowed (was %f)", DArray_max_pool_size(darray));
+
+    // Parameters are clamped into the bounds, and bounds are checked
+    err = DArray_enable_tuning(darray, 3.0, 4.0, 0.6, 0.8);
+    mu_assert(err == 0 && DArray_expand_rate(darray) == 3.0 && darray->max_pool_size == DA_FIXED(0.6), "Parameters not clamped (%#04x)", err);
+    err = DArray_enable_tuning(darray, 1.0, 2.0, 0.0, 0.5);
+    mu_assert(err == (DA_ERR_ARGS | DA_TUNING_BOUNDS), "expand_rate bound of 1 allowed (%#04x)", err);
+    err = DArray_enable_tuning(darray, 1.5, 2.0, 0.5, 0.2);
+    mu_assert(err == (DA_ERR_ARGS | DA_TUNING_BOUNDS), "Reversed pool bounds allowed (%#04x)", err);
+
+    DArray_disable_tuning(darray);
+    mu_assert(darray->tuning == NULL && DArray_expand_rate(darray) == 3.0, "Error disabling tuning");
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_from_buffer_detach_swap(void)
+{
+    static int values[100];
+    DArraySize length = 0;
+    DArraySize store_size = 0;
+
+    // An adopted store keeps its values in place and is grown like any other
+    void **items = malloc(8 * sizeof(void *));
+    for(int i = 0; i < 5; i++) {
+        items[i] = &values[i];
+    }
+    darray = DArray_from_buffer(items, 5, 8, 0.3, 2.0, 0, NULL, &err);
+    mu_assert(darray != NULL && err == 0, "Error adopting buffer (%#04x)", err);
+    mu_assert(darray->items == items && darray->length == 5 && DArray_index(darray, 4) == &values[4], "Buffer copied");
+    mu_assert(items[5] == NULL && items[7] == NULL, "Unused slots not cleared");
+    for(int i = 5; i < 20; i++) {
+        DArray_push(darray, &values[i]);
+    }
+    DArray_unshift(darray, &values[99]);
+    DArray_shift(darray, &err);
+    DArray_shift(darray, &err);
+
+    // Detaching moves the values to the start of the store and frees the array
+    items = DArray_detach(darray, &length, &store_size, &err);
+    mu_assert(items != NULL && err == 0, "Error detaching (%#04x)", err);
+    mu_assert(length == 19 && store_size >= 19, "Incorrect detached length (%" PRIuDA " of %" PRIuDA ")", length, store_size);
+    for(uint32_t i = 0; i < length; i++) {
+        mu_assert(items[i] == &values[i + 1], "Incorrect detached value at %u", i);
+    }
+
+    // A wrapped ring is linearised first
+    darray = DArray_from_buffer(items, length, store_size, 0.0, 2.0, DA_FLAG_RING, NULL, &err);
+    for(int i = 0; i < 10; i++) {
+        DArray_shift(darray, &err);
+    }
+    for(int i = 20; i < 40; i++) {
+        DArray_push(darray, &values[i]);
+    }
+    mu_assert(darray->items == items && darray->start_index + darray->length > darray->store_size, "Ring not wrapped");
+    items = DArray_detach(darray, &length, &store_size, &err);
+    mu_assert(items != NULL && length == 29, "Error detaching ring (%#04x)", err);
+    for(uint32_t i = 0; i < length; i++) {
+        mu_assert(items[i] == &values[i + 11], "Incorrect detached ring value at %u", i);
+    }
+    free(items);
+
+    // A mapped store is copied out of its mapping
+    darray = DArray_init_with_pool(16, 0.3, 2.0, 0, &err);
+    darray->map_threshold = 1024;
+    for(int i = 0; i < 3000; i++) {
+        DArray_push(darray, &values[i % 100]);
+    }
+    items = DArray_detach(darray, &length, &store_size, &err);
+    mu_assert(items != NULL && length == 3000 && store_size >= 3000, "Error detaching mapped store (%#04x)", err);
+    mu_assert(items[2999] == &values[99], "Incorrect value detached from mapped store");
+    free(items);
+
+    // A borrowed store is copied when it must grow, and left alone when destroyed
+    void *local[4] = { &values[0], &values[1], NULL, (void *)1 };
+    darray = DArray_from_buffer(local, 2, 4, 0.3, 2.0, DA_FLAG_BORROWED, NULL, &err);
+    mu_assert(darray != NULL && local[3] == NULL, "Error borrowing buffer (%#04x)", err);
+    DArray_push(darray, &values[2]);
+    DArray_push(darray, &values[3]);
+    mu_assert(darray->items == (void **)local && darray->flags & DA_FLAG_BORROWED, "Borrowed store replaced early");
+    DArray_push(darray, &values[4]);
+    mu_assert(darray->items != (void **)local && !(darray->flags & DA_FLAG_BORROWED), "Borrowed store not copied on growth");
+    mu_assert(DArray_index(darray, 3) == &values[3] && DArray_index(darray, 4) == &values[4], "Incorrect values after copy");
+
+    // Swapping exchanges contents, but only between arrays with one allocator
+    DArray *other = DArray_init_ring(4, 1.5, &err);
+    DArray_push(other, &values[50]);
+    err = DArray_swap(darray, other);
+    mu_assert(err == 0, "Error swapping (%#04x)", err);
+    mu_assert(darray->length == 1 && darray->flags & DA_FLAG_RING && DArray_index(darray, 0) == &values[50], "First array not swapped");
+    mu_assert(other->length == 5 && DArray_index(other, 4) == &values[4], "Second array not swapped");
+
+    Allocator *pool = Allocator_pool(&err);
+    DArray *pooled = DArray_init_with_allocator(4, 0.3, 1.5, 0, 0, pool, &err);
+    err = DArray_swap(darray, pooled);
+    mu_assert(err == (DA_ERR_ARGS | DA_SWAP_ALLOCATOR), "Swap across allocators allowed (%#04x)", err);
+    DArray_destroy(pooled);
+    Allocator_destroy(pool);
+
+    // Invalid arguments
+    mu_assert(DArray_from_buffer(NULL, 0, 4, 0.3, 2.0, 0, NULL, &err) == NULL && err == (DA_ERR_ARGS | DA_INIT_ITEMS), "NULL items allowed");
+    mu_assert(DArray_from_buffer(local, 5, 4, 0.3, 2.0, 0, NULL, &err) == NULL && err == (DA_ERR_ARGS | DA_INIT_STORE_SIZE), "Short store allowed");
+    mu_assert(DArray_from_buffer(local, 0, 4, 0.3, 2.0, DA_FLAG_MAPPED, NULL, &err) == NULL && err == (DA_ERR_ARGS | DA_INIT_FLAGS), "Mapped flag allowed");
+    mu_assert(DArray_detach(NULL, &length, &store_size, &err) == NULL && err == DA_ERR_ARGS, "NULL detach allowed");
+
+    DArray_destroy(darray);
+    DArray_destroy(other);
+    err = 0;
+    return NULL;
+}
+
+// Checks each run follows on from the last; ctx counts the values seen
+static int check_run(void **values, DArraySize count, DArraySize index, void *ctx)
+{
+    DArraySize *seen = ctx;
+
+    if(index != *seen || count == 0 || count > 16) {
+        return -1;
+    }
+    for(DArraySize i = 0; i < count; i++) {
+        if(values[i] != DArray_index(darray, index + i)) {
+            return -1;
+        }
+    }
+    *seen += count;
+
+    return 0;
+}
+
+static int stop_run(void **values, DArraySize count, DArraySize index, void *ctx)
+{
+    (void)values;
+    (void)count;
+    (void)ctx;
+
+    return index > 0 ? 5 : 0;
+}
+
+static char *test_iteration(void)
+{
+    static int values[100];
+    DArraySpan spans[2];
+    void *value = NULL;
+    uint32_t i = 0;
+
+    // Pooled array: one span after the pool
+    darray = DArray_init_with_pool(64, 0.5, 2.0, 8, &err);
+    mu_assert(DArray_spans(darray, spans) == 0, "Spans of empty array");
+    DArray_foreach(darray, value) {
+        i++;
+    }
+    mu_assert(i == 0, "Empty array iterated");
+
+    for(int v = 0; v < 40; v++) {
+        DArray_push(darray, &values[v]);
+    }
+    mu_assert(DArray_spans(darray, spans) == 1 && spans[0].values == darray->items + 8 && spans[0].length == 40, "Incorrect span");
+    DArray_foreach(darray, value) {
+        mu_assert(value == &values[i], "Incorrect value %u in iteration", i);
+        i++;
+    }
+    mu_assert(i == 40, "Incorrect number of values iterated (%u)", i);
+    DArray_destroy(darray);
+
+    // Wrapped ring: two spans
+    darray = DArray_init_ring(64, 2.0, &err);
+    for(int v = 0; v < 60; v++) {
+        DArray_push(darray, &values[v]);
+    }
+    for(int v = 0; v < 30; v++) {
+        DArray_shift(darray, &err);
+    }
+    for(int v = 60; v < 90; v++) {
+        DArray_push(darray, &values[v]);
+    }
+    mu_assert(DArray_spans(darray, spans) == 2 && spans[0].length == 34 && spans[1].length == 26, "Incorrect ring spans");
+
+    i = 0;
+    DArrayIter iter = DArray_iter(darray, 8);
+    while(DArray_iter_next(&iter, &value)) {
+        mu_assert(value == &values[i + 30], "Incorrect value %u in ring iteration", i);
+        i++;
+    }
+    mu_assert(i == 60, "Incorrect number of ring values iterated (%u)", i);
+
+    DArraySize seen = 0;
+    err = DArray_visit_chunks(darray, 16, check_run, &seen);
+    mu_assert(err == 0 && seen == 60, "Error visiting runs (%d, %" PRIuDA " seen)", err, seen);
+    seen = 0;
+    err = DArray_visit_chunks(darray, 0, check_run, &seen);
+    mu_assert(err == -1, "Runs longer than chunk_size not from whole spans (%d)", err);
+
+    err = DArray_visit_chunks(darray, 0, stop_run, NULL);
+    mu_assert(err == 5, "Visit not stopped (%d)", err);
+    err = DArray_visit_chunks(darray, 0, NULL, NULL);
+    mu_assert(err == DA_ERR_ARGS, "Visit without callback allowed (%d)", err);
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_small(void)
+{
+    static int values[40];
+
+    // Values live in the header's allocation until the inline slots run out
+    DArray *small = DArray_init_small(0.3, 2.0, 0, NULL, &err);
+    mu_assert(small != NULL && err == 0, "Error in init_small (%#04x)", err);
+    mu_assert(DArray_is_inline(small) && small->store_size == DARRAY_SMALL_SLOTS, "Store not inline");
+    for(int i = 0; i < (int)DARRAY_SMALL_SLOTS; i++) {
+        DArray_push(small, &values[i]);
+    }
+    mu_assert(DArray_is_inline(small) && small->length == DARRAY_SMALL_SLOTS, "Inline store spilled early");
+
+    DArray_push(small, &values[DARRAY_SMALL_SLOTS]);
+    mu_assert(!DArray_is_inline(small) && small->store_size > DARRAY_SMALL_SLOTS, "Store not spilled to the heap");
+    for(uint32_t i = 0; i <= DARRAY_SMALL_SLOTS; i++) {
+        mu_assert(DArray_index(small, i) == &values[i], "Incorrect value %u after spill", i);
+    }
+
+    // Shrinking brings the values back inline
+    DArray_unshift(small, &values[39]);
+    DArray_pop_n(small, NULL, 6);
+    err = DArray_shrink_to_fit(small);
+    mu_assert(err == 0 && DArray_is_inline(small), "Values not moved back inline (%#04x)", err);
+    mu_assert(small->length == 4 && DArray_index(small, 0) == &values[39] && DArray_index(small, 3) == &values[2], "Incorrect values after shrink");
+
+    // Swapping moves inline values out, as the slots stay with their header
+    DArray *other = DArray_init_with_pool(4, 0.3, 1.5, 0, &err);
+    DArray_push(other, &values[20]);
+    err = DArray_swap(small, other);
+    mu_assert(err == 0, "Error swapping (%#04x)", err);
+    mu_assert(small->length == 1 && DArray_index(small, 0) == &values[20] && !DArray_is_inline(small), "Small array not swapped");
+    mu_assert(other->length == 4 && DArray_index(other, 0) == &values[39] && !(other->flags & DA_FLAG_SMALL), "Other array not swapped");
+    DArray_destroy(other);
+    err = DArray_shrink_to_fit(small);
+    mu_assert(err == 0 && DArray_is_inline(small), "Swapped store not moved inline (%#04x)", err);
+
+    // Detaching copies the inline slots out
+    DArraySize length = 0;
+    DArraySize store_size = 0;
+    void **items = DArray_detach(small, &length, &store_size, &err);
+    mu_assert(items != NULL && err == 0 && length == 1 && items[0] == &values[20], "Error detaching inline store (%#04x)", err);
+    free(items);
+
+    // Ring mode and allocators work as for other arrays
+    Allocator *pool = Allocator_pool(&err);
+    small = DArray_init_small(0.0, 1.5, DA_FLAG_RING, pool, &err);
+    mu_assert(small != NULL && err == 0, "Error in ring init_small (%#04x)", err);
+    for(int i = 0; i < 40; i++) {
+        DArray_push(small, &values[i]);
+        if(i % 3 == 0) {
+            DArray_shift(small, NULL);
+        }
+    }
+    mu_assert(small->length == 26 && DArray_index(small, 25) == &values[39], "Incorrect ring values");
+    DArray_destroy(small);
+    Allocator_destroy(pool);
+
+    mu_assert(DArray_init_small(0.3, 1.0, 0, NULL, &err) == NULL && err == (DA_ERR_ARGS | DA_INIT_EXPAND_RATE), "Invalid expand_rate allowed");
+    mu_assert(DArray_init_small(0.3, 2.0, DA_FLAG_BORROWED, NULL, &err) == NULL && err == (DA_ERR_ARGS | DA_INIT_FLAGS), "Borrowed flag allowed");
+
+    err = 0;
+    return NULL;
+}
+
 static char *all_tests(void) {
     mu_run_test(test_init_with_pool);
     mu_run_test(test_init_without_pool);
@@ -338,6 +1048,20 @@ static char *all_tests(void) {
     mu_run_test(test_unshift_with_pool);
     mu_run_test(test_unshift_without_pool);
     mu_run_test(test_shift_with_pool);
+    mu_run_test(test_qsort);
+    mu_run_test(test_ring);
+    mu_run_test(test_linearise);
+    mu_run_test(test_push_n_pop_n);
+    mu_run_test(test_unshift_n_shift_n);
+    mu_run_test(test_splice);
+    mu_run_test(test_splice_failed_grow);
+    mu_run_test(test_reserve_shrink);
+    mu_run_test(test_mapped_growth);
+    mu_run_test(test_sorted_search);
+    mu_run_test(test_tuning);
+    mu_run_test(test_from_buffer_detach_swap);
+    mu_run_test(test_iteration);
+    mu_run_test(test_small);
 
     return NULL;
 }
@@ -0,0 +1,239 @@
+#undef LIB
+#define DBG_RING
+#define DBG_RATE_LIMIT 3
+#include "minunit.h"
+
+#include <pthread.h>
+
+mu_suite_start();
+
+static char output[1 << 16];
+
+// Start the flusher on a temporary file, with an interval long enough that only stopping drains it;
+// the flusher first drains once the interval has passed, so nothing is written out before then
+static FILE *start_log(void)
+{
+    FILE *out = tmpfile();
+
+    if(out != NULL && dbg_log_start(out, 60000) != 0) {
+        fclose(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+// Stop the flusher and read back what it wrote
+static size_t stop_log(FILE *out)
+{
+    dbg_log_stop();
+    rewind(out);
+    size_t length = fread(output, 1, sizeof(output) - 1, out);
+    output[length] = '\0';
+    fclose(out);
+
+    return length;
+}
+
+static size_t count_lines(const char *text, const char *needle)
+{
+    size_t count = 0;
+
+    for(const char *line = strstr(text, needle); line != NULL; line = strstr(line + 1, needle)) {
+        count++;
+    }
+
+    return count;
+}
+
+static char *test_deferred(void)
+{
+    char expected[256];
+    FILE *out = start_log();
+    mu_assert(out != NULL, "Failed to start flusher");
+    mu_assert(dbg_log_start(out, 10) != 0, "Flusher started twice");
+
+    char name[] = "ring";
+    long long big = -1234567890123LL;
+    size_t size = 4096;
+
+    errno = ENOENT;
+    int line = __LINE__ + 1;
+    log_err("value %d name %s", 42, name);
+    errno = 0;
+    // Changing the string after logging mustn't change the record
+    name[0] = 'R';
+    log_info("%5.2f|%-6s|%x|%lld|%zu|%c|", 3.14159, "ab", 255u, big, size, 'z');
+    log_info("%*d|%.*s|%hhd|%%|%Lg", 4, 7, 2, "xyz", (signed char)-5, (long double)0.5);
+    log_warn("no arguments");
+    debug("debug %u", 1u);
+
+    size_t length = stop_log(out);
+    mu_assert(length > 0, "Nothing written");
+
+    snprintf(expected, sizeof(expected), "[ERROR] (tests/dbg_tests.c:test_deferred:%d; errno: %s) value 42 name ring\n",
+            line, strerror(ENOENT));
+    mu_assert(strstr(output, expected) != NULL, "Incorrect error record: %s", output);
+
+    snprintf(expected, sizeof(expected), "%5.2f|%-6s|%x|%lld|%zu|%c|\n", 3.14159, "ab", 255u, big, size, 'z');
+    mu_assert(strstr(output, expected) != NULL, "Incorrect formatting: %s", output);
+    snprintf(expected, sizeof(expected), "%*d|%.*s|%hhd|%%|%Lg\n", 4, 7, 2, "xyz", (signed char)-5, (long double)0.5);
+    mu_assert(strstr(output, expected) != NULL, "Incorrect formatting of '*' and modifiers: %s", output);
+
+    mu_assert(strstr(output, "[WARN] (tests/dbg_tests.c:test_deferred:") != NULL, "Warning not written");
+    mu_assert(strstr(output, "; errno: None) no arguments\n") != NULL, "Warning errno not captured");
+    mu_assert(strstr(output, "DEBUG tests/dbg_tests.c:test_deferred:") != NULL, "Debug not written");
+
+    return NULL;
+}
+
+static char *test_truncated(void)
+{
+    char long_string[400];
+    memset(long_string, 'a', sizeof(long_string) - 1);
+    long_string[sizeof(long_string) - 1] = '\0';
+
+    FILE *out = start_log();
+    mu_assert(out != NULL, "Failed to start flusher");
+
+    log_info("[%s][%s]", long_string, "lost");
+    log_info("%d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9);
+
+    stop_log(out);
+
+    const char *open = strstr(output, ") [");
+    mu_assert(open != NULL, "Truncated record not written");
+    mu_assert(strspn(open + 3, "a") == 151, "String not truncated to the record");
+    mu_assert(strstr(output, "][]\n") != NULL, "String past the record not empty");
+    mu_assert(strstr(output, ") %d %d %d %d %d %d %d %d %d\n") != NULL, "Record with too many arguments not raw");
+
+    return NULL;
+}
+
+#define THREADS 4
+#define PER_THREAD 100
+
+static void *log_thread(void *arg)
+{
+    for(int i = 0; i < PER_THREAD; i++) {
+        log_info("thread %d record %d", *(int *)arg, i);
+    }
+
+    return NULL;
+}
+
+static char *test_threads(void)
+{
+    pthread_t threads[THREADS];
+    int ids[THREADS];
+
+    FILE *out = start_log();
+    mu_assert(out != NULL, "Failed to start flusher");
+
+    // Two rounds, so the second round's threads reuse the rings released by the first
+    for(int round = 0; round < 2; round++) {
+        for(int t = 0; t < THREADS; t++) {
+            ids[t] = t;
+            pthread_create(&threads[t], NULL, log_thread, &ids[t]);
+        }
+        for(int t = 0; t < THREADS; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        dbg_log_flush();
+    }
+
+    stop_log(out);
+
+    mu_assert(count_lines(output, "[INFO]") == 2 * THREADS * PER_THREAD, "Records lost (%zu)",
+            count_lines(output, "[INFO]"));
+    mu_assert(strstr(output, "thread 3 record 99\n") != NULL, "Last record missing");
+    mu_assert(count_lines(output, "dropped") == 0, "Records dropped");
+
+    return NULL;
+}
+
+static char *test_dropped(void)
+{
+    FILE *out = start_log();
+    mu_assert(out != NULL, "Failed to start flusher");
+
+    for(int i = 0; i < 1000; i++) {
+        log_info("record %d", i);
+    }
+
+    stop_log(out);
+
+    mu_assert(count_lines(output, "[INFO]") == 512, "Ring not bounded (%zu)", count_lines(output, "[INFO]"));
+    mu_assert(strstr(output, "488 log records dropped") != NULL, "Dropped records not reported");
+
+    return NULL;
+}
+
+static uint64_t fake_second = 0;
+
+static uint64_t fake_clock(void)
+{
+    return fake_second;
+}
+
+static int failing_check(void)
+{
+    check(0, "check failed");
+
+    return 0;
+
+error:
+    return -1;
+}
+
+static char *test_rate_limit(void)
+{
+    FILE *out = start_log();
+    mu_assert(out != NULL, "Failed to start flusher");
+
+    fake_second = 100;
+    dbg_limit_set_clock(fake_clock);
+
+    for(int i = 0; i < 10; i++) {
+        failing_check();
+    }
+    mu_assert(errno == 0, "check didn't clear errno");
+
+    fake_second++;
+    failing_check();
+
+    dbg_limit_set_clock(NULL);
+    stop_log(out);
+
+    mu_assert(count_lines(output, "check failed") == 4, "Check not rate limited (%zu)", count_lines(output, "check failed"));
+    mu_assert(strstr(output, "7 messages suppressed") != NULL, "Suppressed messages not reported");
+
+    return NULL;
+}
+
+static char *test_synchronous(void)
+{
+    // Without the flusher, records go straight to stderr and nothing is held back
+    log_info("written directly %d", 1);
+    dbg_log_flush();
+
+    FILE *out = start_log();
+    mu_assert(out != NULL, "Failed to restart flusher");
+    size_t length = stop_log(out);
+    mu_assert(length == 0, "Record held after logging directly");
+
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_deferred);
+    mu_run_test(test_truncated);
+    mu_run_test(test_threads);
+    mu_run_test(test_dropped);
+    mu_run_test(test_rate_limit);
+    mu_run_test(test_synchronous);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,228 @@
+#include "dheap.h"
+#include "minunit.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+mu_suite_start();
+
+static int err;
+
+#define VALUE_COUNT 2000
+
+typedef struct Job {
+    int key;
+    DArraySize index;
+} Job;
+
+static Job jobs[VALUE_COUNT];
+
+static int compare_jobs(void *val1, void *val2)
+{
+    return ((Job *)val1)->key - ((Job *)val2)->key;
+}
+
+static void job_moved(void *value, DArraySize index)
+{
+    ((Job *)value)->index = index;
+}
+
+static void reset_jobs(void)
+{
+    srand(3);
+    for(int i = 0; i < VALUE_COUNT; i++) {
+        jobs[i].key = rand() % 1000;
+        jobs[i].index = UINT32_MAX;
+    }
+}
+
+// Pop everything, checking keys come out in order and every handle was kept up to date
+static char *drain(DHeap *heap, uint32_t expected)
+{
+    int last = INT_MIN;
+    uint32_t count = 0;
+
+    while(DHeap_length(heap) > 0) {
+        for(uint32_t i = 0; i < DHeap_length(heap); i += 97) {
+            Job *job = DArray_index(heap->items, i);
+            mu_assert(job->index == i, "Stale handle at %u (was %" PRIuDA ")", i, job->index);
+        }
+
+        Job *job = DHeap_pop(heap);
+        mu_assert(job->key >= last, "Values out of order (%d after %d)", job->key, last);
+        last = job->key;
+        count++;
+    }
+
+    mu_assert(count == expected, "Incorrect number of values (was %u, should be %u)", count, expected);
+    mu_assert(DHeap_pop(heap) == NULL && DHeap_peek(heap) == NULL, "Value popped from empty heap");
+
+    return NULL;
+}
+
+static char *test_init(void)
+{
+    DHeap *heap = DHeap_init(0, compare_jobs, NULL, &err);
+    mu_assert(heap != NULL && err == 0 && heap->arity == DHEAP_ARITY, "Error in init (%#04x)", err);
+    DHeap_destroy(heap);
+
+    heap = DHeap_init(1, compare_jobs, NULL, &err);
+    mu_assert(heap == NULL && err == (DA_ERR_ARGS | DH_INIT_ARITY), "Arity of 1 allowed (%#04x)", err);
+
+    DArray *ring = DArray_init_ring(8, 2.0, &err);
+    heap = DHeap_from_darray(ring, 4, compare_jobs, NULL, &err);
+    mu_assert(heap == NULL && err == (DA_ERR_ARGS | DH_INIT_RING), "Ring DArray allowed (%#04x)", err);
+    DArray_destroy(ring);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_push_pop(void)
+{
+    for(uint32_t arity = 2; arity <= 8; arity++) {
+        reset_jobs();
+        DHeap *heap = DHeap_init(arity, compare_jobs, job_moved, &err);
+
+        for(int i = 0; i < VALUE_COUNT; i++) {
+            err = DHeap_push(heap, &jobs[i]);
+            mu_assert(err == 0, "Error in push (%#04x)", err);
+        }
+        mu_assert(DHeap_length(heap) == VALUE_COUNT, "Incorrect length after push");
+
+        Job *top = DHeap_peek(heap);
+        for(int i = 0; i < VALUE_COUNT; i++) {
+            mu_assert(top->key <= jobs[i].key, "Peek is not the smallest value");
+        }
+
+        char *msg = drain(heap, VALUE_COUNT);
+        DHeap_destroy(heap);
+        if(msg != NULL) {
+            return msg;
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_from_darray(void)
+{
+    reset_jobs();
+    DArray *darray = DArray_init_with_pool(8, 0.3, 2.0, 3, &err);
+    for(int i = 0; i < VALUE_COUNT; i++) {
+        DArray_push(darray, &jobs[i]);
+    }
+
+    DHeap *heap = DHeap_from_darray(darray, 4, compare_jobs, job_moved, &err);
+    mu_assert(heap != NULL && err == 0, "Error in from_darray (%#04x)", err);
+
+    char *msg = drain(heap, VALUE_COUNT);
+    DHeap_destroy(heap);
+
+    return msg;
+}
+
+static char *test_update_remove(void)
+{
+    reset_jobs();
+    DHeap *heap = DHeap_init(4, compare_jobs, job_moved, &err);
+    for(int i = 0; i < VALUE_COUNT; i++) {
+        DHeap_push(heap, &jobs[i]);
+    }
+
+    // Decrease some keys, increase others, and remove a few through their handles
+    for(int i = 0; i < VALUE_COUNT; i += 7) {
+        jobs[i].key = i % 2 ? jobs[i].key - 500 : jobs[i].key + 500;
+        err = DHeap_update(heap, jobs[i].index);
+        mu_assert(err == 0, "Error in update (%#04x)", err);
+    }
+
+    uint32_t removed = 0;
+    for(int i = 3; i < VALUE_COUNT; i += 11) {
+        Job *job = DHeap_remove(heap, jobs[i].index);
+        mu_assert(job == &jobs[i], "Incorrect value removed");
+        removed++;
+    }
+
+    mu_assert(DHeap_update(heap, VALUE_COUNT) == DA_ERR_ARGS, "Update out of range allowed");
+    mu_assert(DHeap_remove(heap, VALUE_COUNT) == NULL, "Remove out of range allowed");
+
+    char *msg = drain(heap, VALUE_COUNT - removed);
+    DHeap_destroy(heap);
+
+    return msg;
+}
+
+static char *test_merge(void)
+{
+    // A small batch is sifted in, a large one rebuilds the heap; both must give a valid heap
+    uint32_t splits[] = { 1990, 1000, 10 };
+
+    for(int s = 0; s < 3; s++) {
+        reset_jobs();
+        DHeap *heap = DHeap_init(4, compare_jobs, job_moved, &err);
+        DHeap *other = DHeap_init(4, compare_jobs, job_moved, &err);
+
+        for(uint32_t i = 0; i < VALUE_COUNT; i++) {
+            DHeap_push(i < splits[s] ? heap : other, &jobs[i]);
+        }
+
+        err = DHeap_merge(heap, other);
+        mu_assert(err == 0, "Error in merge (%#04x)", err);
+        mu_assert(DHeap_length(other) == 0, "Merged heap not emptied");
+
+        char *msg = drain(heap, VALUE_COUNT);
+        DHeap_destroy(heap);
+        DHeap_destroy(other);
+        if(msg != NULL) {
+            return msg;
+        }
+    }
+
+    mu_assert(DHeap_merge(NULL, NULL) == DA_ERR_ARGS, "Merge of NULL heaps allowed");
+
+    return NULL;
+}
+
+#define LESS_JOBS(a, b) (((Job *)(a))->key < ((Job *)(b))->key)
+DHEAP_DEFINE(job_heap, 4, LESS_JOBS)
+
+static char *test_define(void)
+{
+    reset_jobs();
+    DArray *darray = DArray_init_with_pool(8, 0.3, 2.0, 0, &err);
+
+    for(int i = 0; i < VALUE_COUNT / 2; i++) {
+        DArray_push(darray, &jobs[i]);
+    }
+    job_heap_heapify(darray);
+    for(int i = VALUE_COUNT / 2; i < VALUE_COUNT; i++) {
+        err = job_heap_push(darray, &jobs[i]);
+        mu_assert(err == 0, "Error in generated push (%#04x)", err);
+    }
+
+    int last = -1;
+    for(int i = 0; i < VALUE_COUNT; i++) {
+        Job *job = job_heap_pop(darray);
+        mu_assert(job != NULL && job->key >= last, "Generated heap out of order at %d", i);
+        last = job->key;
+    }
+    mu_assert(job_heap_pop(darray) == NULL, "Value popped from empty generated heap");
+
+    DArray_destroy(darray);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init);
+    mu_run_test(test_push_pop);
+    mu_run_test(test_from_darray);
+    mu_run_test(test_update_remove);
+    mu_run_test(test_merge);
+    mu_run_test(test_define);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
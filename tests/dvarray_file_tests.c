@@ -0,0 +1,176 @@
+#include "dvarray_file.h"
+#include "minunit.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+mu_suite_start();
+
+static int err;
+
+#define VALUE_COUNT 1000
+#define FILE_PATH "/tmp/dvarray_file_tests.dva"
+
+// Save an array with a pool in front of its values
+static char *save_values(void)
+{
+    DVArray *dvarray = DVArray_init_with_pool(sizeof(long), 16, 0.3, 1.5, 4, &err);
+
+    for(long i = 0; i < VALUE_COUNT; i++) {
+        DVArray_push(dvarray, &i);
+    }
+    long value = -1;
+    DVArray_unshift(dvarray, &value);
+
+    err = DVArray_save(dvarray, FILE_PATH);
+    mu_assert(err == 0, "Error in save (%#04x)", err);
+
+    DVArray_destroy(dvarray);
+
+    return NULL;
+}
+
+static char *check_values(DVArray *dvarray)
+{
+    mu_assert(dvarray->length == VALUE_COUNT + 1, "Incorrect length (was %u)", dvarray->length);
+    mu_assert(dvarray->elem_size == sizeof(long), "Incorrect elem_size (was %u)", dvarray->elem_size);
+    mu_assert(*(long *)DVArray_index(dvarray, 0) == -1, "Incorrect first value");
+    for(uint32_t i = 1; i <= VALUE_COUNT; i++) {
+        mu_assert(*(long *)DVArray_index(dvarray, i) == (long)i - 1, "Incorrect value at index %u", i);
+    }
+
+    return NULL;
+}
+
+static char *test_round_trip(void)
+{
+    char *msg = save_values();
+    if(msg != NULL) {
+        return msg;
+    }
+
+    DVArray *dvarray = DVArray_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(dvarray != NULL && err == 0, "Error in open (%#04x)", err);
+    msg = check_values(dvarray);
+    DVArray_destroy(dvarray);
+    if(msg != NULL) {
+        return msg;
+    }
+
+    // Saving an opened array gives the same file back
+    dvarray = DVArray_open(FILE_PATH, DV_OPEN_READ, &err);
+    err = DVArray_save(dvarray, FILE_PATH);
+    mu_assert(err == 0, "Error in save of opened array (%#04x)", err);
+    DVArray_destroy(dvarray);
+
+    dvarray = DVArray_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(dvarray != NULL && err == 0, "Error in reopen (%#04x)", err);
+    msg = check_values(dvarray);
+    DVArray_destroy(dvarray);
+
+    err = 0;
+    return msg;
+}
+
+static char *test_copy(void)
+{
+    char *msg = save_values();
+    if(msg != NULL) {
+        return msg;
+    }
+
+    DVArray *dvarray = DVArray_open(FILE_PATH, DV_OPEN_COPY, &err);
+    mu_assert(dvarray != NULL && err == 0, "Error in open (%#04x)", err);
+
+    // Writes in place stay in the private mapping
+    long value = 42;
+    memcpy(DVArray_index(dvarray, 1), &value, sizeof(value));
+    err = DVArray_shift(dvarray, &value);
+    mu_assert(err == 0 && value == -1, "Incorrect value shifted (%ld)", value);
+
+    // Growing the store moves it to the heap
+    uint32_t store_size = dvarray->store_size;
+    for(long i = 0; i < VALUE_COUNT; i++) {
+        err = DVArray_push(dvarray, &i);
+        mu_assert(err == 0, "Error in push (%#04x)", err);
+    }
+    mu_assert(dvarray->store_size > store_size, "Store did not grow");
+    mu_assert(*(long *)DVArray_index(dvarray, 0) == 42, "Value lost when store grew");
+    mu_assert(*(long *)DVArray_index(dvarray, VALUE_COUNT) == 0, "Incorrect pushed value");
+    DVArray_destroy(dvarray);
+
+    dvarray = DVArray_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(dvarray != NULL && err == 0, "Error in reopen (%#04x)", err);
+    msg = check_values(dvarray);
+    DVArray_destroy(dvarray);
+
+    err = 0;
+    return msg;
+}
+
+static char *test_empty(void)
+{
+    DVArray *dvarray = DVArray_init_with_pool(sizeof(int), 1, 0.0, 2.0, 0, &err);
+    err = DVArray_save(dvarray, FILE_PATH);
+    mu_assert(err == 0, "Error in save of empty array (%#04x)", err);
+    DVArray_destroy(dvarray);
+
+    dvarray = DVArray_open(FILE_PATH, DV_OPEN_COPY, &err);
+    mu_assert(dvarray != NULL && err == 0, "Error in open of empty array (%#04x)", err);
+    mu_assert(dvarray->length == 0, "Incorrect length (was %u)", dvarray->length);
+
+    int value = 7;
+    err = DVArray_push(dvarray, &value);
+    mu_assert(err == 0 && *(int *)DVArray_index(dvarray, 0) == 7, "Error in push to opened array (%#04x)", err);
+    DVArray_destroy(dvarray);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_errors(void)
+{
+    mu_assert(DVArray_save(NULL, FILE_PATH) == DA_ERR_ARGS, "Save of NULL dvarray allowed");
+
+    DVArray *dvarray = DVArray_open("/nonexistent/dvarray.dva", DV_OPEN_READ, &err);
+    mu_assert(dvarray == NULL && err == (DA_ERR_DATA | DV_FILE_IO), "Open of missing file allowed (%#04x)", err);
+
+    dvarray = DVArray_open(FILE_PATH, 7, &err);
+    mu_assert(dvarray == NULL && err == DA_ERR_ARGS, "Invalid mode allowed (%#04x)", err);
+
+    char *msg = save_values();
+    if(msg != NULL) {
+        return msg;
+    }
+
+    // Corrupt the magic, then cut the file short of its store
+    FILE *file = fopen(FILE_PATH, "r+b");
+    fputc('X', file);
+    fclose(file);
+    dvarray = DVArray_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(dvarray == NULL && err == (DA_ERR_DATA | DV_FILE_FORMAT), "Corrupt magic accepted (%#04x)", err);
+
+    msg = save_values();
+    if(msg != NULL) {
+        return msg;
+    }
+    mu_assert(truncate(FILE_PATH, sizeof(DVFileHeader) + 64) == 0, "Failed to truncate");
+    dvarray = DVArray_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(dvarray == NULL && err == (DA_ERR_DATA | DV_FILE_FORMAT), "Truncated file accepted (%#04x)", err);
+
+    remove(FILE_PATH);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_round_trip);
+    mu_run_test(test_copy);
+    mu_run_test(test_empty);
+    mu_run_test(test_errors);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
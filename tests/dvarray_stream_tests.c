@@ -0,0 +1,224 @@
+#include "dvarray_stream.h"
+#include "minunit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+mu_suite_start();
+
+static int err;
+
+#define VALUE_COUNT 50000
+
+// In-memory stream which moves at most 1000 bytes per call, to exercise resumed transfers
+typedef struct Buffer {
+    char *data;
+    size_t size;
+    size_t capacity;
+    size_t read;
+} Buffer;
+
+static ssize_t buffer_write(void *ctx, const struct iovec *iov, int count)
+{
+    Buffer *buffer = ctx;
+    size_t moved = 0;
+
+    for(int i = 0; i < count && moved < 1000; i++) {
+        size_t len = iov[i].iov_len < 1000 - moved ? iov[i].iov_len : 1000 - moved;
+        if(buffer->size + len > buffer->capacity) {
+            buffer->capacity = 2 * (buffer->size + len);
+            buffer->data = realloc(buffer->data, buffer->capacity);
+        }
+        memcpy(buffer->data + buffer->size, iov[i].iov_base, len);
+        buffer->size += len;
+        moved += len;
+    }
+
+    return (ssize_t)moved;
+}
+
+static ssize_t buffer_read(void *ctx, const struct iovec *iov, int count)
+{
+    Buffer *buffer = ctx;
+    size_t moved = 0;
+
+    for(int i = 0; i < count && moved < 1000 && buffer->read < buffer->size; i++) {
+        size_t len = iov[i].iov_len < 1000 - moved ? iov[i].iov_len : 1000 - moved;
+        len = len < buffer->size - buffer->read ? len : buffer->size - buffer->read;
+        memcpy(iov[i].iov_base, buffer->data + buffer->read, len);
+        buffer->read += len;
+        moved += len;
+    }
+
+    return (ssize_t)moved;
+}
+
+static DVArray *make_values(uint32_t count)
+{
+    DVArray *dvarray = DVArray_init_with_pool(sizeof(int), 16, 0.3, 1.5, 4, &err);
+
+    for(int i = 0; i < (int)count; i++) {
+        DVArray_push(dvarray, &i);
+    }
+
+    return dvarray;
+}
+
+static char *check_values(DVArray *dvarray, uint32_t count)
+{
+    mu_assert(dvarray->length == count, "Incorrect length (was %u, should be %u)", dvarray->length, count);
+    for(uint32_t i = 0; i < count; i++) {
+        mu_assert(*(int *)DVArray_index(dvarray, i) == (int)i, "Incorrect value at index %u", i);
+    }
+
+    return NULL;
+}
+
+static char *test_crc32c(void)
+{
+    mu_assert(DVStream_crc32c(0, "123456789", 9) == 0xE3069283, "Incorrect CRC32C");
+
+    uint32_t crc = DVStream_crc32c(0, "1234", 4);
+    mu_assert(DVStream_crc32c(crc, "56789", 5) == 0xE3069283, "Incorrect incremental CRC32C");
+
+    return NULL;
+}
+
+static char *test_snapshot_delta(void)
+{
+    Buffer buffer = {0};
+    DVStream stream = { buffer_write, buffer_read, &buffer, -1 };
+    DVArray *source = make_values(VALUE_COUNT / 2);
+
+    err = DVArray_write_snapshot(source, &stream, 4096);
+    mu_assert(err == 0, "Error in write snapshot (%#04x)", err);
+
+    uint32_t sent = source->length;
+    for(int i = VALUE_COUNT / 2; i < VALUE_COUNT; i++) {
+        DVArray_push(source, &i);
+    }
+    err = DVArray_write_delta(source, sent, &stream, 0);
+    mu_assert(err == 0, "Error in write delta (%#04x)", err);
+    err = DVArray_write_delta(source, source->length, &stream, 0);
+    mu_assert(err == 0, "Error in write empty delta (%#04x)", err);
+
+    DVArray *replica = NULL;
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == 0 && replica != NULL, "Error in read snapshot (%#04x)", err);
+    char *msg = check_values(replica, VALUE_COUNT / 2);
+    if(msg != NULL) {
+        return msg;
+    }
+
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == 0, "Error in read delta (%#04x)", err);
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == 0, "Error in read empty delta (%#04x)", err);
+    msg = check_values(replica, VALUE_COUNT);
+    if(msg != NULL) {
+        return msg;
+    }
+
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == (DA_ERR_DATA | DV_STREAM_END), "End of stream not reported (%#04x)", err);
+
+    // A snapshot into an existing array replaces its values
+    buffer.size = buffer.read = 0;
+    DVArray_write_snapshot(source, &stream, 0);
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == 0, "Error in read snapshot into existing array (%#04x)", err);
+    msg = check_values(replica, VALUE_COUNT);
+
+    DVArray_destroy(source);
+    DVArray_destroy(replica);
+    free(buffer.data);
+    err = 0;
+    return msg;
+}
+
+static char *test_fd(void)
+{
+    FILE *file = tmpfile();
+    mu_assert(file != NULL, "Failed to create temporary file");
+    DVStream stream = DVStream_fd(fileno(file));
+
+    DVArray *source = make_values(VALUE_COUNT);
+    err = DVArray_write_snapshot(source, &stream, 1000);
+    mu_assert(err == 0, "Error in write snapshot (%#04x)", err);
+    DVArray_destroy(source);
+
+    lseek(fileno(file), 0, SEEK_SET);
+    DVArray *replica = NULL;
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == 0, "Error in read snapshot (%#04x)", err);
+    char *msg = check_values(replica, VALUE_COUNT);
+
+    DVArray_destroy(replica);
+    fclose(file);
+    err = 0;
+    return msg;
+}
+
+static char *test_errors(void)
+{
+    Buffer buffer = {0};
+    DVStream stream = { buffer_write, buffer_read, &buffer, -1 };
+    DVArray *source = make_values(1000);
+    DVArray *replica = make_values(10);
+
+    // A delta must follow the replica's length
+    DVArray_write_delta(source, 500, &stream, 0);
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == (DA_ERR_DATA | DV_STREAM_BASE), "Delta with wrong base accepted (%#04x)", err);
+    mu_assert(DVArray_write_delta(source, 1001, &stream, 0) == (DA_ERR_ARGS | DV_STREAM_BASE), "Delta past length allowed");
+
+    // A corrupt value fails its chunk, leaving the replica as it was
+    buffer.size = buffer.read = 0;
+    DVArray_write_delta(source, 10, &stream, 256);
+    buffer.data[sizeof(DVStreamFrame) + 300] ^= 1;
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == (DA_ERR_DATA | DV_STREAM_CHECKSUM), "Corrupt chunk accepted (%#04x)", err);
+    char *msg = check_values(replica, 10);
+    if(msg != NULL) {
+        return msg;
+    }
+
+    // A corrupt header is rejected, as is a stream cut short
+    buffer.size = buffer.read = 0;
+    DVArray_write_delta(source, 10, &stream, 0);
+    buffer.data[12] ^= 1;
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == (DA_ERR_DATA | DV_STREAM_FORMAT), "Corrupt header accepted (%#04x)", err);
+
+    buffer.size = buffer.read = 0;
+    DVArray_write_delta(source, 10, &stream, 0);
+    buffer.size -= 100;
+    err = DVArray_read_frame(&replica, &stream);
+    mu_assert(err == (DA_ERR_DATA | DV_STREAM_IO), "Truncated stream accepted (%#04x)", err);
+
+    // A delta needs an array to apply to
+    buffer.size = buffer.read = 0;
+    DVArray_write_delta(source, 0, &stream, 0);
+    DVArray *missing = NULL;
+    err = DVArray_read_frame(&missing, &stream);
+    mu_assert(err == DA_ERR_ARGS && missing == NULL, "Delta into NULL dvarray allowed (%#04x)", err);
+
+    DVArray_destroy(source);
+    DVArray_destroy(replica);
+    free(buffer.data);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_crc32c);
+    mu_run_test(test_snapshot_delta);
+    mu_run_test(test_fd);
+    mu_run_test(test_errors);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,111 @@
+#include "dvarray.h"
+#include "minunit.h"
+
+mu_suite_start();
+
+static DVArray *dvarray;
+static int err;
+
+static char *test_init_with_pool(void)
+{
+    dvarray = DVArray_init_with_pool(sizeof(double), 10, 0.3, 1.5, 2, &err);
+
+    mu_assert(dvarray != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(dvarray->length == 0, "Initial dvarray length != 0 (was %d)", dvarray->length);
+    mu_assert(dvarray->elem_size == sizeof(double), "elem_size set incorrectly (was %d)", dvarray->elem_size);
+    mu_assert(dvarray->start_index == 2, "start_index set incorrectly (was %d, should be %d)", dvarray->start_index, 2);
+    mu_assert(dvarray->store_size == 10, "store_size set incorrectly (was %d, should be %d)", dvarray->store_size, 10);
+
+    DVArray_destroy(dvarray);
+
+    dvarray = DVArray_init_with_pool(0, 10, 0.3, 1.5, 2, &err);
+    mu_assert(dvarray == NULL && err == (DA_ERR_ARGS | DV_INIT_ELEM_SIZE), "Zero elem_size accepted (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_push_pop(void)
+{
+    dvarray = DVArray_init_with_pool(sizeof(int), 2, 0.0, 1.5, 0, &err);
+
+    // Values are copied, so the loop variable can be reused
+    for(int i = 0; i < 100; i++) {
+        err = DVArray_push(dvarray, &i);
+        mu_assert(err == 0, "Error in push (%#04x)", err);
+    }
+
+    mu_assert(dvarray->length == 100, "Incorrect length after push (was %d)", dvarray->length);
+    for(uint32_t i = 0; i < 100; i++) {
+        mu_assert(*(int *)DVArray_index(dvarray, i) == (int)i, "Incorrect value at index %d", i);
+    }
+
+    int value = -1;
+    err = DVArray_pop(dvarray, &value);
+    mu_assert(err == 0 && value == 99, "Incorrect value popped (%d)", value);
+
+    DVArray_destroy(dvarray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_shift_unshift(void)
+{
+    dvarray = DVArray_init_with_pool(sizeof(long), 10, 0.3, 1.5, 2, &err);
+
+    for(long i = 0; i < 5; i++) {
+        err = DVArray_unshift(dvarray, &i);
+        mu_assert(err == 0, "Error in unshift (%#04x)", err);
+    }
+
+    long value = -1;
+    mu_assert(DVArray_get(dvarray, 0, &value) == 0 && value == 4, "Incorrect first value after unshift (%ld)", value);
+
+    for(long i = 4; i >= 0; i--) {
+        err = DVArray_shift(dvarray, &value);
+        mu_assert(err == 0 && value == i, "Incorrect value shifted (%ld, should be %ld)", value, i);
+    }
+
+    err = DVArray_shift(dvarray, &value);
+    mu_assert(err == (DA_ERR_ARGS | DV_EMPTY), "Shift from empty dvarray allowed (%#04x)", err);
+
+    // A distance beyond the range of int is range checked rather than truncated
+    err = DVArray_move(dvarray, -(int64_t)UINT32_MAX);
+    mu_assert(err == (DA_ERR_ARGS | DA_MOVE_RANGE), "Out of range move allowed (%#04x)", err);
+
+    DVArray_destroy(dvarray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_move(void)
+{
+    dvarray = DVArray_init_with_pool(sizeof(int), 10, 0.3, 1.01, 2, &err);
+
+    for(int i = 0; i < 5; i++) {
+        DVArray_push(dvarray, &i);
+    }
+
+    // A long move grows the store once, straight to the size it needs
+    err = DVArray_move(dvarray, 1000);
+    mu_assert(err == 0 && dvarray->start_index == 1002, "Error in move (%#04x)", err);
+    mu_assert(dvarray->store_size == 1007, "Incorrect store_size after move (was %u, should be %d)", dvarray->store_size, 1007);
+    for(uint32_t i = 0; i < 5; i++) {
+        mu_assert(*(int *)DVArray_index(dvarray, i) == (int)i, "Incorrect value at index %u after move", i);
+    }
+
+    DVArray_destroy(dvarray);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init_with_pool);
+    mu_run_test(test_push_pop);
+    mu_run_test(test_shift_unshift);
+    mu_run_test(test_move);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,198 @@
+#include "dvhash.h"
+#include "minunit.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+mu_suite_start();
+
+static DVHash *hash;
+static int err;
+
+#define KEY_COUNT 20000
+#define FILE_PATH "/tmp/dvhash_tests.dvh"
+
+static char *test_init(void)
+{
+    hash = DVHash_init(sizeof(uint64_t), sizeof(uint64_t), 100, NULL, &err);
+    mu_assert(hash != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(hash->mask + 1 == 128 && hash->count == 0, "Incorrect slots for capacity (%u)", hash->mask + 1);
+    DVHash_destroy(hash);
+
+    hash = DVHash_init(4, 0, 0, NULL, &err);
+    mu_assert(hash != NULL && hash->mask + 1 == DVHASH_GROUP, "Minimum table not one group (%#04x)", err);
+    DVHash_destroy(hash);
+
+    hash = DVHash_init(0, 8, 0, NULL, &err);
+    mu_assert(hash == NULL && err == (DA_ERR_ARGS | VH_INIT_KEY_SIZE), "Empty key allowed (%#04x)", err);
+    hash = DVHash_init(8, 8, UINT32_MAX, NULL, &err);
+    mu_assert(hash == NULL && err == (DA_ERR_ARGS | VH_INIT_CAPACITY), "Capacity too large allowed (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+// Checks every key in [0, KEY_COUNT) maps to key * scale, or is missing when it is odd and skip_odd
+static char *check_keys(DVHash *table, uint64_t scale, int skip_odd)
+{
+    for(uint64_t key = 0; key < KEY_COUNT; key++) {
+        uint64_t *value = DVHash_get(table, &key);
+
+        if(skip_odd && key % 2 == 1) {
+            mu_assert(value == NULL, "Removed key %llu found", (unsigned long long)key);
+        } else {
+            mu_assert(value != NULL && *value == key * scale, "Incorrect value of key %llu", (unsigned long long)key);
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_put_get_remove(void)
+{
+    hash = DVHash_init(sizeof(uint64_t), sizeof(uint64_t), 0, NULL, &err);
+
+    for(uint64_t key = 0; key < KEY_COUNT; key++) {
+        uint64_t value = key * 3;
+        err = DVHash_put(hash, &key, &value);
+        mu_assert(err == 0, "Error in put (%#04x)", err);
+    }
+    mu_assert(hash->count == KEY_COUNT, "Incorrect count after put (%u)", hash->count);
+    mu_assert(check_keys(hash, 3, 0) == NULL, "Incorrect table after put");
+
+    // Putting a key again replaces its value
+    for(uint64_t key = 0; key < KEY_COUNT; key++) {
+        uint64_t value = key * 5;
+        DVHash_put(hash, &key, &value);
+    }
+    mu_assert(hash->count == KEY_COUNT, "Count changed by replacing values (%u)", hash->count);
+
+    for(uint64_t key = 1; key < KEY_COUNT; key += 2) {
+        uint64_t value = 0;
+        err = DVHash_remove(hash, &key, &value);
+        mu_assert(err == 0 && value == key * 5, "Error in remove (%#04x)", err);
+    }
+    mu_assert(hash->count == KEY_COUNT / 2, "Incorrect count after remove (%u)", hash->count);
+    mu_assert(check_keys(hash, 5, 1) == NULL, "Incorrect table after remove");
+
+    uint64_t key = 1;
+    err = DVHash_remove(hash, &key, NULL);
+    mu_assert(err == (DA_ERR_ARGS | VH_REMOVE_MISSING), "Missing key removed (%#04x)", err);
+    err = DVHash_put(hash, NULL, &key);
+    mu_assert(err == DA_ERR_ARGS, "NULL key allowed (%#04x)", err);
+
+    uint32_t slot = 0;
+    uint32_t walked = 0;
+    void *found = NULL;
+    void *value = NULL;
+    while(DVHash_next(hash, &slot, &found, &value)) {
+        mu_assert(*(uint64_t *)found % 2 == 0 && *(uint64_t *)value == *(uint64_t *)found * 5, "Incorrect entry walked");
+        walked++;
+    }
+    mu_assert(walked == KEY_COUNT / 2, "Incorrect number of entries walked (%u)", walked);
+
+    DVHash_destroy(hash);
+    err = 0;
+    return NULL;
+}
+
+static char *test_churn(void)
+{
+    Allocator *allocator = Allocator_pool(&err);
+    mu_assert(allocator != NULL, "Error creating allocator (%#04x)", err);
+
+    // Keys of 12 bytes and no values: a set
+    hash = DVHash_init(3 * sizeof(uint32_t), 0, 0, allocator, &err);
+    mu_assert(hash != NULL, "Error in init with allocator (%#04x)", err);
+
+    // A sliding window of 10 live keys leaves a trail of removals, which must not grow the table
+    for(uint32_t i = 0; i < 100000; i++) {
+        uint32_t key[3] = { i, ~i, i * 7 };
+        err = DVHash_put(hash, key, NULL);
+        mu_assert(err == 0, "Error in put (%#04x)", err);
+
+        if(i >= 10) {
+            uint32_t old[3] = { i - 10, ~(i - 10), (i - 10) * 7 };
+            err = DVHash_remove(hash, old, NULL);
+            mu_assert(err == 0, "Error removing key %u (%#04x)", i - 10, err);
+        }
+    }
+    mu_assert(hash->count == 10 && hash->mask + 1 <= 32, "Table grew under churn (%u slots)", hash->mask + 1);
+
+    for(uint32_t i = 99990; i < 100000; i++) {
+        uint32_t key[3] = { i, ~i, i * 7 };
+        mu_assert(DVHash_get(hash, key) != NULL, "Key %u lost in churn", i);
+    }
+
+    DVHash_destroy(hash);
+    Allocator_destroy(allocator);
+    err = 0;
+    return NULL;
+}
+
+static char *test_save_open(void)
+{
+    hash = DVHash_init(sizeof(uint64_t), sizeof(uint64_t), 0, NULL, &err);
+    for(uint64_t key = 0; key < KEY_COUNT; key++) {
+        uint64_t value = key * 3;
+        DVHash_put(hash, &key, &value);
+    }
+    for(uint64_t key = 1; key < KEY_COUNT; key += 2) {
+        DVHash_remove(hash, &key, NULL);
+    }
+
+    err = DVHash_save(hash, FILE_PATH);
+    mu_assert(err == 0, "Error in save (%#04x)", err);
+    DVHash_destroy(hash);
+
+    DVHash *opened = DVHash_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(opened != NULL && err == 0, "Error in open (%#04x)", err);
+    mu_assert(opened->count == KEY_COUNT / 2, "Incorrect count after open (%u)", opened->count);
+    mu_assert(check_keys(opened, 3, 1) == NULL, "Incorrect table after open");
+    DVHash_destroy(opened);
+
+    // A private copy may grow past the mapping, and leaves the file as it was
+    opened = DVHash_open(FILE_PATH, DV_OPEN_COPY, &err);
+    mu_assert(opened != NULL && err == 0, "Error in copy-on-write open (%#04x)", err);
+    uint32_t slots = opened->mask + 1;
+    for(uint64_t key = 1; key < 4 * KEY_COUNT; key += 2) {
+        uint64_t value = key * 3;
+        err = DVHash_put(opened, &key, &value);
+        mu_assert(err == 0, "Error in put after open (%#04x)", err);
+    }
+    mu_assert(opened->mask + 1 > slots, "Opened table not grown");
+    mu_assert(check_keys(opened, 3, 0) == NULL, "Incorrect table after growing opened table");
+    DVHash_destroy(opened);
+
+    opened = DVHash_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(opened != NULL && opened->count == KEY_COUNT / 2, "File changed by copy-on-write table");
+    DVHash_destroy(opened);
+
+    // A plain array file is not a table
+    DVArray *dvarray = DVArray_init_with_pool(16, 64, 0.3, 1.5, 0, &err);
+    char zero[16] = { 0 };
+    for(int i = 0; i < 64; i++) {
+        DVArray_push(dvarray, zero);
+    }
+    DVArray_save(dvarray, FILE_PATH);
+    DVArray_destroy(dvarray);
+
+    opened = DVHash_open(FILE_PATH, DV_OPEN_READ, &err);
+    mu_assert(opened == NULL && err == (DA_ERR_DATA | DV_FILE_FORMAT), "Array file opened as table (%#04x)", err);
+
+    unlink(FILE_PATH);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init);
+    mu_run_test(test_put_get_remove);
+    mu_run_test(test_churn);
+    mu_run_test(test_save_open);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -23,7 +23,7 @@ Terminate file with RUN_TESTS(all_tests)
 
 #define mu_suite_start() static char *message = NULL
 
-#define mu_assert(test, message, ...) if (!(test)) { log_err(message, ##__VA_ARGS__); return message; }
+#define mu_assert(test, message, ...) if (!(test)) { log_err(message, ##__VA_ARGS__); return (char *)(message); }
 
 #define mu_run_test(test) debug("\n-----%s", " " #test); \
     message = test(); tests_run++; if(message) return message;
@@ -0,0 +1,319 @@
+#include "sdarray.h"
+#include "minunit.h"
+
+#include <pthread.h>
+
+mu_suite_start();
+
+static SDArray *sdarray;
+static int err;
+
+static char *test_init(void)
+{
+    sdarray = SDArray_init(0, &err);
+    mu_assert(sdarray != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(sdarray->chunk_mask + 1 == SDARRAY_CHUNK_SIZE, "Default chunk size not used (was %d)", sdarray->chunk_mask + 1);
+    mu_assert(sdarray->length == 0, "Initial length != 0");
+    SDArray_destroy(sdarray);
+
+    sdarray = SDArray_init(100, &err);
+    mu_assert(sdarray == NULL && err == (DA_ERR_ARGS | SD_INIT_CHUNK_SIZE), "Chunk size not a power of 2 allowed (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_push_pop(void)
+{
+    sdarray = SDArray_init(4, &err);
+
+    int values[20];
+    for(int i = 0; i < 20; i++) {
+        err = SDArray_push(sdarray, &values[i]);
+        mu_assert(err == 0, "Error in push (%#04x)", err);
+    }
+    mu_assert(sdarray->length == 20 && sdarray->chunks->length == 5, "Incorrect layout after push (%" PRIuDA " chunks)", sdarray->chunks->length);
+
+    for(uint32_t i = 0; i < 20; i++) {
+        mu_assert(SDArray_index(sdarray, i) == &values[i], "Incorrect value at index %d", i);
+    }
+    mu_assert(SDArray_index(sdarray, 20) == NULL, "Value past end of array");
+
+    for(int i = 19; i >= 10; i--) {
+        mu_assert(SDArray_pop(sdarray) == &values[i], "Incorrect value popped at %d", i);
+    }
+    mu_assert(sdarray->chunks->length == 3, "Empty chunks not released on pop (%" PRIuDA " chunks)", sdarray->chunks->length);
+
+    SDArray_destroy(sdarray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_shift_unshift(void)
+{
+    sdarray = SDArray_init(4, &err);
+
+    int values[20];
+    for(int i = 0; i < 10; i++) {
+        err = SDArray_unshift(sdarray, &values[i]);
+        mu_assert(err == 0, "Error in unshift (%#04x)", err);
+    }
+    for(int i = 10; i < 20; i++) {
+        SDArray_push(sdarray, &values[i]);
+    }
+
+    mu_assert(SDArray_index(sdarray, 0) == &values[9] && SDArray_index(sdarray, 9) == &values[0], "Incorrect values after unshift");
+    mu_assert(SDArray_index(sdarray, 10) == &values[10], "Incorrect value after unshift and push");
+
+    for(int i = 9; i >= 0; i--) {
+        mu_assert(SDArray_shift(sdarray) == &values[i], "Incorrect value shifted at %d", i);
+    }
+    for(int i = 10; i < 20; i++) {
+        mu_assert(SDArray_shift(sdarray) == &values[i], "Incorrect value shifted at %d", i);
+    }
+
+    mu_assert(sdarray->length == 0 && sdarray->chunks->length == 0, "Chunks left in empty array (%" PRIuDA ")", sdarray->chunks->length);
+    mu_assert(SDArray_shift(sdarray) == NULL && SDArray_pop(sdarray) == NULL, "Value removed from empty array");
+
+    SDArray_destroy(sdarray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_slot_stability(void)
+{
+    sdarray = SDArray_init(8, &err);
+
+    int values[1000];
+    SDArray_push(sdarray, &values[0]);
+    void **slot = SDArray_slot(sdarray, 0);
+
+    // Growth at both ends never moves existing values
+    for(int i = 1; i < 1000; i++) {
+        err = i % 2 ? SDArray_push(sdarray, &values[i]) : SDArray_unshift(sdarray, &values[i]);
+        mu_assert(err == 0, "Error growing array (%#04x)", err);
+    }
+    mu_assert(SDArray_slot(sdarray, 499) == slot && *slot == &values[0], "Slot moved by growth");
+
+    err = SDArray_set(sdarray, 499, &values[1]);
+    mu_assert(err == 0 && SDArray_index(sdarray, 499) == &values[1], "Error in set (%#04x)", err);
+
+    err = SDArray_set(sdarray, 1000, &values[1]);
+    mu_assert(err == DA_ERR_ARGS, "Set past end of array allowed (%#04x)", err);
+
+    SDArray_destroy(sdarray);
+    err = 0;
+    return NULL;
+}
+
+static char *test_snapshot(void)
+{
+    sdarray = SDArray_init(4, &err);
+
+    int values[40];
+    for(int i = 0; i < 30; i++) {
+        SDArray_push(sdarray, &values[i]);
+    }
+
+    SDArray *snapshot = SDArray_snapshot(sdarray, &err);
+    mu_assert(snapshot != NULL && err == 0, "Error in snapshot (%#04x)", err);
+    mu_assert(snapshot->length == 30 && snapshot->chunks == sdarray->chunks, "Snapshot does not share directory");
+
+    // The first write copies the directory and the chunk written, and nothing else
+    err = SDArray_set(sdarray, 5, &values[39]);
+    mu_assert(err == 0 && SDArray_index(sdarray, 5) == &values[39], "Error in set after snapshot (%#04x)", err);
+    mu_assert(SDArray_index(snapshot, 5) == &values[5], "Set after snapshot changed snapshot");
+    mu_assert(snapshot->chunks != sdarray->chunks, "Directory not copied on write");
+    mu_assert(DArray_index(snapshot->chunks, 1) != DArray_index(sdarray->chunks, 1), "Written chunk not copied");
+    mu_assert(DArray_index(snapshot->chunks, 0) == DArray_index(sdarray->chunks, 0) &&
+            DArray_index(snapshot->chunks, 7) == DArray_index(sdarray->chunks, 7), "Unwritten chunks copied");
+
+    // Growing and shrinking the array leaves the snapshot as it was
+    for(int i = 30; i < 40; i++) {
+        SDArray_push(sdarray, &values[i]);
+        SDArray_unshift(sdarray, &values[i]);
+    }
+    for(int i = 0; i < 25; i++) {
+        SDArray_shift(sdarray);
+    }
+    mu_assert(sdarray->length == 25 && SDArray_index(sdarray, 0) == &values[15], "Incorrect array after snapshot");
+
+    SDArray *second = SDArray_snapshot(snapshot, &err);
+    mu_assert(second != NULL && err == 0, "Error in snapshot of snapshot (%#04x)", err);
+    for(int i = 0; i < 10; i++) {
+        SDArray_pop(snapshot);
+    }
+    void **slot = SDArray_slot(snapshot, 0);
+    mu_assert(slot != NULL && *slot == &values[0], "Incorrect slot in snapshot");
+    *slot = &values[39];
+
+    SDArray_destroy(sdarray);
+    mu_assert(snapshot->length == 20 && SDArray_index(snapshot, 0) == &values[39], "Incorrect snapshot after writes");
+    SDArray_destroy(snapshot);
+
+    uint32_t i = 0;
+    void *value = NULL;
+    SDArray_foreach(second, value) {
+        mu_assert(value == &values[i], "Snapshot changed at %u", i);
+        i++;
+    }
+    mu_assert(i == 30, "Incorrect length of snapshot (%u)", i);
+    SDArray_destroy(second);
+
+    mu_assert(SDArray_snapshot(NULL, &err) == NULL && err == DA_ERR_ARGS, "Snapshot of NULL array allowed");
+
+    err = 0;
+    return NULL;
+}
+
+#define READERS 4
+#define SNAPSHOT_VALUES 5000
+
+// Checks a snapshot holds 1 to its length, then destroys it; non-NULL if it didn't
+static void *read_snapshot(void *arg)
+{
+    SDArray *snapshot = arg;
+    void *failed = NULL;
+    void *value = NULL;
+
+    for(int pass = 0; pass < 10 && failed == NULL; pass++) {
+        uintptr_t expected = 1;
+        SDArray_foreach(snapshot, value) {
+            if((uintptr_t)value != expected++) {
+                failed = arg;
+            }
+        }
+        if(expected - 1 != snapshot->length) {
+            failed = arg;
+        }
+    }
+    SDArray_destroy(snapshot);
+
+    return failed;
+}
+
+static char *test_snapshot_threads(void)
+{
+    pthread_t readers[READERS];
+
+    sdarray = SDArray_init(64, &err);
+    for(uintptr_t i = 1; i <= SNAPSHOT_VALUES; i++) {
+        SDArray_push(sdarray, (void *)i);
+    }
+
+    // Each reader checks its own snapshot while the array is rewritten under it
+    for(int r = 0; r < READERS; r++) {
+        SDArray *snapshot = SDArray_snapshot(sdarray, &err);
+        mu_assert(snapshot != NULL, "Error in snapshot (%#04x)", err);
+        pthread_create(&readers[r], NULL, read_snapshot, snapshot);
+        SDArray_pop(sdarray);
+    }
+    for(uint32_t i = 0; i < sdarray->length; i++) {
+        SDArray_set(sdarray, i, NULL);
+    }
+    for(uint32_t i = 0; i < SNAPSHOT_VALUES; i++) {
+        SDArray_unshift(sdarray, NULL);
+        SDArray_shift(sdarray);
+    }
+
+    for(int r = 0; r < READERS; r++) {
+        void *failed = NULL;
+        pthread_join(readers[r], &failed);
+        mu_assert(failed == NULL, "Snapshot %d changed by writes", r);
+    }
+
+    SDArray_destroy(sdarray);
+    err = 0;
+    return NULL;
+}
+
+// Checks each run follows on from the last; ctx counts the values seen
+static int check_run(void **values, DArraySize count, DArraySize index, void *ctx)
+{
+    DArraySize *seen = ctx;
+
+    if(index != *seen || count == 0 || count > 5) {
+        return -1;
+    }
+    for(DArraySize i = 0; i < count; i++) {
+        if(values[i] != SDArray_index(sdarray, (uint32_t)(index + i))) {
+            return -1;
+        }
+    }
+    *seen += count;
+
+    return 0;
+}
+
+static int stop_run(void **values, DArraySize count, DArraySize index, void *ctx)
+{
+    (void)values;
+    (void)count;
+    (void)ctx;
+
+    return index > 0 ? 7 : 0;
+}
+
+static char *test_iteration(void)
+{
+    sdarray = SDArray_init(8, &err);
+
+    void *value = NULL;
+    uint32_t i = 0;
+    SDArray_foreach(sdarray, value) {
+        i++;
+    }
+    mu_assert(i == 0, "Empty array iterated");
+
+    // Values start part way into the first chunk and end part way into the last
+    int values[100];
+    for(int v = 50; v < 100; v++) {
+        SDArray_push(sdarray, &values[v]);
+    }
+    for(int v = 49; v >= 3; v--) {
+        SDArray_unshift(sdarray, &values[v]);
+    }
+
+    SDArray_foreach(sdarray, value) {
+        mu_assert(value == &values[i + 3], "Incorrect value %u in iteration", i);
+        i++;
+    }
+    mu_assert(i == 97, "Incorrect number of values iterated (%u)", i);
+
+    i = 0;
+    SDArrayIter iter = SDArray_iter(sdarray, 4);
+    while(SDArray_iter_next(&iter, &value)) {
+        mu_assert(value == &values[i + 3], "Incorrect value %u in prefetching iteration", i);
+        i++;
+    }
+
+    DArraySize seen = 0;
+    err = SDArray_visit_chunks(sdarray, 5, check_run, &seen);
+    mu_assert(err == 0 && seen == 97, "Error visiting runs (%d, %" PRIuDA " seen)", err, seen);
+    seen = 0;
+    err = SDArray_visit_chunks(sdarray, 0, check_run, &seen);
+    mu_assert(err == -1, "Runs longer than a chunk or not split at chunks (%d)", err);
+
+    err = SDArray_visit_chunks(sdarray, 0, stop_run, NULL);
+    mu_assert(err == 7, "Visit not stopped (%d)", err);
+    err = SDArray_visit_chunks(NULL, 0, stop_run, NULL);
+    mu_assert(err == DA_ERR_ARGS, "Visit of NULL array allowed (%d)", err);
+
+    SDArray_destroy(sdarray);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init);
+    mu_run_test(test_push_pop);
+    mu_run_test(test_shift_unshift);
+    mu_run_test(test_slot_stability);
+    mu_run_test(test_snapshot);
+    mu_run_test(test_snapshot_threads);
+    mu_run_test(test_iteration);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
@@ -0,0 +1,153 @@
+#include "spsc_queue.h"
+#include "minunit.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+mu_suite_start();
+
+static SPSCQueue *queue;
+static int err;
+
+#define TRANSFER_COUNT 100000
+
+static char *test_init(void)
+{
+    queue = SPSCQueue_init(10, &err);
+    mu_assert(queue != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(SPSCQueue_capacity(queue) == 16, "Capacity not rounded up (was %d, should be %d)", SPSCQueue_capacity(queue), 16);
+    mu_assert(SPSCQueue_length(queue) == 0, "Initial length != 0");
+    SPSCQueue_destroy(queue);
+
+    queue = SPSCQueue_init(0, &err);
+    mu_assert(queue == NULL && err == (DA_ERR_ARGS | SQ_INIT_CAPACITY), "Capacity of 0 allowed (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+static char *test_push_pop(void)
+{
+    queue = SPSCQueue_init(4, &err);
+
+    int values[5];
+    for(int i = 0; i < 4; i++) {
+        err = SPSCQueue_try_push(queue, &values[i]);
+        mu_assert(err == 0, "Error in try_push (%#04x)", err);
+    }
+
+    err = SPSCQueue_try_push(queue, &values[4]);
+    mu_assert(err == (DA_ERR_ARGS | SQ_FULL), "Push onto full queue allowed (%#04x)", err);
+
+    void *value = NULL;
+    for(int i = 0; i < 4; i++) {
+        err = SPSCQueue_try_pop(queue, &value);
+        mu_assert(err == 0 && value == &values[i], "Incorrect value popped at %d (%#04x)", i, err);
+    }
+
+    err = SPSCQueue_try_pop(queue, &value);
+    mu_assert(err == (DA_ERR_ARGS | SQ_EMPTY), "Pop from empty queue allowed (%#04x)", err);
+
+    SPSCQueue_destroy(queue);
+    err = 0;
+    return NULL;
+}
+
+static char *test_batch(void)
+{
+    queue = SPSCQueue_init(8, &err);
+
+    int values[12];
+    void *in[12];
+    void *out[12];
+    for(int i = 0; i < 12; i++) {
+        in[i] = &values[i];
+    }
+
+    // Move the indices so the batches wrap around the end of the store
+    uint32_t count = SPSCQueue_try_push_n(queue, in, 5);
+    count += SPSCQueue_try_pop_n(queue, out, 5);
+    mu_assert(count == 10, "Incorrect count in initial batches (%d)", count);
+
+    count = SPSCQueue_try_push_n(queue, in, 12);
+    mu_assert(count == 8 && SPSCQueue_length(queue) == 8, "Incorrect count pushed onto queue (%d)", count);
+
+    count = SPSCQueue_try_pop_n(queue, out, 12);
+    mu_assert(count == 8, "Incorrect count popped from queue (%d)", count);
+    for(int i = 0; i < 8; i++) {
+        mu_assert(out[i] == in[i], "Incorrect value popped in batch at %d", i);
+    }
+
+    SPSCQueue_destroy(queue);
+    err = 0;
+    return NULL;
+}
+
+static void *producer(void *arg)
+{
+    (void)arg;
+
+    for(uintptr_t i = 1; i <= TRANSFER_COUNT; ) {
+        // Alternate single and batched pushes
+        if(i % 2) {
+            if(SPSCQueue_try_push(queue, (void *)i) == 0) {
+                i++;
+            } else {
+                sched_yield();
+            }
+        } else {
+            void *batch[7];
+            uint32_t n = 0;
+            while(n < 7 && i + n <= TRANSFER_COUNT) {
+                batch[n] = (void *)(i + n);
+                n++;
+            }
+            uint32_t pushed = SPSCQueue_try_push_n(queue, batch, n);
+            if(pushed == 0) {
+                sched_yield();
+            }
+            i += pushed;
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_threads(void)
+{
+    queue = SPSCQueue_init(64, &err);
+
+    pthread_t thread;
+    err = pthread_create(&thread, NULL, producer, NULL);
+    mu_assert(err == 0, "Failed to create producer thread");
+
+    uintptr_t expected = 1;
+    while(expected <= TRANSFER_COUNT) {
+        void *batch[5];
+        uint32_t n = SPSCQueue_try_pop_n(queue, batch, 5);
+        if(n == 0) {
+            sched_yield();
+        }
+        for(uint32_t i = 0; i < n; i++, expected++) {
+            mu_assert(batch[i] == (void *)expected, "Values reordered between threads (got %lu, expected %lu)", (unsigned long)(uintptr_t)batch[i], (unsigned long)expected);
+        }
+    }
+
+    pthread_join(thread, NULL);
+    mu_assert(SPSCQueue_length(queue) == 0, "Values left in queue after transfer");
+
+    SPSCQueue_destroy(queue);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init);
+    mu_run_test(test_push_pop);
+    mu_run_test(test_batch);
+    mu_run_test(test_threads);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)
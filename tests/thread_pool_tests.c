@@ -0,0 +1,154 @@
+#include "thread_pool.h"
+#include "minunit.h"
+
+mu_suite_start();
+
+static ThreadPool *pool;
+static int err;
+
+#define TASK_COUNT 1000
+
+static _Atomic uint32_t counter;
+
+static void count_task(void *arg)
+{
+    atomic_fetch_add(&counter, (uint32_t)(uintptr_t)arg);
+}
+
+static char *test_init(void)
+{
+    pool = ThreadPool_init(0, &err);
+    mu_assert(pool != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(ThreadPool_threads(pool) > 0, "No workers started");
+    ThreadPool_destroy(pool);
+
+    pool = ThreadPool_init(4, &err);
+    mu_assert(pool != NULL && err == 0, "Error in init (%#04x)", err);
+    mu_assert(ThreadPool_threads(pool) == 4, "Incorrect number of workers (%u)", ThreadPool_threads(pool));
+
+    return NULL;
+}
+
+static char *test_submit_wait(void)
+{
+    TPGroup group = {0};
+    atomic_store(&counter, 0);
+
+    for(uintptr_t i = 0; i < TASK_COUNT; i++) {
+        err = ThreadPool_submit(pool, &group, count_task, (void *)(i + 1));
+        mu_assert(err == 0, "Error in submit (%#04x)", err);
+    }
+    ThreadPool_wait(pool, &group);
+
+    mu_assert(atomic_load(&counter) == TASK_COUNT * (TASK_COUNT + 1) / 2, "Not every task ran (%u)", atomic_load(&counter));
+    mu_assert(atomic_load(&group.outstanding) == 0, "Group not finished after wait");
+
+    err = ThreadPool_submit(pool, &group, NULL, NULL);
+    mu_assert(err == DA_ERR_ARGS, "NULL fn submitted (%#04x)", err);
+    err = ThreadPool_submit(NULL, &group, count_task, NULL);
+    mu_assert(err == DA_ERR_ARGS, "Submitted to NULL pool (%#04x)", err);
+
+    err = 0;
+    return NULL;
+}
+
+// Sum 1..n by splitting the range in half, with each half run as a task of its own
+typedef struct SumTask {
+    uint64_t begin;
+    uint64_t end;
+    uint64_t sum;
+} SumTask;
+
+static void sum_task(void *arg)
+{
+    SumTask *task = arg;
+
+    if(task->end - task->begin <= 16) {
+        task->sum = 0;
+        for(uint64_t i = task->begin; i < task->end; i++) {
+            task->sum += i;
+        }
+        return;
+    }
+
+    uint64_t mid = task->begin + (task->end - task->begin) / 2;
+    SumTask left = { task->begin, mid, 0 };
+    SumTask right = { mid, task->end, 0 };
+    TPGroup group = {0};
+
+    ThreadPool_submit(pool, &group, sum_task, &left);
+    sum_task(&right);
+    ThreadPool_wait(pool, &group);
+
+    task->sum = left.sum + right.sum;
+}
+
+static char *test_nested(void)
+{
+    SumTask task = { 0, 100000, 0 };
+    TPGroup group = {0};
+
+    err = ThreadPool_submit(pool, &group, sum_task, &task);
+    mu_assert(err == 0, "Error in submit (%#04x)", err);
+    ThreadPool_wait(pool, &group);
+
+    mu_assert(task.sum == UINT64_C(99999) * 100000 / 2, "Incorrect nested sum (%llu)", (unsigned long long)task.sum);
+
+    return NULL;
+}
+
+static char *test_destroy_drains(void)
+{
+    atomic_store(&counter, 0);
+
+    for(int i = 0; i < TASK_COUNT; i++) {
+        err = ThreadPool_submit(pool, NULL, count_task, (void *)1);
+        mu_assert(err == 0, "Error in submit (%#04x)", err);
+    }
+    ThreadPool_destroy(pool);
+
+    mu_assert(atomic_load(&counter) == TASK_COUNT, "Queued tasks dropped by destroy (%u ran)", atomic_load(&counter));
+
+    return NULL;
+}
+
+static char *test_submit_to_pin(void)
+{
+    pool = ThreadPool_init(2, &err);
+    mu_assert(pool != NULL, "Failed to create pool (%#04x)", err);
+
+    // Pinning can be refused where the affinity mask is restricted; workers keep running either way
+    err = ThreadPool_pin(pool);
+    mu_assert(err == 0 || err == (DA_ERR_ARGS | TP_PIN_AFFINITY), "Error pinning workers (%#04x)", err);
+
+    TPGroup group = {0};
+    atomic_store(&counter, 0);
+    // Worker indices wrap around the pool
+    for(uint32_t i = 0; i < TASK_COUNT; i++) {
+        err = ThreadPool_submit_to(pool, i, &group, count_task, (void *)1);
+        mu_assert(err == 0, "Error in submit_to (%#04x)", err);
+    }
+    ThreadPool_wait(pool, &group);
+    mu_assert(atomic_load(&counter) == TASK_COUNT, "Not every task ran (%u)", atomic_load(&counter));
+
+    err = ThreadPool_submit_to(pool, 0, &group, NULL, NULL);
+    mu_assert(err == DA_ERR_ARGS, "NULL fn submitted (%#04x)", err);
+    err = ThreadPool_pin(NULL);
+    mu_assert(err == DA_ERR_ARGS, "NULL pool pinned (%#04x)", err);
+
+    ThreadPool_destroy(pool);
+    err = 0;
+    return NULL;
+}
+
+static char *all_tests(void) {
+    mu_run_test(test_init);
+    mu_run_test(test_submit_wait);
+    mu_run_test(test_nested);
+    mu_run_test(test_destroy_drains);
+    mu_run_test(test_submit_to_pin);
+
+    return NULL;
+}
+
+RUN_TESTS(all_tests)